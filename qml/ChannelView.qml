@@ -1,11 +1,284 @@
 import QtQuick 2.15
 import QtQuick.Controls 2.15
 
+// Chat surface backed by MessageModel rows.  Each message is its own
+// delegate, so only the rows on screen are laid out, an append creates one
+// delegate, and switching channels costs the same however long the history
+// is.  Selection spans rows: the view keeps an anchor and an end as
+// (row, character) pairs and every visible delegate highlights its share;
+// copying asks the model for the text so off-screen rows are included.
 Item {
-    anchors.fill: parent
-    // placeholder for chat messages
-    Text {
-        anchors.centerIn: parent
-        text: "Channel view"
+    id: view
+
+    property var model: null
+    property color backgroundColor: "#1e1e1e"
+    property color textColor: "#d4d4d4"
+    property color selectionColor: "#264f78"
+    property color selectedTextColor: "#ffffff"
+    property string fontFamily: ""
+    property int fontPixelSize: 12
+    // Lets a focused text field keep Ctrl+C for its own selection
+    property bool copyShortcutEnabled: true
+
+    // True while the newest line is out of view
+    readonly property bool scrolledUp: !list.stick
+
+    signal linkActivated(string link)
+    // link is "" when the click was not on a link
+    signal contextMenuRequested(string link)
+    // Scrolled to the oldest loaded line
+    signal reachedTop()
+
+    // ── Selection: anchor is where the press started, end follows the mouse ──
+    property int anchorRow: -1
+    property int anchorPos: 0
+    property int endRow: -1
+    property int endPos: 0
+    readonly property bool anchorFirst: anchorRow < endRow || (anchorRow === endRow && anchorPos <= endPos)
+    readonly property int selFromRow: anchorFirst ? anchorRow : endRow
+    readonly property int selFromPos: anchorFirst ? anchorPos : endPos
+    readonly property int selToRow: anchorFirst ? endRow : anchorRow
+    readonly property int selToPos: anchorFirst ? endPos : anchorPos
+    readonly property bool hasSelection: anchorRow >= 0 && (anchorRow !== endRow || anchorPos !== endPos)
+
+    function clearSelection() {
+        anchorRow = -1
+        endRow = -1
+    }
+
+    function selectedText() {
+        if (!hasSelection) return ""
+        return model.selectedText(selFromRow, selFromPos, selToRow, selToPos)
+    }
+
+    function copySelection() {
+        var text = selectedText()
+        if (text === "") return
+        clipboardHelper.text = text
+        clipboardHelper.selectAll()
+        clipboardHelper.copy()
+        clipboardHelper.text = ""
+    }
+
+    function scrollToBottom() {
+        list.stick = true
+        list.toEnd()
+    }
+
+    // Select the last occurrence of text; false when there is none.
+    function find(text, caseSensitive) {
+        var row = model.findRow(text, caseSensitive, -1)
+        if (row < 0) return false
+        var line = model.plainText(row)
+        var pos = caseSensitive ? line.lastIndexOf(text)
+                                : line.toLowerCase().lastIndexOf(text.toLowerCase())
+        list.stick = false
+        list.positionViewAtIndex(row, ListView.Center)
+        anchorRow = row; anchorPos = pos
+        endRow = row; endPos = pos + text.length
+        return true
+    }
+
+    Rectangle {
+        anchors.fill: parent
+        color: view.backgroundColor
+    }
+
+    ListView {
+        id: list
+        anchors.fill: parent
+        clip: true
+        model: view.model
+        reuseItems: true
+        boundsBehavior: Flickable.StopAtBounds
+        flickableDirection: Flickable.VerticalFlick
+        topMargin: 8; bottomMargin: 8
+
+        ScrollBar.vertical: ScrollBar { }
+
+        // Follow new lines while the newest one is in view
+        property bool stick: true
+        property bool positioning: false
+
+        function toEnd() {
+            positioning = true
+            positionViewAtEnd()
+            positioning = false
+        }
+
+        function atEnd() {
+            return contentY + height >= originY + contentHeight + bottomMargin - 20
+        }
+
+        onContentYChanged: {
+            if (positioning) return
+            stick = atEnd()
+            if (!stick && count > 0 && contentY <= originY - topMargin + 1)
+                view.reachedTop()
+        }
+        // Row heights become known as delegates are created; keep the end in view
+        onContentHeightChanged: if (stick) Qt.callLater(toEnd)
+        onCountChanged: if (stick) Qt.callLater(toEnd)
+        onHeightChanged: if (stick) Qt.callLater(toEnd)
+
+        delegate: TextEdit {
+            id: row
+            required property int index
+            required property string rowHtml
+            required property bool collapsed
+
+            width: ListView.view.width
+            height: collapsed ? 0 : implicitHeight
+            visible: !collapsed
+            leftPadding: 8; rightPadding: 8
+            readOnly: true
+            selectByMouse: false
+            activeFocusOnPress: false
+            textFormat: TextEdit.RichText
+            wrapMode: TextEdit.Wrap
+            text: collapsed ? "" : rowHtml
+            color: view.textColor
+            selectionColor: view.selectionColor
+            selectedTextColor: view.selectedTextColor
+            font.family: view.fontFamily
+            font.pixelSize: view.fontPixelSize
+
+            // This row's share of the view's selection; -1 when outside it
+            readonly property int selFrom: index < view.selFromRow || index > view.selToRow || !view.hasSelection
+                                           ? -1 : (index === view.selFromRow ? view.selFromPos : 0)
+            readonly property int selTo: selFrom < 0 ? -1 : (index === view.selToRow ? view.selToPos : length)
+
+            function applySelection() {
+                if (selFrom < 0 || selFrom === selTo) deselect()
+                else select(selFrom, selTo)
+            }
+            onSelFromChanged: applySelection()
+            onSelToChanged: applySelection()
+            onTextChanged: applySelection()
+            Component.onCompleted: applySelection()
+        }
+
+        MouseArea {
+            id: mouse
+            parent: list // over the viewport, not inside the moving content
+            anchors.fill: parent
+            acceptedButtons: Qt.LeftButton | Qt.RightButton
+            hoverEnabled: true
+            preventStealing: true // drags select text instead of flicking
+            cursorShape: hoveredLink !== "" ? Qt.PointingHandCursor : Qt.IBeamCursor
+
+            property string hoveredLink: ""
+            property bool dragged: false
+            property real lastY: 0
+
+            // Row, character position and link under a viewport point
+            function hit(mx, my) {
+                var y = Math.max(0, Math.min(height - 1, my))
+                var idx = list.indexAt(mx + list.contentX, y + list.contentY)
+                if (idx < 0) return null
+                var item = list.itemAt(mx + list.contentX, y + list.contentY)
+                if (!item) return null
+                var p = mapToItem(item, mx, y)
+                return { row: idx, pos: item.positionAt(p.x, p.y), link: item.linkAt(p.x, p.y), item: item }
+            }
+
+            function extendTo(mx, my) {
+                var h = hit(mx, my)
+                if (!h) return
+                view.endRow = h.row
+                view.endPos = h.pos
+            }
+
+            onPressed: function(event) {
+                var h = hit(event.x, event.y)
+                if (event.button === Qt.RightButton) {
+                    view.contextMenuRequested(h ? h.link : "")
+                    return
+                }
+                dragged = false
+                if (!h) {
+                    view.clearSelection()
+                    return
+                }
+                view.anchorRow = h.row; view.anchorPos = h.pos
+                view.endRow = h.row; view.endPos = h.pos
+            }
+
+            onPositionChanged: function(event) {
+                if (!(pressedButtons & Qt.LeftButton)) {
+                    var h = hit(event.x, event.y)
+                    hoveredLink = h ? h.link : ""
+                    return
+                }
+                dragged = true
+                lastY = event.y
+                extendTo(event.x, event.y)
+                if (event.y < 0 || event.y > height) edgeScroll.start()
+                else edgeScroll.stop()
+            }
+
+            onReleased: function(event) {
+                edgeScroll.stop()
+                if (event.button !== Qt.LeftButton || dragged) return
+                var h = hit(event.x, event.y)
+                view.clearSelection()
+                if (h && h.link !== "") view.linkActivated(h.link)
+            }
+
+            onDoubleClicked: function(event) {
+                var h = hit(event.x, event.y)
+                if (!h || h.link !== "") return
+                var text = h.item.getText(0, h.item.length)
+                var from = h.pos, to = h.pos
+                while (from > 0 && /\S/.test(text.charAt(from - 1))) --from
+                while (to < text.length && /\S/.test(text.charAt(to))) ++to
+                view.anchorRow = h.row; view.anchorPos = from
+                view.endRow = h.row; view.endPos = to
+                dragged = true // keep the word selected on release
+            }
+
+            // Dragging past the top or bottom edge scrolls and keeps selecting
+            Timer {
+                id: edgeScroll
+                interval: 30
+                repeat: true
+                onTriggered: {
+                    var step = mouse.lastY < 0 ? Math.max(mouse.lastY, -60) : Math.min(mouse.lastY - mouse.height, 60)
+                    var minY = list.originY - list.topMargin
+                    var maxY = Math.max(minY, list.originY + list.contentHeight + list.bottomMargin - list.height)
+                    list.contentY = Math.max(minY, Math.min(maxY, list.contentY + step))
+                    mouse.extendTo(mouse.mouseX, mouse.lastY)
+                }
+            }
+        }
+    }
+
+    // Rows inserted or removed above the selection shift its row numbers
+    Connections {
+        target: view.model
+        function onRowsInserted(parent, first, last) {
+            var n = last - first + 1
+            if (view.anchorRow >= first) view.anchorRow += n
+            if (view.endRow >= first) view.endRow += n
+        }
+        function onRowsRemoved(parent, first, last) {
+            if (view.anchorRow >= first || view.endRow >= first) view.clearSelection()
+        }
+        function onModelReset() {
+            view.clearSelection()
+            list.stick = true
+        }
+    }
+
+    Shortcut {
+        sequences: [StandardKey.Copy]
+        enabled: view.visible && view.hasSelection && view.copyShortcutEnabled
+        onActivated: view.copySelection()
+    }
+
+    // Clipboard access for QML goes through a text item
+    TextEdit {
+        id: clipboardHelper
+        visible: false
     }
 }
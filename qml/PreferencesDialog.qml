@@ -56,6 +56,7 @@ Dialog {
         spnScrollback.value         = intSetting("ui/maxScrollback", 10000)
         chkIndentWrap.checked       = boolSetting("ui/indentWrap", true)
         chkCollapseEvents.checked   = boolSetting("ui/collapseEvents", true)
+        chkVirtualChat.checked      = boolSetting("ui/virtualChatView", true)
         chkHighlighting.checked     = boolSetting("ui/textHighlighting", true)
         txtHighlightWords.text      = appSettings.value("ui/highlightWords", "")
 
@@ -124,6 +125,8 @@ Dialog {
         chkClickableUrls.checked    = boolSetting("url/clickable", true)
         chkUrlGrabber.checked       = boolSetting("url/autoGrab", true)
         chkShowInlineImages.checked = boolSetting("ui/showInlineImages", true)
+        chkSniffLinks.checked       = boolSetting("ui/sniffExtensionlessLinks", true)
+        spnImageCache.value         = intSetting("ui/imageCacheMB", 512)
         txtBrowserCmd.text          = appSettings.value("url/browserCmd", "xdg-open %s")
 
         // Advanced (tab 16)
@@ -371,6 +374,9 @@ Dialog {
                     CheckBox { id: chkCollapseEvents; text: "Collapse consecutive join/part/quit events"
                         onCheckedChanged: saveSetting("ui/collapseEvents", checked)
                         contentItem: Text { text: parent.text; color: "#ccc"; font.pixelSize: 12; leftPadding: 22 } }
+                    CheckBox { id: chkVirtualChat; text: "Row-based chat view (faster with long history; restart to apply)"
+                        onCheckedChanged: saveSetting("ui/virtualChatView", checked)
+                        contentItem: Text { text: parent.text; color: "#ccc"; font.pixelSize: 12; leftPadding: 22 } }
                     CheckBox { id: chkHighlighting; text: "Enable text highlighting"
                         onCheckedChanged: saveSetting("ui/textHighlighting", checked)
                         contentItem: Text { text: parent.text; color: "#ccc"; font.pixelSize: 12; leftPadding: 22 } }
@@ -484,7 +490,7 @@ Dialog {
                         contentItem: Text { text: parent.text; color: "#ccc"; font.pixelSize: 12; leftPadding: 22 } }
                     RowLayout {
                         spacing: 8
-                        Text { text: "Reconnect delay (seconds):"; color: "#ccc"; font.pixelSize: 12 }
+                        Text { text: "Longest reconnect delay (seconds):"; color: "#ccc"; font.pixelSize: 12 }
                         SpinBox { id: spnReconnectDelay; from: 1; to: 300; value: 10; Layout.preferredWidth: 100
                             onValueChanged: saveSetting("conn/reconnectDelay", value) }
                     }
@@ -866,6 +872,15 @@ Dialog {
                     CheckBox { id: chkShowInlineImages; text: "Show inline images from links"
                         onCheckedChanged: saveSetting("ui/showInlineImages", checked)
                         contentItem: Text { text: parent.text; color: "#ccc"; font.pixelSize: 12; leftPadding: 22 } }
+                    CheckBox { id: chkSniffLinks; text: "Check links without a file extension for images"
+                        onCheckedChanged: saveSetting("ui/sniffExtensionlessLinks", checked)
+                        contentItem: Text { text: parent.text; color: "#ccc"; font.pixelSize: 12; leftPadding: 22 } }
+                    RowLayout {
+                        spacing: 8
+                        Text { text: "Image cache size (MB):"; color: "#ccc"; font.pixelSize: 12 }
+                        SpinBox { id: spnImageCache; from: 16; to: 8192; stepSize: 16; value: 512; Layout.preferredWidth: 100
+                            onValueChanged: { saveSetting("ui/imageCacheMB", value); imgDownloader.setCacheSizeMB(value) } }
+                    }
                     RowLayout {
                         spacing: 8
                         Text { text: "Browser command:"; color: "#ccc"; font.pixelSize: 12 }
@@ -5,12 +5,49 @@ import QtQuick.Layouts 1.15
 Dialog {
     id: dlg
     title: "Search Text"
-    width: 400
-    height: 160
+    width: searchLogs.checked ? 560 : 400
+    height: searchLogs.checked ? 480 : 190
     modal: true
     anchors.centerIn: parent
 
     background: Rectangle { color: "#2b2b2b"; border.color: "#555"; border.width: 1; radius: 6 }
+    // ── Log search state (searchLogs mode) ──
+    property int requestId: 0
+    property int pageOffset: 0
+    property bool hasMore: false
+    property bool indexIncomplete: false
+    property bool searching: false
+    readonly property int pageSize: 50
+
+    function runLogSearch(offset) {
+        if (searchField.text === "") return
+        if (offset === 0) logResults.clear()
+        pageOffset = offset
+        searching = true
+        requestId = logSearch.search(currentServer, searchField.text, {
+            caseSensitive: caseSensitive.checked,
+            regex: regexSearch.checked,
+            nick: nickFilter.text,
+            channel: thisChannelOnly.checked ? currentChannel : "",
+            offset: offset,
+            limit: pageSize
+        })
+    }
+
+    Connections {
+        target: logSearch
+        function onResultsReady(id, hits, more, incomplete) {
+            if (id !== dlg.requestId) return  // superseded by a newer query
+            for (var i = 0; i < hits.length; ++i)
+                logResults.append(hits[i])
+            dlg.hasMore = more
+            dlg.indexIncomplete = incomplete
+            dlg.searching = false
+        }
+    }
+
+    ListModel { id: logResults }
+
     header: Rectangle {
         height: 36; color: "#252526"; radius: 6
         Rectangle { anchors.bottom: parent.bottom; width: parent.width; height: 6; color: "#252526" }
@@ -42,12 +79,69 @@ Dialog {
                 indicator: Rectangle { width: 16; height: 16; radius: 2; color: regexSearch.checked ? "#0e639c" : "#333"; border.color: "#555"; Text { anchors.centerIn: parent; text: regexSearch.checked ? "✓" : ""; color: "#fff"; font.pixelSize: 11 } }
                 contentItem: Text { text: " Regex"; color: "#ccc"; font.pixelSize: 12; leftPadding: regexSearch.indicator.width + 6 }
             }
+            CheckBox {
+                id: searchLogs
+                indicator: Rectangle { width: 16; height: 16; radius: 2; color: searchLogs.checked ? "#0e639c" : "#333"; border.color: "#555"; Text { anchors.centerIn: parent; text: searchLogs.checked ? "✓" : ""; color: "#fff"; font.pixelSize: 11 } }
+                contentItem: Text { text: " Search logs"; color: "#ccc"; font.pixelSize: 12; leftPadding: searchLogs.indicator.width + 6 }
+            }
             CheckBox {
                 id: searchBackwards
+                visible: !searchLogs.checked
                 indicator: Rectangle { width: 16; height: 16; radius: 2; color: searchBackwards.checked ? "#0e639c" : "#333"; border.color: "#555"; Text { anchors.centerIn: parent; text: searchBackwards.checked ? "✓" : ""; color: "#fff"; font.pixelSize: 11 } }
                 contentItem: Text { text: " Backwards"; color: "#ccc"; font.pixelSize: 12; leftPadding: searchBackwards.indicator.width + 6 }
             }
         }
+        RowLayout {
+            Layout.fillWidth: true; spacing: 12
+            visible: searchLogs.checked
+            TextField {
+                id: nickFilter; Layout.preferredWidth: 160
+                placeholderText: "From nick..."; placeholderTextColor: "#666"
+                color: "#ddd"; font.pixelSize: 12
+                background: Rectangle { color: "#333"; border.color: "#555"; radius: 2 }
+                onAccepted: findBtn.clicked()
+            }
+            CheckBox {
+                id: thisChannelOnly
+                indicator: Rectangle { width: 16; height: 16; radius: 2; color: thisChannelOnly.checked ? "#0e639c" : "#333"; border.color: "#555"; Text { anchors.centerIn: parent; text: thisChannelOnly.checked ? "✓" : ""; color: "#fff"; font.pixelSize: 11 } }
+                contentItem: Text { text: " This channel only"; color: "#ccc"; font.pixelSize: 12; leftPadding: thisChannelOnly.indicator.width + 6 }
+            }
+        }
+        Text {
+            visible: searchLogs.checked && dlg.indexIncomplete
+            Layout.fillWidth: true
+            wrapMode: Text.Wrap
+            text: "Older logs are still being indexed; some results may be missing."
+            color: "#c8a040"; font.pixelSize: 11
+        }
+        ListView {
+            id: resultsView
+            visible: searchLogs.checked
+            Layout.fillWidth: true; Layout.fillHeight: true
+            clip: true
+            model: logResults
+            ScrollBar.vertical: ScrollBar {}
+            delegate: Text {
+                width: resultsView.width
+                wrapMode: Text.Wrap
+                textFormat: Text.PlainText
+                color: "#ccc"; font.pixelSize: 12
+                text: model.timestamp + "  " + model.channel + "  " + model.text
+            }
+            footer: Button {
+                visible: dlg.hasMore
+                text: dlg.searching ? "Searching..." : "More results"
+                enabled: !dlg.searching
+                onClicked: dlg.runLogSearch(dlg.pageOffset + dlg.pageSize)
+                background: Rectangle { color: parent.down ? "#555" : "#444"; radius: 3 }
+                contentItem: Text { text: parent.text; color: "#ccc"; font.pixelSize: 12; horizontalAlignment: Text.AlignHCenter; verticalAlignment: Text.AlignVCenter }
+            }
+            Text {
+                anchors.centerIn: parent
+                visible: resultsView.count === 0 && !dlg.searching && dlg.requestId > 0
+                text: "No results"; color: "#888"; font.pixelSize: 12
+            }
+        }
         RowLayout {
             Layout.fillWidth: true; spacing: 8
             Item { Layout.fillWidth: true }
@@ -56,6 +150,16 @@ Dialog {
                 onClicked: {
                     var term = searchField.text
                     if (term === "") return
+                    if (searchLogs.checked) {
+                        dlg.runLogSearch(0)
+                        return
+                    }
+                    if (root.prefVirtualChat) {
+                        if (!chatList.find(term, caseSensitive.checked))
+                            msgModel.addMessage("system", "No results found for: " + term)
+                        dlg.close()
+                        return
+                    }
                     var allText = chatArea.text
                     var haystack = caseSensitive.checked ? allText : allText.toLowerCase()
                     var needle = caseSensitive.checked ? term : term.toLowerCase()
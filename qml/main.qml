@@ -3,6 +3,7 @@ import QtQuick.Window 2.15
 import QtQuick.Controls 2.15
 import QtQuick.Layouts 1.15
 import QtQuick.Dialogs
+import NUchat 1.0
 
 ApplicationWindow {
     id: root
@@ -71,7 +72,7 @@ ApplicationWindow {
         // When returning to the window, scroll to bottom if the user
         // wasn't intentionally scrolled up before they left.
         if (active && !root.userScrolledUpManual && chatArea) {
-            Qt.callLater(chatArea.scrollToBottom)
+            Qt.callLater(root.scrollChatToBottom)
         }
     }
 
@@ -192,7 +193,6 @@ ApplicationWindow {
     property string historyStash: ""  // stash current input when browsing history
     property string channelTopic: ircManager.channelTopic
     property string channelModes: ""
-    property var channelUsers: ircManager.channelUsers
     property var selectedNicks: []       // multi-select nick list (bare nicks, no prefix)
     property int lastClickedNickIndex: -1  // for shift-click range select
     property string selectedNick: selectedNicks.length > 0 ? selectedNicks[0] : ""  // compat: first selected
@@ -217,6 +217,54 @@ ApplicationWindow {
         return fonts[idx] || "Monospace"
     }
     property int prefFontSize: parseInt(appSettings.value("ui/fontSize", 12)) || 12
+    // Row-based chat view (ChannelView); the single TextArea is the fallback
+    property bool prefVirtualChat:     appSettings.value("ui/virtualChatView", true) === true || appSettings.value("ui/virtualChatView", true) === "true"
+
+    function scrollChatToBottom() {
+        if (prefVirtualChat) chatList.scrollToBottom()
+        else chatArea.scrollToBottom()
+        userScrolledUp = false
+        userScrolledUpManual = false
+    }
+
+    // Left click on a chat link (both chat surfaces)
+    function openChatLink(link) {
+        if (link.startsWith("nick://")) {
+            nickContextMenu.targetNick = decodeURIComponent(link.substring(7))
+            nickContextMenu.popup()
+        } else if (link.startsWith("channel://")) {
+            channelJoinMenu.targetChannel = decodeURIComponent(link.substring(10))
+            channelJoinMenu.popup()
+        } else if (link.startsWith("eventgroup://")) {
+            msgModel.toggleEventGroup(parseInt(link.substring(13)))
+        } else {
+            Qt.openUrlExternally(link)
+        }
+    }
+
+    // Right click in the chat; link is "" when not over one
+    function showChatContextMenu(link) {
+        if (link && link !== "") {
+            if (link.startsWith("nick://")) {
+                nickContextMenu.targetNick = decodeURIComponent(link.substring(7))
+                nickContextMenu.popup()
+            } else if (link.startsWith("channel://")) {
+                channelJoinMenu.targetChannel = decodeURIComponent(link.substring(10))
+                channelJoinMenu.popup()
+            } else {
+                chatLinkMenu.targetUrl = link
+                chatLinkMenu.popup()
+            }
+            return
+        }
+        // If not over nick or link, show appropriate options
+        if (currentChannel !== "" && !currentChannel.startsWith("#") && !currentChannel.startsWith("&")) {
+            queryContextMenu.targetNick = currentChannel
+            queryContextMenu.popup()
+        } else {
+            channelContextMenu.popup()
+        }
+    }
 
     // Helper: run a command for each selected nick
     function forEachSelectedNick(callback) {
@@ -236,7 +284,7 @@ ApplicationWindow {
             }
             currentServer = srv; currentChannel = entry.name
             ircManager.switchToChannel(srv, entry.name)
-            channelTopic = ircManager.channelTopic; channelUsers = ircManager.channelUsers
+            channelTopic = ircManager.channelTopic
             channelModes = ircManager.channelModes()
         } else {
             currentServer = entry.name; currentChannel = ""
@@ -252,11 +300,13 @@ ApplicationWindow {
 
     // ── Flatten tree model into a list for the sidebar ──
     ListModel { id: channelListModel }
+    property var channelRows: ({})  // { ircManager.channelKey(): row }
 
     function refreshChannelList() {
         // Cancel any in-progress drag (delegate about to be destroyed)
         if (serverTree.dragFromIndex >= 0) serverTree.cancelDrag()
         channelListModel.clear()
+        var rows = {}
         var rc = treeModel.rowCount()
         for (var i = 0; i < rc; i++) {
             var sIdx = treeModel.index(i, 0)
@@ -267,6 +317,8 @@ ApplicationWindow {
                 for (var j = 0; j < cc; j++) {
                     var cIdx = treeModel.index(j, 0, sIdx)
                     var chName = treeModel.data(cIdx)
+                    var key = ircManager.channelKey(sName, chName)
+                    if (key >= 0) rows[key] = channelListModel.count
                     channelListModel.append({
                         name: chName, entryType: "channel",
                         hasUnread: ircManager.hasUnread(sName, chName),
@@ -275,19 +327,20 @@ ApplicationWindow {
                 }
             }
         }
+        root.channelRows = rows
     }
 
-    function updateUnreadStates() {
-        var currentSrv = ""
-        for (var i = 0; i < channelListModel.count; i++) {
-            var entry = channelListModel.get(i)
-            if (entry.entryType === "server") {
-                currentSrv = entry.name
-            } else {
-                channelListModel.setProperty(i, "hasUnread", ircManager.hasUnread(currentSrv, entry.name))
-                channelListModel.setProperty(i, "hasHighlight", ircManager.hasHighlight(currentSrv, entry.name))
-            }
-        }
+    // Only the rows the manager reports as changed are touched; rows are
+    // found by the manager's key, which folds names under CASEMAPPING
+    function setChannelActivity(server, channel, unread, highlight) {
+        var i = root.channelRows[ircManager.channelKey(server, channel)]
+        if (i === undefined)
+            return  // collapsed server: refreshChannelList() picks it up
+        var entry = channelListModel.get(i)
+        if (entry.hasUnread !== unread)
+            channelListModel.setProperty(i, "hasUnread", unread)
+        if (entry.hasHighlight !== highlight)
+            channelListModel.setProperty(i, "hasHighlight", highlight)
     }
 
     Component.onCompleted: {
@@ -1031,7 +1084,6 @@ ApplicationWindow {
                                     root.currentChannel = name
                                     ircManager.switchToChannel(srvLeft, name)
                                     root.channelTopic = ircManager.channelTopic
-                                    root.channelUsers = ircManager.channelUsers
                                 } else {
                                     root.currentServer = name
                                     root.currentChannel = ""
@@ -1202,226 +1254,264 @@ ApplicationWindow {
             }
 
             // ── Message area ──
-            ScrollView {
-                id: chatScrollView
+            Item {
                 Layout.fillWidth: true
                 Layout.fillHeight: true
-                clip: true
 
-                TextArea {
-                    id: chatArea
-                    readOnly: true
-                    activeFocusOnPress: false  // never steal focus from messageInput
-                    selectByMouse: true
-                    selectedTextColor: theme.highlightText
+                ChannelView {
+                    id: chatList
+                    anchors.fill: parent
+                    visible: root.prefVirtualChat
+                    model: root.prefVirtualChat ? msgModel : null
+                    backgroundColor: theme.chatBg
+                    textColor: theme.textPrimary
                     selectionColor: theme.highlight
-                    color: theme.textPrimary
-                    font.family: root.prefFontFamily
-                    font.pixelSize: root.prefFontSize
-                    wrapMode: TextEdit.Wrap
-                    textFormat: TextEdit.RichText
-                    background: Rectangle { color: theme.chatBg }
-                    padding: 8
-
-                    onLinkActivated: function(link) {
-                        if (link.startsWith("nick://")) {
-                            var nick = decodeURIComponent(link.substring(7))
-                            nickContextMenu.targetNick = nick
-                            nickContextMenu.popup()
-                        } else if (link.startsWith("channel://")) {
-                            var ch = decodeURIComponent(link.substring(10))
-                            channelJoinMenu.targetChannel = ch
-                            channelJoinMenu.popup()
-                        } else if (link.startsWith("eventgroup://")) {
-                            var gid = parseInt(link.substring(13))
-                            var oldContentY = chatScrollView.contentItem.contentY
-                            var oldCursor = chatArea.cursorPosition
-                            var wasAtBottom = !root.userScrolledUp
-                            
-                            // Temporarily suspend auto-scrolling
-                            chatArea.pendingScrollToBottom = true
-                            
-                            msgModel.toggleEventGroup(gid)
-                            chatArea.text = msgModel.allFormattedText()
-                            chatArea.cursorPosition = oldCursor
-                            
-                            Qt.callLater(function() {
-                                if (!wasAtBottom) {
-                                    chatScrollView.contentItem.contentY = oldContentY
-                                } else {
-                                    chatArea.startScrollSettle()
-                                }
-                                chatArea.pendingScrollToBottom = false
-                            })
-                        } else {
-                            Qt.openUrlExternally(link)
-                        }
+                    selectedTextColor: theme.highlightText
+                    fontFamily: root.prefFontFamily
+                    fontPixelSize: root.prefFontSize
+                    copyShortcutEnabled: messageInput.selectedText === ""
+
+                    property bool loadingOlder: false
+
+                    onLinkActivated: function(link) { root.openChatLink(link) }
+                    onContextMenuRequested: function(link) { root.showChatContextMenu(link) }
+                    onScrolledUpChanged: {
+                        root.userScrolledUp = scrolledUp
+                        // Only mark as "manually scrolled" when the window is
+                        // focused, as for the TextArea below.
+                        if (root.active) root.userScrolledUpManual = scrolledUp
                     }
-
-                    // Change cursor to hand when hovering a link
-                    HoverHandler {
-                        cursorShape: chatArea.hoveredLink !== "" ? Qt.PointingHandCursor : Qt.IBeamCursor
+                    onReachedTop: {
+                        if (loadingOlder || currentChannel === "") return
+                        loadingOlder = true
+                        ircManager.loadOlderHistory(currentServer, currentChannel)
+                        Qt.callLater(function() { chatList.loadingOlder = false })
                     }
 
-                    // Forward typing to the message input
-                    Keys.onPressed: function(event) {
-                        if (event.modifiers & Qt.ControlModifier) return
-                        if (event.modifiers & Qt.AltModifier) return
-                        if (event.text && event.text.length > 0) {
-                            messageInput.forceActiveFocus()
-                            messageInput.text += event.text
-                            messageInput.cursorPosition = messageInput.text.length
-                            event.accepted = true
-                        }
+                    Connections {
+                        target: root.prefVirtualChat ? msgModel : null
+                        function onReloaded() { chatList.scrollToBottom() }
                     }
+                }
 
-                    TapHandler {
-                        acceptedButtons: Qt.RightButton
-                        onTapped: function(eventPoint) {
-                            var px = eventPoint.position.x
-                            var py = eventPoint.position.y
-
-                            // Check for link under cursor first
-                            var link = chatArea.linkAt(px, py)
-                            if (link && link !== "") {
-                                if (link.startsWith("nick://")) {
-                                    nickContextMenu.targetNick = decodeURIComponent(link.substring(7))
-                                    nickContextMenu.popup()
-                                } else if (link.startsWith("channel://")) {
-                                    channelJoinMenu.targetChannel = decodeURIComponent(link.substring(10))
-                                    channelJoinMenu.popup()
-                                } else {
-                                    chatLinkMenu.targetUrl = link
-                                    chatLinkMenu.popup()
-                                }
-                                return
-                            }
+                ScrollView {
+                    id: chatScrollView
+                    anchors.fill: parent
+                    visible: !root.prefVirtualChat
+                    clip: true
 
-                            // If not over nick or link, show appropriate options
-                            if (currentChannel !== "" && !currentChannel.startsWith("#") && !currentChannel.startsWith("&")) {
-                                queryContextMenu.targetNick = currentChannel
-                                queryContextMenu.popup()
+                    TextArea {
+                        id: chatArea
+                        readOnly: true
+                        activeFocusOnPress: false  // never steal focus from messageInput
+                        selectByMouse: true
+                        selectedTextColor: theme.highlightText
+                        selectionColor: theme.highlight
+                        color: theme.textPrimary
+                        font.family: root.prefFontFamily
+                        font.pixelSize: root.prefFontSize
+                        wrapMode: TextEdit.Wrap
+                        textFormat: TextEdit.RichText
+                        background: Rectangle { color: theme.chatBg }
+                        padding: 8
+
+                        onLinkActivated: function(link) {
+                            if (link.startsWith("eventgroup://")) {
+                                var oldContentY = chatScrollView.contentItem.contentY
+                                var wasAtBottom = !root.userScrolledUp
+                                
+                                // Temporarily suspend auto-scrolling
+                                chatArea.pendingScrollToBottom = true
+                                
+                                // chatDoc redoes the group's lines in place
+                                root.openChatLink(link)
+                                
+                                Qt.callLater(function() {
+                                    if (!wasAtBottom) {
+                                        chatScrollView.contentItem.contentY = oldContentY
+                                    } else {
+                                        chatArea.startScrollSettle()
+                                    }
+                                    chatArea.pendingScrollToBottom = false
+                                })
                             } else {
-                                channelContextMenu.popup()
+                                root.openChatLink(link)
                             }
                         }
-                    }
 
-                    Connections {
-                        target: msgModel
-                        function onMessageAdded(formattedLine) {
-                            // Live incoming message — fast single-line append
-                            chatArea.append(formattedLine)
-                            if (!root.userScrolledUp) {
-                                chatArea.startScrollSettle()
+                        // Change cursor to hand when hovering a link
+                        HoverHandler {
+                            cursorShape: chatArea.hoveredLink !== "" ? Qt.PointingHandCursor : Qt.IBeamCursor
+                        }
+
+                        // Forward typing to the message input
+                        Keys.onPressed: function(event) {
+                            if (event.modifiers & Qt.ControlModifier) return
+                            if (event.modifiers & Qt.AltModifier) return
+                            if (event.text && event.text.length > 0) {
+                                messageInput.forceActiveFocus()
+                                messageInput.text += event.text
+                                messageInput.cursorPosition = messageInput.text.length
+                                event.accepted = true
                             }
                         }
-                        function onCleared() {
-                            chatArea.text = ""
+
+                        TapHandler {
+                            acceptedButtons: Qt.RightButton
+                            onTapped: function(eventPoint) {
+                                root.showChatContextMenu(chatArea.linkAt(eventPoint.position.x,
+                                                                         eventPoint.position.y))
+                            }
                         }
-                        function onReloaded() {
-                            var fullText = msgModel.allFormattedText()
-                            // Channel switch: set entire text in one shot.
-                            chatArea.text = fullText
-                            // Immediately position cursor at end — prevents Qt's
-                            // internal ensureVisible(0) from scrolling to top
-                            // after the text assignment resets cursorPosition.
-                            chatArea.cursorPosition = chatArea.length
-                            root.userScrolledUp = false
-                            chatArea.startScrollSettle()
+
+                        // Mirrors msgModel into the document block by block:
+                        // appends, in-place event-group updates and trimming
+                        // to the scrollback limit, never a full-text reload.
+                        ChatDocument {
+                            id: chatDoc
+                            textDocument: chatArea.textDocument
+                            model: root.prefVirtualChat ? null : msgModel
+                            maxLines: parseInt(appSettings.value("ui/maxScrollback", 10000)) || 10000
+                        }
+
+                        // Only while the TextArea is the chat surface
+                        Connections {
+                            target: root.prefVirtualChat ? null : msgModel
+                            function onMessageAdded(formattedLine) {
+                                // chatDoc has appended the line already
+                                if (!root.userScrolledUp) {
+                                    chatArea.startScrollSettle()
+                                }
+                            }
+                            function onReloaded() {
+                                // Channel switch: position cursor at end — prevents
+                                // Qt's internal ensureVisible(0) from scrolling to top.
+                                chatArea.cursorPosition = chatArea.length
+                                root.userScrolledUp = false
+                                chatArea.startScrollSettle()
+                            }
+                            function onRowsAboutToBeInserted(parent, first, last) {
+                                if (first >= msgModel.rowCount()) return
+                                // Older log lines are about to go in above the viewport
+                                var f = chatScrollView.contentItem
+                                chatArea.prependHeight = f.contentHeight
+                                chatArea.prependContentY = f.contentY
+                                chatArea.pendingScrollToBottom = true
+                            }
+                            function onOlderMessagesPrepended(count) {
+                                // Keep the lines the user is reading in place
+                                var f = chatScrollView.contentItem
+                                Qt.callLater(function() {
+                                    f.contentY = chatArea.prependContentY + (f.contentHeight - chatArea.prependHeight)
+                                    chatArea.pendingScrollToBottom = false
+                                })
+                            }
                         }
-                    }
 
-                    // True while a channel-switch text load or live append is
-                    // still being laid out.  Cleared by scrollSettleTimer once
-                    // content height has been stable long enough.
-                    property bool pendingScrollToBottom: false
+                        property real prependHeight: 0
+                        property real prependContentY: 0
 
-                    // Keep scrolling on every contentHeight change while pending.
-                    onContentHeightChanged: {
-                        if (pendingScrollToBottom) {
-                            scrollToBottom()
+                        // True while loadOlderHistory() is paging in a batch
+                        property bool loadingOlder: false
+
+                        // True while a channel-switch text load or live append is
+                        // still being laid out.  Cleared by scrollSettleTimer once
+                        // content height has been stable long enough.
+                        property bool pendingScrollToBottom: false
+
+                        // Keep scrolling on every contentHeight change while pending.
+                        onContentHeightChanged: {
+                            if (pendingScrollToBottom) {
+                                scrollToBottom()
+                            }
                         }
-                    }
 
-                    // Repeating timer: polls every 50 ms and forces scroll to
-                    // bottom until the content height has been stable for 500 ms
-                    // (10 consecutive ticks).  This is far more reliable than a
-                    // one-shot timer because Qt's rich-text engine can finish
-                    // layout across multiple event-loop iterations without
-                    // emitting intermediate contentHeight changes.
-                    Timer {
-                        id: scrollSettleTimer
-                        interval: 50
-                        repeat: true
-                        property int stableCount: 0
-                        property real lastHeight: -1
-                        onTriggered: {
-                            chatArea.scrollToBottom()
-                            var f = chatScrollView.contentItem
-                            if (Math.abs(f.contentHeight - lastHeight) < 1) {
-                                stableCount++
-                                if (stableCount >= 10) { // stable for 500 ms
-                                    chatArea.pendingScrollToBottom = false
+                        // Repeating timer: polls every 50 ms and forces scroll to
+                        // bottom until the content height has been stable for 500 ms
+                        // (10 consecutive ticks).  This is far more reliable than a
+                        // one-shot timer because Qt's rich-text engine can finish
+                        // layout across multiple event-loop iterations without
+                        // emitting intermediate contentHeight changes.
+                        Timer {
+                            id: scrollSettleTimer
+                            interval: 50
+                            repeat: true
+                            property int stableCount: 0
+                            property real lastHeight: -1
+                            onTriggered: {
+                                chatArea.scrollToBottom()
+                                var f = chatScrollView.contentItem
+                                if (Math.abs(f.contentHeight - lastHeight) < 1) {
+                                    stableCount++
+                                    if (stableCount >= 10) { // stable for 500 ms
+                                        chatArea.pendingScrollToBottom = false
+                                        stableCount = 0
+                                        lastHeight = -1
+                                        stop()
+                                    }
+                                } else {
                                     stableCount = 0
-                                    lastHeight = -1
-                                    stop()
+                                    lastHeight = f.contentHeight
                                 }
-                            } else {
-                                stableCount = 0
-                                lastHeight = f.contentHeight
                             }
                         }
-                    }
 
-                    function startScrollSettle() {
-                        pendingScrollToBottom = true
-                        scrollSettleTimer.stableCount = 0
-                        scrollSettleTimer.lastHeight = -1
-                        scrollToBottom()
-                        scrollSettleTimer.restart()
-                    }
+                        function startScrollSettle() {
+                            pendingScrollToBottom = true
+                            scrollSettleTimer.stableCount = 0
+                            scrollSettleTimer.lastHeight = -1
+                            scrollToBottom()
+                            scrollSettleTimer.restart()
+                        }
 
-                    // Scroll the Flickable to the absolute bottom.  Uses both
-                    // contentY (immediate) and cursorPosition (tells Qt's
-                    // internal layout to make the end visible).
-                    function scrollToBottom() {
-                        var f = chatScrollView.contentItem
-                        f.contentY = Math.max(0, f.contentHeight - f.height)
-                        // Position cursor at end so Qt keeps the bottom
-                        // visible, but preserve messageInput focus — on some
-                        // Qt builds setting cursorPosition grabs activeFocus.
-                        var hadInputFocus = messageInput.activeFocus
-                        chatArea.cursorPosition = chatArea.length
-                        if (hadInputFocus) messageInput.forceActiveFocus()
-                        root.userScrolledUp = false
-                        root.userScrolledUpManual = false
-                    }
+                        // Scroll the Flickable to the absolute bottom.  Uses both
+                        // contentY (immediate) and cursorPosition (tells Qt's
+                        // internal layout to make the end visible).
+                        function scrollToBottom() {
+                            var f = chatScrollView.contentItem
+                            f.contentY = Math.max(0, f.contentHeight - f.height)
+                            // Position cursor at end so Qt keeps the bottom
+                            // visible, but preserve messageInput focus — on some
+                            // Qt builds setting cursorPosition grabs activeFocus.
+                            var hadInputFocus = messageInput.activeFocus
+                            chatArea.cursorPosition = chatArea.length
+                            if (hadInputFocus) messageInput.forceActiveFocus()
+                            root.userScrolledUp = false
+                            root.userScrolledUpManual = false
+                        }
 
-                    Component.onCompleted: {
-                        text = msgModel.allFormattedText()
-                        cursorPosition = length
-                        startScrollSettle()
+                        Component.onCompleted: {
+                            if (root.prefVirtualChat) return
+                            cursorPosition = length
+                            startScrollSettle()
+                        }
                     }
-                }
 
-                // ── Scroll position tracking ──
-                Connections {
-                    target: chatScrollView.contentItem
-                    function onContentYChanged() {
-                        // During a reload/channel-switch, ignore contentY
-                        // changes — the layout is still settling and these
-                        // intermediate positions are not user-initiated scrolls.
-                        if (chatArea.pendingScrollToBottom) return
-
-                        var f = chatScrollView.contentItem
-                        var atBottom = (f.contentY + f.height) >= (f.contentHeight - 20)
-                        root.userScrolledUp = !atBottom
-                        // Only mark as "manually scrolled" when the window
-                        // is focused — prevents false positives from content
-                        // growing while tabbed away.
-                        if (root.active) {
-                            root.userScrolledUpManual = !atBottom
+                    // ── Scroll position tracking ──
+                    Connections {
+                        target: chatScrollView.contentItem
+                        function onContentYChanged() {
+                            // During a reload/channel-switch, ignore contentY
+                            // changes — the layout is still settling and these
+                            // intermediate positions are not user-initiated scrolls.
+                            if (chatArea.pendingScrollToBottom) return
+
+                            var f = chatScrollView.contentItem
+                            var atBottom = (f.contentY + f.height) >= (f.contentHeight - 20)
+                            root.userScrolledUp = !atBottom
+                            // Only mark as "manually scrolled" when the window
+                            // is focused — prevents false positives from content
+                            // growing while tabbed away.
+                            if (root.active) {
+                                root.userScrolledUpManual = !atBottom
+                            }
+                            // Reached the top: page older history in from the log
+                            if (f.contentY <= 0 && root.userScrolledUpManual &&
+                                    !chatArea.loadingOlder && currentChannel !== "") {
+                                chatArea.loadingOlder = true
+                                ircManager.loadOlderHistory(currentServer, currentChannel)
+                                Qt.callLater(function() { chatArea.loadingOlder = false })
+                            }
                         }
                     }
                 }
@@ -1449,7 +1539,7 @@ ApplicationWindow {
 
                     MouseArea {
                         anchors.fill: parent; cursorShape: Qt.PointingHandCursor
-                        onClicked: chatArea.scrollToBottom()
+                        onClicked: root.scrollChatToBottom()
                     }
                 }
             }
@@ -1584,7 +1674,7 @@ ApplicationWindow {
 
                         Keys.onTabPressed: function(event) {
                             event.accepted = true
-                            if (!channelUsers || channelUsers.length === 0) return
+                            if (ircManager.nickList.count === 0) return
                             var txt = messageInput.text
                             var curPos = messageInput.cursorPosition
 
@@ -1605,14 +1695,7 @@ ApplicationWindow {
                                 messageInput.tabPrefix = partial
                                 messageInput.tabWordStart = wordStart
                                 messageInput.tabIndex = 0
-                                var matches = []
-                                var lp = partial.toLowerCase()
-                                for (var i = 0; i < channelUsers.length; i++) {
-                                    var nick = channelUsers[i].replace(/^[@%+~&]/, '')
-                                    if (nick.toLowerCase().indexOf(lp) === 0)
-                                        matches.push(nick)
-                                }
-                                messageInput.tabMatches = matches
+                                messageInput.tabMatches = ircManager.nickList.completions(partial)
                             } else {
                                 messageInput.tabIndex = (messageInput.tabIndex + 1) % messageInput.tabMatches.length
                             }
@@ -1784,7 +1867,7 @@ ApplicationWindow {
                     color: theme.nickListHeaderBg
                     Text {
                         anchors.centerIn: parent
-                        text: channelUsers ? channelUsers.length + " USERS" : "USERS"
+                        text: ircManager.nickList.count + " USERS"
                         color: theme.textMuted
                         font.pixelSize: 10
                         font.bold: true
@@ -1805,14 +1888,16 @@ ApplicationWindow {
                     Layout.fillHeight: true
                     clip: true
                     boundsBehavior: Flickable.StopAtBounds
-                    model: channelUsers || []
+                    model: ircManager.nickList
 
                     delegate: Rectangle {
                         required property int index
-                        required property string modelData
+                        required property string display
+                        required property string nick
+                        required property string prefix
                         width: nickList.width
                         height: 22
-                        property string bareN: modelData.replace(/^[@%+~&]/, '')
+                        property string bareN: nick
                         property bool isSelected: root.selectedNicks.indexOf(bareN) !== -1
                         color: isSelected ? theme.highlight : (nickMouse.containsMouse ? theme.hoverBg : "transparent")
 
@@ -1820,14 +1905,14 @@ ApplicationWindow {
                             anchors.left: parent.left
                             anchors.leftMargin: 8
                             anchors.verticalCenter: parent.verticalCenter
-                            text: modelData
+                            text: display
                             color: {
                                 // Color by prefix: @ = op, + = voice, % = halfop
-                                if (modelData.startsWith("@")) return theme.nickOp
-                                if (modelData.startsWith("%")) return theme.nickHalfOp
-                                if (modelData.startsWith("+")) return theme.nickVoice
-                                if (modelData.startsWith("~")) return theme.nickOwner
-                                if (modelData.startsWith("&")) return theme.nickAdmin
+                                if (prefix === "@") return theme.nickOp
+                                if (prefix === "%") return theme.nickHalfOp
+                                if (prefix === "+") return theme.nickVoice
+                                if (prefix === "~") return theme.nickOwner
+                                if (prefix === "&") return theme.nickAdmin
                                 return theme.nickNormal
                             }
                             font.pixelSize: 12
@@ -1852,14 +1937,13 @@ ApplicationWindow {
                                         root.selectedNicks = sel
                                     } else if (mouse.modifiers & Qt.ShiftModifier) {
                                         // Shift+click: range select from last clicked
-                                        var users = channelUsers || []
                                         var from = root.lastClickedNickIndex
                                         var to = index
                                         if (from < 0) from = to
                                         var lo = Math.min(from, to), hi = Math.max(from, to)
                                         // keep existing selection from ctrl, add range
                                         for (var r = lo; r <= hi; r++) {
-                                            var rn = root.bareNick(users[r])
+                                            var rn = ircManager.nickList.nickAt(r)
                                             if (sel.indexOf(rn) === -1) sel.push(rn)
                                         }
                                         root.selectedNicks = sel
@@ -2185,15 +2269,19 @@ ApplicationWindow {
         historyStash = ""
         var target = currentChannel !== "" ? currentChannel : (currentServer !== "" ? currentServer : "")
         var lines = txt.split(/\r?\n/)
+        var outgoing = []
         for (var i = 0; i < lines.length; i++) {
             var line = lines[i]
             if (line === "") continue
-            if (line.startsWith("/")) {
-                ircManager.sendMessage(target, line)
-            } else if (currentChannel !== "") {
-                ircManager.sendMessage(currentChannel, line)
-            }
+            // Plain text needs a channel; commands go to the server tab too
+            if (line.startsWith("/") || currentChannel !== "")
+                outgoing.push(line)
         }
+        // A paste goes out on the bulk lane, behind anything typed later
+        if (outgoing.length > 1)
+            ircManager.sendMessages(target, outgoing)
+        else if (outgoing.length === 1)
+            ircManager.sendMessage(target, outgoing[0])
         messageInput.text = ""
         messageInput.forceActiveFocus()
     }
@@ -2315,8 +2403,8 @@ ApplicationWindow {
                 }
             }
         }
-        function onUnreadStateChanged() {
-            updateUnreadStates()
+        function onChannelActivityChanged(server, channel, unread, highlight) {
+            setChannelActivity(server, channel, unread, highlight)
         }
         function onCurrentNickChanged(nick) {
             // Could update a nick display somewhere
@@ -2324,9 +2412,6 @@ ApplicationWindow {
         function onChannelTopicChanged(topic) {
             root.channelTopic = topic
         }
-        function onChannelUsersChanged(users) {
-            root.channelUsers = users
-        }
         function onChannelModesChanged(modes) {
             root.channelModes = modes
         }
@@ -0,0 +1,27 @@
+#include "ChangeAggregator.h"
+
+ChangeAggregator::ChangeAggregator(QObject *parent) : QObject(parent) {
+  m_timer.setSingleShot(true);
+  m_timer.setTimerType(Qt::PreciseTimer);
+  m_timer.setInterval(kFrameMs);
+  connect(&m_timer, &QTimer::timeout, this, &ChangeAggregator::flush);
+}
+
+void ChangeAggregator::mark(int channel, Changes changes) {
+  if (channel < 0 || !changes)
+    return;
+  m_dirty[channel] |= changes;
+  // Not restarted by later marks: the first one decides when the frame ends
+  if (!m_timer.isActive())
+    m_timer.start();
+}
+
+void ChangeAggregator::flush() {
+  m_timer.stop();
+  if (m_dirty.isEmpty())
+    return;
+  // Marks made by receivers land in the next frame
+  QHash<int, Changes> changes;
+  changes.swap(m_dirty);
+  emit flushed(changes);
+}
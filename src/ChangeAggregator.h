@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+
+// Collects "this channel changed" marks and hands them over at most once
+// per display frame, so a burst of traffic costs the UI one update per
+// dirty channel instead of one per message.
+class ChangeAggregator : public QObject {
+  Q_OBJECT
+public:
+  enum Change {
+    Activity = 0x1, // unread / highlight state
+    Users = 0x2     // member list
+  };
+  Q_DECLARE_FLAGS(Changes, Change)
+
+  static constexpr int kFrameMs = 16;
+
+  explicit ChangeAggregator(QObject *parent = nullptr);
+
+  void mark(int channel, Changes changes);
+  bool isPending() const { return !m_dirty.isEmpty(); }
+  // Delivers pending changes now instead of at the end of the frame
+  void flush();
+
+signals:
+  // Channel id → everything marked for it since the last flush
+  void flushed(const QHash<int, ChangeAggregator::Changes> &changes);
+
+private:
+  QHash<int, Changes> m_dirty;
+  QTimer m_timer;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(ChangeAggregator::Changes)
@@ -0,0 +1,207 @@
+#include "ChannelHistory.h"
+
+#include <QDateTime>
+
+namespace {
+
+// Text block size in characters; longer lines get a block of their own
+constexpr qsizetype kBlockChars = 8192;
+
+// Value of the n digits at pos, or -1
+int digits(QStringView text, int pos, int n) {
+  int v = 0;
+  for (int i = pos; i < pos + n; ++i) {
+    const char16_t c = text.at(i).unicode();
+    if (c < u'0' || c > u'9')
+      return -1;
+    v = v * 10 + (c - u'0');
+  }
+  return v;
+}
+
+} // namespace
+
+// ── Types and timestamps ──
+
+ChannelHistory::Type ChannelHistory::typeFromName(QStringView name) {
+  if (name == QLatin1String("system"))
+    return Type::System;
+  if (name == QLatin1String("action"))
+    return Type::Action;
+  if (name == QLatin1String("error"))
+    return Type::Error;
+  if (name == QLatin1String("embed"))
+    return Type::Embed;
+  return Type::Chat;
+}
+
+QString ChannelHistory::typeName(Type type) {
+  switch (type) {
+  case Type::Action:
+    return QStringLiteral("action");
+  case Type::System:
+    return QStringLiteral("system");
+  case Type::Error:
+    return QStringLiteral("error");
+  case Type::Embed:
+    return QStringLiteral("embed");
+  case Type::Chat:
+    break;
+  }
+  return QStringLiteral("chat");
+}
+
+qint64 ChannelHistory::parseTimestamp(QStringView text) {
+  // Fast path for the two shapes we write ourselves
+  if (text.size() == 19 && text.at(4) == u'-' && text.at(7) == u'-' &&
+      (text.at(10) == u'T' || text.at(10) == u' ') && text.at(13) == u':' &&
+      text.at(16) == u':') {
+    const QDate date(digits(text, 0, 4), digits(text, 5, 2),
+                     digits(text, 8, 2));
+    const QTime time(digits(text, 11, 2), digits(text, 14, 2),
+                     digits(text, 17, 2));
+    const QDateTime dt(date, time);
+    return dt.isValid() ? dt.toMSecsSinceEpoch() : 0;
+  }
+  if (text.isEmpty())
+    return 0;
+  const QDateTime dt = QDateTime::fromString(text.toString(), Qt::ISODate);
+  return dt.isValid() ? dt.toMSecsSinceEpoch() : 0;
+}
+
+QString ChannelHistory::formatTimestamp(qint64 msecs) {
+  if (msecs == 0)
+    return QString();
+  return QDateTime::fromMSecsSinceEpoch(msecs).toString(Qt::ISODate);
+}
+
+// ── Storage ──
+
+ChannelHistory::ChannelHistory(int capacity) : m_capacity(qMax(1, capacity)) {}
+
+void ChannelHistory::grow() {
+  const int size = qMin(m_capacity, qMax(16, int(m_ring.size()) * 2));
+  QVector<Record> ring;
+  ring.reserve(size);
+  for (int i = 0; i < m_count; ++i)
+    ring.append(record(i));
+  ring.resize(size);
+  m_ring = std::move(ring);
+  m_head = 0;
+}
+
+ChannelHistory::Record ChannelHistory::store(Type type, QStringView text,
+                                             qint64 timestamp, bool front) {
+  const qsizetype length = text.size();
+  // Never write past a block's reserved capacity: the text must not move
+  // while views into it are out.
+  const auto fits = [length](const Block &b) {
+    return b.text.size() + length <= b.text.capacity();
+  };
+  const auto fresh = [length] {
+    Block b;
+    b.text.reserve(qMax(kBlockChars, length));
+    return b;
+  };
+  int seq;
+  if (front) {
+    if (m_blocks.isEmpty() || !fits(m_blocks.first())) {
+      m_blocks.prepend(fresh());
+      --m_firstBlock;
+    }
+    seq = m_firstBlock;
+  } else {
+    if (m_blocks.isEmpty() || !fits(m_blocks.last()))
+      m_blocks.append(fresh());
+    seq = m_firstBlock + int(m_blocks.size()) - 1;
+  }
+  Block &b = m_blocks[seq - m_firstBlock];
+  Record r;
+  r.timestamp = timestamp;
+  r.block = seq;
+  r.offset = quint32(b.text.size());
+  r.length = quint32(length);
+  r.type = type;
+  b.text.append(text);
+  ++b.live;
+  return r;
+}
+
+void ChannelHistory::popFront() {
+  const Record r = record(0);
+  m_head = (m_head + 1) % m_ring.size();
+  --m_count;
+  --m_blocks[r.block - m_firstBlock].live;
+  while (!m_blocks.isEmpty() && m_blocks.first().live == 0) {
+    m_blocks.removeFirst();
+    ++m_firstBlock;
+  }
+}
+
+void ChannelHistory::append(Type type, QStringView text, qint64 timestamp) {
+  if (m_count == m_capacity)
+    popFront();
+  if (m_count == m_ring.size())
+    grow();
+  const Record r = store(type, text, timestamp, false);
+  m_ring[(m_head + m_count) % m_ring.size()] = r;
+  ++m_count;
+}
+
+int ChannelHistory::insertOlder(int at, const QVector<Line> &lines) {
+  const int n = qMin(m_capacity - m_count, int(lines.size()));
+  if (n <= 0)
+    return 0;
+  at = qBound(0, at, m_count);
+
+  // Lift the lines in front of the insertion point off, push the new ones
+  // and put the lifted ones back on top; only the front of the ring moves.
+  QVector<Line> lifted;
+  lifted.reserve(at);
+  for (int i = 0; i < at; ++i)
+    lifted.append(this->at(i));
+  for (int i = 0; i < at; ++i)
+    popFront();
+  while (m_ring.size() < m_count + n + at)
+    grow();
+
+  const auto pushFront = [this](const Line &line) {
+    const Record r = store(line.type, line.text, line.timestamp, true);
+    m_head = (m_head - 1 + int(m_ring.size())) % int(m_ring.size());
+    m_ring[m_head] = r;
+    ++m_count;
+  };
+  for (int i = int(lines.size()) - 1; i >= int(lines.size()) - n; --i)
+    pushFront(lines.at(i));
+  for (int i = at - 1; i >= 0; --i)
+    pushFront(lifted.at(i));
+  return n;
+}
+
+void ChannelHistory::clear() {
+  m_ring.clear();
+  m_head = 0;
+  m_count = 0;
+  m_blocks.clear();
+  m_firstBlock = 0;
+}
+
+// ── Access ──
+
+QStringView ChannelHistory::textAt(int i) const {
+  const Record &r = record(i);
+  return QStringView(m_blocks.at(r.block - m_firstBlock).text)
+      .mid(r.offset, r.length);
+}
+
+ChannelHistory::Line ChannelHistory::at(int i) const {
+  const Record &r = record(i);
+  return {r.type, textAt(i).toString(), r.timestamp};
+}
+
+qsizetype ChannelHistory::textCapacity() const {
+  qsizetype total = 0;
+  for (const Block &b : m_blocks)
+    total += b.text.capacity();
+  return total;
+}
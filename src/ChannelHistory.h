@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QVector>
+
+// Bounded scrollback of one channel.
+//
+// Lines are fixed-size records (type, timestamp, where the text is) in a
+// ring that grows up to the capacity and then evicts the oldest line in
+// O(1).  The text is packed into shared UTF-16 blocks rather than one
+// QString per line; a block is released once every line in it has been
+// evicted, so a full history costs about capacity * sizeof(record) plus the
+// live text and at most one partly dead block at either end.
+class ChannelHistory {
+public:
+  // Unknown type names are stored as Chat, which is how MessageModel
+  // renders them anyway.
+  enum class Type : quint8 { Chat, Action, System, Error, Embed };
+  static Type typeFromName(QStringView name);
+  static QString typeName(Type type);
+
+  // Timestamps are milliseconds since the epoch, 0 when unknown.  Parses
+  // ISO dates with a 'T' or a space ("yyyy-MM-dd HH:mm:ss" in the logs) as
+  // local time; formatTimestamp(0) is empty.
+  static qint64 parseTimestamp(QStringView text);
+  static QString formatTimestamp(qint64 msecs);
+
+  struct Line {
+    Type type = Type::Chat;
+    QString text;
+    qint64 timestamp = 0;
+  };
+
+  explicit ChannelHistory(int capacity = 5000);
+
+  int capacity() const { return m_capacity; }
+  int size() const { return m_count; }
+  bool isEmpty() const { return m_count == 0; }
+
+  // Newest line at the end; drops the oldest line when full.
+  void append(Type type, QStringView text, qint64 timestamp);
+  // Inserts older lines, oldest first, in front of line `at` (which is
+  // meant to be 0 or a header or two).  Only what fits in the free room
+  // is kept — the oldest of `lines` are dropped first.  Returns the count
+  // inserted.
+  int insertOlder(int at, const QVector<Line> &lines);
+  void clear();
+
+  // Views stay valid until the history is next modified.
+  Type typeAt(int i) const { return record(i).type; }
+  QStringView textAt(int i) const;
+  qint64 timestampAt(int i) const { return record(i).timestamp; }
+  Line at(int i) const;
+
+  // Characters held in text blocks, live or not
+  qsizetype textCapacity() const;
+
+private:
+  struct Record {
+    qint64 timestamp;
+    int block; // block sequence number
+    quint32 offset;
+    quint32 length;
+    Type type;
+  };
+  struct Block {
+    QString text;
+    int live = 0;
+  };
+
+  const Record &record(int i) const {
+    return m_ring.at((m_head + i) % m_ring.size());
+  }
+  Record store(Type type, QStringView text, qint64 timestamp, bool front);
+  void popFront();
+  void grow();
+
+  int m_capacity;
+  QVector<Record> m_ring;
+  int m_head = 0;
+  int m_count = 0;
+  // Block order follows line order, so blocks free from the front
+  QList<Block> m_blocks;
+  int m_firstBlock = 0;
+};
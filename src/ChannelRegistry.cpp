@@ -0,0 +1,130 @@
+#include "ChannelRegistry.h"
+
+ChannelRegistry::CaseMapping
+ChannelRegistry::caseMappingFromName(QStringView name) {
+  if (name.compare(QLatin1String("ascii"), Qt::CaseInsensitive) == 0)
+    return CaseMapping::Ascii;
+  if (name.compare(QLatin1String("strict-rfc1459"), Qt::CaseInsensitive) == 0)
+    return CaseMapping::StrictRfc1459;
+  return CaseMapping::Rfc1459;
+}
+
+QChar ChannelRegistry::fold(QChar c, CaseMapping mapping) {
+  const char16_t u = c.unicode();
+  if (u >= u'A' && u <= u'Z')
+    return QChar(char16_t(u + 32));
+  if (mapping == CaseMapping::Ascii)
+    return c;
+  switch (u) {
+  case u'[':
+    return QChar(u'{');
+  case u']':
+    return QChar(u'}');
+  case u'\\':
+    return QChar(u'|');
+  case u'~':
+    return mapping == CaseMapping::Rfc1459 ? QChar(u'^') : c;
+  default:
+    return c;
+  }
+}
+
+QString ChannelRegistry::fold(QStringView text, CaseMapping mapping) {
+  QString out(text.size(), Qt::Uninitialized);
+  QChar *d = out.data();
+  for (const QChar c : text)
+    *d++ = fold(c, mapping);
+  return out;
+}
+
+// ── Lookup ──
+
+int ChannelRegistry::serverIndex(const QString &server) const {
+  const auto it = m_serverBySpelling.constFind(server);
+  if (it != m_serverBySpelling.constEnd())
+    return it.value();
+  const int index = m_serverByFolded.value(server.toCaseFolded(), -1);
+  if (index >= 0)
+    m_serverBySpelling.insert(server, index);
+  return index;
+}
+
+int ChannelRegistry::channelId(const Server &s, const QString &channel) const {
+  const auto it = s.bySpelling.constFind(channel);
+  if (it != s.bySpelling.constEnd())
+    return it.value();
+  const int id = s.byFolded.value(fold(channel, s.mapping), -1);
+  if (id >= 0)
+    s.bySpelling.insert(channel, id);
+  return id;
+}
+
+int ChannelRegistry::find(const QString &server, const QString &channel) const {
+  const int index = serverIndex(server);
+  return index < 0 ? -1 : channelId(m_servers.at(index), channel);
+}
+
+int ChannelRegistry::intern(const QString &server, const QString &channel) {
+  int index = serverIndex(server);
+  if (index < 0) {
+    index = m_servers.size();
+    Server s;
+    s.name = server;
+    m_servers.append(s);
+    m_serverByFolded.insert(server.toCaseFolded(), index);
+    m_serverBySpelling.insert(server, index);
+  }
+  Server &s = m_servers[index];
+  int id = channelId(s, channel);
+  if (id < 0) {
+    id = m_entries.size();
+    m_entries.append({index, channel});
+    s.byFolded.insert(fold(channel, s.mapping), id);
+    s.bySpelling.insert(channel, id);
+  }
+  return id;
+}
+
+const QString &ChannelRegistry::serverName(int id) const {
+  return m_servers.at(m_entries.at(id).server).name;
+}
+
+const QString &ChannelRegistry::channelName(int id) const {
+  return m_entries.at(id).channel;
+}
+
+bool ChannelRegistry::isOnServer(int id, const QString &server) const {
+  return m_entries.at(id).server == serverIndex(server);
+}
+
+// ── Case mapping ──
+
+void ChannelRegistry::setCaseMapping(const QString &server,
+                                     CaseMapping mapping) {
+  int index = serverIndex(server);
+  if (index < 0) {
+    // Nothing interned yet: remember the mapping for when there is
+    intern(server, server);
+    index = serverIndex(server);
+  }
+  Server &s = m_servers[index];
+  if (s.mapping == mapping)
+    return;
+  s.mapping = mapping;
+  s.byFolded.clear();
+  s.bySpelling.clear();
+  for (int id = 0; id < m_entries.size(); ++id) {
+    const Entry &e = m_entries.at(id);
+    if (e.server != index)
+      continue;
+    const QString folded = fold(e.channel, mapping);
+    if (!s.byFolded.contains(folded))
+      s.byFolded.insert(folded, id);
+  }
+}
+
+ChannelRegistry::CaseMapping
+ChannelRegistry::caseMapping(const QString &server) const {
+  const int index = serverIndex(server);
+  return index < 0 ? CaseMapping::Rfc1459 : m_servers.at(index).mapping;
+}
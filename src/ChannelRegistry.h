@@ -0,0 +1,58 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+// Small integer ids for (server, channel) pairs.
+//
+// Channel names are compared under the CASEMAPPING the server advertised in
+// RPL_ISUPPORT (rfc1459 until it says otherwise) and server names
+// case-insensitively.  A pair is folded once, the first time it is seen;
+// after that every spelling already met resolves with one hash lookup and
+// no allocation, so per-channel state can be kept in containers keyed by
+// int.  Ids are never reused, so an id held across a PART stays valid.
+class ChannelRegistry {
+public:
+  enum class CaseMapping { Ascii, Rfc1459, StrictRfc1459 };
+  // Value of the CASEMAPPING token; unknown mappings (rfc7613, …) are
+  // treated as rfc1459, which is what they reduce to for ASCII names.
+  static CaseMapping caseMappingFromName(QStringView name);
+  static QChar fold(QChar c, CaseMapping mapping);
+  static QString fold(QStringView text, CaseMapping mapping);
+
+  // Id of (server, channel), interned on first use.
+  int intern(const QString &server, const QString &channel);
+  // Id of (server, channel), or -1 if it was never interned.
+  int find(const QString &server, const QString &channel) const;
+
+  // Names as first seen
+  const QString &serverName(int id) const;
+  const QString &channelName(int id) const;
+  bool isOnServer(int id, const QString &server) const;
+
+  // Re-folds the server's channels; names that now fold together keep the
+  // older id.
+  void setCaseMapping(const QString &server, CaseMapping mapping);
+  CaseMapping caseMapping(const QString &server) const;
+
+private:
+  struct Server {
+    QString name;
+    CaseMapping mapping = CaseMapping::Rfc1459;
+    QHash<QString, int> byFolded;           // folded channel → id
+    mutable QHash<QString, int> bySpelling; // every spelling met → id
+  };
+  struct Entry {
+    int server;
+    QString channel;
+  };
+
+  int serverIndex(const QString &server) const;
+  int channelId(const Server &s, const QString &channel) const;
+
+  QVector<Server> m_servers;
+  QHash<QString, int> m_serverByFolded;
+  mutable QHash<QString, int> m_serverBySpelling;
+  QVector<Entry> m_entries;
+};
@@ -0,0 +1,229 @@
+#include "ChatDocument.h"
+#include "MessageModel.h"
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
+
+ChatDocument::ChatDocument(QObject *parent) : QObject(parent) {}
+
+void ChatDocument::setTextDocument(QQuickTextDocument *doc) {
+  if (m_quickDoc == doc)
+    return;
+  m_quickDoc = doc;
+  setDocument(doc ? doc->textDocument() : nullptr);
+  emit textDocumentChanged();
+}
+
+void ChatDocument::setDocument(QTextDocument *doc) {
+  if (m_doc == doc)
+    return;
+  m_doc = doc;
+  // A read-only log: the undo stack would keep every line ever shown alive
+  if (m_doc)
+    m_doc->setUndoRedoEnabled(false);
+  rebuild();
+}
+
+void ChatDocument::setModel(MessageModel *model) {
+  if (m_model == model)
+    return;
+  if (m_model)
+    disconnect(m_model, nullptr, this, nullptr);
+  m_model = model;
+  if (m_model) {
+    connect(m_model, &QAbstractItemModel::rowsInserted, this,
+            &ChatDocument::onRowsInserted);
+    connect(m_model, &QAbstractItemModel::dataChanged, this,
+            &ChatDocument::onDataChanged);
+    connect(m_model, &QAbstractItemModel::rowsRemoved, this,
+            &ChatDocument::rebuild);
+    connect(m_model, &QAbstractItemModel::modelReset, this,
+            &ChatDocument::rebuild);
+  }
+  rebuild();
+  emit modelChanged();
+}
+
+void ChatDocument::setMaxLines(int lines) {
+  lines = qMax(1, lines);
+  if (m_maxLines == lines)
+    return;
+  m_maxLines = lines;
+  rebuild();
+  emit maxLinesChanged();
+}
+
+// ── Model → document ──
+
+void ChatDocument::onRowsInserted(const QModelIndex &, int first, int last) {
+  if (!m_doc)
+    return;
+  const int count = last - first + 1;
+  if (first < m_firstRow) {
+    // Above the part that was trimmed away: stays out of the document
+    m_firstRow += count;
+    return;
+  }
+  QTextCursor edit(m_doc);
+  edit.beginEditBlock();
+  int block = blockForRow(first);
+  for (int row = first; row <= last; ++row) {
+    const QModelIndex idx = m_model->index(row);
+    const bool shown = !idx.data(MessageModel::CollapsedRole).toBool();
+    m_shown.insert(row - m_firstRow, shown);
+    if (shown)
+      insertBlock(block++, idx.data(MessageModel::RowHtmlRole).toString());
+  }
+  if (last == m_model->rowCount() - 1)
+    trim();
+  edit.endEditBlock();
+}
+
+// Event groups forming, growing or toggling: only their rows are redone.
+void ChatDocument::onDataChanged(const QModelIndex &topLeft,
+                                 const QModelIndex &bottomRight,
+                                 const QList<int> &roles) {
+  if (!m_doc)
+    return;
+  if (!roles.isEmpty() && !roles.contains(MessageModel::RowHtmlRole) &&
+      !roles.contains(MessageModel::CollapsedRole))
+    return;
+  const int from = qMax(topLeft.row(), m_firstRow);
+  const int to = qMin(bottomRight.row(), m_firstRow + int(m_shown.size()) - 1);
+  if (from > to)
+    return;
+
+  QTextCursor edit(m_doc);
+  edit.beginEditBlock();
+  int block = blockForRow(from);
+  for (int row = from; row <= to; ++row) {
+    const QModelIndex idx = m_model->index(row);
+    const bool was = m_shown.at(row - m_firstRow);
+    const bool shown = !idx.data(MessageModel::CollapsedRole).toBool();
+    if (was && shown)
+      replaceBlock(block++, idx.data(MessageModel::RowHtmlRole).toString());
+    else if (was)
+      removeBlock(block);
+    else if (shown)
+      insertBlock(block++, idx.data(MessageModel::RowHtmlRole).toString());
+    m_shown[row - m_firstRow] = shown;
+  }
+  edit.endEditBlock();
+}
+
+// Channel switch, clear or a new cap: lay out the newest maxLines rows only.
+void ChatDocument::rebuild() {
+  m_shown.clear();
+  m_blocks = 0;
+  m_firstRow = 0;
+  if (!m_doc)
+    return;
+  m_doc->clear();
+  if (!m_model)
+    return;
+
+  const int rows = m_model->rowCount();
+  int first = rows;
+  int shownCount = 0;
+  while (first > 0 && shownCount < m_maxLines) {
+    --first;
+    if (!m_model->index(first).data(MessageModel::CollapsedRole).toBool())
+      ++shownCount;
+  }
+  m_firstRow = first;
+
+  QTextCursor edit(m_doc);
+  edit.beginEditBlock();
+  for (int row = first; row < rows; ++row) {
+    const QModelIndex idx = m_model->index(row);
+    const bool shown = !idx.data(MessageModel::CollapsedRole).toBool();
+    m_shown.append(shown);
+    if (shown)
+      insertBlock(m_blocks, idx.data(MessageModel::RowHtmlRole).toString());
+  }
+  edit.endEditBlock();
+}
+
+// ── Blocks ──
+
+// Block number of row, or where its block goes when it has none: the
+// number of shown rows above it.  Counted from whichever end is nearer, so
+// the live end of the chat costs O(1).
+int ChatDocument::blockForRow(int row) const {
+  const int i = row - m_firstRow;
+  int shown = 0;
+  if (i < m_shown.size() / 2) {
+    for (int k = 0; k < i; ++k)
+      shown += m_shown.at(k);
+    return shown;
+  }
+  for (int k = i; k < m_shown.size(); ++k)
+    shown += m_shown.at(k);
+  return m_blocks - shown;
+}
+
+void ChatDocument::insertBlock(int block, const QString &html) {
+  QTextCursor c(m_doc);
+  if (m_blocks == 0) {
+    // The empty document's only block takes the first row
+  } else if (block >= m_blocks) {
+    c.movePosition(QTextCursor::End);
+    c.insertBlock(QTextBlockFormat(), QTextCharFormat());
+  } else {
+    c.setPosition(m_doc->findBlockByNumber(block).position());
+    c.insertBlock(QTextBlockFormat(), QTextCharFormat());
+    c.movePosition(QTextCursor::PreviousBlock);
+  }
+  c.insertHtml(html);
+  ++m_blocks;
+}
+
+void ChatDocument::replaceBlock(int block, const QString &html) {
+  const QTextBlock b = m_doc->findBlockByNumber(block);
+  QTextCursor c(m_doc);
+  c.setPosition(b.position());
+  c.setPosition(b.position() + b.length() - 1, QTextCursor::KeepAnchor);
+  c.removeSelectedText();
+  c.setCharFormat(QTextCharFormat());
+  c.insertHtml(html);
+}
+
+void ChatDocument::removeBlock(int block) {
+  const QTextBlock b = m_doc->findBlockByNumber(block);
+  QTextCursor c(m_doc);
+  if (m_blocks == 1) {
+    c.select(QTextCursor::Document);
+  } else if (b.next().isValid()) {
+    // The block's text and the separator after it
+    c.setPosition(b.position());
+    c.setPosition(b.next().position(), QTextCursor::KeepAnchor);
+  } else {
+    // Last block: take the separator before it instead
+    c.setPosition(b.position() - 1);
+    c.setPosition(b.position() + b.length() - 1, QTextCursor::KeepAnchor);
+  }
+  c.removeSelectedText();
+  --m_blocks;
+}
+
+// Cutting lines from the top shifts the layout of everything below, so the
+// document may run maxLines/10 over before one cut takes it back to maxLines.
+void ChatDocument::trim() {
+  if (m_blocks <= m_maxLines + m_maxLines / 10)
+    return;
+  int drop = m_blocks - m_maxLines;
+  int rows = 0;
+  for (int left = drop; left > 0; ++rows)
+    left -= m_shown.at(rows);
+  // Hidden rows right after the cut belong to a group whose head is gone
+  while (rows < m_shown.size() && !m_shown.at(rows))
+    ++rows;
+
+  QTextCursor c(m_doc);
+  c.setPosition(m_doc->findBlockByNumber(drop).position(),
+                QTextCursor::KeepAnchor);
+  c.removeSelectedText();
+  m_shown.remove(0, rows);
+  m_firstRow += rows;
+  m_blocks -= drop;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QQuickTextDocument>
+
+class MessageModel;
+class QTextDocument;
+
+// Keeps the chat TextArea's document in step with a MessageModel without
+// ever re-parsing the whole history.  Every visible model row is one text
+// block: appends insert a block at the end, event groups are replaced in
+// place when the model reports their rows changed, and once the document
+// holds more than maxLines blocks the oldest are cut from the top.  Work
+// per incoming message does not depend on how much scrollback is shown.
+class ChatDocument : public QObject {
+  Q_OBJECT
+  Q_PROPERTY(QQuickTextDocument *textDocument READ textDocument WRITE
+                 setTextDocument NOTIFY textDocumentChanged)
+  Q_PROPERTY(MessageModel *model READ model WRITE setModel NOTIFY modelChanged)
+  Q_PROPERTY(int maxLines READ maxLines WRITE setMaxLines NOTIFY
+                 maxLinesChanged)
+
+public:
+  explicit ChatDocument(QObject *parent = nullptr);
+
+  QQuickTextDocument *textDocument() const { return m_quickDoc; }
+  void setTextDocument(QQuickTextDocument *doc);
+  // Plain QTextDocument target (tests, non-Quick callers)
+  void setDocument(QTextDocument *doc);
+  QTextDocument *document() const { return m_doc; }
+
+  MessageModel *model() const { return m_model; }
+  void setModel(MessageModel *model);
+
+  int maxLines() const { return m_maxLines; }
+  void setMaxLines(int lines);
+
+  // First model row still in the document
+  int firstRow() const { return m_firstRow; }
+
+signals:
+  void textDocumentChanged();
+  void modelChanged();
+  void maxLinesChanged();
+
+private slots:
+  void onRowsInserted(const QModelIndex &parent, int first, int last);
+  void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight,
+                     const QList<int> &roles);
+  void rebuild();
+
+private:
+  int blockForRow(int row) const;
+  void insertBlock(int block, const QString &html);
+  void replaceBlock(int block, const QString &html);
+  void removeBlock(int block);
+  void trim();
+
+  QQuickTextDocument *m_quickDoc = nullptr;
+  QPointer<QTextDocument> m_doc;
+  QPointer<MessageModel> m_model;
+  int m_maxLines = 10000;
+  int m_firstRow = 0;  // rows above this one were trimmed away
+  int m_blocks = 0;    // blocks holding a row; 0 while the document is empty
+  QList<bool> m_shown; // rows from m_firstRow on: has a block
+};
@@ -51,16 +51,9 @@ void IRCConnectionManager::initCommandTable() {
     if (!ch.isEmpty() && !args.isEmpty()) {
       conn->sendMessage(ch, args);
       QString nick = conn->nickname(), displayNick = nick;
-      ChannelKey key{m_activeServer, ch};
-      if (m_users.contains(key)) {
-        for (const QString &u : m_users[key]) {
-          auto [pfx, bare] = IrcConnection::stripNickPrefix(u);
-          if (bare.compare(nick, Qt::CaseInsensitive) == 0) {
-            if (!pfx.isEmpty()) displayNick = pfx[0] + nick;
-            break;
-          }
-        }
-      }
+      const int key = channelId(m_activeServer, ch);
+      if (const NickListModel *users = findUsers(key))
+        displayNick = users->prefix(nick) + nick;
       QString text = "<" + displayNick + "> " + args;
       if (m_msgModel && m_activeChannel == ch) m_msgModel->addMessage("chat", text);
       appendToChannel(m_activeServer, ch, "chat", text);
@@ -353,7 +346,7 @@ void IRCConnectionManager::initCommandTable() {
   T["SERVER"] = serverHandler; T["NEWSERVER"] = serverHandler;
 
   // ═══════════════════════════════════════════════════
-  //  Utility commands (/TIMER, /LASTLOG, /EXEC, /ALIAS, /NOTIFY)
+  //  Utility commands (/TIMER, /LASTLOG, /EXEC, /ALIAS, /NOTIFY, /SENDQ)
   // ═══════════════════════════════════════════════════
 
   // /TIMER <seconds> <command or text> — runs once after the delay
@@ -386,19 +379,23 @@ void IRCConnectionManager::initCommandTable() {
       return true;
     }
     if (!m_msgModel) return true;
-    ChannelKey key{m_activeServer, m_activeChannel};
-    const auto &hist = m_history.value(key);
-    QVector<StoredMessage> matches;
-    for (const auto &m : hist) {
-      if (m.text.contains(pattern, Qt::CaseInsensitive))
-        matches.append(m);
+    const int key = channelId(m_activeServer, m_activeChannel);
+    const ChannelHistory &hist = history(key);
+    QVector<int> matches;
+    for (int i = 0; i < hist.size(); ++i) {
+      if (hist.textAt(i).contains(pattern, Qt::CaseInsensitive))
+        matches.append(i);
     }
     static constexpr int kMaxLastlog = 100;
     int start = qMax(0, matches.size() - kMaxLastlog);
     m_msgModel->addMessage("system",
         "── LastLog: \"" + pattern + "\" (" + QString::number(matches.size()) + " matches) ──");
-    for (int i = start; i < matches.size(); ++i)
-      m_msgModel->addMessage(matches[i].type, matches[i].text, matches[i].timestamp);
+    for (int i = start; i < matches.size(); ++i) {
+      const int m = matches[i];
+      m_msgModel->addMessage(ChannelHistory::typeName(hist.typeAt(m)),
+                             hist.textAt(m).toString(),
+                             ChannelHistory::formatTimestamp(hist.timestampAt(m)));
+    }
     m_msgModel->addMessage("system", "── End of LastLog ──");
     return true;
   };
@@ -531,6 +528,37 @@ void IRCConnectionManager::initCommandTable() {
     return true;
   };
 
+  // /SENDQ [PROFILE <name>] — send queue depth, or pick this network's
+  // flood-control profile
+  T["SENDQ"] = [this](IrcConnection *conn, const QString &, const QString &args) -> bool {
+    if (!m_msgModel) return true;
+    if (args.section(' ', 0, 0).compare("PROFILE", Qt::CaseInsensitive) == 0) {
+      const QString name = args.section(' ', 1, 1).toLower();
+      if (!SendScheduler::profileNames().contains(name)) {
+        m_msgModel->addMessage("system", "Usage: /SENDQ PROFILE <" +
+                                             SendScheduler::profileNames().join('|') + ">");
+        return true;
+      }
+      conn->setSendProfile(SendScheduler::profileNamed(name));
+      if (m_settings) {
+        m_settings->setValue("sendProfile/" + serverNameFor(conn), name);
+        m_settings->sync();
+      }
+      m_msgModel->addMessage("system", "Send profile for " + serverNameFor(conn) + ": " + name);
+      return true;
+    }
+    const SendScheduler &q = conn->sendScheduler();
+    using Lane = SendScheduler::Lane;
+    m_msgModel->addMessage("system",
+        QString("Send queue (%1 profile): %2 control, %3 interactive, %4 bulk waiting, "
+                "%5 bytes; peak %6; %7 ms ahead of the server's clock")
+            .arg(q.profile().name)
+            .arg(q.depth(Lane::Control)).arg(q.depth(Lane::Interactive))
+            .arg(q.depth(Lane::Bulk)).arg(q.queuedBytes()).arg(q.peakDepth())
+            .arg(conn->sendBacklogMs()));
+    return true;
+  };
+
   // ═══════════════════════════════════════════════════
   //  DCC
   // ═══════════════════════════════════════════════════
@@ -0,0 +1,341 @@
+#include "DccEngine.h"
+#include <QCoreApplication>
+#include <QSocketNotifier>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QtEndian>
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <sys/sendfile.h>
+#endif
+
+namespace {
+
+QThread *g_transferThread = nullptr;
+QObject *g_transferAnchor = nullptr; // lives on the thread, to queue the stop
+
+// Handed to the kernel per pass before letting the thread's other events
+// (ACKs, other transfers, abort) in
+constexpr qint64 kSendfilePass = 16 * 1024 * 1024;
+
+void stopTransferThread() {
+  if (!g_transferThread)
+    return;
+  QMetaObject::invokeMethod(
+      g_transferAnchor, [] { QThread::currentThread()->quit(); },
+      Qt::QueuedConnection);
+  g_transferThread->wait();
+  delete g_transferAnchor;
+  delete g_transferThread;
+  g_transferAnchor = nullptr;
+  g_transferThread = nullptr;
+}
+
+} // namespace
+
+QThread *DccEngine::transferThread() {
+  if (!g_transferThread) {
+    g_transferThread = new QThread;
+    g_transferThread->setObjectName(QStringLiteral("DccTransfer"));
+    g_transferAnchor = new QObject;
+    g_transferAnchor->moveToThread(g_transferThread);
+    g_transferThread->start();
+    qAddPostRoutine(stopTransferThread);
+  }
+  return g_transferThread;
+}
+
+qint64 DccEngine::bufferSizeFor(double bytesPerSecond) {
+  if (!(bytesPerSecond > 0))
+    return kMinBuffer;
+  return qint64(std::clamp(bytesPerSecond / 20, double(kMinBuffer),
+                           double(kMaxBuffer)));
+}
+
+DccEngine::DccEngine(QObject *parent) : QObject(parent), m_file(this) {}
+
+DccEngine::~DccEngine() { abort(); }
+
+qint64 DccEngine::bufferSize() const {
+  const qint64 ms = m_clock.isValid() ? m_clock.elapsed() : 0;
+  if (ms <= 0)
+    return kMinBuffer;
+  return bufferSizeFor(double(transferred()) * 1000.0 / double(ms));
+}
+
+// ── Send ──
+
+quint16 DccEngine::listen(const QString &path, quint16 port, bool turbo,
+                          QString *error) {
+  m_sending = true;
+  m_turbo = turbo;
+  m_file.setFileName(path);
+  if (!m_file.open(QIODevice::ReadOnly)) {
+    *error = "Cannot open file: " + m_file.errorString();
+    return 0;
+  }
+  m_size = m_file.size();
+
+  m_server = new QTcpServer(this);
+  connect(m_server, &QTcpServer::newConnection, this, &DccEngine::onIncoming);
+  if (!m_server->listen(QHostAddress::Any, port)) {
+    *error = "Cannot listen on port " + QString::number(port) + ": " +
+             m_server->errorString();
+    m_file.close();
+    return 0;
+  }
+  return m_server->serverPort();
+}
+
+void DccEngine::onIncoming() {
+  if (m_socket || m_done)
+    return;
+  m_socket = m_server->nextPendingConnection();
+  m_socket->setParent(this);
+  m_server->close(); // only accept one connection
+  connect(m_socket, &QTcpSocket::readyRead, this, &DccEngine::onAcks);
+  watch();
+  startTransfer();
+}
+
+void DccEngine::pumpSendfile() {
+#ifdef Q_OS_LINUX
+  if (m_done || !m_notifier)
+    return;
+  m_notifier->setEnabled(false);
+  const int out = int(m_socket->socketDescriptor());
+  off_t offset = off_t(transferred());
+  const off_t passEnd = offset + off_t(kSendfilePass);
+  while (offset < m_size) {
+    if (offset >= passEnd) {
+      QMetaObject::invokeMethod(this, &DccEngine::pumpSendfile,
+                                Qt::QueuedConnection);
+      return;
+    }
+    const size_t chunk = size_t(std::min<qint64>(m_size - offset, kSendfilePass));
+    const ssize_t n = ::sendfile(out, m_file.handle(), &offset, chunk);
+    if (n > 0) {
+      m_transferred.store(offset, std::memory_order_relaxed);
+      continue;
+    }
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      m_notifier->setEnabled(true); // socket buffer full
+      return;
+    }
+    if (n < 0 && (errno == EINVAL || errno == ENOSYS)) {
+      // A file system that can't do it: copy through user space instead
+      dropNotifier();
+      m_zeroCopy = false;
+      m_file.seek(offset);
+      connect(m_socket, &QTcpSocket::bytesWritten, this,
+              &DccEngine::pumpBuffered);
+      pumpBuffered();
+      return;
+    }
+    finish(false, n == 0 ? QStringLiteral("File shrank while sending")
+                         : QString::fromLocal8Bit(std::strerror(errno)));
+    return;
+  }
+#endif
+}
+
+void DccEngine::pumpBuffered() {
+  if (m_done)
+    return;
+  const qint64 highWater = bufferSize();
+  qint64 sent = transferred();
+  while (sent < m_size && m_socket->bytesToWrite() < highWater) {
+    const QByteArray block = m_file.read(std::min(highWater, m_size - sent));
+    if (block.isEmpty()) {
+      finish(false, "Cannot read file: " + m_file.errorString());
+      return;
+    }
+    m_socket->write(block);
+    sent += block.size();
+    m_transferred.store(sent, std::memory_order_relaxed);
+  }
+}
+
+void DccEngine::onAcks() {
+  // 4-byte big-endian count of bytes received; only the latest matters
+  bool any = false;
+  quint32 acked = 0;
+  while (m_socket->bytesAvailable() >= 4) {
+    char ack[4];
+    m_socket->read(ack, 4);
+    acked = qFromBigEndian<quint32>(ack);
+    any = true;
+  }
+  if (any && transferred() >= m_size &&
+      acked == static_cast<quint32>(m_size & 0xFFFFFFFF)) {
+    m_socket->disconnectFromHost();
+    finish(true);
+  }
+}
+
+// ── Receive ──
+
+void DccEngine::receive(const QString &path, const QHostAddress &address,
+                        quint16 port, qint64 size, bool turbo) {
+  m_size = size;
+  m_turbo = turbo;
+  m_file.setFileName(path);
+  // Unbuffered: flush() already writes in large blocks
+  if (!m_file.open(QIODevice::WriteOnly | QIODevice::Unbuffered)) {
+    finish(false, "Cannot open file for writing: " + m_file.errorString());
+    return;
+  }
+  m_socket = new QTcpSocket(this);
+  connect(m_socket, &QTcpSocket::connected, this, &DccEngine::startTransfer);
+  connect(m_socket, &QTcpSocket::readyRead, this, &DccEngine::onData);
+  watch();
+  m_socket->connectToHost(address, port);
+}
+
+void DccEngine::onData() {
+  if (m_done)
+    return;
+  qint64 got = transferred();
+  while (m_socket->bytesAvailable() > 0) {
+    // In slices, so a streaming sender hears from us every kAckBytes
+    const qint64 at = m_pending.size();
+    const qint64 n = std::min(m_socket->bytesAvailable(), kAckBytes);
+    m_pending.resize(at + n);
+    const qint64 read = m_socket->read(m_pending.data() + at, n);
+    m_pending.resize(at + std::max<qint64>(read, 0));
+    if (read <= 0)
+      break;
+    got += read;
+    m_transferred.store(got, std::memory_order_relaxed);
+    if (got - m_acked >= kAckBytes)
+      sendAck();
+  }
+
+  const bool complete = m_size > 0 && got >= m_size;
+  if ((complete || m_pending.size() >= bufferSize()) && !flush())
+    return;
+  // Drained: a sender waiting on this ACK can go on right away
+  sendAck();
+  if (complete) {
+    m_socket->disconnectFromHost();
+    finish(true);
+  }
+}
+
+bool DccEngine::flush() {
+  if (m_pending.isEmpty())
+    return true;
+  if (m_file.write(m_pending) != m_pending.size()) {
+    m_pending.clear();
+    finish(false, "Cannot write file: " + m_file.errorString());
+    return false;
+  }
+  m_pending.truncate(0); // keeps the capacity for the next block
+  return true;
+}
+
+void DccEngine::sendAck() {
+  if (m_turbo || !m_socket ||
+      m_socket->state() != QAbstractSocket::ConnectedState)
+    return;
+  const qint64 got = transferred();
+  if (got == m_acked)
+    return;
+  char ack[4];
+  qToBigEndian(static_cast<quint32>(got & 0xFFFFFFFF), ack);
+  m_socket->write(ack, 4);
+  m_acked = got;
+}
+
+// ── Both ──
+
+void DccEngine::watch() {
+  connect(m_socket, &QTcpSocket::disconnected, this, &DccEngine::onClosed);
+  connect(m_socket, &QTcpSocket::errorOccurred, this,
+          [this](QAbstractSocket::SocketError err) {
+            if (err == QAbstractSocket::RemoteHostClosedError)
+              onClosed();
+            else
+              finish(false, m_socket->errorString());
+          });
+}
+
+void DccEngine::startTransfer() {
+  m_clock.start();
+  emit connected();
+  if (!m_sending) {
+    m_pending.reserve(kMaxBuffer);
+    return;
+  }
+#ifdef Q_OS_LINUX
+  m_zeroCopy = true;
+  m_notifier = new QSocketNotifier(m_socket->socketDescriptor(),
+                                   QSocketNotifier::Write, this);
+  m_notifier->setEnabled(false);
+  connect(m_notifier, &QSocketNotifier::activated, this,
+          &DccEngine::pumpSendfile);
+  pumpSendfile();
+#else
+  connect(m_socket, &QTcpSocket::bytesWritten, this, &DccEngine::pumpBuffered);
+  pumpBuffered();
+#endif
+}
+
+void DccEngine::onClosed() {
+  if (m_done)
+    return;
+  if (!m_sending) {
+    onData(); // whatever arrived with the close
+    if (m_done || !flush())
+      return;
+  }
+  // A receiver is done once it has it all.  A sender only knows that from
+  // the final ACK (see onAcks()), unless the receiver was told to send none.
+  const bool all = m_size > 0 && transferred() >= m_size;
+  if (all && (!m_sending || m_turbo))
+    finish(true);
+  else if (all)
+    finish(false, QStringLiteral("Connection closed before the file was "
+                                 "acknowledged"));
+  else
+    finish(false, QStringLiteral("Connection closed prematurely"));
+}
+
+void DccEngine::finish(bool ok, const QString &error) {
+  if (m_done)
+    return;
+  m_done = true;
+  dropNotifier();
+  // Keep what did arrive, as a partial file
+  if (!m_sending && !m_pending.isEmpty())
+    m_file.write(m_pending);
+  m_file.close();
+  if (!ok && m_socket)
+    m_socket->abort();
+  emit finished(ok, error);
+}
+
+void DccEngine::abort() {
+  m_done = true;
+  dropNotifier();
+  if (m_socket)
+    m_socket->abort();
+  if (m_server)
+    m_server->close();
+  m_file.close();
+}
+
+void DccEngine::dropNotifier() {
+  if (!m_notifier)
+    return;
+  // Possibly from its own activated(): only disabled here, deleted later
+  m_notifier->setEnabled(false);
+  m_notifier->deleteLater();
+  m_notifier = nullptr;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHostAddress>
+#include <QObject>
+#include <atomic>
+
+class QSocketNotifier;
+class QTcpServer;
+class QTcpSocket;
+class QThread;
+
+// The byte-moving half of a DccTransfer, living on the shared DCC thread so
+// a fast transfer never competes with the GUI or the IRC sockets.
+//
+// Sending listens for the receiver and, on Linux, hands the file to the
+// socket with sendfile(2): the data never passes through user space.
+// Elsewhere, or if the kernel refuses, the file is read and written in
+// blocks sized by bufferSizeFor() — about 50 ms worth at the rate so far.
+// The sender never waits on ACKs, but it is only done when the last byte
+// is acknowledged: bytes handed to the kernel are not bytes received.
+// Only a turbo (TSEND) transfer counts the receiver closing as success.
+//
+// Receiving collects what the socket delivers and writes it to the file in
+// the same adaptive blocks.  Each read is ACKed once the socket is drained,
+// so a sender that waits on every ACK gets it at once; a streaming sender,
+// whose reads come in large, gets one per kAckBytes.  A turbo sender
+// expects no ACKs at all.
+//
+// Create it, move it to transferThread() and call listen() or receive()
+// there.  transferred() can be read from any thread.
+class DccEngine : public QObject {
+  Q_OBJECT
+public:
+  static constexpr qint64 kMinBuffer = 64 * 1024;
+  static constexpr qint64 kMaxBuffer = 4 * 1024 * 1024;
+  static constexpr qint64 kAckBytes = 1024 * 1024;
+
+  // Started on first use and stopped with the application
+  static QThread *transferThread();
+  // About 50 ms of data at this rate, between kMinBuffer and kMaxBuffer
+  static qint64 bufferSizeFor(double bytesPerSecond);
+
+  explicit DccEngine(QObject *parent = nullptr);
+  ~DccEngine() override;
+
+  // Opens path and waits for the receiver on port (0 = any); turbo if it
+  // was offered with TSEND.  The port listened on, or 0 with *error set.
+  quint16 listen(const QString &path, quint16 port, bool turbo,
+                 QString *error);
+  // Connects to the sender and writes size bytes to path.
+  void receive(const QString &path, const QHostAddress &address, quint16 port,
+               qint64 size, bool turbo);
+  // Stops at once, without finished()
+  void abort();
+
+  qint64 transferred() const {
+    return m_transferred.load(std::memory_order_relaxed);
+  }
+  // Whether the file is going out through sendfile(2)
+  bool zeroCopy() const { return m_zeroCopy; }
+
+signals:
+  void connected();
+  void finished(bool ok, const QString &error);
+
+private:
+  void onIncoming();
+  void watch();
+  void startTransfer();
+  void pumpSendfile();
+  void pumpBuffered();
+  void onAcks();
+  void onData();
+  bool flush();
+  void sendAck();
+  void onClosed();
+  void finish(bool ok, const QString &error = QString());
+  void dropNotifier();
+  qint64 bufferSize() const;
+
+  QTcpServer *m_server = nullptr;
+  QTcpSocket *m_socket = nullptr;
+  QSocketNotifier *m_notifier = nullptr; // writable, while sendfile waits
+  QFile m_file;
+  QByteArray m_pending; // received, not yet written
+  QElapsedTimer m_clock;
+  bool m_sending = false;
+  bool m_turbo = false;
+  bool m_zeroCopy = false;
+  bool m_done = false;
+  qint64 m_size = 0;
+  qint64 m_acked = 0; // receive: last ACK sent
+  std::atomic<qint64> m_transferred{0};
+};
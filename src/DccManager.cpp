@@ -1,10 +1,11 @@
 #include "DccManager.h"
+#include "DccEngine.h"
 #include "IrcConnection.h"
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
 #include <QHostAddress>
 #include <QUuid>
-#include <QtEndian>
 
 // ════════════════════════════════════════════════════════
 //  DccTransfer
@@ -17,9 +18,7 @@ DccTransfer::DccTransfer(QObject *parent) : QObject(parent) {
 }
 
 DccTransfer::~DccTransfer() {
-  if (m_file.isOpen()) m_file.close();
-  delete m_socket;
-  delete m_server;
+  stopEngine();
 }
 
 double DccTransfer::progress() const {
@@ -63,6 +62,7 @@ QString DccTransfer::statusString() const {
 }
 
 void DccTransfer::updateSpeed() {
+  if (m_engine) transferred = m_engine->transferred();
   qint64 delta = transferred - m_lastBytes;
   m_lastBytes = transferred;
   // Exponential moving average (α=0.3)
@@ -90,189 +90,111 @@ void DccTransfer::startReceive(const QString &downloadDir) {
     }
   }
 
-  m_file.setFileName(filePath);
-  if (!m_file.open(QIODevice::WriteOnly)) {
+  // Claim the name now; the engine reopens it on the DCC thread
+  QFile file(filePath);
+  if (!file.open(QIODevice::WriteOnly)) {
     state = Failed;
-    errorString = "Cannot open file for writing: " + m_file.errorString();
+    errorString = "Cannot open file for writing: " + file.errorString();
     emit stateChanged();
     return;
   }
+  file.close();
 
   state = Connecting;
   emit stateChanged();
 
-  m_socket = new QTcpSocket(this);
-  connect(m_socket, &QTcpSocket::connected, this, &DccTransfer::onConnected);
-  connect(m_socket, &QTcpSocket::readyRead, this, &DccTransfer::onDataReady);
-  connect(m_socket, &QTcpSocket::disconnected, this, &DccTransfer::onDisconnected);
-  connect(m_socket, &QTcpSocket::errorOccurred, this, &DccTransfer::onError);
-
-  // Convert 32-bit int IP to QHostAddress
-  QHostAddress addr(peerAddress);
-  m_socket->connectToHost(addr, peerPort);
+  DccEngine *engine = createEngine();
+  QMetaObject::invokeMethod(engine, [engine, path = filePath,
+                                     addr = QHostAddress(peerAddress),
+                                     port = peerPort, size = fileSize,
+                                     noAcks = turbo]() {
+    engine->receive(path, addr, port, size, noAcks);
+  });
 
   // 30-second connection timeout
   QTimer::singleShot(30000, this, [this]() {
     if (state == Connecting) {
+      stopEngine();
       state = Failed;
       errorString = "Connection timed out (30s)";
-      if (m_socket) m_socket->abort();
-      if (m_file.isOpen()) m_file.close();
       emit stateChanged();
     }
   });
 }
 
-void DccTransfer::onConnected() {
-  state = Transferring;
-  m_elapsed.start();
-  m_lastBytes = 0;
-  m_speedTimer.start();
-  emit stateChanged();
-}
-
-void DccTransfer::onDataReady() {
-  while (m_socket->bytesAvailable() > 0) {
-    QByteArray data = m_socket->read(CHUNK_SIZE);
-    m_file.write(data);
-    transferred += data.size();
-  }
-
-  // Send DCC acknowledgment (4-byte big-endian total received)
-  sendAck();
-
-  if (fileSize > 0 && transferred >= fileSize) {
-    state = Complete;
-    m_speedTimer.stop();
-    m_file.close();
-    m_socket->disconnectFromHost();
-    emit stateChanged();
-  }
-
-  emit progressUpdated();
-}
-
-void DccTransfer::sendAck() {
-  if (!m_socket || !m_socket->isWritable()) return;
-  quint32 ack = qToBigEndian(static_cast<quint32>(transferred & 0xFFFFFFFF));
-  m_socket->write(reinterpret_cast<const char *>(&ack), 4);
-}
-
 // ── Send ──
 void DccTransfer::startSend(const QString &localPath, quint16 listenPort) {
   filePath = localPath;
-  m_file.setFileName(localPath);
-  if (!m_file.open(QIODevice::ReadOnly)) {
-    state = Failed;
-    errorString = "Cannot open file: " + m_file.errorString();
-    emit stateChanged();
-    return;
-  }
-  fileSize = m_file.size();
-
-  m_server = new QTcpServer(this);
-  connect(m_server, &QTcpServer::newConnection, this, &DccTransfer::onNewConnection);
-
-  if (!m_server->listen(QHostAddress::Any, listenPort)) {
+  fileSize = QFileInfo(localPath).size();
+
+  // Blocking: the caller needs the port for the offer
+  DccEngine *engine = createEngine();
+  quint16 port = 0;
+  QString error;
+  QMetaObject::invokeMethod(
+      engine, [&]() { port = engine->listen(localPath, listenPort, turbo, &error); },
+      Qt::BlockingQueuedConnection);
+  if (port == 0) {
+    stopEngine();
     state = Failed;
-    errorString = "Cannot listen on port " + QString::number(listenPort) + ": " + m_server->errorString();
+    errorString = error;
     emit stateChanged();
     return;
   }
 
-  peerPort = m_server->serverPort();
+  peerPort = port;
   state = Pending; // waiting for remote to connect
   emit stateChanged();
 }
 
-void DccTransfer::onNewConnection() {
-  m_socket = m_server->nextPendingConnection();
-  m_server->close(); // only accept one connection
-
-  connect(m_socket, &QTcpSocket::readyRead, this, &DccTransfer::onSendDataReady);
-  connect(m_socket, &QTcpSocket::disconnected, this, &DccTransfer::onDisconnected);
-  connect(m_socket, &QTcpSocket::errorOccurred, this, &DccTransfer::onError);
-  connect(m_socket, &QTcpSocket::bytesWritten, this, [this]() {
-    if (state == Transferring) sendNextChunk();
-  });
+// ── Engine ──
+DccEngine *DccTransfer::createEngine() {
+  m_engine = new DccEngine;
+  m_engine->moveToThread(DccEngine::transferThread());
+  connect(m_engine, &DccEngine::connected, this, &DccTransfer::onEngineConnected);
+  connect(m_engine, &DccEngine::finished, this, &DccTransfer::onEngineFinished);
+  return m_engine;
+}
 
+void DccTransfer::onEngineConnected() {
+  if (state != Pending && state != Connecting) return;
   state = Transferring;
-  m_elapsed.start();
   m_lastBytes = 0;
   m_speedTimer.start();
   emit stateChanged();
-  sendNextChunk();
 }
 
-void DccTransfer::sendNextChunk() {
-  if (!m_socket || !m_file.isOpen() || state != Transferring) return;
-  // Don't flood the socket buffer
-  if (m_socket->bytesToWrite() > CHUNK_SIZE * 4) return;
-
-  QByteArray data = m_file.read(CHUNK_SIZE);
-  if (data.isEmpty()) return; // EOF — wait for ack
-
-  m_socket->write(data);
-  transferred += data.size();
-  emit progressUpdated();
-
-  if (transferred >= fileSize) {
-    // All data sent, wait for remote to close or ack
-  }
-}
-
-void DccTransfer::onSendDataReady() {
-  // Read acknowledgment from receiver (4-byte big-endian)
-  while (m_socket && m_socket->bytesAvailable() >= 4) {
-    char ackBuf[4];
-    m_socket->read(ackBuf, 4);
-    quint32 acked = qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(ackBuf));
-    if (acked >= static_cast<quint32>(fileSize & 0xFFFFFFFF) && transferred >= fileSize) {
-      state = Complete;
-      m_speedTimer.stop();
-      m_file.close();
-      m_socket->disconnectFromHost();
-      emit stateChanged();
-      return;
-    }
-  }
-}
-
-void DccTransfer::cancel() {
-  if (state == Complete || state == Cancelled) return;
-  state = Cancelled;
+void DccTransfer::onEngineFinished(bool ok, const QString &error) {
+  if (state == Complete || state == Failed || state == Cancelled) return;
+  if (m_engine) transferred = m_engine->transferred();
   m_speedTimer.stop();
-  if (m_socket) m_socket->abort();
-  if (m_server) m_server->close();
-  if (m_file.isOpen()) {
-    m_file.close();
-    // Delete partial download
-    if (direction == Receive && !filePath.isEmpty())
-      QFile::remove(filePath);
-  }
+  state = ok ? Complete : Failed;
+  errorString = error;
   emit stateChanged();
 }
 
-void DccTransfer::onDisconnected() {
-  if (state == Transferring) {
-    if (fileSize > 0 && transferred >= fileSize) {
-      state = Complete;
-    } else {
-      state = Failed;
-      errorString = "Connection closed prematurely";
-    }
-    m_speedTimer.stop();
-    if (m_file.isOpen()) m_file.close();
-    emit stateChanged();
-  }
+void DccTransfer::stopEngine() {
+  if (!m_engine) return;
+  DccEngine *engine = m_engine;
+  m_engine = nullptr;
+  disconnect(engine, nullptr, this, nullptr);
+  // Blocking, so the file is closed by the time this returns
+  QMetaObject::invokeMethod(engine, [engine]() { engine->abort(); },
+                            Qt::BlockingQueuedConnection);
+  transferred = engine->transferred();
+  engine->deleteLater();
 }
 
-void DccTransfer::onError(QAbstractSocket::SocketError) {
+void DccTransfer::cancel() {
   if (state == Complete || state == Cancelled) return;
-  state = Failed;
-  errorString = m_socket ? m_socket->errorString() : "Socket error";
+  const bool receiving = direction == Receive &&
+                         (state == Connecting || state == Transferring);
+  state = Cancelled;
   m_speedTimer.stop();
-  if (m_file.isOpen()) m_file.close();
+  stopEngine();
+  // Delete partial download
+  if (receiving && !filePath.isEmpty())
+    QFile::remove(filePath);
   emit stateChanged();
 }
 
@@ -337,7 +259,8 @@ DccTransfer *DccManager::findTransfer(const QString &id) {
 
 // ── Handle incoming DCC SEND offer ──
 void DccManager::handleDccSend(const QString &nick, const QString &fileName,
-                               quint32 ip, quint16 port, qint64 size, int token) {
+                               quint32 ip, quint16 port, qint64 size, int token,
+                               bool turbo) {
   // Check file size limit
   if (m_maxFileSize > 0 && size > m_maxFileSize) {
     emit transferFailed(nick, fileName,
@@ -352,6 +275,7 @@ void DccManager::handleDccSend(const QString &nick, const QString &fileName,
   t->peerAddress = ip;
   t->peerPort = port;
   t->token = token;
+  t->turbo = turbo;
   t->direction = DccTransfer::Receive;
 
   connect(t, &DccTransfer::stateChanged, this, [this, t]() {
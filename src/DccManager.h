@@ -2,15 +2,14 @@
 
 #include <QAbstractListModel>
 #include <QObject>
-#include <QTcpServer>
-#include <QTcpSocket>
-#include <QFile>
 #include <QTimer>
-#include <QElapsedTimer>
 
+class DccEngine;
 class IrcConnection;
 
 // ── Single DCC file transfer ──
+// The model side of a transfer; the bytes move on a DccEngine on the DCC
+// thread, which this polls for progress once a second.
 class DccTransfer : public QObject {
   Q_OBJECT
 public:
@@ -38,6 +37,7 @@ public:
   quint32 peerAddress = 0;  // 32-bit IP (network byte order)
   quint16 peerPort = 0;
   int     token = 0;        // passive DCC token (0 = active)
+  bool    turbo = false;    // TSEND: the sender expects no ACKs
 
   // ── Methods ──
   void startReceive(const QString &downloadDir);
@@ -55,26 +55,17 @@ signals:
   void progressUpdated();
 
 private slots:
-  void onConnected();
-  void onDataReady();
-  void onSendDataReady();
-  void onNewConnection();
-  void onDisconnected();
-  void onError(QAbstractSocket::SocketError err);
   void updateSpeed();
 
-
 private:
-  QTcpSocket *m_socket = nullptr;
-  QTcpServer *m_server = nullptr;  // for sending
-  QFile       m_file;
+  DccEngine  *m_engine = nullptr;
   QTimer      m_speedTimer;
-  QElapsedTimer m_elapsed;
   qint64      m_lastBytes = 0;     // for speed calculation
-  static constexpr int CHUNK_SIZE = 8192;
 
-  void sendNextChunk();
-  void sendAck();
+  DccEngine *createEngine();
+  void onEngineConnected();
+  void onEngineFinished(bool ok, const QString &error);
+  void stopEngine();
 };
 
 // ── DCC Manager — coordinates all transfers, exposed to QML ──
@@ -111,7 +102,8 @@ public:
 
   // Called from CTCP handler when DCC SEND is received
   void handleDccSend(const QString &nick, const QString &fileName,
-                     quint32 ip, quint16 port, qint64 size, int token = 0);
+                     quint32 ip, quint16 port, qint64 size, int token = 0,
+                     bool turbo = false);
 
   // Settings
   void setDownloadDir(const QString &dir) { m_downloadDir = dir; }
@@ -0,0 +1,77 @@
+#include "FetchScheduler.h"
+
+FetchScheduler::FetchScheduler(int global, int perHost)
+    : m_global(global), m_perHost(perHost) {}
+
+bool FetchScheduler::enqueue(const Job &job) {
+  if (m_running.contains(job.url))
+    return false;
+  for (Job &queued : m_queue) {
+    if (queued.url != job.url)
+      continue;
+    if (job.priority < queued.priority) {
+      queued.priority = job.priority;
+      queued.group = job.group;
+    }
+    return false;
+  }
+  m_queue.append(job);
+  return true;
+}
+
+bool FetchScheduler::next(Job &job) {
+  if (m_running.size() >= m_global)
+    return false;
+  int best = -1;
+  for (int i = 0; i < m_queue.size(); ++i) {
+    const Job &candidate = m_queue.at(i);
+    if (m_hostLoad.value(candidate.host) >= m_perHost)
+      continue;
+    if (best < 0 || candidate.priority < m_queue.at(best).priority)
+      best = i;
+    if (candidate.priority == Priority::Explicit)
+      break; // nothing comes before it
+  }
+  if (best < 0)
+    return false;
+  job = m_queue.takeAt(best);
+  m_running.insert(job.url, job);
+  ++m_hostLoad[job.host];
+  return true;
+}
+
+void FetchScheduler::finished(const QString &url) {
+  auto it = m_running.find(url);
+  if (it == m_running.end())
+    return;
+  auto load = m_hostLoad.find(it->host);
+  if (load != m_hostLoad.end() && --*load <= 0)
+    m_hostLoad.erase(load);
+  m_running.erase(it);
+}
+
+QStringList FetchScheduler::cancelGroup(quintptr group, QStringList *dropped) {
+  for (auto it = m_queue.begin(); it != m_queue.end();) {
+    if (it->group == group) {
+      if (dropped)
+        dropped->append(it->url);
+      it = m_queue.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  QStringList running;
+  for (const Job &job : std::as_const(m_running)) {
+    if (job.group == group)
+      running.append(job.url);
+  }
+  return running;
+}
+
+bool FetchScheduler::isQueued(const QString &url) const {
+  for (const Job &job : m_queue) {
+    if (job.url == url)
+      return true;
+  }
+  return false;
+}
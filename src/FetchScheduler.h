@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// Decides which inline-media fetches may run, for ImageDownloader.
+//
+// At most `global` fetches run at once and at most `perHost` against any
+// one host, so a bot pasting fifty links to one image host gets a couple
+// of connections rather than fifty.  Waiting jobs start in priority order
+// (Explicit — the user asked for this file — before Inline embeds), first
+// come first served within a priority.  A URL is only ever queued or
+// running once.  Every job belongs to a group (the requesting view, 0 for
+// none); cancelGroup() drops a view's jobs when it switches channel.
+//
+// Pure bookkeeping: the caller starts and finishes the actual requests.
+class FetchScheduler {
+public:
+  enum class Priority { Explicit, Inline };
+
+  struct Job {
+    QString url;
+    QString host;
+    quintptr group = 0;
+    Priority priority = Priority::Inline;
+  };
+
+  explicit FetchScheduler(int global = 6, int perHost = 2);
+
+  // False if the URL is already queued or running.  A queued duplicate
+  // with a more urgent priority is promoted, and moves to the new group.
+  bool enqueue(const Job &job);
+  // The next job allowed to start, now counted as running; false if the
+  // limits or an empty queue say wait.
+  bool next(Job &job);
+  // A running job is done (or failed); frees its slots.
+  void finished(const QString &url);
+  // Drops the group's queued jobs and returns the URLs of its running ones,
+  // which stay counted until the caller aborts them and calls finished().
+  QStringList cancelGroup(quintptr group, QStringList *dropped = nullptr);
+
+  bool isQueued(const QString &url) const;
+  bool isRunning(const QString &url) const { return m_running.contains(url); }
+  int queued() const { return int(m_queue.size()); }
+  int running() const { return int(m_running.size()); }
+  int running(const QString &host) const { return m_hostLoad.value(host); }
+
+private:
+  int m_global;
+  int m_perHost;
+  QList<Job> m_queue; // in arrival order
+  QHash<QString, Job> m_running;
+  QHash<QString, int> m_hostLoad;
+};
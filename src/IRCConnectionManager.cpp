@@ -1,6 +1,7 @@
 #include "IRCConnectionManager.h"
 #include "DccManager.h"
 #include "IrcConnection.h"
+#include "IrcFormatter.h"
 #include "Logger.h"
 #include "MessageModel.h"
 #include "ServerChannelModel.h"
@@ -9,8 +10,11 @@
 #include <QDateTime>
 #include <QDebug>
 #include <QFile>
+#include <QHostInfo>
+#include <QMetaMethod>
 #include <QNetworkProxy>
 #include <QProcess>
+#include <QRandomGenerator>
 #include <QRegularExpression>
 #include <QSysInfo>
 #include <QTextStream>
@@ -24,6 +28,8 @@
 #endif
 
 IRCConnectionManager::IRCConnectionManager(QObject *parent) : QObject(parent) {
+  initNumericTable();
+
   // ── Lag meter ── ping every connected server every 30s
   m_lagTimer.setInterval(30000);
   connect(&m_lagTimer, &QTimer::timeout, this, [this]() {
@@ -36,6 +42,14 @@ IRCConnectionManager::IRCConnectionManager(QObject *parent) : QObject(parent) {
       conn->sendPing("LAG" + QString::number(state.pingSent.msecsSinceReference()));
     }
   });
+
+  connect(&m_changes, &ChangeAggregator::flushed, this,
+          &IRCConnectionManager::applyChanges);
+
+  m_netsplitTimer.setSingleShot(true);
+  m_netsplitTimer.setInterval(kNetsplitFlushMs);
+  connect(&m_netsplitTimer, &QTimer::timeout, this,
+          &IRCConnectionManager::flushNetsplits);
 }
 
 IRCConnectionManager::~IRCConnectionManager() {
@@ -63,6 +77,7 @@ void IRCConnectionManager::setSettings(Settings *settings) {
     if (stored.isValid())
       m_ignoreList = stored.toStringList();
   }
+  m_ignoreMatcher.setMasks(m_ignoreList);
 }
 
 void IRCConnectionManager::connectToServer(
@@ -145,6 +160,7 @@ void IRCConnectionManager::connectToServer(
   // Set as active server
   m_activeServer = name;
   m_activeChannel = name; // server tab
+  updateActiveNickList();
 
   // Record a system message
   if (m_msgModel) {
@@ -157,6 +173,7 @@ void IRCConnectionManager::connectToServer(
                       "...");
 
   applyProxySettings(conn);
+  applySendProfile(conn);
   if (m_settings)
     conn->setAllowSelfSignedCerts(
         m_settings->getBool("conn/allowSelfSignedCerts", false));
@@ -243,6 +260,7 @@ void IRCConnectionManager::closeServer(const QString &serverName) {
   if (m_activeServer == serverName) {
     m_activeServer = QString();
     m_activeChannel = QString();
+    updateActiveNickList();
   }
 
   // Best-effort cleanup of any per-channel state that might be lingering
@@ -254,7 +272,12 @@ void IRCConnectionManager::closeServer(const QString &serverName) {
 
 void IRCConnectionManager::sendMessage(const QString &target,
                                        const QString &message) {
-  auto *conn = activeConnection();
+  sendMessage(activeConnection(), target, message);
+}
+
+void IRCConnectionManager::sendMessage(IrcConnection *conn,
+                                       const QString &target,
+                                       const QString &message) {
   if (!conn)
     return;
 
@@ -269,23 +292,37 @@ void IRCConnectionManager::sendMessage(const QString &target,
   conn->sendMessage(target, message);
 
   // Show our own message locally with status prefix
+  const QString server = serverNameFor(conn);
   QString nick = conn->nickname();
   QString displayNick = nick;
-  ChannelKey key{m_activeServer, target};
-  if (m_users.contains(key)) {
-    for (const QString &u : m_users[key]) {
-      auto [pfx, bare] = IrcConnection::stripNickPrefix(u);
-      if (bare.compare(nick, Qt::CaseInsensitive) == 0) {
-        if (!pfx.isEmpty())
-          displayNick = pfx[0] + nick;
-        break;
-      }
-    }
-  }
+  const int key = channelId(server, target);
+  if (const NickListModel *users = findUsers(key))
+    displayNick = users->prefix(nick) + nick;
   QString text = "<" + displayNick + "> " + message;
-  if (m_msgModel && m_activeChannel == target)
+  if (m_msgModel && m_activeServer == server && m_activeChannel == target)
     m_msgModel->addMessage("chat", text);
-  appendToChannel(m_activeServer, target, "chat", text);
+  appendToChannel(server, target, "chat", text);
+}
+
+void IRCConnectionManager::sendMessages(const QString &target,
+                                        const QStringList &lines) {
+  // Resolved once: switching tabs mid-paste doesn't split it
+  IrcConnection *conn = activeConnection();
+  for (const QString &line : lines) {
+    if (!line.isEmpty())
+      sendBulkMessage(conn, target, line);
+  }
+}
+
+void IRCConnectionManager::sendBulkMessage(IrcConnection *conn,
+                                           const QString &target,
+                                           const QString &message) {
+  if (!conn)
+    return;
+  const SendScheduler::Lane lane = conn->sendLane();
+  conn->setSendLane(SendScheduler::Lane::Bulk);
+  sendMessage(conn, target, message);
+  conn->setSendLane(lane);
 }
 
 bool IRCConnectionManager::handleSlashCommand(IrcConnection *conn,
@@ -349,16 +386,19 @@ void IRCConnectionManager::changeNick(const QString &newNick) {
 
 void IRCConnectionManager::setActiveServer(const QString &host) {
   m_activeServer = host;
+  updateActiveNickList();
 }
 
 void IRCConnectionManager::setActiveChannel(const QString &channel) {
   m_activeChannel = channel;
+  updateActiveNickList();
 }
 
 void IRCConnectionManager::switchToChannel(const QString &serverName,
                                            const QString &channel) {
   m_activeServer = serverName;
   m_activeChannel = channel;
+  updateActiveNickList();
 
   // Clear unread/highlight for this channel
   clearUnread(serverName, channel);
@@ -376,24 +416,26 @@ void IRCConnectionManager::switchToChannel(const QString &serverName,
   // Make sure we have loaded previous session's logs for this tab
   ensureScrollbackLoaded(serverName, channel);
 
-  ChannelKey key{serverName, channel};
-  if (m_history.contains(key) && !m_history[key].isEmpty()) {
-    const auto &msgs = m_history[key];
+  const int key = channelId(serverName, channel);
+  const auto histIt = m_history.constFind(key);
+  if (histIt != m_history.constEnd() && !histIt->isEmpty()) {
+    const ChannelHistory &msgs = *histIt;
     // Disable highlight for log-file scrollback, enable for session messages
     m_msgModel->setHighlightEnabled(false);
     // Batch mode: suppress per-message signals and do a single reload at the end
     m_msgModel->beginBatch();
     bool pastScrollback = false;
-    for (const auto &m : msgs) {
+    for (int i = 0; i < msgs.size(); ++i) {
+      const ChannelHistory::Type type = msgs.typeAt(i);
+      const QStringView text = msgs.textAt(i);
+      m_msgModel->addMessage(ChannelHistory::typeName(type), text.toString(),
+                             ChannelHistory::formatTimestamp(msgs.timestampAt(i)));
       // Enable highlights after the scrollback end marker
-      if (!pastScrollback && m.type == QLatin1String("system") &&
-          m.text.contains(QLatin1String("End of scrollback"))) {
+      if (!pastScrollback && type == ChannelHistory::Type::System &&
+          text.contains(QLatin1String("End of scrollback"))) {
         pastScrollback = true;
-        m_msgModel->addMessage(m.type, m.text, m.timestamp);
         m_msgModel->setHighlightEnabled(true);
-        continue;
       }
-      m_msgModel->addMessage(m.type, m.text, m.timestamp);
     }
     // If no scrollback was loaded, enable highlights now
     if (!pastScrollback)
@@ -406,7 +448,7 @@ void IRCConnectionManager::switchToChannel(const QString &serverName,
 
   emit currentNickChanged(currentNick());
   emit channelTopicChanged(channelTopic());
-  emit channelUsersChanged(channelUsers());
+  usersChanged(serverName, channel);
   emit channelModesChanged(channelModes());
 }
 
@@ -442,60 +484,105 @@ QString IRCConnectionManager::currentNick() const {
 }
 
 QString IRCConnectionManager::channelTopic() const {
-  ChannelKey key{m_activeServer, m_activeChannel};
+  const int key = findChannelId(m_activeServer, m_activeChannel);
   // Render mIRC color/format codes and make URLs clickable (mIRC-style bar)
-  return MessageModel::linkifyUrls(
-      MessageModel::ircToHtml(m_topics.value(key)));
+  IrcFormatter::Options opt;
+  opt.nickLinks = false;
+  return IrcFormatter::toHtml(m_topics.value(key), opt);
 }
 
 QString IRCConnectionManager::channelTopicRaw() const {
-  ChannelKey key{m_activeServer, m_activeChannel};
+  const int key = findChannelId(m_activeServer, m_activeChannel);
   return m_topics.value(key);
 }
 
 QString IRCConnectionManager::channelModes() const {
-  ChannelKey key{m_activeServer, m_activeChannel};
+  const int key = findChannelId(m_activeServer, m_activeChannel);
   return m_modes.value(key);
 }
 
-static int prefixRank(const QString &nick) {
-  if (nick.isEmpty())
-    return 99;
-  QChar c = nick.at(0);
-  if (c == '~')
-    return 0; // owner
-  if (c == '&')
-    return 1; // admin / protected
-  if (c == '@')
-    return 2; // op
-  if (c == '%')
-    return 3; // halfop
-  if (c == '+')
-    return 4; // voice
-  return 5;   // regular
+QStringList IRCConnectionManager::channelUsers() const {
+  const NickListModel *users =
+      findUsers(findChannelId(m_activeServer, m_activeChannel));
+  return users ? users->names() : QStringList();
 }
 
-QStringList IRCConnectionManager::channelUsers() const {
-  ChannelKey key{m_activeServer, m_activeChannel};
-  QStringList users = m_users.value(key);
-  std::sort(users.begin(), users.end(), [](const QString &a, const QString &b) {
-    int ra = prefixRank(a);
-    int rb = prefixRank(b);
-    if (ra != rb)
-      return ra < rb;
-    // Same rank: sort alphabetically (case-insensitive), stripping prefix
-    QString na = (ra < 5) ? a.mid(1) : a;
-    QString nb = (rb < 5) ? b.mid(1) : b;
-    return na.compare(nb, Qt::CaseInsensitive) < 0;
-  });
+NickListModel *IRCConnectionManager::nickList() const { return m_activeUsers; }
+
+NickListModel *IRCConnectionManager::users(int key) {
+  NickListModel *&users = m_users[key];
+  if (!users) {
+    users = new NickListModel(this);
+    users->setCaseMapping(
+        m_channels.caseMapping(m_channels.serverName(key)));
+  }
   return users;
 }
 
+void IRCConnectionManager::updateActiveNickList() {
+  NickListModel *users =
+      findUsers(findChannelId(m_activeServer, m_activeChannel));
+  if (!users)
+    users = &m_noUsers;
+  if (users != m_activeUsers) {
+    m_activeUsers = users;
+    emit nickListChanged();
+  }
+}
+
+void IRCConnectionManager::usersChanged(const QString &server,
+                                        const QString &channel) {
+  if (server == m_activeServer && channel == m_activeChannel)
+    m_changes.mark(findChannelId(server, channel), ChangeAggregator::Users);
+}
+
+void IRCConnectionManager::applyChanges(
+    const QHash<int, ChangeAggregator::Changes> &changes) {
+  bool activity = false;
+  const int activeKey = findChannelId(m_activeServer, m_activeChannel);
+  for (auto it = changes.cbegin(); it != changes.cend(); ++it) {
+    const int key = it.key();
+    const QString server = m_channels.serverName(key);
+    const QString channel = m_channels.channelName(key);
+    if (it.value() & ChangeAggregator::Activity) {
+      activity = true;
+      const bool unread = m_unread.contains(key);
+      const bool highlight = m_highlighted.contains(key);
+      emit channelActivityChanged(server, channel, unread, highlight);
+    }
+    // The nick list view follows the model's row signals; the whole list
+    // is only rebuilt for whoever still listens to channelUsersChanged.
+    static const QMetaMethod usersSignal =
+        QMetaMethod::fromSignal(&IRCConnectionManager::channelUsersChanged);
+    if ((it.value() & ChangeAggregator::Users) && key == activeKey &&
+        isSignalConnected(usersSignal))
+      emit channelUsersChanged(channelUsers());
+  }
+  // Aggregate state (tray icon) once per frame
+  if (activity)
+    emit unreadStateChanged();
+}
+
 // ── Private ──
 
 void IRCConnectionManager::wireConnection(IrcConnection *conn) {
   QString host = m_connToName[conn];
 
+  // Lines that arrived together reach the chat view as one row insert and
+  // the log writer as one hand-off
+  connect(conn, &IrcConnection::batchStarted, this, [this]() {
+    if (m_msgModel)
+      m_msgModel->holdAppends();
+    if (m_logger)
+      m_logger->holdLines();
+  });
+  connect(conn, &IrcConnection::batchFinished, this, [this]() {
+    if (m_msgModel)
+      m_msgModel->releaseAppends();
+    if (m_logger)
+      m_logger->releaseLines();
+  });
+
   // Forward raw lines for Raw Log + lag meter PONG detection
   connect(conn, &IrcConnection::rawLineReceived, this,
           [this, conn](const QString &line) {
@@ -556,12 +643,13 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
         }
       }
       static const QRegularExpression chanSep(QStringLiteral("[,\\s]+"));
-      const QStringList autojoinChans =
-          ri.autojoin.split(chanSep, Qt::SkipEmptyParts);
-      for (const QString &chan : autojoinChans) {
+      QStringList autojoinChans;
+      for (const QString &chan : ri.autojoin.split(chanSep, Qt::SkipEmptyParts)) {
         if (chan.startsWith('#') || chan.startsWith('&'))
-          conn->joinChannel(chan);
+          autojoinChans.append(chan);
       }
+      // A handful of JOIN lines rather than one per channel
+      conn->joinChannels(autojoinChans);
     }
 
     // ── Notify list: subscribe via IRCv3 MONITOR ──
@@ -620,7 +708,7 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
                 prefix.contains('!') ? prefix.section('!', 0, 0) : prefix;
 
             // ── Ignore list filtering ──
-            if (isIgnored(prefix) || isIgnored(nick))
+            if (isIgnored(prefix))
               return;
 
             QString channel = target;
@@ -636,17 +724,9 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
 
             // Look up user's channel prefix (@, +, etc.)
             QString displayNick = nick;
-            ChannelKey key{srv, channel};
-            if (m_users.contains(key)) {
-              for (const QString &u : m_users[key]) {
-                auto [pfx, bare] = IrcConnection::stripNickPrefix(u);
-                if (bare.compare(nick, Qt::CaseInsensitive) == 0) {
-                  if (!pfx.isEmpty())
-                    displayNick = pfx[0] + nick;
-                  break;
-                }
-              }
-            }
+            const int key = channelId(srv, channel);
+            if (const NickListModel *users = findUsers(key))
+              displayNick = users->prefix(nick) + nick;
 
             QString text = "<" + displayNick + "> " + message;
             appendToChannel(srv, channel, "chat", text);
@@ -665,7 +745,7 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
                 prefix.contains('!') ? prefix.section('!', 0, 0) : prefix;
 
             // ── Ignore list filtering ──
-            if (isIgnored(prefix) || isIgnored(nick))
+            if (isIgnored(prefix))
               return;
 
             QString text = "-" + nick + "- " + message;
@@ -687,10 +767,10 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
             } else if (dest != srv) {
               // Mark channel/query tabs unread for notices (server tab excluded
               // to avoid noise from services/server notices)
-              QString ukey = unreadKey(srv, dest);
-              if (!m_unread.contains(ukey)) {
-                m_unread.insert(ukey);
-                emit unreadStateChanged();
+              const int key = channelId(srv, dest);
+              if (!m_unread.contains(key)) {
+                m_unread.insert(key);
+                m_changes.mark(key, ChangeAggregator::Activity);
               }
             }
           });
@@ -710,17 +790,19 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
           emit channelJoined(srv, channel);
 
           // Load scrollback from log file before showing "Now talking in"
-          ChannelKey key{srv, channel};
+          const int key = channelId(srv, channel);
           if (m_logger && !m_history.contains(key)) {
-            auto entries = m_logger->loadScrollback(srv, channel, 200);
+            const auto page = m_logger->loadScrollbackPage(
+                srv, channel, Logger::ScrollbackCursor(), 200);
+            const auto &entries = page.entries;
+            m_scrollbackLoaded.insert(key);
+            if (!page.atStart)
+              m_scrollbackCursor.insert(key, page.next);
             if (!entries.isEmpty()) {
-              for (const auto &e : entries) {
-                StoredMessage sm;
-                sm.type = e.type;
-                sm.text = e.text;
-                sm.timestamp = e.timestamp;
-                m_history[key].append(sm);
-              }
+              ChannelHistory &hist = history(key);
+              for (const auto &e : entries)
+                hist.append(ChannelHistory::typeFromName(e.type), e.text,
+                            ChannelHistory::parseTimestamp(e.timestamp));
             }
           }
 
@@ -729,9 +811,10 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
           // happened on a non-active connection, e.g. auto-join on reconnect)
           m_activeServer = srv;
           m_activeChannel = channel;
+          updateActiveNickList();
           if (m_msgModel) {
             m_msgModel->clear();
-            const auto &msgs = m_history[key];
+            const ChannelHistory &msgs = history(key);
 
             // Find where scrollback ends (the last "Now talking in" is the live
             // one we just appended)
@@ -748,31 +831,43 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
                                 "\u2500\u2500 Scrollback from %1 \u2500\u2500")
                                 .arg(channel));
               for (int i = 0; i < scrollbackEnd; ++i)
-                m_msgModel->addMessage(msgs[i].type, msgs[i].text);
+                m_msgModel->addMessage(
+                    ChannelHistory::typeName(msgs.typeAt(i)),
+                    msgs.textAt(i).toString());
               m_msgModel->addMessage(
                   "system", QString::fromUtf8(
                                 "\u2500\u2500 End of scrollback \u2500\u2500"));
             }
             // Show the current "Now talking in" message
-            m_msgModel->addMessage(msgs.last().type, msgs.last().text);
+            m_msgModel->addMessage(
+                ChannelHistory::typeName(msgs.typeAt(scrollbackEnd)),
+                msgs.textAt(scrollbackEnd).toString());
             m_msgModel->endBatch(); // emits reloaded() → QML does one scroll-to-bottom
           }
           // Request channel modes so we can display them
           conn->sendRaw("MODE " + channel);
         } else {
+          const int key = channelId(srv, channel);
+          // Add to user list now, so modes and nick changes that follow
+          // find it even while the line below waits
+          NickListModel *users = findUsers(key);
+          if (users && users->add(nick))
+            usersChanged(srv, channel);
+          // Split nicks coming back are reported with the rest of the netjoin
+          if (m_netsplits.join(
+                  key, nick,
+                  ChannelRegistry::fold(nick, m_channels.caseMapping(srv)),
+                  QDateTime::currentMSecsSinceEpoch())) {
+            if (!m_netsplitTimer.isActive())
+              m_netsplitTimer.start();
+            return;
+          }
           QString text = nick + " has joined " + channel;
           appendToChannel(srv, channel, "system", text);
           if (m_msgModel && m_activeServer == srv &&
               m_activeChannel == channel) {
             m_msgModel->addMessage("system", text);
           }
-          // Add to user list
-          ChannelKey key{srv, channel};
-          if (m_users.contains(key) && !m_users[key].contains(nick)) {
-            m_users[key].append(nick);
-            if (m_activeServer == srv && m_activeChannel == channel)
-              emit channelUsersChanged(channelUsers());
-          }
         }
       });
 
@@ -795,19 +890,10 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
           emit channelParted(srv, channel);
         }
         // Remove from user list
-        ChannelKey key{srv, channel};
-        if (m_users.contains(key)) {
-          auto &users = m_users[key];
-          users.erase(std::remove_if(
-                          users.begin(), users.end(),
-                          [&](const QString &u) {
-                            auto [pfx, bare] = IrcConnection::stripNickPrefix(u);
-                            return bare.compare(nick, Qt::CaseInsensitive) == 0;
-                          }),
-                      users.end());
-          if (m_activeServer == srv && m_activeChannel == channel)
-            emit channelUsersChanged(channelUsers());
-        }
+        const int key = channelId(srv, channel);
+        NickListModel *users = findUsers(key);
+        if (users && users->remove(nick))
+          usersChanged(srv, channel);
       });
 
   // QUIT
@@ -817,34 +903,44 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
         QString srv = serverNameFor(conn);
         QString nick =
             prefix.contains('!') ? prefix.section('!', 0, 0) : prefix;
+        // A netsplit: hold the QUIT for the per-channel summary
+        if (NetsplitTracker::isSplitReason(reason)) {
+          const QString folded =
+              ChannelRegistry::fold(nick, m_channels.caseMapping(srv));
+          const qint64 now = QDateTime::currentMSecsSinceEpoch();
+          for (auto it = m_users.cbegin(); it != m_users.cend(); ++it) {
+            if (!m_channels.isOnServer(it.key(), srv) ||
+                !it.value()->contains(nick))
+              continue;
+            // Gone again before its rejoin was reported: neither is shown
+            if (m_netsplits.quit(it.key(), reason, nick, folded, now) &&
+                it.value()->remove(nick))
+              usersChanged(srv, m_channels.channelName(it.key()));
+          }
+          if (m_netsplits.hasPending() && !m_netsplitTimer.isActive())
+            m_netsplitTimer.start();
+          return;
+        }
         QString text = nick + " has quit";
         if (!reason.isEmpty())
           text += " (" + reason + ")";
         // Remove from all channels on this server and show quit message
         bool emitUpdate = false;
         for (auto it = m_users.begin(); it != m_users.end(); ++it) {
-          if (it.key().server != srv)
+          if (!m_channels.isOnServer(it.key(), srv))
             continue;
-          auto &users = it.value();
-          int before = users.size();
-          users.erase(std::remove_if(
-                          users.begin(), users.end(),
-                          [&](const QString &u) {
-                            auto [pfx, bare] = IrcConnection::stripNickPrefix(u);
-                            return bare.compare(nick, Qt::CaseInsensitive) == 0;
-                          }),
-                      users.end());
-          if (users.size() != before) {
+          if (it.value()->remove(nick)) {
             // User was in this channel — show quit message there
-            appendToChannel(srv, it.key().channel, "system", text);
-            if (m_activeServer == srv && m_activeChannel == it.key().channel)
+            const QString channel = m_channels.channelName(it.key());
+            appendToChannel(srv, channel, "system", text);
+            if (m_activeServer == srv && m_activeChannel == channel)
               emitUpdate = true;
           }
         }
         if (emitUpdate) {
           if (m_msgModel)
             m_msgModel->addMessage("system", text);
-          emit channelUsersChanged(channelUsers());
+          usersChanged(m_activeServer, m_activeChannel);
         }
       });
 
@@ -864,20 +960,10 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
           m_msgModel->addMessage("system", text);
         }
         // Remove kicked user from list
-        ChannelKey key{srv, channel};
-        if (m_users.contains(key)) {
-          auto &users = m_users[key];
-          users.erase(
-              std::remove_if(users.begin(), users.end(),
-                             [&](const QString &u) {
-                               auto [pfx, bare] = IrcConnection::stripNickPrefix(u);
-                               return bare.compare(kicked,
-                                                   Qt::CaseInsensitive) == 0;
-                             }),
-              users.end());
-          if (m_activeServer == srv && m_activeChannel == channel)
-            emit channelUsersChanged(channelUsers());
-        }
+        const int key = channelId(srv, channel);
+        NickListModel *users = findUsers(key);
+        if (users && users->remove(kicked))
+          usersChanged(srv, channel);
       });
 
   // NICK change
@@ -893,34 +979,27 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
             // is present
             bool emitUpdate = false;
             for (auto it = m_users.begin(); it != m_users.end(); ++it) {
-              if (it.key().server != srv)
+              if (!m_channels.isOnServer(it.key(), srv))
                 continue;
-              auto &users = it.value();
-              for (int i = 0; i < users.size(); i++) {
-                QString entry = users[i];
-                auto [prefix, bare] = IrcConnection::stripNickPrefix(entry);
-                if (bare.compare(oldNick, Qt::CaseInsensitive) == 0) {
-                  users[i] = prefix + newNick;
-                  appendToChannel(srv, it.key().channel, "system", text);
-                  if (m_activeServer == srv &&
-                      m_activeChannel == it.key().channel) {
-                    emitUpdate = true;
-                    if (m_msgModel)
-                      m_msgModel->addMessage("system", text);
-                  }
-                  break;
-                }
+              if (!it.value()->rename(oldNick, newNick))
+                continue;
+              const QString channel = m_channels.channelName(it.key());
+              appendToChannel(srv, channel, "system", text);
+              if (m_activeServer == srv && m_activeChannel == channel) {
+                emitUpdate = true;
+                if (m_msgModel)
+                  m_msgModel->addMessage("system", text);
               }
             }
             if (emitUpdate)
-              emit channelUsersChanged(channelUsers());
+              usersChanged(m_activeServer, m_activeChannel);
           });
 
   // TOPIC
   connect(conn, &IrcConnection::topicReceived, this,
           [this, conn](const QString &channel, const QString &topic) {
             QString srv = serverNameFor(conn);
-            ChannelKey key{srv, channel};
+            const int key = channelId(srv, channel);
             m_topics[key] = topic;
             QString text = "Topic for " + channel + ": " + topic;
             appendToChannel(srv, channel, "system", text);
@@ -951,8 +1030,9 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
 
         // Update user prefixes in the nick list for channel modes
         if (target.startsWith('#')) {
-          ChannelKey key{srv, target};
-          if (!m_users.contains(key))
+          const int key = channelId(srv, target);
+          NickListModel *users = findUsers(key);
+          if (!users)
             return;
 
           // Map mode chars to prefix symbols
@@ -972,7 +1052,7 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
 
           bool adding = true;
           int paramIdx = 0;
-          QStringList &users = m_users[key];
+          bool changed = false;
 
           for (QChar c : modeStr) {
             if (c == '+') {
@@ -995,60 +1075,14 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
               continue;
             }
 
-            QString affected = params[paramIdx++];
-
-            // Find and update the user in the list
-            for (int i = 0; i < users.size(); i++) {
-              QString entry = users[i];
-              QString bareNick = entry;
-              QString currentPrefix;
-              // Strip all existing prefixes
-              while (!bareNick.isEmpty() &&
-                     QString("~&@%+").contains(bareNick[0])) {
-                currentPrefix += bareNick[0];
-                bareNick = bareNick.mid(1);
-              }
-              if (bareNick.compare(affected, Qt::CaseInsensitive) != 0)
-                continue;
-
-              if (adding) {
-                // Add prefix if not already present
-                if (!currentPrefix.contains(pfx))
-                  currentPrefix += pfx;
-              } else {
-                // Remove prefix
-                currentPrefix.remove(pfx);
-              }
-
-              // Rebuild with highest-rank prefix only (IRC convention)
-              QChar best;
-              int bestRank = 99;
-              for (QChar p : currentPrefix) {
-                int r = 99;
-                if (p == '~')
-                  r = 0;
-                else if (p == '&')
-                  r = 1;
-                else if (p == '@')
-                  r = 2;
-                else if (p == '%')
-                  r = 3;
-                else if (p == '+')
-                  r = 4;
-                if (r < bestRank) {
-                  bestRank = r;
-                  best = p;
-                }
-              }
-              users[i] = best.isNull() ? bareNick : (QString(best) + bareNick);
-              break;
-            }
+            // Members keep every prefix they hold; the list shows the
+            // highest one (IRC convention)
+            if (users->setPrefix(params[paramIdx++], pfx, adding))
+              changed = true;
           }
 
-          // Re-emit sorted list if active channel
-          if (m_activeServer == srv && m_activeChannel == target) {
-            emit channelUsersChanged(channelUsers());
-          }
+          if (changed)
+            usersChanged(srv, target);
         }
       });
 
@@ -1061,7 +1095,7 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
                 prefix.contains('!') ? prefix.section('!', 0, 0) : prefix;
 
             // ── Ignore list filtering ──
-            if (isIgnored(prefix) || isIgnored(nick))
+            if (isIgnored(prefix))
               return;
 
             // Determine the proper destination channel
@@ -1081,9 +1115,11 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
               // ── DCC SEND parsing ──
               // Format: DCC SEND <filename> <ip> <port> <filesize> [token]
               // Filename may be quoted: DCC SEND "my file.txt" 123456 1024 5000
+              // TSEND is the same offer from a sender that wants no ACKs.
               QString rest = args.trimmed();
-              if (rest.startsWith("SEND ", Qt::CaseInsensitive)) {
-                rest = rest.mid(5).trimmed();
+              const bool turbo = rest.startsWith("TSEND ", Qt::CaseInsensitive);
+              if (turbo || rest.startsWith("SEND ", Qt::CaseInsensitive)) {
+                rest = rest.mid(turbo ? 6 : 5).trimmed();
                 QString fileName;
                 if (rest.startsWith('"')) {
                   int closeQuote = rest.indexOf('"', 1);
@@ -1102,7 +1138,8 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
                   qint64 size = parts[2].toLongLong();
                   int token = parts.size() > 3 ? parts[3].toInt() : 0;
                   m_dccManager->setConnection(conn);
-                  m_dccManager->handleDccSend(nick, fileName, ip, port, size, token);
+                  m_dccManager->handleDccSend(nick, fileName, ip, port, size, token,
+                                              turbo);
                   // Show in server buffer
                   text = "DCC SEND offer from " + nick + ": " + fileName +
                          " (" + DccTransfer::formatSize(size) + ")";
@@ -1124,291 +1161,36 @@ void IRCConnectionManager::wireConnection(IrcConnection *conn) {
   connect(conn, &IrcConnection::namesReceived, this,
           [this, conn](const QString &channel, const QStringList &names) {
             QString srv = serverNameFor(conn);
-            ChannelKey key{srv, channel};
-            m_users[key] = names;
-            // Emit if this is the active channel
+            const int key = channelId(srv, channel);
+            users(key)->reset(names);
+            // The first NAMES for the active channel brings its model
             if (m_activeServer == srv && m_activeChannel == channel) {
-              emit channelUsersChanged(channelUsers());
+              updateActiveNickList();
+              usersChanged(srv, channel);
             }
           });
 
-  // Numeric replies (general — for MOTD etc.)
-  connect(
-      conn, &IrcConnection::numericReceived, this,
-      [this, conn](int code, const QStringList &params,
-                   const QString &trailing) {
-        QString srv = serverNameFor(conn);
-
-        // ── WHOIS replies (311–319, 330, 338, 378, 671) ──
-        // Accumulate all WHOIS lines into a buffer, then display as a
-        // structured block when RPL_ENDOFWHOIS (318) arrives.
-        if (code == 311) {
-          // RPL_WHOISUSER: <nick> <user> <host> * :<realname>
-          QString nick = params.value(0);
-          QString user = params.value(1);
-          QString host = params.value(2);
-          QString key = srv + "\n" + nick.toLower();
-          m_whoisBuffer[key].clear(); // start fresh
-          m_whoisBuffer[key] << nick + " (" + user + "@" + host + ")";
-          m_whoisBuffer[key] << "  Real name: " + trailing;
-        } else if (code == 312) {
-          // RPL_WHOISSERVER: <nick> <server> :<server info>
-          QString nick = params.value(0);
-          QString server = params.value(1);
-          QString key = srv + "\n" + nick.toLower();
-          m_whoisBuffer[key] << "  Server: " + server + " (" + trailing + ")";
-        } else if (code == 313) {
-          // RPL_WHOISOPERATOR
-          QString nick = params.value(0);
-          QString key = srv + "\n" + nick.toLower();
-          m_whoisBuffer[key] << "  " + trailing;
-        } else if (code == 317) {
-          // RPL_WHOISIDLE: <nick> <seconds> <signon> :seconds idle
-          QString nick = params.value(0);
-          int idleSecs = params.value(1).toInt();
-          int d = idleSecs / 86400, h = (idleSecs % 86400) / 3600,
-              m = (idleSecs % 3600) / 60, s = idleSecs % 60;
-          QString idle;
-          if (d > 0)
-            idle += QString::number(d) + "d ";
-          if (h > 0)
-            idle += QString::number(h) + "h ";
-          if (m > 0)
-            idle += QString::number(m) + "m ";
-          idle += QString::number(s) + "s";
-          QString signonTime;
-          if (params.size() > 2) {
-            qint64 ts = params.value(2).toLongLong();
-            signonTime = QDateTime::fromSecsSinceEpoch(ts).toString(
-                "yyyy-MM-dd hh:mm:ss");
-          }
-          QString key = srv + "\n" + nick.toLower();
-          QString line = "  Idle: " + idle;
-          if (!signonTime.isEmpty())
-            line += " | Signed on: " + signonTime;
-          m_whoisBuffer[key] << line;
-        } else if (code == 318) {
-          // RPL_ENDOFWHOIS — flush the accumulated WHOIS block
-          QString nick = params.value(0);
-          QString key = srv + "\n" + nick.toLower();
-          QString ch = m_activeChannel.isEmpty() ? srv : m_activeChannel;
-
-          if (m_whoisBuffer.contains(key) && !m_whoisBuffer[key].isEmpty()) {
-            // Display as a structured block with separator
-            QString sep = "━━━━━━━━ WHOIS " + nick + " ━━━━━━━━";
-            if (m_msgModel) m_msgModel->addMessage("system", sep);
-            appendToChannel(srv, ch, "system", sep);
-
-            for (const QString &line : m_whoisBuffer[key]) {
-              if (m_msgModel) m_msgModel->addMessage("system", line);
-              appendToChannel(srv, ch, "system", line);
-            }
-
-            QString endSep = "━━━━━━━━ End of WHOIS ━━━━━━━━";
-            if (m_msgModel) m_msgModel->addMessage("system", endSep);
-            appendToChannel(srv, ch, "system", endSep);
-            m_whoisBuffer.remove(key);
-          } else {
-            // No data accumulated (shouldn't happen normally)
-            QString text = "[WHOIS] No information for " + nick;
-            if (m_msgModel) m_msgModel->addMessage("system", text);
-            appendToChannel(srv, ch, "system", text);
-          }
-        } else if (code == 319) {
-          // RPL_WHOISCHANNELS: <nick> :<channels>
-          QString nick = params.value(0);
-          QString key = srv + "\n" + nick.toLower();
-          m_whoisBuffer[key] << "  Channels: " + trailing;
-        } else if (code == 330) {
-          // RPL_WHOISACCOUNT: <nick> <account> :is logged in as
-          QString nick = params.value(0);
-          QString acct = params.value(1);
-          QString key = srv + "\n" + nick.toLower();
-          m_whoisBuffer[key] << "  Account: " + acct;
-        } else if (code == 338) {
-          // RPL_WHOISACTUALLY: <nick> <ip> :actually using host
-          QString nick = params.value(0);
-          QString ip = params.value(1);
-          QString key = srv + "\n" + nick.toLower();
-          m_whoisBuffer[key] << "  Actual host: " + ip;
-        } else if (code == 378) {
-          // RPL_WHOISHOST: connecting from
-          QString nick = params.value(0);
-          QString key = srv + "\n" + nick.toLower();
-          m_whoisBuffer[key] << "  " + trailing;
-        } else if (code == 671) {
-          // RPL_WHOISSECURE
-          QString nick = params.value(0);
-          QString key = srv + "\n" + nick.toLower();
-          m_whoisBuffer[key] << "  " + trailing;
-        } else if (code == 324) {
-          // RPL_CHANNELMODEIS: <channel> <modes> [<mode params>]
-          QString channel = params.value(1);
-          QString modes = params.value(2);
-          QStringList modeParams = params.mid(3);
-          QString text = "Channel modes for " + channel + ": " + modes;
-          if (!modeParams.isEmpty())
-            text += " " + modeParams.join(" ");
-          // Store the mode string for display in the topic bar
-          ChannelKey key{srv, channel};
-          m_modes[key] = modes;
-          if (m_activeServer == srv && m_activeChannel == channel)
-            emit channelModesChanged(modes);
-          appendToChannel(srv, channel, "system", text);
-          if (m_msgModel && m_activeServer == srv && m_activeChannel == channel)
-            m_msgModel->addMessage("system", text);
-        } else if (code == 329) {
-          // RPL_CREATIONTIME: <channel> <timestamp>
-          QString channel = params.value(1);
-          qint64 ts = params.value(2).toLongLong();
-          QString timeStr = QDateTime::fromSecsSinceEpoch(ts).toString(
-              "ddd MMM d hh:mm:ss yyyy");
-          QString text = "Channel " + channel + " created on " + timeStr;
-          appendToChannel(srv, channel, "system", text);
-          if (m_msgModel && m_activeServer == srv && m_activeChannel == channel)
-            m_msgModel->addMessage("system", text);
-        } else if (code == 314) {
-          // RPL_WHOWASUSER
-          QString nick = params.value(1);
-          QString user = params.value(2);
-          QString host = params.value(3);
-          QString text = "[WHOWAS] " + nick + " was " + user + "@" + host +
-                         " : " + trailing;
-          if (m_msgModel)
-            m_msgModel->addMessage("system", text);
-          appendToChannel(srv,
-                          m_activeChannel.isEmpty() ? srv : m_activeChannel,
-                          "system", text);
-        }
-
-        // RPL_UNAWAY (305) and RPL_NOWAWAY (306) — track away state
-        else if (code == 305) {
-          // You are no longer marked as being away
-          m_isAway = false;
-          emit awayStateChanged(false);
-          QString text = trailing.isEmpty()
-                             ? "You are no longer marked as being away"
-                             : trailing;
-          appendToChannel(srv,
-                          m_activeChannel.isEmpty() ? srv : m_activeChannel,
-                          "system", text);
-          if (m_msgModel)
-            m_msgModel->addMessage("system", text);
-          // Show away log summary if there were messages
-          if (!m_awayLog.isEmpty()) {
-            if (m_msgModel)
-              m_msgModel->addMessage(
-                  "system", "You have " + QString::number(m_awayLog.size()) +
-                                " message(s) in your away log. Use View > Away "
-                                "Log to see them.");
-          }
-        } else if (code == 306) {
-          // You have been marked as being away
-          m_isAway = true;
-          m_awayLog.clear();
-          emit awayStateChanged(true);
-          QString text = trailing.isEmpty()
-                             ? "You have been marked as being away"
-                             : trailing;
-          appendToChannel(srv,
-                          m_activeChannel.isEmpty() ? srv : m_activeChannel,
-                          "system", text);
-          if (m_msgModel)
-            m_msgModel->addMessage("system", text);
-        }
-
-        // ── MONITOR notify list: RPL_MONONLINE (730) / RPL_MONOFFLINE (731) ──
-        else if (code == 730 || code == 731) {
-          // trailing: comma-separated nick[!user@host] list
-          const QStringList targets = trailing.split(',', Qt::SkipEmptyParts);
-          for (const QString &t : targets) {
-            QString nick = t.section('!', 0, 0).trimmed();
-            if (nick.isEmpty()) continue;
-            bool online = (code == 730);
-            QString text = nick + (online
-                ? QStringLiteral(" is online (notify)")
-                : QStringLiteral(" is offline (notify)"));
-            appendToChannel(srv, srv, "system", text);
-            if (m_msgModel && m_activeServer == srv)
-              m_msgModel->addMessage("system", text);
-            if (online)
-              emit notifyUser(QStringLiteral("Notify"), text, false, false);
-          }
-        }
-
-        // ── RPL_BANLIST (367): <channel> <mask> <setter> <timestamp> ──
-        else if (code == 367) {
-          // params[0]=channel, [1]=mask, [2]=setter, [3]=timestamp
-          // (our nick was already stripped by IrcConnection)
-          QString channel = params.value(0);
-          QString mask = params.value(1);
-          QString setter = params.value(2);
-          // The timestamp is a Unix epoch; convert to readable
-          QString timeStr;
-          if (params.size() > 3) {
-            qint64 ts = params.value(3).toLongLong();
-            timeStr = QDateTime::fromSecsSinceEpoch(ts).toString(
-                "yyyy-MM-dd hh:mm");
-          }
-          emit banListEntry(channel, mask, setter, timeStr);
-        }
-        // ── RPL_ENDOFBANLIST (368) ──
-        else if (code == 368) {
-          QString channel = params.value(0);
-          emit banListEnd(channel);
-        }
-        else if ((code >= 372 && code <= 376) || code == 2 || code == 3 ||
-                 code == 4 || code == 5 || code == 251 || code == 252 ||
-                 code == 253 || code == 254 || code == 255 || code == 265 ||
-                 code == 266) {
-          appendToChannel(srv, srv, "system", trailing);
-          if (m_activeServer == srv &&
-              (m_activeChannel.isEmpty() || m_activeChannel == srv)) {
-            if (m_msgModel)
-              m_msgModel->addMessage("system", trailing);
-          }
-        }
-        // Error numerics — route to the relevant channel if mentioned in
-        // params, else server tab
-        if (code >= 400 && code < 600) {
-          QString text = "[" + QString::number(code) + "] " + trailing;
-          // Some error numerics mention a channel in params (e.g. 404 #channel
-          // :Cannot send)
-          QString dest = srv;
-          for (int pi = 1; pi < params.size(); pi++) {
-            if (params[pi].startsWith('#') || params[pi].startsWith('&')) {
-              dest = params[pi];
-              break;
-            }
-          }
-          appendToChannel(srv, dest, "error", text);
-          if (m_msgModel && m_activeServer == srv && m_activeChannel == dest)
-            m_msgModel->addMessage("error", text);
-        }
-      });
+  // Numeric replies (general — for MOTD etc.), see NumericTable.cpp
+  connect(conn, &IrcConnection::numericReceived, this,
+          [this, conn](int code, const QStringList &params,
+                       const QString &trailing) {
+            dispatchNumeric(conn, code, params, trailing);
+          });
 }
 
 void IRCConnectionManager::appendToChannel(const QString &server,
                                            const QString &channel,
                                            const QString &type,
                                            const QString &text) {
+  const int key = channelId(server, channel);
   // Make sure scrollback is populated into history before we start appending
   // new messages
-  ensureScrollbackLoaded(server, channel);
-
-  ChannelKey key{server, channel};
-  StoredMessage msg;
-  msg.type = type;
-  msg.text = text;
-  msg.timestamp = QDateTime::currentDateTime().toString(Qt::ISODate);
-  auto &hist = m_history[key];
-  hist.append(msg);
-
-  // Enforce per-channel history cap to prevent unbounded memory growth
-  if (hist.size() > kMaxHistoryPerChannel) {
-    int excess = hist.size() - kMaxHistoryPerChannel;
-    hist.remove(0, excess);
-  }
+  if (!m_scrollbackLoaded.contains(key))
+    ensureScrollbackLoaded(server, channel);
+
+  // Bounded ring: the oldest line drops out once the channel is full
+  history(key).append(ChannelHistory::typeFromName(type), text,
+                      QDateTime::currentMSecsSinceEpoch());
 
   // Log to file
   if (m_logger)
@@ -1417,13 +1199,12 @@ void IRCConnectionManager::appendToChannel(const QString &server,
   // Track unread state for non-active channels
   bool isActive = (server == m_activeServer && channel == m_activeChannel);
   if (!isActive && (type == "chat" || type == "action")) {
-    QString ukey = unreadKey(server, channel);
     bool changed = false;
     bool isNickHighlight = false;
     bool isPrivateMsg = false;
 
-    if (!m_unread.contains(ukey)) {
-      m_unread.insert(ukey);
+    if (!m_unread.contains(key)) {
+      m_unread.insert(key);
       changed = true;
     }
     // Check for nick highlight (whole-word mention of our nick)
@@ -1431,8 +1212,8 @@ void IRCConnectionManager::appendToChannel(const QString &server,
       QString myNick = conn->nickname();
       if (!myNick.isEmpty() && MessageModel::containsNickWord(text, myNick)) {
         isNickHighlight = true;
-        if (!m_highlighted.contains(ukey)) {
-          m_highlighted.insert(ukey);
+        if (!m_highlighted.contains(key)) {
+          m_highlighted.insert(key);
           changed = true;
         }
       }
@@ -1441,13 +1222,13 @@ void IRCConnectionManager::appendToChannel(const QString &server,
     if (!channel.startsWith('#') && !channel.startsWith('&') &&
         channel != server) {
       isPrivateMsg = true;
-      if (!m_highlighted.contains(ukey)) {
-        m_highlighted.insert(ukey);
+      if (!m_highlighted.contains(key)) {
+        m_highlighted.insert(key);
         changed = true;
       }
     }
     if (changed)
-      emit unreadStateChanged();
+      m_changes.mark(key, ChangeAggregator::Activity);
 
     // Fire desktop notification for highlights and PMs
     if (isNickHighlight || isPrivateMsg) {
@@ -1499,65 +1280,195 @@ void IRCConnectionManager::appendToChannel(const QString &server,
 
 void IRCConnectionManager::ensureScrollbackLoaded(const QString &server,
                                                   const QString &channel) {
-  QString ukey = unreadKey(server, channel);
-  if (m_scrollbackLoaded.contains(ukey)) {
+  const int key = channelId(server, channel);
+  if (m_scrollbackLoaded.contains(key)) {
     return;
   }
-  m_scrollbackLoaded.insert(ukey);
+  m_scrollbackLoaded.insert(key);
 
   if (!m_logger) {
     return;
   }
 
-  auto entries = m_logger->loadScrollback(server, channel, 200);
+  const auto page = m_logger->loadScrollbackPage(
+      server, channel, Logger::ScrollbackCursor(), 200);
+  if (!page.atStart)
+    m_scrollbackCursor.insert(key, page.next);
+  const auto &entries = page.entries;
   if (entries.isEmpty()) {
     return;
   }
 
-  ChannelKey key{server, channel};
-
   // We want to insert the scrollback BEFORE any existing messages in m_history
-  // for this session.
-  QVector<StoredMessage> prependedHistory;
-
-  StoredMessage startHeader;
-  startHeader.type = "system";
-  startHeader.text = "── Scrollback from " + channel + " ──";
-  startHeader.timestamp = QDateTime::currentDateTime().toString(Qt::ISODate);
-  prependedHistory.append(startHeader);
-
-  for (const auto &e : entries) {
-    StoredMessage sm;
-    sm.type = e.type;
-    sm.text = e.text;
-    sm.timestamp = e.timestamp;
-    prependedHistory.append(sm);
-  }
-
-  StoredMessage endHeader;
-  endHeader.type = "system";
-  endHeader.text = "── End of scrollback ──";
-  endHeader.timestamp = QDateTime::currentDateTime().toString(Qt::ISODate);
-  prependedHistory.append(endHeader);
-
-  // If we already received some elements in this session (should be rare since
-  // we call this on the first append), append those afterward.
-  if (m_history.contains(key)) {
-    prependedHistory.append(m_history[key]);
-  }
-
-  m_history[key] = prependedHistory;
+  // for this session (should be rare since we call this on the first append).
+  const qint64 now = QDateTime::currentMSecsSinceEpoch();
+  QVector<ChannelHistory::Line> scrollback;
+  scrollback.reserve(entries.size() + 2);
+  scrollback.append({ChannelHistory::Type::System,
+                     "── Scrollback from " + channel + " ──", now});
+  for (const auto &e : entries)
+    scrollback.append({ChannelHistory::typeFromName(e.type), e.text,
+                       ChannelHistory::parseTimestamp(e.timestamp)});
+  scrollback.append(
+      {ChannelHistory::Type::System, QStringLiteral("── End of scrollback ──"), now});
+
+  history(key).insertOlder(0, scrollback);
 }
 
 void IRCConnectionManager::cleanupChannelState(const QString &server,
                                                 const QString &channel) {
-  ChannelKey key{server, channel};
+  const int key = channelId(server, channel);
   m_history.remove(key);
-  m_users.remove(key);
+  // The model may be the one on screen; it is emptied, not deleted
+  if (NickListModel *users = findUsers(key))
+    users->clear();
   m_topics.remove(key);
   m_modes.remove(key);
   // Also remove the scrollback-loaded marker so it reloads if re-joined
-  m_scrollbackLoaded.remove(unreadKey(server, channel));
+  m_scrollbackLoaded.remove(key);
+  m_scrollbackCursor.remove(key);
+  m_netsplits.forget(key);
+}
+
+void IRCConnectionManager::flushNetsplits() {
+  // One line per channel instead of one per nick; long lists are cut short
+  static constexpr int kMaxNicksShown = 30;
+  bool activeChanged = false;
+  const auto events = m_netsplits.take(QDateTime::currentMSecsSinceEpoch());
+  for (const NetsplitTracker::Event &e : events) {
+    NickListModel *users = findUsers(e.channel);
+    if (!users)
+      continue;
+    // Rejoined nicks were listed at their JOIN; name those still there
+    QStringList nicks;
+    if (e.rejoin) {
+      for (const QString &nick : e.nicks) {
+        if (users->contains(nick))
+          nicks.append(nick);
+      }
+    } else if (users->removeAll(e.nicks) > 0) {
+      nicks = e.nicks;
+    }
+    if (nicks.isEmpty())
+      continue;
+
+    QString list = nicks.mid(0, kMaxNicksShown).join(", ");
+    if (nicks.size() > kMaxNicksShown)
+      list += QString(" (+%1 more)").arg(nicks.size() - kMaxNicksShown);
+    const QString servers =
+        QString(e.servers).replace(' ', QString::fromUtf8(" \u2194 "));
+    const QString text = e.rejoin
+                             ? "Netsplit over " + servers + ", joins: " + list
+                             : "Netsplit " + servers + ", quits: " + list;
+    const QString server = m_channels.serverName(e.channel);
+    const QString channel = m_channels.channelName(e.channel);
+    appendToChannel(server, channel, "system", text);
+    if (server == m_activeServer && channel == m_activeChannel) {
+      if (m_msgModel)
+        m_msgModel->addMessage("system", text);
+      activeChanged = true;
+    }
+  }
+  if (activeChanged)
+    usersChanged(m_activeServer, m_activeChannel);
+}
+
+bool IRCConnectionManager::loadOlderHistory(const QString &server,
+                                            const QString &channel,
+                                            int maxLines) {
+  const int key = channelId(server, channel);
+  if (!m_logger)
+    return false;
+  const bool shown =
+      m_msgModel && server == m_activeServer && channel == m_activeChannel;
+
+  auto cursorIt = m_scrollbackCursor.find(key);
+  if (cursorIt == m_scrollbackCursor.end())
+    return false;
+  ChannelHistory &hist = history(key);
+  const int room = hist.capacity() - hist.size();
+  // Past the per-channel cap, pages go straight from the log to the view.
+  // They are not kept: switching back rebuilds the view from the history.
+  if (room <= 0)
+    return shown && loadOlderIntoView(server, channel, maxLines);
+
+  const auto page = m_logger->loadScrollbackPage(server, channel, *cursorIt,
+                                                 qMin(maxLines, room));
+  if (page.atStart)
+    m_scrollbackCursor.erase(cursorIt);
+  else
+    *cursorIt = page.next;
+  if (page.entries.isEmpty())
+    return false;
+
+  // Older lines go just below the "Scrollback from" header, if there is one
+  int insertAt = 0;
+  if (!hist.isEmpty() && hist.typeAt(0) == ChannelHistory::Type::System &&
+      hist.textAt(0).contains(QLatin1String("Scrollback from ")))
+    insertAt = 1;
+  QVector<ChannelHistory::Line> older;
+  older.reserve(page.entries.size());
+  QList<MessageModel::Entry> rows;
+  rows.reserve(page.entries.size());
+  for (const auto &e : page.entries) {
+    older.append({ChannelHistory::typeFromName(e.type), e.text,
+                  ChannelHistory::parseTimestamp(e.timestamp)});
+    rows.append({e.type, e.text, e.timestamp});
+  }
+  hist.insertOlder(insertAt, older);
+
+  if (shown)
+    m_msgModel->prependMessages(rows);
+  return !page.atStart;
+}
+
+// A full ring has evicted lines since the cursor was set (and a rotation
+// moves lines to another file), so the cursor no longer says where the view
+// starts: page by time instead, before the first log line the view shows.
+// The log only has whole seconds; lines of that second the view already
+// holds are dropped from the end of the page.
+bool IRCConnectionManager::loadOlderIntoView(const QString &server,
+                                             const QString &channel,
+                                             int maxLines) {
+  const int count = m_msgModel->rowCount();
+  const auto textAt = [this](int row) {
+    return m_msgModel->index(row).data(MessageModel::TextRole).toString();
+  };
+  const auto secondAt = [this](int row) {
+    const qint64 ms = ChannelHistory::parseTimestamp(
+        m_msgModel->index(row).data(MessageModel::TimestampRole).toString());
+    return ms - ms % 1000;
+  };
+  int row = 0;
+  if (count > 0 &&
+      m_msgModel->index(0).data(MessageModel::TypeRole).toString() ==
+          QLatin1String("system") &&
+      textAt(0).contains(QLatin1String("Scrollback from ")))
+    row = 1;
+  if (row >= count)
+    return false;
+  const qint64 second = secondAt(row);
+  if (second <= 0)
+    return false;
+  QSet<QString> held;
+  for (int r = row; r < count && secondAt(r) == second; ++r)
+    held.insert(textAt(r));
+
+  auto page = m_logger->loadScrollbackBefore(server, channel, second + 1000,
+                                             maxLines + int(held.size()));
+  while (!page.entries.isEmpty()) {
+    const auto &e = page.entries.last();
+    const qint64 ms = ChannelHistory::parseTimestamp(e.timestamp);
+    if (ms - ms % 1000 != second || !held.contains(e.text))
+      break;
+    page.entries.removeLast();
+  }
+  QList<MessageModel::Entry> rows;
+  rows.reserve(page.entries.size());
+  for (const auto &e : page.entries)
+    rows.append({e.type, e.text, e.timestamp});
+  m_msgModel->prependMessages(rows);
+  return !page.atStart;
 }
 
 QString IRCConnectionManager::serverNameFor(IrcConnection *conn) const {
@@ -1566,24 +1477,24 @@ QString IRCConnectionManager::serverNameFor(IrcConnection *conn) const {
 
 bool IRCConnectionManager::hasUnread(const QString &server,
                                      const QString &channel) const {
-  return m_unread.contains(unreadKey(server, channel));
+  return m_unread.contains(findChannelId(server, channel));
 }
 
 bool IRCConnectionManager::hasHighlight(const QString &server,
                                         const QString &channel) const {
-  return m_highlighted.contains(unreadKey(server, channel));
+  return m_highlighted.contains(findChannelId(server, channel));
 }
 
 void IRCConnectionManager::clearUnread(const QString &server,
                                        const QString &channel) {
-  QString ukey = unreadKey(server, channel);
+  const int key = channelId(server, channel);
   bool changed = false;
-  if (m_unread.remove(ukey))
+  if (m_unread.remove(key))
     changed = true;
-  if (m_highlighted.remove(ukey))
+  if (m_highlighted.remove(key))
     changed = true;
   if (changed)
-    emit unreadStateChanged();
+    m_changes.mark(key, ChangeAggregator::Activity);
 }
 
 // ── /SYSINFO helper ──
@@ -1752,6 +1663,7 @@ void IRCConnectionManager::addIgnore(const QString &mask) {
     normalized = normalized + "!*@*";
   if (!m_ignoreList.contains(normalized, Qt::CaseInsensitive)) {
     m_ignoreList.append(normalized);
+    m_ignoreMatcher.setMasks(m_ignoreList);
     if (m_settings) {
       m_settings->setValue("ignore/list", m_ignoreList);
       m_settings->sync();
@@ -1770,6 +1682,7 @@ void IRCConnectionManager::removeIgnore(const QString &mask) {
       m_ignoreList.removeAt(i);
     }
   }
+  m_ignoreMatcher.setMasks(m_ignoreList);
   if (m_settings) {
     m_settings->setValue("ignore/list", m_ignoreList);
     m_settings->sync();
@@ -1781,6 +1694,7 @@ QStringList IRCConnectionManager::ignoreList() const { return m_ignoreList; }
 
 void IRCConnectionManager::clearIgnoreList() {
   m_ignoreList.clear();
+  m_ignoreMatcher.setMasks(m_ignoreList);
   if (m_settings) {
     m_settings->setValue("ignore/list", m_ignoreList);
     m_settings->sync();
@@ -1788,30 +1702,10 @@ void IRCConnectionManager::clearIgnoreList() {
   emit ignoreListChanged();
 }
 
-bool IRCConnectionManager::isIgnored(const QString &nickOrMask) const {
-  if (m_ignoreList.isEmpty())
-    return false;
-
-  for (const QString &pattern : m_ignoreList) {
-    // Convert the ignore mask pattern to a regex: * → .*, ? → .
-    QString regex = QRegularExpression::escape(pattern);
-    regex.replace("\\*", ".*").replace("\\?", ".");
-    QRegularExpression re("^" + regex + "$",
-                          QRegularExpression::CaseInsensitiveOption);
-    if (re.match(nickOrMask).hasMatch())
-      return true;
-    // Also try matching just the nick part if the input is a full prefix
-    if (nickOrMask.contains('!')) {
-      QString nick = nickOrMask.section('!', 0, 0);
-      // Check if the pattern is a simple nick!*@* pattern
-      QString patternNick = pattern.section('!', 0, 0);
-      if (!patternNick.contains('*') && !patternNick.contains('?')) {
-        if (nick.compare(patternNick, Qt::CaseInsensitive) == 0)
-          return true;
-      }
-    }
-  }
-  return false;
+// Masks are compiled by m_ignoreMatcher when the list changes; a lookup
+// is one pass over the sender's nick!user@host.
+bool IRCConnectionManager::isIgnored(const QString &prefix) const {
+  return m_ignoreMatcher.matches(prefix);
 }
 
 // ═══════════════════════════════════════════════════════════════════
@@ -1831,7 +1725,8 @@ void IRCConnectionManager::attemptReconnect(const QString &host) {
 
   ReconnectInfo &ri = m_reconnectInfo[host];
   int maxAttempts = m_settings->getInt("conn/maxReconnectAttempts", 10);
-  int delay = m_settings->getInt("conn/reconnectDelay", 10);
+  // The setting is the longest wait; the first retry comes much sooner
+  const int maxDelayMs = m_settings->getInt("conn/reconnectDelay", 10) * 1000;
 
   if (maxAttempts > 0 && ri.attempts >= maxAttempts) {
     QString msg = "Auto-reconnect: max attempts (" +
@@ -1843,8 +1738,11 @@ void IRCConnectionManager::attemptReconnect(const QString &host) {
   }
 
   ri.attempts++;
+  const int delayMs =
+      reconnectDelayMs(ri.attempts, kReconnectBaseDelayMs, maxDelayMs,
+                       QRandomGenerator::global()->generateDouble());
   QString msg = "Auto-reconnect: attempting to reconnect to " + ri.host + " in " +
-                QString::number(delay) + "s (attempt " +
+                QString::number(delayMs / 1000.0, 'f', 1) + "s (attempt " +
                 QString::number(ri.attempts) + "/" +
                 (maxAttempts > 0 ? QString::number(maxAttempts) : "∞") + ")";
   appendToChannel(host, host, "system", msg);
@@ -1859,6 +1757,10 @@ void IRCConnectionManager::attemptReconnect(const QString &host) {
     oldConn->deleteLater();
   }
 
+  // Resolve while we wait: the lookup lands in Qt's host cache, so the
+  // socket doesn't pay for DNS when the timer fires.
+  QHostInfo::lookupHost(ri.host, this, [](const QHostInfo &) {});
+
   // Set up a timer
   if (ri.timer) {
     ri.timer->stop();
@@ -1894,6 +1796,7 @@ void IRCConnectionManager::attemptReconnect(const QString &host) {
 
     m_activeServer = host;
     m_activeChannel = host;
+    updateActiveNickList();
 
     QString reconnMsg =
         "Reconnecting to " + info.host + ":" + QString::number(info.port) + "...";
@@ -1902,12 +1805,23 @@ void IRCConnectionManager::attemptReconnect(const QString &host) {
       m_msgModel->addMessage("system", reconnMsg);
 
     applyProxySettings(conn);
+    applySendProfile(conn);
     if (m_settings)
       conn->setAllowSelfSignedCerts(
           m_settings->getBool("conn/allowSelfSignedCerts", false));
     conn->connectToServer(info.host, static_cast<quint16>(info.port), info.ssl);
   });
-  ri.timer->start(delay * 1000);
+  ri.timer->start(delayMs);
+}
+
+int IRCConnectionManager::reconnectDelayMs(int attempt, int baseMs, int maxMs,
+                                           double jitter) {
+  // Exponential backoff with "equal jitter": half the step is fixed, the
+  // other half random, so clients dropped by the same netsplit don't all
+  // come back in the same second.
+  const int shift = qBound(0, attempt - 1, 20);
+  const qint64 step = qMin<qint64>(qMax(baseMs, maxMs), qint64(baseMs) << shift);
+  return int(step / 2 + qint64(jitter * (step - step / 2)));
 }
 
 // ═══════════════════════════════════════════════════════════════════
@@ -2029,6 +1943,13 @@ void IRCConnectionManager::clearAwayLog() {
 //  Proxy Support
 // ═══════════════════════════════════════════════════════════════════
 
+void IRCConnectionManager::applySendProfile(IrcConnection *conn) {
+  QString name;
+  if (m_settings)
+    name = m_settings->getString("sendProfile/" + m_connToName.value(conn));
+  conn->setSendProfile(SendScheduler::profileNamed(name));
+}
+
 void IRCConnectionManager::applyProxySettings(IrcConnection *conn) {
   if (!m_settings || !conn)
     return;
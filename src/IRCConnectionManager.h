@@ -1,5 +1,12 @@
 #pragma once
 
+#include "ChangeAggregator.h"
+#include "ChannelHistory.h"
+#include "ChannelRegistry.h"
+#include "IgnoreMatcher.h"
+#include "Logger.h"
+#include "NetsplitTracker.h"
+#include "NickListModel.h"
 #include <QElapsedTimer>
 #include <QHash>
 #include <QMap>
@@ -10,12 +17,12 @@
 #include <QVariantList>
 #include <QVariantMap>
 #include <QVector>
+#include <array>
 #include <functional>
 
 class IrcConnection;
 class MessageModel;
 class ServerChannelModel;
-class Logger;
 class Settings;
 class DccManager;
 
@@ -25,6 +32,7 @@ class IRCConnectionManager : public QObject {
   Q_PROPERTY(QString channelTopic READ channelTopic NOTIFY channelTopicChanged)
   Q_PROPERTY(
       QStringList channelUsers READ channelUsers NOTIFY channelUsersChanged)
+  Q_PROPERTY(NickListModel *nickList READ nickList NOTIFY nickListChanged)
   Q_PROPERTY(bool isAway READ isAway NOTIFY awayStateChanged)
   Q_PROPERTY(int lagMs READ lagMs NOTIFY lagChanged)
 
@@ -66,6 +74,16 @@ public:
                                 const QString &channelName);
   Q_INVOKABLE void closeServer(const QString &serverName);
   Q_INVOKABLE void sendMessage(const QString &target, const QString &message);
+  // Several lines at once (a paste): queued on the bulk lane, so anything
+  // typed meanwhile overtakes them
+  Q_INVOKABLE void sendMessages(const QString &target,
+                                const QStringList &lines);
+  // sendMessage() through conn, which need not be the active connection
+  void sendMessage(IrcConnection *conn, const QString &target,
+                   const QString &message);
+  // The same on conn's bulk lane, for script output
+  void sendBulkMessage(IrcConnection *conn, const QString &target,
+                       const QString &message);
   Q_INVOKABLE void sendRawCommand(const QString &raw);
   Q_INVOKABLE void changeNick(const QString &newNick);
 
@@ -76,6 +94,11 @@ public:
   // Per-channel message history
   Q_INVOKABLE void switchToChannel(const QString &serverName,
                                    const QString &channel);
+  // Page older lines for a channel in from its log (the chat view calls this
+  // when scrolled to the top).  Returns false once the log is exhausted.
+  Q_INVOKABLE bool loadOlderHistory(const QString &server,
+                                    const QString &channel,
+                                    int maxLines = 200);
 
   // Open a private query tab (creates tab if needed, switches to it)
   Q_INVOKABLE void openQuery(const QString &serverName, const QString &nick);
@@ -88,6 +111,12 @@ public:
   Q_INVOKABLE void clearUnread(const QString &server, const QString &channel);
   Q_INVOKABLE bool anyUnread() const { return !m_unread.isEmpty(); }
   Q_INVOKABLE bool anyHighlight() const { return !m_highlighted.isEmpty(); }
+  // The same for every spelling of a channel under the server's
+  // CASEMAPPING; -1 for one never seen
+  Q_INVOKABLE int channelKey(const QString &server,
+                             const QString &channel) const {
+    return findChannelId(server, channel);
+  }
 
   // ── Ignore list ──
   Q_INVOKABLE void addIgnore(const QString &mask);
@@ -109,33 +138,30 @@ public:
   QString channelTopic() const;
   // Raw topic text (mIRC control codes intact) — for inline topic editing
   Q_INVOKABLE QString channelTopicRaw() const;
+  // Snapshot of the active channel's nick list; nickList is the live model
   QStringList channelUsers() const;
+  NickListModel *nickList() const;
   Q_INVOKABLE QString channelModes() const;
 
-  // Channel message history
-  struct ChannelKey {
-    QString server;
-    QString channel;
-    bool operator<(const ChannelKey &o) const {
-      int cmp = server.compare(o.server, Qt::CaseInsensitive);
-      if (cmp != 0)
-        return cmp < 0;
-      return channel.compare(o.channel, Qt::CaseInsensitive) < 0;
-    }
-    bool operator==(const ChannelKey &o) const {
-      return server.compare(o.server, Qt::CaseInsensitive) == 0 &&
-             channel.compare(o.channel, Qt::CaseInsensitive) == 0;
-    }
-    friend size_t qHash(const ChannelKey &k, size_t seed = 0) {
-      return qHash(k.server.toLower(), seed) ^ qHash(k.channel.toLower(), seed);
-    }
-  };
-
-  struct StoredMessage {
-    QString type;
-    QString text;
-    QString timestamp;
-  };
+  // ── Numeric dispatch table ──
+  // Handlers receive (conn, server name, numeric, params without our nick,
+  // trailing).  Every handler registered for a numeric runs, in order; the
+  // built-in ones are registered first, so plugins and scripts see the
+  // numeric after the client has updated its own state.
+  using NumericHandler = std::function<void(
+      IrcConnection *conn, const QString &server, int code,
+      const QStringList &params, const QString &trailing)>;
+  static constexpr int kNumericTableSize = 1000;
+  // Returns an id for unregisterNumericHandler(), or -1 if code is out of
+  // range.
+  int registerNumericHandler(int code, NumericHandler handler);
+  void unregisterNumericHandler(int id);
+
+  // ── Auto-reconnect ──
+  // Wait before the given (1-based) attempt: baseMs doubling per attempt up
+  // to maxMs, of which a random half (jitter in [0, 1)) is dropped.
+  static constexpr int kReconnectBaseDelayMs = 1000;
+  static int reconnectDelayMs(int attempt, int baseMs, int maxMs, double jitter);
 
 signals:
   void clientAdded(IrcConnection *conn);
@@ -147,9 +173,13 @@ signals:
   void serverClosed(const QString &serverName);
   void channelTopicChanged(const QString &topic);
   void channelUsersChanged(const QStringList &users);
+  void nickListChanged();
   void channelModesChanged(const QString &modes);
   void rawLineReceived(const QString &direction, const QString &line);
   void unreadStateChanged();
+  // One per channel whose unread/highlight state changed, once per frame
+  void channelActivityChanged(const QString &server, const QString &channel,
+                              bool unread, bool highlight);
   void ignoreListChanged();
   void awayStateChanged(bool away);
   void awayLogUpdated();
@@ -170,14 +200,19 @@ private:
   QString serverNameFor(IrcConnection *conn) const;
   IrcConnection *connectionForServer(const QString &name) const;
   static QString gatherSysInfo();
-  bool isIgnored(const QString &nickOrMask) const;
+  bool isIgnored(const QString &prefix) const;
   void extractUrls(const QString &text, const QString &nick,
                    const QString &channel);
   void executePerformCommands(const QString &server);
   void attemptReconnect(const QString &host);
   void applyProxySettings(IrcConnection *conn);
+  // Per-network send scheduler profile ("sendProfile/<network>")
+  void applySendProfile(IrcConnection *conn);
   void ensureScrollbackLoaded(const QString &server, const QString &channel);
   void cleanupChannelState(const QString &server, const QString &channel);
+  // loadOlderHistory() once the channel's history is full
+  bool loadOlderIntoView(const QString &server, const QString &channel,
+                         int maxLines);
   // ── Command dispatch table ──
   // Each handler receives (conn, target, args) and returns true if consumed.
   using CommandHandler = std::function<bool(IrcConnection *conn,
@@ -188,6 +223,16 @@ private:
   // Dispatch /command input — returns true if the message was consumed.
   bool handleSlashCommand(IrcConnection *conn, const QString &target,
                           const QString &cmd, const QString &args);
+  // Indexed directly by numeric (000–999); see NumericTable.cpp.
+  struct NumericEntry {
+    int id;
+    NumericHandler handler;
+  };
+  std::array<QVector<NumericEntry>, kNumericTableSize> m_numericTable;
+  int m_nextNumericHandlerId = 1;
+  void initNumericTable();
+  void dispatchNumeric(IrcConnection *conn, int code,
+                       const QStringList &params, const QString &trailing);
 
   QVector<IrcConnection *> m_connections;
   QMap<IrcConnection *, QString> m_connToName; // conn -> display name (host)
@@ -199,23 +244,49 @@ private:
   QString m_activeServer;
   QString m_activeChannel;
 
+  // Per-channel state is keyed by ChannelRegistry id
+  ChannelRegistry m_channels;
+  int channelId(const QString &server, const QString &channel) {
+    return m_channels.intern(server, channel);
+  }
+  int findChannelId(const QString &server, const QString &channel) const {
+    return m_channels.find(server, channel);
+  }
+
   // Per-channel message history
   static constexpr int kMaxHistoryPerChannel = 5000;
-  QMap<ChannelKey, QVector<StoredMessage>> m_history;
+  QHash<int, ChannelHistory> m_history;
+  ChannelHistory &history(int key) {
+    auto it = m_history.find(key);
+    if (it == m_history.end())
+      it = m_history.insert(key, ChannelHistory(kMaxHistoryPerChannel));
+    return *it;
+  }
 
   // Per-channel topic and user lists
-  QMap<ChannelKey, QString> m_topics;
-  QMap<ChannelKey, QStringList> m_users;
-  QMap<ChannelKey, QString> m_modes;  // per-channel mode string (+nst etc.)
+  QHash<int, QString> m_topics;
+  QHash<int, QString> m_modes; // per-channel mode string (+nst etc.)
+  // Member lists, one model per channel once NAMES has arrived; owned by us
+  QHash<int, NickListModel *> m_users;
+  NickListModel *users(int key);
+  NickListModel *findUsers(int key) const { return m_users.value(key); }
+  NickListModel m_noUsers; // for tabs without a member list
+  NickListModel *m_activeUsers = &m_noUsers;
+  void updateActiveNickList();
+  // Refreshes channelUsers for listeners, if this is the active channel
+  void usersChanged(const QString &server, const QString &channel);
+
+  // Unread/highlight and member-list notifications, batched per frame
+  ChangeAggregator m_changes;
+  void applyChanges(const QHash<int, ChangeAggregator::Changes> &changes);
 
   // Unread / highlight tracking
-  QSet<QString> m_unread;      // "server\nchannel" keys with new messages
-  QSet<QString> m_highlighted; // "server\nchannel" keys with nick mentions
-  QSet<QString>
-      m_scrollbackLoaded; // "server\nchannel" keys mapped to loaded scrollback
-  QString unreadKey(const QString &server, const QString &channel) const {
-    return server + "\n" + channel;
-  }
+  QSet<int> m_unread;           // channels with new messages
+  QSet<int> m_highlighted;      // channels with nick mentions
+  QSet<int> m_scrollbackLoaded; // channels mapped to loaded scrollback
+  // Where the next loadOlderHistory() page starts; absent once the log is
+  // exhausted.
+  QHash<int, Logger::ScrollbackCursor> m_scrollbackCursor;
 
   // ── Structured WHOIS accumulation ──
   // Key: "server\nnick", Value: accumulated formatted lines
@@ -223,10 +294,19 @@ private:
 
   // ── Ignore list ──
   QStringList m_ignoreList; // nick!user@host masks (wildcards supported)
+  IgnoreMatcher m_ignoreMatcher; // m_ignoreList compiled for lookups
 
   // ── DCC file transfer ──
   DccManager *m_dccManager = nullptr;
 
+  // ── Netsplits ──
+  // Split QUITs and the matching rejoins are held for a moment and then
+  // reported, and applied to the nick lists, once per channel.
+  static constexpr int kNetsplitFlushMs = 750;
+  NetsplitTracker m_netsplits;
+  QTimer m_netsplitTimer;
+  void flushNetsplits();
+
   // ── Lag meter ──
   // Per-connection lag tracking for multi-server support
   struct LagState {
@@ -0,0 +1,165 @@
+#include "IgnoreMatcher.h"
+#include <algorithm>
+
+namespace {
+
+// Glob tokens; anything >= 0 is a folded character
+constexpr int kStar = -1;
+constexpr int kAny = -2;
+constexpr int kAccept = -3;
+
+// A spam flood from rotating hosts can walk the DFA into many states;
+// past this many the cache starts over instead of growing without bound.
+constexpr int kMaxDfaStates = 4096;
+
+bool hasWildcard(QStringView text) {
+  return text.contains(u'*') || text.contains(u'?');
+}
+
+} // namespace
+
+QChar IgnoreMatcher::fold(QChar c) {
+  const char16_t u = c.unicode();
+  if (u >= u'A' && u <= u'Z')
+    return QChar(char16_t(u + 32));
+  switch (u) {
+  case u'[':
+    return QChar(u'{');
+  case u']':
+    return QChar(u'}');
+  case u'\\':
+    return QChar(u'|');
+  case u'~':
+    return QChar(u'^');
+  default:
+    return u < 0x80 ? c : c.toCaseFolded();
+  }
+}
+
+QString IgnoreMatcher::fold(QStringView text) {
+  QString out(text.size(), Qt::Uninitialized);
+  QChar *d = out.data();
+  for (const QChar c : text)
+    *d++ = fold(c);
+  return out;
+}
+
+void IgnoreMatcher::setMasks(const QStringList &masks) {
+  m_nicks.clear();
+  m_tokens.clear();
+  m_starts.clear();
+
+  for (const QString &raw : masks) {
+    const QString mask = raw.trimmed();
+    if (mask.isEmpty())
+      continue;
+    // A bare nick is nick!*@*, as IRCConnectionManager::addIgnore stores it
+    if (!mask.contains(u'!') && !mask.contains(u'@')) {
+      if (!hasWildcard(mask)) {
+        m_nicks.insert(fold(mask));
+        continue;
+      }
+    } else {
+      const qsizetype bang = mask.indexOf(u'!');
+      const QStringView nick = QStringView(mask).first(qMax<qsizetype>(bang, 0));
+      const QStringView rest = QStringView(mask).sliced(bang + 1);
+      if (bang > 0 && !hasWildcard(nick) &&
+          (rest == QLatin1String("*@*") || rest == QLatin1String("*"))) {
+        m_nicks.insert(fold(nick));
+        continue;
+      }
+    }
+
+    m_starts.append(m_tokens.size());
+    for (const QChar c : mask) {
+      if (c == u'*') {
+        if (m_tokens.size() > m_starts.last() && m_tokens.last() == kStar)
+          continue; // "**" is "*"
+        m_tokens.append(kStar);
+      } else if (c == u'?') {
+        m_tokens.append(kAny);
+      } else {
+        m_tokens.append(fold(c).unicode());
+      }
+    }
+    if (!mask.contains(u'!') && !mask.contains(u'@')) {
+      // Wildcard nick shorthand: "spam*" is "spam*!*@*"
+      m_tokens << int(u'!') << kStar << int(u'@') << kStar;
+    }
+    m_tokens.append(kAccept);
+  }
+  resetDfa();
+}
+
+bool IgnoreMatcher::matches(QStringView prefix) const {
+  if (!m_nicks.isEmpty()) {
+    const qsizetype bang = prefix.indexOf(u'!');
+    if (m_nicks.contains(fold(bang >= 0 ? prefix.first(bang) : prefix)))
+      return true;
+  }
+  if (m_starts.isEmpty())
+    return false;
+
+  if (m_dfa.size() > kMaxDfaStates)
+    resetDfa();
+  int state = 0;
+  for (const QChar c : prefix) {
+    state = step(state, fold(c));
+    if (m_dfa.at(state).positions.isEmpty())
+      return false; // no mask can match any more
+  }
+  return m_dfa.at(state).accept;
+}
+
+// ── Lazy DFA ──
+
+void IgnoreMatcher::resetDfa() const {
+  m_dfa.clear();
+  m_dfaIds.clear();
+  m_transitions.clear();
+  stateFor(m_starts);
+}
+
+// Id of the DFA state for a set of NFA positions, creating it if new.  A
+// position on a '*' also stands for the position after it, since the star
+// may match nothing.
+int IgnoreMatcher::stateFor(QVector<int> positions) const {
+  for (qsizetype i = 0; i < positions.size(); ++i) {
+    if (m_tokens.at(positions.at(i)) == kStar)
+      positions.append(positions.at(i) + 1);
+  }
+  std::sort(positions.begin(), positions.end());
+  positions.erase(std::unique(positions.begin(), positions.end()),
+                  positions.end());
+
+  const auto it = m_dfaIds.constFind(positions);
+  if (it != m_dfaIds.constEnd())
+    return it.value();
+
+  DfaState s;
+  s.accept = std::any_of(positions.cbegin(), positions.cend(),
+                         [this](int p) { return m_tokens.at(p) == kAccept; });
+  s.positions = positions;
+  m_dfa.append(s);
+  m_dfaIds.insert(positions, m_dfa.size() - 1);
+  return m_dfa.size() - 1;
+}
+
+int IgnoreMatcher::step(int state, QChar c) const {
+  const quint64 key = (quint64(state) << 32) | c.unicode();
+  const auto it = m_transitions.constFind(key);
+  if (it != m_transitions.constEnd())
+    return it.value();
+
+  QVector<int> next;
+  for (const int p : m_dfa.at(state).positions) {
+    const int token = m_tokens.at(p);
+    if (token == kStar)
+      next.append(p);
+    else if (token == kAny || token == c.unicode())
+      next.append(p + 1);
+  }
+  const int id = stateFor(next);
+  m_transitions.insert(key, id);
+  return id;
+}
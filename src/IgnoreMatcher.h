@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Compiled form of the ignore list, rebuilt whenever the list changes.
+//
+// Masks are nick!user@host globs ('*' matches any run, '?' one character)
+// compared under RFC 1459 case mapping; a mask with neither '!' nor '@' is a
+// nick and means nick!*@*.  Plain "nick!*@*" masks, which is what /ignore
+// adds, live in a hash set and cost one lookup.  Every other mask is merged
+// into a single NFA that is turned into a DFA lazily, one state per distinct
+// set of live mask positions, so a lookup walks the prefix once however
+// many masks there are.
+//
+// Lookups fill the DFA cache, so one matcher must not be shared between
+// threads.
+class IgnoreMatcher {
+public:
+  void setMasks(const QStringList &masks);
+  bool isEmpty() const { return m_nicks.isEmpty() && m_starts.isEmpty(); }
+
+  // prefix is "nick!user@host", or just a nick or server name.
+  bool matches(QStringView prefix) const;
+
+  // RFC 1459 case mapping: ASCII letters fold to lowercase and []\~ to
+  // their lowercase forms {}|^.  Other characters use Unicode case folding.
+  static QChar fold(QChar c);
+  static QString fold(QStringView text);
+
+private:
+  struct DfaState {
+    QVector<int> positions; // sorted NFA positions, closed over '*'
+    bool accept = false;
+  };
+
+  void resetDfa() const;
+  int stateFor(QVector<int> positions) const;
+  int step(int state, QChar c) const;
+
+  QSet<QString> m_nicks; // folded
+  // Tokens of all wildcard masks back to back, each ending in kAccept;
+  // m_starts holds the index of each mask's first token.
+  QVector<int> m_tokens;
+  QVector<int> m_starts;
+
+  mutable QVector<DfaState> m_dfa;
+  mutable QHash<QVector<int>, int> m_dfaIds;
+  mutable QHash<quint64, int> m_transitions; // (state << 32 | char) → state
+};
@@ -0,0 +1,163 @@
+#include "ImageCacheIndex.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const QByteArray kMagic = QByteArrayLiteral("NUCIMG01");
+
+// op(1) pad(3) width(4) height(4) pad(4) bytes(8) lastAccess(8)
+// name(32) mime(32), little-endian, text NUL-padded
+constexpr int kRecordSize = 96;
+constexpr int kNameOffset = 32;
+constexpr int kMimeOffset = 64;
+constexpr int kTextSize = 32;
+
+void putText(char *p, const QByteArray &text) {
+  std::memcpy(p, text.constData(), qMin<qsizetype>(text.size(), kTextSize - 1));
+}
+
+QByteArray getText(const char *p) {
+  return QByteArray(p, qstrnlen(p, kTextSize));
+}
+
+} // namespace
+
+bool ImageCacheIndex::load(const QString &path) {
+  m_entries.clear();
+  m_totalBytes = 0;
+  m_journal.clear();
+  // Anything but a clean index is rewritten by the next compaction
+  m_fileRecords = -1;
+
+  QFile f(path);
+  if (!f.open(QIODevice::ReadOnly))
+    return false;
+  const QByteArray data = f.readAll();
+  if (!data.startsWith(kMagic))
+    return false;
+  const qsizetype count = (data.size() - kMagic.size()) / kRecordSize;
+  const char *p = data.constData() + kMagic.size();
+  for (qsizetype i = 0; i < count; ++i, p += kRecordSize) {
+    Entry e;
+    e.width = qFromLittleEndian<qint32>(p + 4);
+    e.height = qFromLittleEndian<qint32>(p + 8);
+    e.bytes = qFromLittleEndian<qint64>(p + 16);
+    e.lastAccess = qFromLittleEndian<qint64>(p + 24);
+    e.name = QString::fromLatin1(getText(p + kNameOffset));
+    e.mime = getText(p + kMimeOffset);
+    const quint8 op = quint8(p[0]);
+    if (!e.name.isEmpty() && (op == Put || op == Remove))
+      apply(Op(op), e);
+  }
+  // A record cut short by a crash would misalign everything appended
+  // after it
+  if ((data.size() - kMagic.size()) % kRecordSize == 0)
+    m_fileRecords = count;
+  return true;
+}
+
+void ImageCacheIndex::insert(const Entry &entry) {
+  apply(Put, entry);
+  record(Put, entry);
+}
+
+void ImageCacheIndex::touch(const QString &name, qint64 now) {
+  auto it = m_entries.find(name);
+  if (it == m_entries.end() || it->lastAccess >= now)
+    return;
+  it->lastAccess = now;
+  record(Put, *it);
+}
+
+void ImageCacheIndex::remove(const QString &name) {
+  auto it = m_entries.find(name);
+  if (it == m_entries.end())
+    return;
+  const Entry e = *it;
+  apply(Remove, e);
+  record(Remove, e);
+}
+
+QVector<ImageCacheIndex::Entry> ImageCacheIndex::evict() {
+  QVector<Entry> evicted;
+  if (m_totalBytes <= m_budget)
+    return evicted;
+  QVector<Entry> all = m_entries.values();
+  std::sort(all.begin(), all.end(), [](const Entry &a, const Entry &b) {
+    return a.lastAccess < b.lastAccess;
+  });
+  for (const Entry &e : std::as_const(all)) {
+    if (m_totalBytes <= m_budget)
+      break;
+    remove(e.name);
+    evicted.append(e);
+  }
+  return evicted;
+}
+
+QByteArray ImageCacheIndex::takeJournal() {
+  QByteArray journal;
+  journal.swap(m_journal);
+  return journal;
+}
+
+bool ImageCacheIndex::wantsCompaction() const {
+  return m_fileRecords < 0 || m_fileRecords > 2 * qint64(count()) + 1024;
+}
+
+QByteArray ImageCacheIndex::snapshot() {
+  m_journal.clear();
+  m_fileRecords = 0;
+  for (const Entry &e : std::as_const(m_entries))
+    record(Put, e);
+  return kMagic + takeJournal();
+}
+
+bool ImageCacheIndex::appendToFile(const QString &path,
+                                   const QByteArray &records) {
+  QFile f(path);
+  if (!f.open(QIODevice::WriteOnly | QIODevice::Append))
+    return false;
+  if (f.size() == 0 && f.write(kMagic) != kMagic.size())
+    return false;
+  return f.write(records) == records.size();
+}
+
+bool ImageCacheIndex::replaceFile(const QString &path,
+                                  const QByteArray &contents) {
+  QSaveFile f(path);
+  if (!f.open(QIODevice::WriteOnly))
+    return false;
+  f.write(contents);
+  return f.commit();
+}
+
+void ImageCacheIndex::record(Op op, const Entry &entry) {
+  char rec[kRecordSize] = {};
+  rec[0] = char(op);
+  qToLittleEndian<qint32>(entry.width, rec + 4);
+  qToLittleEndian<qint32>(entry.height, rec + 8);
+  qToLittleEndian<qint64>(entry.bytes, rec + 16);
+  qToLittleEndian<qint64>(entry.lastAccess, rec + 24);
+  putText(rec + kNameOffset, entry.name.toLatin1());
+  putText(rec + kMimeOffset, entry.mime);
+  m_journal.append(rec, kRecordSize);
+  if (m_fileRecords >= 0)
+    ++m_fileRecords;
+}
+
+void ImageCacheIndex::apply(Op op, const Entry &entry) {
+  auto it = m_entries.find(entry.name);
+  if (it != m_entries.end()) {
+    m_totalBytes -= it->bytes;
+    m_entries.erase(it);
+  }
+  if (op == Put) {
+    m_entries.insert(entry.name, entry);
+    m_totalBytes += entry.bytes;
+  }
+}
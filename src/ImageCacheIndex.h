@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+// What is in ImageDownloader's on-disk cache, kept in memory so lookups
+// never touch the filesystem.
+//
+// The index file ("index") is a journal of fixed-size records after an
+// 8-byte magic: a put records a file's name, MIME type, size on disk,
+// pixel size and last access, and later puts of the same name or removes
+// supersede it.  Loading replays the journal, so a restart costs one read
+// and no directory scan.  Once the file holds mostly superseded records,
+// snapshot() produces a compacted replacement.
+//
+// The class itself does no I/O besides load(): records pile up in a
+// journal buffer that the owner writes out (appendToFile/replaceFile) on a
+// background thread, together with deleting the files evict() returns.
+class ImageCacheIndex {
+public:
+  struct Entry {
+    QString name;       // original's file name in the cache directory
+    QByteArray mime;    // Content-Type it was served with, if known
+    qint64 bytes = 0;   // on disk, original and thumbnail together
+    int width = 0;      // original's pixel size
+    int height = 0;
+    qint64 lastAccess = 0; // ms since epoch
+  };
+
+  static constexpr qint64 kDefaultBudget = 512LL * 1024 * 1024;
+
+  // Replaces the contents with the journal at path.  False (and empty) if
+  // the file is missing or not an index.
+  bool load(const QString &path);
+
+  bool contains(const QString &name) const { return m_entries.contains(name); }
+  Entry entry(const QString &name) const { return m_entries.value(name); }
+  void insert(const Entry &entry);
+  void touch(const QString &name, qint64 now);
+  void remove(const QString &name);
+
+  qint64 budget() const { return m_budget; }
+  void setBudget(qint64 bytes) { m_budget = bytes; }
+  qint64 totalBytes() const { return m_totalBytes; }
+  int count() const { return int(m_entries.size()); }
+
+  // Drops least recently used entries until the total fits the budget and
+  // returns them, oldest first; the caller deletes their files.
+  QVector<Entry> evict();
+
+  // ── Persistence ──
+  // Records added since the last call, for appendToFile()
+  QByteArray takeJournal();
+  // The file is mostly superseded records; rewrite it with snapshot()
+  bool wantsCompaction() const;
+  // A complete index file with one record per entry.  Clears the journal.
+  QByteArray snapshot();
+
+  static bool appendToFile(const QString &path, const QByteArray &records);
+  static bool replaceFile(const QString &path, const QByteArray &contents);
+
+private:
+  enum Op : quint8 { Put = 1, Remove = 2 };
+  void record(Op op, const Entry &entry);
+  void apply(Op op, const Entry &entry);
+
+  QHash<QString, Entry> m_entries;
+  qint64 m_totalBytes = 0;
+  qint64 m_budget = kDefaultBudget;
+  QByteArray m_journal;
+  qint64 m_fileRecords = 0; // in the file, counting the journal
+};
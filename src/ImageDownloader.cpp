@@ -1,4 +1,6 @@
 #include "ImageDownloader.h"
+#include "ImageSniffer.h"
+#include "ThumbnailCache.h"
 
 #include <QStandardPaths>
 #include <QDir>
@@ -6,14 +8,96 @@
 #include <QCryptographicHash>
 #include <QNetworkReply>
 #include <QNetworkRequest>
-#include <QImageReader>
-#include <QBuffer>
 #include <QUrl>
 #include <QGuiApplication>
 #include <QClipboard>
 #include <QFileInfo>
 #include <QHostAddress>
 #include <QHostInfo>
+#include <QDateTime>
+#include <QFutureWatcher>
+#include <QSaveFile>
+#include <QSettings>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <memory>
+
+namespace {
+
+struct Thumbnail {
+    QImage image;
+    QSize original;     // only when made from the original
+    qint64 bytes = 0;   // original plus thumbnail on disk
+};
+
+// Enough for the header of every format ImageSniffer knows, and for a JPEG
+// to get past its EXIF block to the frame header
+constexpr qsizetype kSniffBytes = 64 * 1024;
+// More than this would not decode within QImageReader's allocation limit
+constexpr qint64 kMaxImagePixels = 40'000'000;
+
+// A response being received: its head is held until ImageSniffer has seen
+// enough of it, after which the body goes straight to the part file.
+struct Download {
+    QByteArray head;
+    std::unique_ptr<QFile> part;
+    QByteArray mime;        // as sniffed
+    QSize size;             // as sniffed, if the header had it
+    qint64 bytes = 0;
+    QString rejected;       // why it was aborted, if it was
+    bool notImage = false;  // rejected for what it is, not how big
+};
+
+// Takes the next chunk of the body; false, with d.rejected set, when the
+// response should be aborted.  complete means this is the last of it.
+bool feed(Download &d, const QByteArray &chunk, const QString &partPath,
+          qint64 maxBytes, bool complete)
+{
+    d.bytes += chunk.size();
+    if (d.bytes > maxBytes) {
+        d.rejected = QStringLiteral("Image too large, aborted:");
+        return false;
+    }
+    if (d.part) {
+        if (d.part->write(chunk) != chunk.size()) {
+            d.rejected = QStringLiteral("Could not write image to cache:");
+            return false;
+        }
+        return true;
+    }
+
+    d.head += chunk;
+    const ImageSniffer::Result sniffed = ImageSniffer::sniff(d.head, complete);
+    if (sniffed.verdict == ImageSniffer::Verdict::NeedMore && d.head.size() < kSniffBytes)
+        return true;
+    if (sniffed.verdict != ImageSniffer::Verdict::Image) {
+        d.rejected = QStringLiteral("Not an image, aborted:");
+        d.notImage = true;
+        return false;
+    }
+    if (sniffed.size.isValid()
+        && qint64(sniffed.size.width()) * sniffed.size.height() > kMaxImagePixels) {
+        d.rejected = QStringLiteral("Image dimensions too large, aborted:");
+        return false;
+    }
+    // A JPEG's size comes after its metadata: keep looking for a while
+    if (!sniffed.size.isValid() && sniffed.mime == "image/jpeg" && !complete
+        && d.head.size() < kSniffBytes)
+        return true;
+
+    d.mime = sniffed.mime;
+    d.size = sniffed.size;
+    d.part = std::make_unique<QFile>(partPath);
+    if (!d.part->open(QIODevice::WriteOnly) || d.part->write(d.head) != d.head.size()) {
+        d.rejected = QStringLiteral("Could not write image to cache:");
+        return false;
+    }
+    d.head = QByteArray();
+    return true;
+}
+
+} // namespace
 
 ImageDownloader *ImageDownloader::instance()
 {
@@ -28,6 +112,39 @@ ImageDownloader::ImageDownloader(QObject *parent)
     m_cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
                  + QStringLiteral("/images");
     QDir().mkpath(m_cacheDir);
+    // Decoding is CPU-bound; leave the rest of the machine to everything else
+    m_decodePool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 4));
+
+    m_ioPool.setMaxThreadCount(1);
+    m_maintainTimer.setSingleShot(true);
+    m_maintainTimer.setInterval(2000);
+    connect(&m_maintainTimer, &QTimer::timeout, this, &ImageDownloader::maintainCache);
+
+    QSettings prefs;
+    m_index.setBudget(prefs.value(QStringLiteral("ui/imageCacheMB"), 512).toLongLong()
+                      * 1024 * 1024);
+    m_indexPath = m_cacheDir + QStringLiteral("/index");
+    if (!m_index.load(m_indexPath)) {
+        // A cache from before the index, or a damaged one: nothing in it is
+        // known, so start over instead of scanning it.  Files from this run
+        // are newer than `started` and stay.
+        const QDateTime started = QDateTime::currentDateTime();
+        m_ioPool.start([dir = m_cacheDir, started]() {
+            const QFileInfoList files = QDir(dir).entryInfoList(QDir::Files);
+            for (const QFileInfo &fi : files) {
+                if (fi.fileName() != QLatin1String("index") && fi.lastModified() < started)
+                    QFile::remove(fi.filePath());
+            }
+        });
+        scheduleMaintenance();  // writes a fresh index
+    }
+}
+
+ImageDownloader::~ImageDownloader()
+{
+    m_maintainTimer.stop();
+    maintainCache();
+    m_ioPool.waitForDone();
 }
 
 // ---------- helpers ----------
@@ -54,7 +171,7 @@ QString ImageDownloader::urlToFilename(const QString &url) const
 
 bool ImageDownloader::isCached(const QString &url) const
 {
-    return QFile::exists(m_cacheDir + QChar('/') + urlToFilename(url));
+    return m_index.contains(urlToFilename(url));
 }
 
 QString ImageDownloader::cachedPath(const QString &url) const
@@ -62,6 +179,12 @@ QString ImageDownloader::cachedPath(const QString &url) const
     return m_cacheDir + QChar('/') + urlToFilename(url);
 }
 
+QString ImageDownloader::thumbnailPath(const QString &url) const
+{
+    return m_cacheDir + QChar('/') + QFileInfo(urlToFilename(url)).completeBaseName()
+           + QStringLiteral(".thumb");
+}
+
 // ---------- URL classification ----------
 
 bool ImageDownloader::isImageUrl(const QString &url)
@@ -83,6 +206,17 @@ bool ImageDownloader::isImageUrl(const QString &url)
     return false;
 }
 
+bool ImageDownloader::mightBeImageUrl(const QString &url)
+{
+    QUrl qurl(url);
+    const QString path = qurl.path();
+    // A site's front page or a directory is a page
+    if (path.isEmpty() || path.endsWith(QLatin1Char('/')))
+        return false;
+    // Any extension would have said what it is
+    return !path.section(QLatin1Char('/'), -1).contains(QLatin1Char('.'));
+}
+
 bool ImageDownloader::isVideoUrl(const QString &url)
 {
     static const QStringList exts = {
@@ -133,8 +267,25 @@ static bool isSafeImageUrl(const QUrl &qurl) {
 
 void ImageDownloader::download(const QString &url)
 {
-    if (m_pending.contains(url))
+    request(url, FetchScheduler::Priority::Explicit, 0);
+}
+
+void ImageDownloader::fetchInline(const QString &url, const QObject *view)
+{
+    request(url, FetchScheduler::Priority::Inline, quintptr(view));
+}
+
+void ImageDownloader::request(const QString &url, FetchScheduler::Priority priority,
+                              quintptr group)
+{
+    if (m_pending.contains(url)) {
+        // Still waiting for a slot: an explicit request moves it up
+        if (m_fetches.isQueued(url)) {
+            m_fetches.enqueue({url, QUrl(url).host().toLower(), group, priority});
+            pumpFetches();
+        }
         return;
+    }
 
     // Validate URL before making any network request.
     QUrl qurl(url);
@@ -144,41 +295,108 @@ void ImageDownloader::download(const QString &url)
         return;
     }
 
-    // Already cached – emit immediately
-    if (isCached(url)) {
-        QString path = cachedPath(url);
-        QImageReader reader(path);
-        QSize sz = reader.size();
-        emit imageReady(url, path, sz.width(), sz.height());
+    // Already turned out not to be an image this session
+    if (m_notImages.contains(url)) {
+        emit downloadFailed(url);
         return;
     }
 
     m_pending.insert(url);
 
+    // Already downloaded: only the thumbnail is left to find or make
+    if (isCached(url)) {
+        prepareThumbnail(url);
+        return;
+    }
+
+    m_fetches.enqueue({url, qurl.host().toLower(), group, priority});
+    pumpFetches();
+}
+
+void ImageDownloader::cancelFetches(const QObject *view)
+{
+    QStringList dropped;
+    const QStringList running = m_fetches.cancelGroup(quintptr(view), &dropped);
+    for (const QString &url : dropped)
+        m_pending.remove(url);
+    for (const QString &url : running) {
+        if (QNetworkReply *reply = m_replies.value(url)) {
+            reply->abort();  // the finished handler frees the slot
+            continue;
+        }
+        // Still resolving: the lookup will find nobody waiting for it
+        for (QStringList &waiting : m_resolving)
+            waiting.removeAll(url);
+        m_pending.remove(url);
+        m_fetches.finished(url);
+    }
+    pumpFetches();
+}
+
+void ImageDownloader::pumpFetches()
+{
+    FetchScheduler::Job job;
+    while (m_fetches.next(job))
+        resolveAndStart(job.url, job.host);
+}
+
+void ImageDownloader::failFetch(const QString &url)
+{
+    m_pending.remove(url);
+    m_fetches.finished(url);
+    emit downloadFailed(url);
+}
+
+void ImageDownloader::resolveAndStart(const QString &url, const QString &host)
+{
     // DNS-rebinding guard: resolve the hostname first and reject URLs whose
     // host resolves to a private/loopback address (a literal-IP check alone
     // can be bypassed by a hostname pointing at 192.168.x.x etc.).
-    QHostAddress literal(qurl.host());
-    if (literal.isNull()) {
-        QHostInfo::lookupHost(qurl.host(), this, [this, url](const QHostInfo &info) {
-            if (info.error() != QHostInfo::NoError || info.addresses().isEmpty()) {
-                m_pending.remove(url);
-                emit downloadFailed(url);
-                return;
-            }
-            const QList<QHostAddress> addrs = info.addresses();
-            for (const QHostAddress &a : addrs) {
-                if (isPrivateAddress(a)) {
-                    qWarning() << "[ImageDownloader] Host resolves to private address, blocked:" << url;
-                    m_pending.remove(url);
-                    emit downloadFailed(url);
-                    return;
-                }
-            }
-            startDownload(url);
-        });
+    if (!QHostAddress(host).isNull()) {
+        startDownload(url);
+        return;
+    }
+
+    // Resolved a moment ago, or being resolved right now: one lookup per
+    // host, however many links point at it
+    const auto cached = m_dnsCache.constFind(host);
+    if (cached != m_dnsCache.constEnd()
+        && cached->expires > QDateTime::currentMSecsSinceEpoch()) {
+        startResolved(url, cached->addresses);
+        return;
+    }
+    QStringList &waiting = m_resolving[host];
+    waiting.append(url);
+    if (waiting.size() > 1)
+        return;
+
+    QHostInfo::lookupHost(host, this, [this, host](const QHostInfo &info) {
+        const QStringList urls = m_resolving.take(host);
+        QList<QHostAddress> addrs;
+        if (info.error() == QHostInfo::NoError) {
+            addrs = info.addresses();
+            if (!addrs.isEmpty())
+                m_dnsCache.insert(host, {addrs, QDateTime::currentMSecsSinceEpoch() + kDnsTtlMs});
+        }
+        for (const QString &url : urls)
+            startResolved(url, addrs);
+        pumpFetches();
+    });
+}
+
+void ImageDownloader::startResolved(const QString &url, const QList<QHostAddress> &addrs)
+{
+    if (addrs.isEmpty()) {
+        failFetch(url);
         return;
     }
+    for (const QHostAddress &a : addrs) {
+        if (isPrivateAddress(a)) {
+            qWarning() << "[ImageDownloader] Host resolves to private address, blocked:" << url;
+            failFetch(url);
+            return;
+        }
+    }
     startDownload(url);
 }
 
@@ -191,19 +409,79 @@ void ImageDownloader::startDownload(const QString &url)
     req.setHeader(QNetworkRequest::UserAgentHeader, "NUchat/1.0");
 
     QNetworkReply *reply = m_nam->get(req);
-    // Abort oversized downloads early instead of buffering the whole body
-    connect(reply, &QNetworkReply::downloadProgress, reply,
-            [reply](qint64 received, qint64) {
-                if (received > MAX_DOWNLOAD_SIZE)
-                    reply->abort();
-            });
-    connect(reply, &QNetworkReply::finished, this, [this, reply, url]() {
+    m_replies.insert(url, reply);
+    // Bound what Qt buffers ahead of us; readyRead drains it as it comes
+    reply->setReadBufferSize(256 * 1024);
+
+    auto download = std::make_shared<Download>();
+    const QString path = cachedPath(url);
+    const QString partPath = path + QStringLiteral(".part");
+    auto reject = [reply, download](const QString &why) {
+        download->rejected = why;
+        reply->abort();
+    };
+
+    // Re-validate every hop before following it
+    connect(reply, &QNetworkReply::redirected, reply, [reply, reject](const QUrl &target) {
+        if (!isSafeImageUrl(reply->url().resolved(target)))
+            reject(QStringLiteral("Redirect to unsafe URL blocked:"));
+    });
+    // The headers alone are often enough to say no
+    connect(reply, &QNetworkReply::metaDataChanged, reply, [reply, download, reject]() {
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (status >= 300 && status < 400)
+            return;  // a hop being followed; redirected() checks it
+        const QByteArray contentType =
+            reply->header(QNetworkRequest::ContentTypeHeader).toByteArray().toLower();
+        static const QList<QByteArray> kImageMimeTypes = {
+            "image/png", "image/jpeg", "image/gif", "image/webp",
+            "image/bmp",  "image/svg+xml", "image/tiff",
+            // Left to the sniffer
+            "application/octet-stream", "binary/octet-stream"
+        };
+        bool mimeOk = false;
+        for (const QByteArray &mime : kImageMimeTypes) {
+            if (contentType.startsWith(mime)) { mimeOk = true; break; }
+        }
+        if (!contentType.isEmpty() && !mimeOk) {
+            download->notImage = true;
+            reject(QStringLiteral("Non-image Content-Type rejected:"));
+            return;
+        }
+        const QVariant length = reply->header(QNetworkRequest::ContentLengthHeader);
+        if (length.isValid() && length.toLongLong() > MAX_DOWNLOAD_SIZE)
+            reject(QStringLiteral("Image too large, aborted:"));
+    });
+    connect(reply, &QNetworkReply::readyRead, reply, [reply, download, partPath, reject]() {
+        if (!download->rejected.isEmpty())
+            return;
+        if (!feed(*download, reply->readAll(), partPath, MAX_DOWNLOAD_SIZE, false))
+            reject(download->rejected);
+    });
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply, url, download, path, partPath]() {
         reply->deleteLater();
         m_pending.remove(url);
+        m_replies.remove(url);
+        m_fetches.finished(url);
+        pumpFetches();
+
+        auto fail = [this, url, download, partPath]() {
+            download->part.reset();
+            QFile::remove(partPath);
+            if (download->notImage)
+                m_notImages.insert(url);
+            emit downloadFailed(url);
+        };
 
+        if (!download->rejected.isEmpty()) {
+            qWarning() << "[ImageDownloader]" << download->rejected << url;
+            fail();
+            return;
+        }
         if (reply->error() != QNetworkReply::NoError) {
             qWarning() << "Image download failed:" << reply->errorString() << url;
-            emit downloadFailed(url);
+            fail();
             return;
         }
 
@@ -211,52 +489,148 @@ void ImageDownloader::startDownload(const QString &url)
         if (!isSafeImageUrl(reply->url())) {
             qWarning() << "[ImageDownloader] Redirect to unsafe URL blocked:"
                        << reply->url().toString();
-            emit downloadFailed(url);
+            fail();
             return;
         }
 
-        // Check Content-Type — must be an image MIME type.
-        const QByteArray contentType =
-            reply->header(QNetworkRequest::ContentTypeHeader).toByteArray().toLower();
-        static const QList<QByteArray> kImageMimeTypes = {
-            "image/png", "image/jpeg", "image/gif", "image/webp",
-            "image/bmp",  "image/svg+xml", "image/tiff"
-        };
-        bool mimeOk = false;
-        for (const QByteArray &mime : kImageMimeTypes) {
-            if (contentType.startsWith(mime)) { mimeOk = true; break; }
-        }
-        if (!contentType.isEmpty() && !mimeOk) {
-            qWarning() << "[ImageDownloader] Non-image Content-Type rejected:"
-                       << contentType << url;
-            emit downloadFailed(url);
+        if (!feed(*download, reply->readAll(), partPath, MAX_DOWNLOAD_SIZE, true)) {
+            qWarning() << "[ImageDownloader]" << download->rejected << url;
+            fail();
             return;
         }
-
-        QByteArray data = reply->readAll();
-        if (data.size() > MAX_DOWNLOAD_SIZE) {
-            qWarning() << "Image too large, skipping:" << url;
-            emit downloadFailed(url);
+        download->part->close();
+        download->part.reset();
+        QFile::remove(path);
+        if (!QFile::rename(partPath, path)) {
+            fail();
             return;
         }
 
-        // Save to cache
-        QString path = cachedPath(url);
-        QFile file(path);
-        if (!file.open(QIODevice::WriteOnly)) {
-            emit downloadFailed(url);
-            return;
+        // In the index before decoding, so it is evicted like any other
+        // file even if this run ends before the thumbnail is made
+        ImageCacheIndex::Entry entry;
+        entry.name = urlToFilename(url);
+        entry.mime = download->mime;
+        entry.bytes = download->bytes;
+        entry.width = download->size.width();
+        entry.height = download->size.height();
+        entry.lastAccess = QDateTime::currentMSecsSinceEpoch();
+        m_index.insert(entry);
+        scheduleMaintenance();
+
+        m_pending.insert(url);  // until the thumbnail is ready
+        prepareThumbnail(url);
+    });
+}
+
+void ImageDownloader::prepareThumbnail(const QString &url)
+{
+    const QString name = urlToFilename(url);
+    const QString thumb = thumbnailPath(url);
+    const QString source = QStringLiteral("image://thumbnails/") + QFileInfo(thumb).fileName();
+
+    // Decoded recently: nothing to read at all
+    const QImage cached = ThumbnailCache::instance()->find(thumb);
+    if (!cached.isNull() && m_index.contains(name)) {
+        m_pending.remove(url);
+        m_index.touch(name, QDateTime::currentMSecsSinceEpoch());
+        scheduleMaintenance();
+        emit imageReady(url, source, cached.width(), cached.height());
+        return;
+    }
+
+    auto *watcher = new QFutureWatcher<Thumbnail>(this);
+    connect(watcher, &QFutureWatcher<Thumbnail>::finished, this,
+            [this, watcher, url, name, thumb, source]() {
+                const Thumbnail result = watcher->result();
+                watcher->deleteLater();
+                m_pending.remove(url);
+                if (result.image.isNull()) {
+                    qWarning() << "[ImageDownloader] Could not decode image:" << url;
+                    // Forget it, so the next attempt downloads it again, and
+                    // delete what is on disk: untracked, evict() would never
+                    // see it.  Queued behind any pending index writes.
+                    m_index.remove(name);
+                    scheduleMaintenance();
+                    m_ioPool.start([original = cachedPath(url), thumb]() {
+                        QFile::remove(original);
+                        QFile::remove(thumb);
+                    });
+                    emit downloadFailed(url);
+                    return;
+                }
+                // Now with the thumbnail's bytes, and the pixel size if the
+                // original was decoded
+                ImageCacheIndex::Entry entry = m_index.entry(name);
+                entry.name = name;
+                entry.bytes = result.bytes;
+                if (result.original.isValid()) {
+                    entry.width = result.original.width();
+                    entry.height = result.original.height();
+                }
+                entry.lastAccess = QDateTime::currentMSecsSinceEpoch();
+                m_index.insert(entry);
+                scheduleMaintenance();
+                ThumbnailCache::instance()->insert(thumb, result.image);
+                emit imageReady(url, source, result.image.width(), result.image.height());
+            });
+    const QString original = cachedPath(url);
+    watcher->setFuture(QtConcurrent::run(&m_decodePool, [original, thumb]() {
+        Thumbnail result;
+        // Made on an earlier run: far cheaper than decoding the original
+        if (!result.image.load(thumb)) {
+            result.image = ThumbnailCache::decodeScaled(original, kThumbnailWidth,
+                                                        &result.original);
+            if (result.image.isNull())
+                return result;
+            // Photos as JPEG, anything with transparency as PNG; the reader
+            // tells them apart by content, so the name stays the same.
+            const bool alpha = result.image.hasAlphaChannel();
+            QSaveFile file(thumb);
+            if (file.open(QIODevice::WriteOnly)
+                && result.image.save(&file, alpha ? "PNG" : "JPG", alpha ? -1 : 85))
+                file.commit();
         }
-        file.write(data);
-        file.close();
+        result.bytes = QFileInfo(original).size() + QFileInfo(thumb).size();
+        return result;
+    }));
+}
+
+// ---------- cache maintenance ----------
+
+void ImageDownloader::setCacheSizeMB(int mb)
+{
+    m_index.setBudget(qint64(qMax(mb, 1)) * 1024 * 1024);
+    scheduleMaintenance();
+}
 
-        // Read dimensions
-        QBuffer buf(&data);
-        buf.open(QIODevice::ReadOnly);
-        QImageReader reader(&buf);
-        QSize sz = reader.size();
+void ImageDownloader::scheduleMaintenance()
+{
+    // Batches the index records of a burst of images into one write
+    if (!m_maintainTimer.isActive())
+        m_maintainTimer.start();
+}
 
-        emit imageReady(url, path, sz.width(), sz.height());
+void ImageDownloader::maintainCache()
+{
+    QStringList doomed;
+    const QVector<ImageCacheIndex::Entry> evicted = m_index.evict();
+    for (const ImageCacheIndex::Entry &e : evicted) {
+        doomed << m_cacheDir + QChar('/') + e.name
+               << m_cacheDir + QChar('/') + QFileInfo(e.name).completeBaseName()
+                      + QStringLiteral(".thumb");
+    }
+    const bool compact = m_index.wantsCompaction();
+    const QByteArray records = compact ? m_index.snapshot() : m_index.takeJournal();
+    if (doomed.isEmpty() && records.isEmpty())
+        return;
+    m_ioPool.start([doomed, records, compact, path = m_indexPath]() {
+        for (const QString &file : doomed)
+            QFile::remove(file);
+        if (compact)
+            ImageCacheIndex::replaceFile(path, records);
+        else
+            ImageCacheIndex::appendToFile(path, records);
     });
 }
 
@@ -291,3 +665,27 @@ void ImageDownloader::copyToClipboard(const QString &text)
 {
     QGuiApplication::clipboard()->setText(text);
 }
+
+// ---------- thumbnail provider ----------
+
+ThumbnailProvider::ThumbnailProvider(const QString &cacheDir)
+    : QQuickImageProvider(QQuickImageProvider::Image,
+                          QQmlImageProviderBase::ForceAsynchronousImageLoading),
+      m_cacheDir(cacheDir)
+{
+}
+
+QImage ThumbnailProvider::requestImage(const QString &id, QSize *size,
+                                       const QSize &requestedSize)
+{
+    // Only names ImageDownloader made, never a path out of the cache
+    if (id.contains(QChar('/')) || id.contains(QChar('\\')) || id.startsWith(QChar('.')))
+        return {};
+    QImage image = ThumbnailCache::instance()->load(m_cacheDir + QChar('/') + id);
+    if (size)
+        *size = image.size();
+    if (!image.isNull() && requestedSize.width() > 0 && requestedSize.height() > 0
+        && requestedSize != image.size())
+        image = image.scaled(requestedSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    return image;
+}
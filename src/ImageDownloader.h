@@ -1,37 +1,121 @@
 #pragma once
 
+#include "FetchScheduler.h"
+#include "ImageCacheIndex.h"
 #include <QObject>
 #include <QNetworkAccessManager>
+#include <QQuickImageProvider>
 #include <QSet>
 #include <QHash>
+#include <QHostAddress>
+#include <QThreadPool>
+#include <QTimer>
 
+// Fetches inline images and turns them into display-sized thumbnails.
+//
+// Originals are kept in the cache directory for "save image"; next to each
+// one a worker pool writes "<hash>.thumb", decoded and scaled down to
+// kThumbnailWidth.  imageReady() reports the thumbnail as an
+// image://thumbnails/ source with its own size, and ThumbnailProvider
+// serves it from ThumbnailCache, so neither the GUI nor the render thread
+// ever decodes a full-size original.
+//
+// Fetches go through a FetchScheduler: a few at a time, a couple per host,
+// explicit requests before inline embeds, and a view's embeds dropped when
+// it switches channel.  Host lookups for the private-address check are
+// cached for a few minutes and shared by every link to the same host.
+//
+// Responses are checked as they arrive: a non-image Content-Type or an
+// oversized Content-Length aborts at the headers, ImageSniffer's verdict on
+// the first bytes (and the pixel size in them) before the rest, and what
+// passes is written straight to disk rather than buffered.  Links that
+// turned out not to be images are remembered for the session and not
+// requested again.
+//
+// What the cache holds is tracked by an ImageCacheIndex, so isCached() is a
+// hash lookup.  Index records are written, and files over the size budget
+// deleted, on a single background I/O thread a moment after they change.
 class ImageDownloader : public QObject
 {
     Q_OBJECT
 public:
+    static constexpr int kThumbnailWidth = 400;
+
     static ImageDownloader *instance();
 
+    // The user asked for this file: ahead of every inline embed
     Q_INVOKABLE void download(const QString &url);
+    // An embed for view, the chat view showing it
+    void fetchInline(const QString &url, const QObject *view);
+    // view changed channel: drop its embeds, queued or in flight
+    void cancelFetches(const QObject *view);
     Q_INVOKABLE bool isCached(const QString &url) const;
     Q_INVOKABLE QString cachedPath(const QString &url) const;
+    QString thumbnailPath(const QString &url) const;
+    QString cacheDir() const { return m_cacheDir; }
     Q_INVOKABLE bool saveImageToDownloads(const QString &url);
     Q_INVOKABLE void copyToClipboard(const QString &text);
+    // Total size of the on-disk cache ("ui/imageCacheMB")
+    Q_INVOKABLE void setCacheSizeMB(int mb);
 
     static bool isImageUrl(const QString &url);
+    // No extension to go by, but not obviously a page either: worth
+    // fetching far enough to sniff the first bytes
+    static bool mightBeImageUrl(const QString &url);
     static bool isVideoUrl(const QString &url);
 
 signals:
-    void imageReady(const QString &url, const QString &localPath, int width, int height);
+    // source is an image://thumbnails/ URL; width and height are the
+    // thumbnail's, at most kThumbnailWidth wide
+    void imageReady(const QString &url, const QString &source, int width, int height);
     void downloadFailed(const QString &url);
 
 private:
     explicit ImageDownloader(QObject *parent = nullptr);
+    ~ImageDownloader() override;
     QString urlToFilename(const QString &url) const;
+    void request(const QString &url, FetchScheduler::Priority priority, quintptr group);
+    void pumpFetches();
+    void resolveAndStart(const QString &url, const QString &host);
+    void startResolved(const QString &url, const QList<QHostAddress> &addrs);
+    void failFetch(const QString &url);
     void startDownload(const QString &url);  // after host validation
+    // The original is on disk and in the index
+    void prepareThumbnail(const QString &url);
+    void scheduleMaintenance();
+    void maintainCache();  // evict, then write the index, in the background
 
     QNetworkAccessManager *m_nam;
     QString m_cacheDir;
-    QSet<QString> m_pending;
+    QString m_indexPath;
+    QSet<QString> m_pending;  // queued, downloading or decoding
+    QSet<QString> m_notImages;  // answered with something else this session
+    FetchScheduler m_fetches;
+    QHash<QString, QNetworkReply *> m_replies;  // url -> fetch in flight
+    struct HostAddresses {
+        QList<QHostAddress> addresses;
+        qint64 expires = 0;  // ms since epoch
+    };
+    QHash<QString, HostAddresses> m_dnsCache;
+    QHash<QString, QStringList> m_resolving;  // host -> urls waiting on it
+    static constexpr qint64 kDnsTtlMs = 5 * 60 * 1000;
+    QThreadPool m_decodePool;
+    ImageCacheIndex m_index;
+    QThreadPool m_ioPool;  // one thread: index writes and deletes, in order
+    QTimer m_maintainTimer;
 
     static constexpr qint64 MAX_DOWNLOAD_SIZE = 15 * 1024 * 1024; // 15MB
 };
+
+// "image://thumbnails/<hash>.thumb" for the chat view.  Asynchronous, so
+// a miss in ThumbnailCache is read from disk on Qt Quick's loader thread.
+class ThumbnailProvider : public QQuickImageProvider
+{
+public:
+    explicit ThumbnailProvider(const QString &cacheDir);
+    QImage requestImage(const QString &id, QSize *size,
+                        const QSize &requestedSize) override;
+
+private:
+    QString m_cacheDir;
+};
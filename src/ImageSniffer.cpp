@@ -0,0 +1,127 @@
+#include "ImageSniffer.h"
+#include <QtEndian>
+
+namespace ImageSniffer {
+
+namespace {
+
+quint32 be16(QByteArrayView d, qsizetype at) {
+  return qFromBigEndian<quint16>(d.data() + at);
+}
+quint32 be32(QByteArrayView d, qsizetype at) {
+  return qFromBigEndian<quint32>(d.data() + at);
+}
+quint32 le16(QByteArrayView d, qsizetype at) {
+  return qFromLittleEndian<quint16>(d.data() + at);
+}
+quint32 le24(QByteArrayView d, qsizetype at) {
+  return le16(d, at) | quint32(quint8(d[at + 2])) << 16;
+}
+qint32 le32(QByteArrayView d, qsizetype at) {
+  return qFromLittleEndian<qint32>(d.data() + at);
+}
+
+Result image(const char *mime, QSize size = QSize()) {
+  return {Verdict::Image, QByteArray(mime), size};
+}
+
+// Walks the segments up to the first start-of-frame, which holds the size.
+// The size stays unknown until enough of the head has arrived.
+QSize jpegSize(QByteArrayView d) {
+  qsizetype pos = 2;
+  while (pos + 4 <= d.size()) {
+    if (quint8(d[pos]) != 0xFF)
+      return {}; // not a marker: corrupt, leave it to the decoder
+    const quint8 marker = quint8(d[pos + 1]);
+    if (marker == 0xFF) { // fill byte
+      ++pos;
+      continue;
+    }
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+      pos += 2; // no length
+      continue;
+    }
+    const bool sof = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+                     marker != 0xC8 && marker != 0xCC;
+    if (sof) {
+      if (pos + 9 > d.size())
+        return {};
+      return QSize(int(be16(d, pos + 7)), int(be16(d, pos + 5)));
+    }
+    pos += 2 + be16(d, pos + 2);
+  }
+  return {};
+}
+
+QSize webpSize(QByteArrayView d) {
+  const QByteArrayView chunk = d.sliced(12, 4);
+  if (chunk == "VP8 " && d.size() >= 30)
+    return QSize(int(le16(d, 26) & 0x3fff), int(le16(d, 28) & 0x3fff));
+  if (chunk == "VP8L" && d.size() >= 25) {
+    const quint32 bits = quint32(le32(d, 21));
+    return QSize(int(bits & 0x3fff) + 1, int((bits >> 14) & 0x3fff) + 1);
+  }
+  if (chunk == "VP8X" && d.size() >= 30)
+    return QSize(int(le24(d, 24)) + 1, int(le24(d, 27)) + 1);
+  return {};
+}
+
+// Text that starts like an SVG document (possibly after a BOM, an XML
+// declaration or comments) and has an <svg element in the head.
+bool looksLikeSvg(QByteArrayView d) {
+  if (d.startsWith("\xEF\xBB\xBF"))
+    d = d.sliced(3);
+  while (!d.isEmpty() && (d[0] == ' ' || d[0] == '\t' || d[0] == '\r' ||
+                          d[0] == '\n'))
+    d = d.sliced(1);
+  if (!d.startsWith("<?xml") && !d.startsWith("<svg") &&
+      !d.startsWith("<!--") && !d.startsWith("<!DOCTYPE svg"))
+    return false;
+  return d.indexOf("<svg") >= 0;
+}
+
+} // namespace
+
+Result sniff(QByteArrayView d, bool complete) {
+  // Enough for every signature and every fixed-position header
+  constexpr qsizetype kFixedHeader = 30;
+  const Result needMore{complete ? Verdict::NotImage : Verdict::NeedMore, {},
+                        {}};
+
+  if (d.startsWith("\x89PNG\r\n\x1A\n")) {
+    if (d.size() < 24)
+      return complete ? image("image/png") : needMore;
+    return image("image/png", QSize(int(be32(d, 16)), int(be32(d, 20))));
+  }
+  if (d.startsWith("\xFF\xD8\xFF"))
+    return image("image/jpeg", jpegSize(d));
+  if (d.startsWith("GIF87a") || d.startsWith("GIF89a")) {
+    if (d.size() < 10)
+      return complete ? image("image/gif") : needMore;
+    return image("image/gif", QSize(int(le16(d, 6)), int(le16(d, 8))));
+  }
+  if (d.size() >= 16 && d.startsWith("RIFF") && d.sliced(8, 4) == "WEBP")
+    return image("image/webp", webpSize(d));
+  if (d.startsWith("BM") && d.size() >= 26) {
+    const qint32 dib = le32(d, 14);
+    if (dib == 12)
+      return image("image/bmp", QSize(int(le16(d, 18)), int(le16(d, 20))));
+    if (dib >= 40)
+      return image("image/bmp", QSize(le32(d, 18), qAbs(le32(d, 22))));
+    return image("image/bmp");
+  }
+  if (d.startsWith(QByteArrayView("II*\0", 4)) ||
+      d.startsWith(QByteArrayView("MM\0*", 4)))
+    return image("image/tiff");
+
+  if (d.size() < kFixedHeader && !complete)
+    return needMore;
+  // SVG is text: give it a kilobyte to reach the <svg element
+  if (looksLikeSvg(d))
+    return image("image/svg+xml");
+  if (d.size() < 1024 && !complete && d.trimmed().startsWith('<'))
+    return needMore;
+  return {Verdict::NotImage, {}, {}};
+}
+
+} // namespace ImageSniffer
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QSize>
+
+// Tells images from everything else by their first bytes, the way
+// ImageDownloader looks at a response before downloading the rest.
+//
+// Recognises PNG, JPEG, GIF, WebP, BMP, TIFF and SVG by signature and, for
+// the raster formats, reads the pixel size from the header: PNG, GIF, BMP
+// and WebP keep it in the first 30 bytes, JPEG in the first SOF segment
+// after however much metadata precedes it.
+namespace ImageSniffer {
+
+enum class Verdict {
+  NeedMore, // can't tell from this many bytes
+  Image,
+  NotImage,
+};
+
+struct Result {
+  Verdict verdict = Verdict::NeedMore;
+  QByteArray mime; // for Image
+  QSize size;      // invalid until the header holding it has been seen
+};
+
+// head is the start of the body; complete means no more bytes follow.
+Result sniff(QByteArrayView head, bool complete = false);
+
+} // namespace ImageSniffer
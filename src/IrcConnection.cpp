@@ -1,38 +1,54 @@
 #include "IrcConnection.h"
 #include "Version.h"
+#include "IrcMessage.h"
+#include "IrcSocketWorker.h"
+#include <QDateTime>
 #include <QDebug>
+#include <QMetaMethod>
+#include <QThread>
 
 IrcConnection::IrcConnection(QObject *parent)
-    : QObject(parent), m_socket(new QSslSocket(this)), m_port(6697),
+    : QObject(parent), m_worker(new IrcSocketWorker), m_port(6697),
       m_useSsl(true), m_nickname("NUchat_user"), m_username("nuchat"),
       m_realname("NUchat User"), m_registered(false) {
-  connect(m_socket, &QSslSocket::readyRead, this, &IrcConnection::onReadyRead);
-  connect(m_socket, &QSslSocket::disconnected, this,
+  m_worker->moveToThread(IrcSocketWorker::networkThread());
+  // Cross-thread, so all of these are queued
+  connect(m_worker, &IrcSocketWorker::linesReady, this,
+          &IrcConnection::drainInbox);
+  connect(m_worker, &IrcSocketWorker::socketConnected, this,
+          &IrcConnection::onSocketConnected);
+  connect(m_worker, &IrcSocketWorker::disconnected, this,
           &IrcConnection::onDisconnectedSlot);
-  connect(m_socket, qOverload<const QList<QSslError> &>(&QSslSocket::sslErrors),
-          this, &IrcConnection::onSslErrors);
+  connect(m_worker, &IrcSocketWorker::errorOccurred, this,
+          &IrcConnection::errorOccurred);
 
-  // Flood protection: drain one queued message per timer tick
-  m_sendTimer.setInterval(kDrainIntervalMs);
-  connect(&m_sendTimer, &QTimer::timeout, this, &IrcConnection::drainSendQueue);
+  // Flood protection: the timer wakes us when the next line may go
+  m_sendClock.start();
+  m_sendTimer.setSingleShot(true);
+  connect(&m_sendTimer, &QTimer::timeout, this, &IrcConnection::pumpSendQueue);
 
   // CAP/SASL negotiation timeout — if registration stalls, force CAP END
   m_regTimeoutTimer.setSingleShot(true);
   m_regTimeoutTimer.setInterval(kRegistrationTimeoutMs);
   connect(&m_regTimeoutTimer, &QTimer::timeout, this, [this]() {
-    if (m_registered ||
-        m_socket->state() != QAbstractSocket::ConnectedState)
+    if (m_registered || !m_socketConnected)
       return;
     qWarning() << "[IRC] CAP/SASL negotiation timed out on" << m_host
                << "— sending CAP END to complete registration";
     m_saslInProgress = false;
     emit errorOccurred(
         tr("CAP/SASL negotiation timed out — completing registration"));
-    sendRawImmediate("CAP END");
+    endCapNegotiation();
   });
 }
 
-IrcConnection::~IrcConnection() = default;
+IrcConnection::~IrcConnection() {
+  // Lines still in the inbox are dropped with the worker
+  if (m_worker->thread()->isRunning())
+    m_worker->deleteLater();
+  else
+    delete m_worker;
+}
 
 void IrcConnection::connectToServer(const QString &host, quint16 port,
                                     bool useSsl) {
@@ -40,72 +56,67 @@ void IrcConnection::connectToServer(const QString &host, quint16 port,
   m_port = port;
   m_useSsl = useSsl;
   m_registered = false;
-  m_readBuffer.clear();
-
-  if (m_socket->isOpen())
-    m_socket->disconnectFromHost();
-
-  if (useSsl) {
-    // Connect the encrypted signal for SSL
-    connect(m_socket, &QSslSocket::encrypted, this,
-            &IrcConnection::onSocketConnected, Qt::UniqueConnection);
-    m_socket->connectToHostEncrypted(host, port);
-  } else {
-    connect(m_socket, &QSslSocket::connected, this,
-            &IrcConnection::onSocketConnected, Qt::UniqueConnection);
-    m_socket->connectToHost(host, port);
-  }
+  m_socketConnected = false;
+  m_capEnded = false;
+  m_sendScheduler.clear();
+  m_sendTimer.stop();
+  // Lines of the old connection may still be in the inbox: drainInbox()
+  // drops them by this
+  ++m_generation;
+
+  QMetaObject::invokeMethod(
+      m_worker,
+      [w = m_worker, host, port, useSsl, generation = m_generation]() {
+        w->connectToHost(host, port, useSsl, generation);
+      },
+      Qt::QueuedConnection);
   qDebug() << "[IRC] Connecting to" << host << ":" << port
            << (useSsl ? "(SSL)" : "(plain)");
 }
 
 void IrcConnection::disconnectFromServer(const QString &quitMsg) {
-  if (m_socket->isOpen()) {
-    // Bypass the flood queue — the socket closes immediately after, so a
-    // queued QUIT would be silently dropped.
-    sendRawImmediate("QUIT :" + quitMsg);
-    m_socket->flush();
-    m_socket->disconnectFromHost();
-  }
+  // Bypass the flood queue — the socket closes immediately after, so a
+  // queued QUIT would be silently dropped.
+  const QByteArray quit = ("QUIT :" + quitMsg).toUtf8();
+  QMetaObject::invokeMethod(
+      m_worker, [w = m_worker, quit]() { w->disconnectFromHost(quit); },
+      Qt::QueuedConnection);
 }
 
 void IrcConnection::sendRaw(const QString &line) {
-  if (m_socket->state() != QAbstractSocket::ConnectedState &&
-      m_socket->state() != QAbstractSocket::BoundState)
+  if (!m_socketConnected)
     return;
-
-  // Flood protection: burst-then-throttle.
-  // Allow kBurst messages instantly, then queue the rest.
-  if (m_burstRemaining > 0) {
-    --m_burstRemaining;
-    sendRawImmediate(line);
-    if (!m_sendTimer.isActive())
-      m_sendTimer.start();
-  } else {
-    m_sendQueue.enqueue(line);
-    if (!m_sendTimer.isActive())
-      m_sendTimer.start();
-  }
+  enqueueSend(m_sendLane, line);
 }
 
 void IrcConnection::sendRawImmediate(const QString &line) {
-  QByteArray data = line.toUtf8();
-  data.append("\r\n");
-  m_socket->write(data);
-  m_socket->flush();
-  qDebug() << "[IRC >]" << line;
+  enqueueSend(SendScheduler::Lane::Control, line);
 }
 
-void IrcConnection::drainSendQueue() {
-  if (m_sendQueue.isEmpty()) {
-    // Nothing queued — replenish burst tokens and stop the timer
-    m_burstRemaining = kBurst;
-    m_sendTimer.stop();
-    return;
+void IrcConnection::enqueueSend(SendScheduler::Lane lane, const QString &line) {
+  m_sendScheduler.enqueue(lane, line.toUtf8());
+  pumpSendQueue();
+}
+
+void IrcConnection::pumpSendQueue() {
+  const qint64 now = m_sendClock.elapsed();
+  QByteArray line;
+  while (m_sendScheduler.next(now, line)) {
+    qDebug() << "[IRC >]" << line;
+    QMetaObject::invokeMethod(
+        m_worker, [w = m_worker, line]() { w->write(line); },
+        Qt::QueuedConnection);
   }
-  // Send one queued message
-  QString line = m_sendQueue.dequeue();
-  sendRawImmediate(line);
+  const qint64 wait = m_sendScheduler.delayUntilNext(now);
+  if (wait >= 0)
+    m_sendTimer.start(int(qMax<qint64>(wait, 1)));
+  else
+    m_sendTimer.stop();
+  emit sendQueueChanged(m_sendScheduler.depth());
+}
+
+void IrcConnection::setSendProfile(const SendScheduler::Profile &profile) {
+  m_sendScheduler.setProfile(profile);
 }
 
 QPair<QString, QString> IrcConnection::stripNickPrefix(const QString &nick) {
@@ -148,12 +159,12 @@ void IrcConnection::setNickServPass(const QString &pass) {
 void IrcConnection::setProxy(QNetworkProxy::ProxyType type, const QString &host,
                              quint16 port, const QString &user,
                              const QString &password) {
-  if (type == QNetworkProxy::NoProxy) {
-    m_socket->setProxy(QNetworkProxy::NoProxy);
-  } else {
-    QNetworkProxy proxy(type, host, port, user, password);
-    m_socket->setProxy(proxy);
-  }
+  QNetworkProxy proxy(QNetworkProxy::NoProxy);
+  if (type != QNetworkProxy::NoProxy)
+    proxy = QNetworkProxy(type, host, port, user, password);
+  QMetaObject::invokeMethod(
+      m_worker, [w = m_worker, proxy]() { w->setProxy(proxy); },
+      Qt::QueuedConnection);
   qDebug() << "[IRC] Proxy set:" << static_cast<int>(type) << host << port;
 }
 
@@ -164,6 +175,34 @@ void IrcConnection::joinChannel(const QString &channel, const QString &key) {
     sendRaw("JOIN " + channel + " " + key);
 }
 
+void IrcConnection::joinChannels(const QStringList &channels) {
+  for (const QString &line : packJoins(channels))
+    sendRaw(line);
+}
+
+QStringList IrcConnection::packJoins(const QStringList &channels,
+                                     int maxBytes) {
+  static const QByteArray kJoin = "JOIN ";
+  QStringList lines;
+  QByteArray line;
+  for (const QString &channel : channels) {
+    const QByteArray name = channel.toUtf8();
+    if (line.size() > kJoin.size() &&
+        line.size() + 1 + name.size() > maxBytes) {
+      lines.append(QString::fromUtf8(line));
+      line.clear();
+    }
+    if (line.isEmpty())
+      line = kJoin;
+    else
+      line += ',';
+    line += name;
+  }
+  if (!line.isEmpty())
+    lines.append(QString::fromUtf8(line));
+  return lines;
+}
+
 void IrcConnection::partChannel(const QString &channel, const QString &reason) {
   if (reason.isEmpty())
     sendRaw("PART " + channel);
@@ -228,7 +267,7 @@ void IrcConnection::sendCtcp(const QString &target, const QString &command,
 
 void IrcConnection::sendPing(const QString &token) {
   // Bypass the flood queue so lag measurement doesn't include queue latency
-  if (m_socket->state() == QAbstractSocket::ConnectedState)
+  if (m_socketConnected)
     sendRawImmediate("PING :" + token);
 }
 
@@ -238,26 +277,34 @@ void IrcConnection::whois(const QString &nick) { sendRaw("WHOIS " + nick); }
 
 // ── Slots ──
 
-void IrcConnection::onReadyRead() {
-  m_readBuffer += m_socket->readAll();
-
-  // Process complete lines (terminated by \r\n or \n)
-  while (true) {
-    int idx = m_readBuffer.indexOf('\n');
-    if (idx < 0)
-      break;
-    QByteArray rawLine = m_readBuffer.left(idx);
-    m_readBuffer = m_readBuffer.mid(idx + 1);
-    // strip trailing \r
-    if (rawLine.endsWith('\r'))
-      rawLine.chop(1);
-    QString line = QString::fromUtf8(rawLine);
-    if (!line.isEmpty())
-      processLine(line);
-  }
+void IrcConnection::drainInbox() {
+  // A handler that starts a nested event loop must not begin a second pass
+  // over newer lines while this one is half done; the outer loop picks up
+  // whatever arrived in the meantime.
+  if (m_draining)
+    return;
+  auto batches = m_worker->takeBatches();
+  if (batches.isEmpty())
+    return;
+  m_draining = true;
+  emit batchStarted();
+  do {
+    for (const IrcSocketWorker::Batch &batch : std::as_const(batches)) {
+      // Checked per batch: a handler may have reconnected in the meantime
+      if (batch.generation != m_generation)
+        continue;
+      for (const IrcMessage &msg : batch.messages)
+        processMessage(msg);
+    }
+    batches = m_worker->takeBatches();
+  } while (!batches.isEmpty());
+  m_draining = false;
+  emit batchFinished();
 }
 
-void IrcConnection::onSocketConnected() {
+void IrcConnection::onSocketConnected(const QHostAddress &localAddress) {
+  m_socketConnected = true;
+  m_localAddress = localAddress;
   qDebug() << "[IRC] Socket connected to" << m_host;
   emit socketConnected();
   sendRegistration();
@@ -265,6 +312,10 @@ void IrcConnection::onSocketConnected() {
 
 void IrcConnection::onDisconnectedSlot() {
   m_regTimeoutTimer.stop();
+  m_socketConnected = false;
+  // Nothing queued makes sense on the next connection
+  m_sendScheduler.clear();
+  m_sendTimer.stop();
   bool wasRegistered = m_registered;
   m_registered = false;
   if (wasRegistered)
@@ -274,27 +325,9 @@ void IrcConnection::onDisconnectedSlot() {
 }
 
 void IrcConnection::setAllowSelfSignedCerts(bool allow) {
-  m_allowSelfSignedCerts = allow;
-}
-
-void IrcConnection::onSslErrors(const QList<QSslError> &errors) {
-  // If the user has explicitly allowed self-signed / untrusted certs (global pref),
-  // ignore all errors reported for this handshake so the connection can proceed.
-  // This makes the "Accept self-signed / untrusted SSL certificates" setting effective
-  // for any cert validation failure (not just a hard-coded list of 6 codes).
-  if (m_allowSelfSignedCerts) {
-    for (const QSslError &e : errors) {
-      qDebug() << "[IRC] Ignoring SSL error (user-approved):" << e.errorString();
-    }
-    m_socket->ignoreSslErrors();
-    return;
-  }
-
-  // Secure default: fail on any SSL error.
-  if (!errors.isEmpty()) {
-    emit errorOccurred(tr("SSL error: %1").arg(errors.first().errorString()));
-    m_socket->abort();
-  }
+  QMetaObject::invokeMethod(
+      m_worker, [w = m_worker, allow]() { w->setAllowSelfSignedCerts(allow); },
+      Qt::QueuedConnection);
 }
 
 // ── IRC Protocol ──
@@ -302,6 +335,7 @@ void IrcConnection::onSslErrors(const QList<QSslError> &errors) {
 void IrcConnection::sendRegistration() {
   // Watchdog: if CAP/SASL negotiation stalls, force CAP END (see ctor)
   m_regTimeoutTimer.start();
+  m_capEnded = false;
 
   // Registration messages bypass the flood queue — they must go immediately
   // or the server will time us out.
@@ -317,72 +351,60 @@ void IrcConnection::sendRegistration() {
   sendRawImmediate("USER " + m_username + " 0 * :" + m_realname);
 }
 
-QString IrcConnection::nickFromPrefix(const QString &prefix) {
-  int bang = prefix.indexOf('!');
-  return (bang > 0) ? prefix.left(bang) : prefix;
+void IrcConnection::endCapNegotiation() {
+  // Pipelined CAP END may already be on its way; a second one would be
+  // answered with ERR_UNKNOWNCOMMAND on some servers.
+  if (m_capEnded)
+    return;
+  m_capEnded = true;
+  sendRawImmediate("CAP END");
 }
 
 void IrcConnection::processLine(const QString &line) {
-  emit rawLineReceived(line);
-  qDebug() << "[IRC <]" << line;
-
-  // ── IRCv3 message-tags: strip @tags prefix ──
-  // Format: @tag1=val;tag2;tag3=val :prefix COMMAND ...
-  QString rest = line;
-  m_lastTags.clear();
-  if (rest.startsWith('@')) {
-    int sp = rest.indexOf(' ');
-    if (sp > 0) {
-      m_lastTags = parseTags(rest.mid(1, sp - 1));
-      rest = rest.mid(sp + 1).trimmed();
-      emit taggedMessageReceived(m_lastTags);
-    }
-  }
+  const QByteArray utf8 = line.toUtf8();
+  processLine(QByteArrayView(utf8));
+}
 
-  // PING/PONG (no prefix)
-  if (rest.startsWith("PING ")) {
-    sendRawImmediate("PONG " + rest.mid(5));  // PONG must not be queued
-    return;
-  }
+void IrcConnection::processLine(QByteArrayView line) {
+  // Parse: [@tags] [:prefix] command [params...] [:trailing]
+  // Fields stay as views into `line` until a handler decodes them.
+  IrcMessage msg;
+  if (IrcMessage::parse(line, msg))
+    processMessage(msg);
+}
 
-  // Parse: [:prefix] command [params...] [:trailing]
-  QString prefix, command, trailing;
-  QStringList params;
+void IrcConnection::processMessage(const IrcMessage &msg) {
+  static const QMetaMethod rawLineSignal =
+      QMetaMethod::fromSignal(&IrcConnection::rawLineReceived);
+  static const QMetaMethod taggedSignal =
+      QMetaMethod::fromSignal(&IrcConnection::taggedMessageReceived);
 
-  if (rest.startsWith(':')) {
-    int sp = rest.indexOf(' ');
-    if (sp < 0)
-      return;
-    prefix = rest.mid(1, sp - 1);
-    rest = rest.mid(sp + 1);
-  }
+  if (isSignalConnected(rawLineSignal))
+    emit rawLineReceived(QString::fromUtf8(msg.raw));
+  qDebug() << "[IRC <]" << msg.raw;
 
-  // Find trailing
-  int colonIdx = rest.indexOf(" :");
-  if (colonIdx >= 0) {
-    trailing = rest.mid(colonIdx + 2);
-    rest = rest.left(colonIdx);
-  }
+  // ── IRCv3 message-tags ──
+  // Format: @tag1=val;tag2;tag3=val :prefix COMMAND ...
+  if (msg.hasTags() && isSignalConnected(taggedSignal))
+    emit taggedMessageReceived(msg.tags());
 
-  QStringList tokens = rest.split(' ', Qt::SkipEmptyParts);
-  if (tokens.isEmpty())
+  // PING/PONG
+  // PING/PONG: answered by the worker as soon as it is read, however busy
+  // this thread is
+  if (msg.commandIs("PING"))
     return;
-  command = tokens.takeFirst().toUpper();
-  params = tokens;
-  if (!trailing.isNull())
-    params.append(trailing);
 
   // ── Handle by command ──
 
   // CAP negotiation
-  if (command == "CAP") {
+  if (msg.commandIs("CAP")) {
     // params: [nick] [subcommand] ... [trailing]
-    QString sub = (params.size() >= 2) ? params[1].toUpper() : "";
+    const QString sub = msg.param(1).toUpper();
     if (sub == "LS") {
       // Multi-line CAP LS: if the second param (after nick) is "*", more
       // lines follow.  Accumulate until the final line (no "*").
-      bool more = (params.size() >= 3 && params[2] == "*");
-      QString capList = params.last();
+      bool more = msg.paramCount >= 3 && msg.paramEquals(2, "*");
+      QString capList = msg.lastParam();
 
       if (more) {
         // Continuation line — accumulate caps
@@ -415,11 +437,15 @@ void IrcConnection::processLine(const QString &line) {
           m_saslInProgress = true;
         sendRawImmediate("CAP REQ :" + capsToReq.join(' '));
         qDebug() << "[IRC] Requesting capabilities:" << capsToReq;
+        // Without SASL there is nothing to wait for: the server handles the
+        // REQ before the END, so registration finishes a round trip sooner.
+        if (!m_saslInProgress)
+          endCapNegotiation();
       } else {
-        sendRawImmediate("CAP END");
+        endCapNegotiation();
       }
     } else if (sub == "ACK") {
-      QString acked = params.last();
+      QString acked = msg.lastParam();
       if (acked.contains("sasl", Qt::CaseInsensitive)) {
         // Start SASL authentication
         if (m_saslMethod == "PLAIN") {
@@ -430,21 +456,21 @@ void IrcConnection::processLine(const QString &line) {
           // Unsupported method, just end
           qDebug() << "[IRC] Unsupported SASL method:" << m_saslMethod;
           m_saslInProgress = false;
-          sendRawImmediate("CAP END");
+          endCapNegotiation();
         }
       } else {
-        sendRawImmediate("CAP END");
+        endCapNegotiation();
       }
     } else if (sub == "NAK") {
       m_saslInProgress = false;
-      sendRawImmediate("CAP END");
+      endCapNegotiation();
     }
     return;
   }
 
   // AUTHENTICATE challenge
-  if (command == "AUTHENTICATE") {
-    if (params.size() >= 1 && params[0] == "+") {
+  if (msg.commandIs("AUTHENTICATE")) {
+    if (msg.paramEquals(0, "+")) {
       if (m_saslMethod == "PLAIN") {
         // SASL PLAIN: base64(authzid \0 authcid \0 password)
         QString authStr =
@@ -466,14 +492,11 @@ void IrcConnection::processLine(const QString &line) {
   }
 
   // Numeric replies
-  bool isNumeric = false;
-  int numeric = command.toInt(&isNumeric);
+  const int numeric = msg.numeric();
 
-  if (isNumeric) {
+  if (numeric >= 0) {
     // Strip the first param (our nick) for the signal
-    QStringList numParams = params;
-    if (!numParams.isEmpty())
-      numParams.removeFirst(); // remove our nick
+    const QStringList numParams = msg.paramList(1);
     QString numTrailing = numParams.isEmpty() ? QString() : numParams.last();
 
     emit numericReceived(numeric, numParams, numTrailing);
@@ -486,8 +509,8 @@ void IrcConnection::processLine(const QString &line) {
       m_nickRetries = 0;
       // Update our nick from the server's response (params[0] is our actual
       // nick)
-      if (!params.isEmpty()) {
-        QString actualNick = params.first();
+      if (msg.paramCount > 0) {
+        QString actualNick = msg.param(0);
         if (actualNick != m_nickname) {
           m_nickname = actualNick;
           emit nicknameChanged(m_nickname);
@@ -528,7 +551,7 @@ void IrcConnection::processLine(const QString &line) {
     else if (numeric == 903) {
       m_saslInProgress = false;
       qDebug() << "[IRC] SASL authentication successful";
-      sendRawImmediate("CAP END");
+      endCapNegotiation();
     }
     // ERR_SASLFAIL (904), ERR_SASLTOOLONG (905), ERR_SASLABORTED (906),
     // ERR_SASLALREADY (907)
@@ -538,7 +561,7 @@ void IrcConnection::processLine(const QString &line) {
       qDebug() << "[IRC] SASL authentication failed (" << numeric << ")";
       emit errorOccurred("SASL authentication failed (" +
                          QString::number(numeric) + "): " + numTrailing);
-      sendRawImmediate("CAP END");
+      endCapNegotiation();
     }
     // RPL_TOPIC (332)
     else if (numeric == 332 && numParams.size() >= 2) {
@@ -604,19 +627,20 @@ void IrcConnection::processLine(const QString &line) {
 
   // ── Named commands ──
 
-  if (command == "PRIVMSG") {
-    if (params.size() < 2)
+  if (msg.commandIs("PRIVMSG")) {
+    if (msg.paramCount < 2)
       return;
-    QString target = params[0];
-    QString msg = params[1];
+    const QString prefix = msg.source();
+    QString target = msg.param(0);
+    QString text = msg.param(1);
     // Check for CTCP
-    if (msg.startsWith('\x01') && msg.endsWith('\x01')) {
-      QString ctcp = msg.mid(1, msg.length() - 2);
+    if (text.startsWith('\x01') && text.endsWith('\x01')) {
+      QString ctcp = text.mid(1, text.length() - 2);
       int sp = ctcp.indexOf(' ');
       QString ctcpCmd = (sp >= 0) ? ctcp.left(sp).toUpper() : ctcp.toUpper();
       QString ctcpArgs = (sp >= 0) ? ctcp.mid(sp + 1) : "";
       // Auto-reply to common CTCPs
-      QString nick = nickFromPrefix(prefix);
+      QString nick = msg.nick();
       if (ctcpCmd == "VERSION") {
         sendRaw("NOTICE " + nick +
                 " :\x01VERSION NUchat " NUCHAT_VERSION " (Qt6)\x01");
@@ -629,76 +653,44 @@ void IrcConnection::processLine(const QString &line) {
       emit ctcpReceived(prefix, target, ctcpCmd, ctcpArgs);
       return;
     }
-    emit privmsgReceived(prefix, target, msg);
-  } else if (command == "NOTICE") {
-    if (params.size() < 2)
+    emit privmsgReceived(prefix, target, text);
+  } else if (msg.commandIs("NOTICE")) {
+    if (msg.paramCount < 2)
       return;
-    emit noticeReceived(prefix, params[0], params[1]);
-  } else if (command == "JOIN") {
-    QString channel = params.isEmpty() ? "" : params[0];
-    emit joinReceived(prefix, channel);
+    emit noticeReceived(msg.source(), msg.param(0), msg.param(1));
+  } else if (msg.commandIs("JOIN")) {
+    QString channel = msg.param(0);
+    emit joinReceived(msg.source(), channel);
     // If it's us joining, init names list
-    if (nickFromPrefix(prefix) == m_nickname) {
+    if (msg.nick() == m_nickname) {
       m_channelNames[channel] = QStringList();
       m_namesStarted.remove(channel);  // allow fresh tracking on next 353
     }
-  } else if (command == "PART") {
-    QString channel = params.isEmpty() ? "" : params[0];
-    QString reason = (params.size() >= 2) ? params[1] : "";
-    emit partReceived(prefix, channel, reason);
-  } else if (command == "QUIT") {
-    QString reason = params.isEmpty() ? "" : params[0];
-    emit quitReceived(prefix, reason);
-  } else if (command == "KICK") {
-    if (params.size() < 2)
+  } else if (msg.commandIs("PART")) {
+    emit partReceived(msg.source(), msg.param(0), msg.param(1));
+  } else if (msg.commandIs("QUIT")) {
+    emit quitReceived(msg.source(), msg.param(0));
+  } else if (msg.commandIs("KICK")) {
+    if (msg.paramCount < 2)
       return;
-    QString channel = params[0];
-    QString kicked = params[1];
-    QString reason = (params.size() >= 3) ? params[2] : "";
-    emit kickReceived(prefix, channel, kicked, reason);
-  } else if (command == "NICK") {
-    QString newNick = params.isEmpty() ? "" : params[0];
-    QString oldNick = nickFromPrefix(prefix);
+    emit kickReceived(msg.source(), msg.param(0), msg.param(1), msg.param(2));
+  } else if (msg.commandIs("NICK")) {
+    QString newNick = msg.param(0);
+    QString oldNick = msg.nick();
     if (oldNick == m_nickname) {
       m_nickname = newNick;
       emit nicknameChanged(m_nickname);
     }
     emit nickChanged(oldNick, newNick);
-  } else if (command == "TOPIC") {
-    if (params.size() >= 2)
-      emit topicReceived(params[0], params[1]);
-  } else if (command == "MODE") {
-    if (params.size() >= 2) {
-      QString target = params[0];
-      QString modeStr = params[1];
-      QStringList modeParams = params.mid(2);
-      emit modeReceived(prefix, target, modeStr, modeParams);
-    }
-  } else if (command == "ERROR") {
-    emit errorOccurred(params.isEmpty() ? "Unknown error" : params.join(" "));
-  }
-}
-
-// ── IRCv3 message-tags parser ──
-// Parse "tag1=val;tag2;tag3=escaped\\svalue" into QMap
-QMap<QString, QString> IrcConnection::parseTags(const QString &tagStr) {
-  QMap<QString, QString> tags;
-  const auto parts = tagStr.split(';', Qt::SkipEmptyParts);
-  for (const QString &part : parts) {
-    int eq = part.indexOf('=');
-    if (eq >= 0) {
-      QString key = part.left(eq);
-      QString val = part.mid(eq + 1);
-      // IRCv3 tag value unescaping: \: = ; \s = space \\ = \ \r \n
-      val.replace("\\:", ";");
-      val.replace("\\s", " ");
-      val.replace("\\r", "\r");
-      val.replace("\\n", "\n");
-      val.replace("\\\\", "\\");
-      tags[key] = val;
-    } else {
-      tags[part] = QString();  // boolean tag (no value)
-    }
+  } else if (msg.commandIs("TOPIC")) {
+    if (msg.paramCount >= 2)
+      emit topicReceived(msg.param(0), msg.param(1));
+  } else if (msg.commandIs("MODE")) {
+    if (msg.paramCount >= 2)
+      emit modeReceived(msg.source(), msg.param(0), msg.param(1),
+                        msg.paramList(2));
+  } else if (msg.commandIs("ERROR")) {
+    emit errorOccurred(msg.paramCount == 0 ? QStringLiteral("Unknown error")
+                                           : msg.paramList().join(" "));
   }
-  return tags;
 }
@@ -1,15 +1,23 @@
 #pragma once
 
+#include <QElapsedTimer>
 #include <QObject>
-#include <QQueue>
 #include <QSet>
 #include <QStringList>
 #include <QMap>
 #include <QTimer>
-#include <QtNetwork/QSslSocket>
 #include <QtNetwork/QNetworkProxy>
 #include <QtNetwork/QHostAddress>
+#include "SendScheduler.h"
 
+class IrcSocketWorker;
+struct IrcMessage;
+
+// One server connection, as seen from the GUI thread.
+//
+// The socket itself, TLS and line parsing live in an IrcSocketWorker on the
+// network thread; parsed lines arrive here in batches and are turned into
+// the signals below.  All methods are for the GUI thread.
 class IrcConnection : public QObject
 {
     Q_OBJECT
@@ -52,13 +60,26 @@ public:
     bool isConnected() const { return m_registered; }
 
     // Local address of the connected socket (used for DCC SEND offers)
-    QHostAddress localAddress() const { return m_socket->localAddress(); }
+    QHostAddress localAddress() const { return m_localAddress; }
 
     // Send a PING immediately, bypassing the flood queue (lag measurement)
     void sendPing(const QString &token);
 
+    // Outgoing flood control.  sendRaw() and the commands below queue on
+    // the current lane (Interactive unless a caller switched it, e.g. to
+    // Bulk around a paste); registration, PINGs and QUIT use Control.
+    void setSendLane(SendScheduler::Lane lane) { m_sendLane = lane; }
+    SendScheduler::Lane sendLane() const { return m_sendLane; }
+    void setSendProfile(const SendScheduler::Profile &profile);
+    const SendScheduler &sendScheduler() const { return m_sendScheduler; }
+    qint64 sendBacklogMs() const { return m_sendScheduler.backlogMs(m_sendClock.elapsed()); }
+
     // IRC commands
     Q_INVOKABLE void joinChannel(const QString &channel, const QString &key = QString());
+    // Joins all of them with as few JOIN lines as fit the line limit
+    void joinChannels(const QStringList &channels);
+    // "JOIN #a,#b,..." lines of at most maxBytes (UTF-8, without CRLF)
+    static QStringList packJoins(const QStringList &channels, int maxBytes = 510);
     Q_INVOKABLE void partChannel(const QString &channel, const QString &reason = QString());
     Q_INVOKABLE void sendMessage(const QString &target, const QString &message);
     Q_INVOKABLE void sendNotice(const QString &target, const QString &notice);
@@ -74,9 +95,17 @@ signals:
     void registered();                   // RPL_WELCOME received — fully logged in
     void disconnectedFromServer();
     void rawLineReceived(const QString &line);
+
+    // Bracket the signals of every line that arrived together (everything
+    // read while the GUI thread was busy).  Optional: a receiver can hold
+    // back model updates and log writes in between and apply them once.
+    void batchStarted();
+    void batchFinished();
     void nicknameChanged(const QString &nick);
     void serverHostChanged(const QString &host);
     void connectionStateChanged(bool connected);
+    // Lines waiting in the send scheduler changed (queued or released)
+    void sendQueueChanged(int depth);
 
     // Parsed IRC events
     void privmsgReceived(const QString &prefix, const QString &target, const QString &message);
@@ -99,25 +128,26 @@ signals:
     void taggedMessageReceived(const QMap<QString, QString> &tags);
 
 private slots:
-    void onReadyRead();
-    void onSocketConnected();
+    void drainInbox();
+    void onSocketConnected(const QHostAddress &localAddress);
     void onDisconnectedSlot();
-    void onSslErrors(const QList<QSslError> &errors);
-    void drainSendQueue();
+    void pumpSendQueue();
 
 private:
-    QSslSocket *m_socket;
+    IrcSocketWorker *m_worker;  // on IrcSocketWorker::networkThread()
+    bool m_socketConnected = false;
+    QHostAddress m_localAddress;
     QString m_host;
     quint16 m_port;
     bool m_useSsl;
-    bool m_allowSelfSignedCerts = false;
     QString m_nickname;
     QString m_username;
     QString m_realname;
     QString m_password;
     bool m_registered;
     int m_nickRetries = 0;      // incremented on each 433; reset on registration
-    QByteArray m_readBuffer;
+    bool m_draining = false;
+    quint32 m_generation = 0;   // of the current connectToServer()
 
     // SASL authentication state
     QString m_saslMethod;   // "None", "PLAIN", "EXTERNAL"
@@ -134,32 +164,29 @@ private:
     QSet<QString> m_namesStarted;   // channels with an in-progress 353 sequence
 
     // ── Flood protection ──
-    // Burst-then-throttle: allow up to kBurst messages instantly, then
-    // drain the queue at kDrainIntervalMs.
-    static constexpr int kBurst = 5;
-    static constexpr int kDrainIntervalMs = 1000;  // 1 message per second
-    QQueue<QString> m_sendQueue;
-    QTimer m_sendTimer;
-    int m_burstRemaining = kBurst;
+    SendScheduler m_sendScheduler;
+    SendScheduler::Lane m_sendLane = SendScheduler::Lane::Interactive;
+    QElapsedTimer m_sendClock;
+    QTimer m_sendTimer;  // single-shot, fires when the next line may go
 
     // ── Registration / CAP negotiation timeout ──
     // If the CAP/SASL dance stalls (server ACKs sasl but never completes),
     // bail out with CAP END so registration can finish instead of hanging.
     static constexpr int kRegistrationTimeoutMs = 30000;
     QTimer m_regTimeoutTimer;
+    bool m_capEnded = false;  // CAP END sent on this connection
 
     // ── Multi-line CAP LS accumulation ──
     QString m_pendingCapLs;  // caps seen so far when server sends CAP * LS *
 
-    // ── IRCv3 message-tags ──
-    QMap<QString, QString> m_lastTags;  // tags from the most recently parsed line
-    static QMap<QString, QString> parseTags(const QString &tagStr);
-
     void processLine(const QString &line);
-    void sendRawImmediate(const QString &line);  // bypass flood queue
+    void processLine(QByteArrayView line);  // parses via IrcMessage, no copies
+    void processMessage(const IrcMessage &msg);
+    void sendRawImmediate(const QString &line);  // Control lane
+    void enqueueSend(SendScheduler::Lane lane, const QString &line);
 
     // Allow unit tests to drive processLine() directly
     friend class IrcConnectionTestable;
     void sendRegistration();
-    static QString nickFromPrefix(const QString &prefix);
+    void endCapNegotiation();
 };
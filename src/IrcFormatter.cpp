@@ -0,0 +1,575 @@
+#include "IrcFormatter.h"
+#include "ImageDownloader.h"
+#include <QVector>
+#include <algorithm>
+
+namespace {
+
+// Standard mIRC color palette (indices 0-15)
+const char *const kMircColors[] = {
+    "#ffffff", "#000000",
+    "#00007f", "#009300", // 0-3: white, black, navy, green
+    "#ff0000", "#7f0000",
+    "#9c009c", "#fc7f00", // 4-7: red, brown, purple, orange
+    "#ffff00", "#00fc00",
+    "#009393", "#00ffff", // 8-11: yellow, lime, teal, cyan
+    "#0000fc", "#ff00ff",
+    "#7f7f7f", "#d2d2d2" // 12-15: blue, pink, grey, light grey
+};
+
+// 16 distinct nick colors – dark palette (bright on dark bg)
+const char *const kNickPaletteDark[] = {
+    "#c678dd", // purple
+    "#e06c75", // red
+    "#98c379", // green
+    "#e5c07b", // yellow
+    "#61afef", // blue
+    "#56b6c2", // cyan
+    "#be5046", // dark red
+    "#d19a66", // orange
+    "#ff79c6", // pink
+    "#50fa7b", // bright green
+    "#8be9fd", // bright cyan
+    "#bd93f9", // lavender
+    "#ffb86c", // light orange
+    "#ff5555", // bright red
+    "#69ff94", // mint
+    "#f1fa8c", // light yellow
+};
+// 16 distinct nick colors – light palette (dark/saturated on light bg)
+const char *const kNickPaletteLight[] = {
+    "#7b2fa0", // purple
+    "#b5182e", // red
+    "#3a7d1a", // green
+    "#9e7c16", // dark yellow
+    "#1a5fb4", // blue
+    "#1a8a7d", // teal
+    "#8b2d1a", // dark red
+    "#a85600", // orange
+    "#c4246e", // pink
+    "#1d8348", // forest green
+    "#0e6f87", // dark cyan
+    "#6a3daa", // dark lavender
+    "#b46a00", // dark orange
+    "#cc2222", // bright red
+    "#127a3a", // dark mint
+    "#887a09", // olive
+};
+constexpr int kNickColorCount = 16;
+
+// Literal HTML a relay bot may embed is dropped, but only for known element
+// names: "<nick>", "<3 you>" or "<QMap K, V>" are user text.  Sorted for
+// binary search.
+const char *const kHtmlTagNames[] = {
+    "a",      "article", "aside",   "b",      "big",      "blockquote",
+    "body",   "br",      "button",  "code",   "div",      "em",
+    "font",   "footer",  "form",    "h1",     "h2",       "h3",
+    "h4",     "h5",      "h6",      "head",   "header",   "hr",
+    "html",   "i",       "img",     "input",  "label",    "li",
+    "link",   "main",    "meta",    "nav",    "ol",       "option",
+    "p",      "pre",     "s",       "script", "section",  "select",
+    "small",  "span",    "strong",  "style",  "sub",      "sup",
+    "table",  "tbody",   "td",      "textarea", "th",     "thead",
+    "title",  "tr",      "u",       "ul"};
+
+struct TagNameLess {
+  bool operator()(const char *a, QStringView b) const {
+    return b.compare(QLatin1String(a), Qt::CaseInsensitive) > 0;
+  }
+  bool operator()(QStringView a, const char *b) const {
+    return a.compare(QLatin1String(b), Qt::CaseInsensitive) < 0;
+  }
+};
+
+bool isHtmlTag(QStringView content) {
+  content = content.trimmed();
+  if (content.startsWith(u'/'))
+    content = content.sliced(1);
+  const qsizetype space = content.indexOf(u' ');
+  const QStringView name = space >= 0 ? content.first(space) : content;
+  if (name.isEmpty())
+    return false;
+  return std::binary_search(std::begin(kHtmlTagNames), std::end(kHtmlTagNames),
+                            name, TagNameLess());
+}
+
+// Emoji get an explicit emoji-capable font stack so they render in color
+// while the chat font (often monospace) stays in charge of everything else.
+bool isEmojiBaseCodepoint(char32_t cp) {
+  if (cp >= 0x1F300 && cp <= 0x1FAFF)
+    return true;
+  if (cp >= 0x1F1E6 && cp <= 0x1F1FF)
+    return true; // regional indicators (flags)
+  if (cp >= 0x2600 && cp <= 0x27BF)
+    return true;
+  if (cp >= 0x2300 && cp <= 0x23FF)
+    return true;
+  if (cp == 0x00A9 || cp == 0x00AE || cp == 0x203C || cp == 0x2049 ||
+      cp == 0x2122 || cp == 0x2139 || cp == 0x3030 || cp == 0x303D ||
+      cp == 0x3297 || cp == 0x3299)
+    return true;
+  return false;
+}
+
+bool isEmojiJoinerOrModifier(char32_t cp) {
+  return cp == 0x200D || cp == 0xFE0E || cp == 0xFE0F || cp == 0x20E3 ||
+         (cp >= 0x1F3FB && cp <= 0x1F3FF);
+}
+
+char32_t codepointAt(QStringView text, qsizetype i, int *units) {
+  const QChar c = text[i];
+  if (c.isHighSurrogate() && i + 1 < text.size() &&
+      text[i + 1].isLowSurrogate()) {
+    *units = 2;
+    return QChar::surrogateToUcs4(c, text[i + 1]);
+  }
+  *units = 1;
+  return c.unicode();
+}
+
+bool isFormatCode(char16_t u) {
+  return u == 0x02 || u == 0x03 || u == 0x04 || u == 0x0F || u == 0x11 ||
+         u == 0x16 || u == 0x1D || u == 0x1E || u == 0x1F;
+}
+
+bool isModePrefix(QChar c) {
+  return c == u'~' || c == u'&' || c == u'@' || c == u'%' || c == u'+';
+}
+
+// Characters that can appear in an IRC nick (RFC 2812 + common
+// extensions); a mention is the nick NOT surrounded by these.
+bool isNickChar(QChar c) {
+  const char16_t u = c.unicode();
+  return (u >= u'A' && u <= u'Z') || (u >= u'a' && u <= u'z') ||
+         (u >= u'0' && u <= u'9') || u == u'_' || u == u'-' || u == u'[' ||
+         u == u']' || u == u'\\' || u == u'`' || u == u'^' || u == u'{' ||
+         u == u'}' || u == u'|';
+}
+
+// Whole-word nick at p; `from` is where the searched text starts, so there
+// is nothing to the left of it.
+bool nickWordAt(QStringView text, qsizetype p, QStringView nick,
+                qsizetype from) {
+  const qsizetype n = nick.size();
+  if (p + n > text.size())
+    return false;
+  if (p > from && isNickChar(text[p - 1]))
+    return false;
+  if (text.sliced(p, n).compare(nick, Qt::CaseInsensitive) != 0)
+    return false;
+  return p + n == text.size() || !isNickChar(text[p + n]);
+}
+
+// Text that goes out unchanged: no markup, entity, URL or emoji can start
+// at it.
+bool isPlain(QChar c) {
+  const char16_t u = c.unicode();
+  if (u < 0x20 || u == u'<' || u == u'>' || u == u'&' || u == u'"' ||
+      u == u'h' || c.isSurrogate())
+    return false;
+  return !isEmojiBaseCodepoint(u);
+}
+
+void appendEscaped(QString &out, QStringView text) {
+  qsizetype run = 0;
+  for (qsizetype i = 0; i < text.size(); ++i) {
+    const char16_t u = text[i].unicode();
+    const char *entity = u == u'<'   ? "&lt;"
+                         : u == u'>' ? "&gt;"
+                         : u == u'&' ? "&amp;"
+                         : u == u'"' ? "&quot;"
+                                     : nullptr;
+    if (!entity)
+      continue;
+    out.append(text.sliced(run, i - run));
+    out += QLatin1String(entity);
+    run = i + 1;
+  }
+  out.append(text.sliced(run));
+}
+
+void appendNickLink(QString &out, QStringView nick, bool dark) {
+  out += QLatin1String("<a href=\"nick://");
+  appendEscaped(out, nick);
+  out += QLatin1String("\" style=\"color:");
+  out += IrcFormatter::nickColor(nick, dark);
+  out += QLatin1String("; text-decoration:none; font-weight:bold;\">");
+  appendEscaped(out, nick);
+  out += QLatin1String("</a>");
+}
+
+// Current foreground/background: a palette index or "RRGGBB" from \x04
+struct Color {
+  int mirc = -1;
+  QStringView hex;
+
+  bool isSet() const { return mirc >= 0 || !hex.isEmpty(); }
+  static Color palette(int index) {
+    Color c;
+    if (index >= 0 && index <= 98)
+      c.mirc = index;
+    return c;
+  }
+};
+
+const QString &paletteColor(int index) {
+  static const QVector<QString> table = [] {
+    QVector<QString> t;
+    for (int i = 0; i <= 98; ++i)
+      t.append(IrcFormatter::mircColor(i));
+    return t;
+  }();
+  return table.at(index);
+}
+
+bool isHex6(QStringView text, qsizetype i) {
+  if (i + 6 > text.size())
+    return false;
+  for (qsizetype k = i; k < i + 6; ++k) {
+    const char16_t u = text[k].unicode();
+    if (!((u >= u'0' && u <= u'9') || (u >= u'a' && u <= u'f') ||
+          (u >= u'A' && u <= u'F')))
+      return false;
+  }
+  return true;
+}
+
+} // namespace
+
+namespace IrcFormatter {
+
+QString mircColor(int idx) {
+  if (idx >= 0 && idx <= 15)
+    return QString::fromLatin1(kMircColors[idx]);
+  // Extended colors 16-98: generate from standard 6x6x6 cube + greys
+  if (idx >= 16 && idx <= 87) {
+    int n = idx - 16;
+    int r = (n / 36) * 51;
+    int g = ((n / 6) % 6) * 51;
+    int b = (n % 6) * 51;
+    return QStringLiteral("#%1%2%3")
+        .arg(r, 2, 16, QLatin1Char('0'))
+        .arg(g, 2, 16, QLatin1Char('0'))
+        .arg(b, 2, 16, QLatin1Char('0'));
+  }
+  if (idx >= 88 && idx <= 98) {
+    int grey = (idx - 88) * 23 + 10;
+    return QStringLiteral("#%1%1%1").arg(grey, 2, 16, QLatin1Char('0'));
+  }
+  return QString();
+}
+
+QString nickColor(QStringView nick, bool darkPalette) {
+  // DJB2 hash for consistent color assignment
+  uint hash = 5381;
+  for (const QChar c : nick)
+    hash = ((hash << 5) + hash) + c.toLower().unicode();
+  const char *const *palette = darkPalette ? kNickPaletteDark : kNickPaletteLight;
+  return QString::fromLatin1(palette[hash % kNickColorCount]);
+}
+
+bool containsNickWord(QStringView text, QStringView nick) {
+  if (nick.isEmpty())
+    return false;
+  const QChar first = nick.front().toCaseFolded();
+  for (qsizetype p = 0; p + nick.size() <= text.size(); ++p) {
+    if (text[p].toCaseFolded() == first && nickWordAt(text, p, nick, 0))
+      return true;
+  }
+  return false;
+}
+
+QString toHtml(QStringView text, const Options &options) {
+  QString out;
+  out.reserve(text.size() * 3 / 2 + 64);
+  appendHtml(text, out, options);
+  return out;
+}
+
+bool appendHtml(QStringView text, QString &out, const Options &opt) {
+  const qsizetype len = text.size();
+
+  // ── Mention detection, advanced as the scan moves ──
+  // Only text after the "<sender>" prefix counts, and never our own lines.
+  const QStringView nick = opt.mentionNick;
+  qsizetype mentionPos = len;
+  if (!nick.isEmpty()) {
+    const qsizetype lt = text.indexOf(u'<');
+    const qsizetype gt = text.indexOf(u'>');
+    if (lt >= 0 && gt > lt) {
+      QStringView sender = text.sliced(lt + 1, gt - lt - 1);
+      while (!sender.isEmpty() && isModePrefix(sender.front()))
+        sender = sender.sliced(1);
+      if (sender.compare(nick, Qt::CaseInsensitive) != 0)
+        mentionPos = gt + 1;
+    }
+  }
+  const qsizetype bodyStart = mentionPos;
+  const QChar nickFirst = nick.isEmpty() ? QChar() : nick.front().toCaseFolded();
+  bool mentioned = false;
+  auto scanMentions = [&](qsizetype upTo) {
+    for (; !mentioned && mentionPos < upTo; ++mentionPos)
+      mentioned = text[mentionPos].toCaseFolded() == nickFirst &&
+                  nickWordAt(text, mentionPos, nick, bodyStart);
+  };
+
+  // ── Formatting state ──
+  bool bold = false, italic = false, underline = false, strike = false;
+  Color fg, bg;
+  int openFonts = 0;
+  auto closeFonts = [&] {
+    for (; openFonts > 0; --openFonts)
+      out += QLatin1String("</font>");
+  };
+  auto openFont = [&] {
+    if (!fg.isSet())
+      return;
+    out += QLatin1String("<font color=\"");
+    if (fg.mirc >= 0) {
+      out += paletteColor(fg.mirc);
+    } else {
+      out += QLatin1Char('#');
+      out.append(fg.hex);
+    }
+    out += QLatin1String("\">");
+    ++openFonts;
+  };
+  auto toggle = [&](bool &on, const char *open, const char *close) {
+    out += QLatin1String(on ? close : open);
+    on = !on;
+  };
+
+  qsizetype i = 0;
+
+  // "* nick does something": the action's nick
+  if (opt.nickLinks && text.startsWith(QLatin1String("* "))) {
+    qsizetype j = 2;
+    while (j < len) {
+      int units;
+      const char32_t cp = codepointAt(text, j, &units);
+      if (cp < 0x20 || cp == u'<' || QChar::isSpace(cp) ||
+          isEmojiBaseCodepoint(cp))
+        break;
+      j += units;
+    }
+    if (j > 2) {
+      out += QLatin1String("* ");
+      appendNickLink(out, text.sliced(2, j - 2), opt.darkPalette);
+      i = j;
+    }
+  }
+
+  while (i < len) {
+    scanMentions(i);
+    const QChar c = text[i];
+    const char16_t u = c.unicode();
+
+    // ── mIRC control codes ──
+    if (u < 0x20) {
+      ++i;
+      switch (u) {
+      case 0x02:
+        toggle(bold, "<b>", "</b>");
+        break;
+      case 0x1D:
+        toggle(italic, "<i>", "</i>");
+        break;
+      case 0x1F:
+        toggle(underline, "<u>", "</u>");
+        break;
+      case 0x1E:
+        toggle(strike, "<s>", "</s>");
+        break;
+      case 0x16: // Reverse — swap fg/bg
+        closeFonts();
+        std::swap(fg, bg);
+        if (!fg.isSet() && bg.isSet())
+          fg = Color::palette(1); // black
+        openFont();
+        break;
+      case 0x0F: // Reset
+        closeFonts();
+        if (bold)
+          toggle(bold, "<b>", "</b>");
+        if (italic)
+          toggle(italic, "<i>", "</i>");
+        if (underline)
+          toggle(underline, "<u>", "</u>");
+        if (strike)
+          toggle(strike, "<s>", "</s>");
+        fg = bg = Color();
+        break;
+      case 0x03: { // Color: \x03FG[,BG]; bare \x03 resets
+        closeFonts();
+        int f = -1, b = -1;
+        if (i < len && text[i].isDigit()) {
+          f = text[i++].digitValue();
+          if (i < len && text[i].isDigit())
+            f = f * 10 + text[i++].digitValue();
+          if (i < len && text[i] == u',') {
+            ++i;
+            if (i < len && text[i].isDigit()) {
+              b = text[i++].digitValue();
+              if (i < len && text[i].isDigit())
+                b = b * 10 + text[i++].digitValue();
+            }
+          }
+        }
+        if (f >= 0) {
+          fg = Color::palette(f);
+          if (b >= 0)
+            bg = Color::palette(b);
+        } else {
+          fg = bg = Color();
+        }
+        openFont();
+        break;
+      }
+      case 0x04: // Hex color: \x04RRGGBB[,RRGGBB]
+        closeFonts();
+        if (isHex6(text, i)) {
+          fg = Color();
+          fg.hex = text.sliced(i, 6);
+          i += 6;
+          if (i < len && text[i] == u',') {
+            ++i;
+            if (isHex6(text, i)) {
+              bg = Color();
+              bg.hex = text.sliced(i, 6);
+              i += 6;
+            }
+          }
+        }
+        openFont();
+        break;
+      case 0x11: // Monospace: not widely used, dropped
+        break;
+      default:
+        out += c;
+        break;
+      }
+      continue;
+    }
+
+    // ── '<': literal HTML, a <nick>, or just a '<' ──
+    if (u == u'<') {
+      const qsizetype end = text.indexOf(u'>', i + 1);
+      if (end >= 0 && isHtmlTag(text.sliced(i + 1, end - i - 1))) {
+        i = end + 1;
+        continue;
+      }
+      if (opt.nickLinks && end >= 0) {
+        qsizetype p = i + 1;
+        while (p < end && isModePrefix(text[p]))
+          ++p;
+        // "<@>": the lone prefix is the nick
+        if (p == end && p > i + 1 && text[p - 1] != u'&')
+          --p;
+        bool ok = p < end;
+        for (qsizetype k = p; ok && k < end;) {
+          int units;
+          const char32_t cp = codepointAt(text, k, &units);
+          ok = cp != u'&' && cp != u'<' && cp != u'"' &&
+               !(cp < 0x20 && isFormatCode(char16_t(cp))) &&
+               !isEmojiBaseCodepoint(cp);
+          k += units;
+        }
+        if (ok) {
+          out += QLatin1String("&lt;");
+          appendEscaped(out, text.sliced(i + 1, p - i - 1));
+          appendNickLink(out, text.sliced(p, end - p), opt.darkPalette);
+          out += QLatin1String("&gt;");
+          i = end + 1;
+          continue;
+        }
+      }
+      out += QLatin1String("&lt;");
+      ++i;
+      continue;
+    }
+    if (u == u'>' || u == u'&' || u == u'"') {
+      appendEscaped(out, text.sliced(i, 1));
+      ++i;
+      continue;
+    }
+
+    // ── http(s) URLs ──
+    if (u == u'h') {
+      const QStringView rest = text.sliced(i);
+      const qsizetype scheme = rest.startsWith(QLatin1String("http://"))    ? 7
+                               : rest.startsWith(QLatin1String("https://")) ? 8
+                                                                             : 0;
+      qsizetype j = i + scheme;
+      while (scheme && j < len) {
+        int units;
+        const char32_t cp = codepointAt(text, j, &units);
+        if (cp < 0x20 || QChar::isSpace(cp) || isEmojiBaseCodepoint(cp))
+          break;
+        j += units;
+      }
+      if (scheme && j > i + scheme) {
+        // Trailing markup characters, then trailing punctuation
+        qsizetype end = j;
+        while (end > i + scheme &&
+               (text[end - 1] == u'&' || text[end - 1] == u'<' ||
+                text[end - 1] == u'>'))
+          --end;
+        while (end > i + scheme &&
+               QStringView(u".,;:)'").contains(text[end - 1]))
+          --end;
+        const QStringView url = text.sliced(i, end - i);
+        out += QLatin1String("<a href=\"");
+        appendEscaped(out, url);
+        out += QLatin1String(
+            "\" style=\"color:#4fc3f7; text-decoration:underline;\">");
+        appendEscaped(out, url);
+        out += QLatin1String("</a>");
+        if (ImageDownloader::isVideoUrl(url.toString()))
+          out += QLatin1String(" <font color=\"#4fc3f7\">&#9654; Video</font>");
+        i = end;
+        continue;
+      }
+    }
+
+    // ── Emoji and the joiners/modifiers that follow them ──
+    int units;
+    const char32_t cp = codepointAt(text, i, &units);
+    if (isEmojiBaseCodepoint(cp)) {
+      out += QLatin1String("<span style=\"font-family:'Noto Color Emoji',"
+                           "'Segoe UI Emoji','Apple Color Emoji','Noto Emoji';\">");
+      qsizetype j = i + units;
+      while (j < len) {
+        int n;
+        const char32_t next = codepointAt(text, j, &n);
+        if (!isEmojiJoinerOrModifier(next) && !isEmojiBaseCodepoint(next))
+          break;
+        j += n;
+      }
+      out.append(text.sliced(i, j - i));
+      out += QLatin1String("</span>");
+      i = j;
+      continue;
+    }
+
+    // ── Plain text: copy the whole run ──
+    qsizetype j = i + units;
+    while (j < len && isPlain(text[j]))
+      ++j;
+    out.append(text.sliced(i, j - i));
+    i = j;
+  }
+  scanMentions(len);
+
+  closeFonts();
+  if (bold)
+    out += QLatin1String("</b>");
+  if (italic)
+    out += QLatin1String("</i>");
+  if (underline)
+    out += QLatin1String("</u>");
+  if (strike)
+    out += QLatin1String("</s>");
+  return mentioned;
+}
+
+} // namespace IrcFormatter
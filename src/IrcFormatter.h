@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QString>
+#include <QStringView>
+
+// Raw IRC text to chat HTML in one left-to-right scan.
+//
+// A single state machine handles everything the chat view shows for a
+// line: literal HTML tags from relay bots are dropped, text is escaped,
+// mIRC control codes (bold, italic, underline, strikethrough, reverse,
+// reset, \x03 palette and \x04 hex colors) become tags, http(s) URLs become
+// links, "<nick>" and the nick of "* nick action" become colored nick://
+// links, emoji get a color-font fallback span, and mentions of our own nick
+// are detected on the way.  Output is appended to the caller's string, so a
+// caller that reserves once formats a line with a single allocation.
+namespace IrcFormatter {
+
+struct Options {
+  bool nickLinks = true;   // color <nick> / "* nick" and link them
+  bool darkPalette = true; // nick colors for a dark or light background
+  // Report whole-word mentions of this nick in a "<sender> text" line,
+  // unless the sender is this nick.  Empty: never.
+  QString mentionNick;
+};
+
+// Append text as HTML to out.  Returns true if mentionNick is mentioned.
+bool appendHtml(QStringView text, QString &out, const Options &options = {});
+QString toHtml(QStringView text, const Options &options = {});
+
+// Whole-word nick match honoring IRC nick characters, case-insensitive:
+// nick "ed" matches "ed: hi" but not "edited".
+bool containsNickWord(QStringView text, QStringView nick);
+
+// Stable per-nick color from a 16-color palette.
+QString nickColor(QStringView nick, bool darkPalette);
+// "#rrggbb" for mIRC color index 0-98; empty otherwise.
+QString mircColor(int index);
+
+} // namespace IrcFormatter
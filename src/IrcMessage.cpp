@@ -0,0 +1,201 @@
+#include "IrcMessage.h"
+#include <cstring>
+
+namespace {
+
+qsizetype findByte(QByteArrayView v, char c, qsizetype from = 0) {
+  if (from >= v.size())
+    return -1;
+  const void *p = std::memchr(v.data() + from, c, v.size() - from);
+  return p ? static_cast<const char *>(p) - v.data() : -1;
+}
+
+bool viewEquals(QByteArrayView a, QByteArrayView b) {
+  return a.size() == b.size() &&
+         (a.isEmpty() || std::memcmp(a.data(), b.data(), a.size()) == 0);
+}
+
+qsizetype skipSpaces(QByteArrayView v, qsizetype pos) {
+  while (pos < v.size() && v[pos] == ' ')
+    ++pos;
+  return pos;
+}
+
+} // namespace
+
+bool IrcMessage::parse(QByteArrayView line, IrcMessage &msg) {
+  msg = IrcMessage();
+  msg.raw = line;
+  const qsizetype n = line.size();
+  qsizetype pos = 0;
+
+  // ── @tags ──
+  if (n > 0 && line[0] == '@') {
+    const qsizetype sp = findByte(line, ' ');
+    if (sp < 0)
+      return false;
+    msg.tagBlock = line.sliced(1, sp - 1);
+    pos = skipSpaces(line, sp + 1);
+  }
+
+  // ── :source ──
+  if (pos < n && line[pos] == ':') {
+    const qsizetype sp = findByte(line, ' ', pos);
+    if (sp < 0)
+      return false;
+    msg.sourceView = line.sliced(pos + 1, sp - pos - 1);
+    pos = skipSpaces(line, sp + 1);
+  }
+
+  // ── COMMAND ──
+  qsizetype end = findByte(line, ' ', pos);
+  if (end < 0)
+    end = n;
+  if (end == pos)
+    return false;
+  msg.commandView = line.sliced(pos, end - pos);
+  pos = skipSpaces(line, end);
+  msg.argsView = line.sliced(pos);
+
+  // ── params ──
+  while (pos < n) {
+    if (line[pos] == ':') {
+      msg.params[msg.paramCount++] = line.sliced(pos + 1);
+      msg.hasTrailing = true;
+      break;
+    }
+    if (msg.paramCount == kMaxParams - 1) {
+      // The 15th parameter takes the rest of the line even without ':'.
+      msg.params[msg.paramCount++] = line.sliced(pos);
+      break;
+    }
+    end = findByte(line, ' ', pos);
+    if (end < 0)
+      end = n;
+    msg.params[msg.paramCount++] = line.sliced(pos, end - pos);
+    pos = skipSpaces(line, end);
+  }
+  return true;
+}
+
+bool IrcMessage::commandIs(const char *verb) const {
+  const qsizetype len = static_cast<qsizetype>(std::strlen(verb));
+  if (commandView.size() != len)
+    return false;
+  for (qsizetype i = 0; i < len; ++i) {
+    char c = commandView[i];
+    if (c >= 'a' && c <= 'z')
+      c -= 'a' - 'A';
+    if (c != verb[i])
+      return false;
+  }
+  return true;
+}
+
+int IrcMessage::numeric() const {
+  if (commandView.size() != 3)
+    return -1;
+  int value = 0;
+  for (char c : commandView) {
+    if (c < '0' || c > '9')
+      return -1;
+    value = value * 10 + (c - '0');
+  }
+  return value;
+}
+
+bool IrcMessage::paramEquals(int i, const char *value) const {
+  return i < paramCount && viewEquals(params[i], QByteArrayView(value));
+}
+
+QString IrcMessage::command() const {
+  return QString::fromLatin1(commandView).toUpper();
+}
+
+QString IrcMessage::nick() const {
+  const qsizetype bang = findByte(sourceView, '!');
+  return QString::fromUtf8(bang > 0 ? sourceView.first(bang) : sourceView);
+}
+
+QStringList IrcMessage::paramList(int from) const {
+  QStringList out;
+  if (from < paramCount)
+    out.reserve(paramCount - from);
+  for (int i = from; i < paramCount; ++i)
+    out.append(QString::fromUtf8(params[i]));
+  return out;
+}
+
+QByteArrayView IrcMessage::tagValueRaw(QByteArrayView key,
+                                       bool *present) const {
+  if (present)
+    *present = false;
+  qsizetype pos = 0;
+  const qsizetype n = tagBlock.size();
+  while (pos < n) {
+    qsizetype end = findByte(tagBlock, ';', pos);
+    if (end < 0)
+      end = n;
+    const QByteArrayView part = tagBlock.sliced(pos, end - pos);
+    const qsizetype eq = findByte(part, '=');
+    const QByteArrayView k = eq >= 0 ? part.first(eq) : part;
+    if (viewEquals(k, key)) {
+      if (present)
+        *present = true;
+      return eq >= 0 ? part.sliced(eq + 1) : QByteArrayView();
+    }
+    pos = end + 1;
+  }
+  return QByteArrayView();
+}
+
+QString IrcMessage::tag(QByteArrayView key) const {
+  return unescapeTagValue(tagValueRaw(key));
+}
+
+QMap<QString, QString> IrcMessage::tags() const {
+  QMap<QString, QString> out;
+  qsizetype pos = 0;
+  const qsizetype n = tagBlock.size();
+  while (pos < n) {
+    qsizetype end = findByte(tagBlock, ';', pos);
+    if (end < 0)
+      end = n;
+    const QByteArrayView part = tagBlock.sliced(pos, end - pos);
+    if (!part.isEmpty()) {
+      const qsizetype eq = findByte(part, '=');
+      if (eq >= 0)
+        out[QString::fromUtf8(part.first(eq))] =
+            unescapeTagValue(part.sliced(eq + 1));
+      else
+        out[QString::fromUtf8(part)] = QString(); // boolean tag (no value)
+    }
+    pos = end + 1;
+  }
+  return out;
+}
+
+// IRCv3 tag value unescaping: \: = ;  \s = space  \\ = \  \r  \n
+QString IrcMessage::unescapeTagValue(QByteArrayView value) {
+  if (findByte(value, '\\') < 0)
+    return QString::fromUtf8(value);
+  QByteArray out;
+  out.reserve(value.size());
+  for (qsizetype i = 0; i < value.size(); ++i) {
+    const char c = value[i];
+    if (c != '\\' || i + 1 >= value.size()) {
+      if (c != '\\')
+        out.append(c);
+      continue;
+    }
+    const char e = value[++i];
+    switch (e) {
+    case ':': out.append(';'); break;
+    case 's': out.append(' '); break;
+    case 'r': out.append('\r'); break;
+    case 'n': out.append('\n'); break;
+    default: out.append(e); break; // "\\" and unknown escapes
+    }
+  }
+  return QString::fromUtf8(out);
+}
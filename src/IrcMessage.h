@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QByteArrayView>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+// One parsed IRC line, as views into the raw UTF-8 bytes.
+//
+//   [@tags] [:source] COMMAND [param ...] [:trailing]
+//
+// parse() only records where each field starts and ends; nothing is copied
+// or decoded.  Handlers call param()/source()/tag() for the fields they
+// actually read, so e.g. a PRIVMSG pays for exactly two QString decodes and
+// the tag block of a line is never touched unless someone asks for it.
+//
+// The views borrow from the buffer passed to parse(), which must outlive
+// the IrcMessage.
+struct IrcMessage {
+  static constexpr int kMaxParams = 15; // RFC 1459 §2.3
+
+  QByteArrayView raw;      // whole line, without CR/LF
+  QByteArrayView tagBlock; // after '@', up to the first space
+  QByteArrayView sourceView;
+  QByteArrayView commandView;
+  QByteArrayView argsView; // everything after the command, verbatim
+  QByteArrayView params[kMaxParams];
+  int paramCount = 0;
+  bool hasTrailing = false; // last param was introduced by " :"
+
+  // Fill msg from line.  Returns false if the line has no command.
+  static bool parse(QByteArrayView line, IrcMessage &msg);
+
+  bool hasTags() const { return !tagBlock.isEmpty(); }
+  bool hasSource() const { return !sourceView.isEmpty(); }
+
+  // Case-insensitive compare against an upper-case ASCII verb.
+  bool commandIs(const char *verb) const;
+  // Three-digit numerics return 0–999; anything else returns -1.
+  int numeric() const;
+
+  QString command() const;
+  QString source() const { return QString::fromUtf8(sourceView); }
+  // Nick part of the source ("nick!user@host" → "nick").
+  QString nick() const;
+  bool paramEquals(int i, const char *value) const;
+  QString param(int i) const {
+    return i < paramCount ? QString::fromUtf8(params[i]) : QString();
+  }
+  QString lastParam() const {
+    return paramCount ? QString::fromUtf8(params[paramCount - 1]) : QString();
+  }
+  // params [from, paramCount) decoded.
+  QStringList paramList(int from = 0) const;
+
+  // Raw (still escaped) value of tag key, or a null view if absent.
+  QByteArrayView tagValueRaw(QByteArrayView key, bool *present = nullptr) const;
+  // Unescaped value of tag key.
+  QString tag(QByteArrayView key) const;
+  // Every tag, unescaped.  Only for consumers that genuinely want them all.
+  QMap<QString, QString> tags() const;
+
+  static QString unescapeTagValue(QByteArrayView value);
+};
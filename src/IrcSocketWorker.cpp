@@ -0,0 +1,204 @@
+#include "IrcSocketWorker.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QHash>
+#include <QThread>
+#include <QtNetwork/QSslConfiguration>
+#include <QtNetwork/QSslSocket>
+#include <algorithm>
+
+namespace {
+
+QThread *g_networkThread = nullptr;
+QObject *g_networkAnchor = nullptr; // lives on the thread, to queue the stop
+// "host:port" -> last TLS session ticket.  Only touched on the network
+// thread, where every worker lives.
+QHash<QString, QByteArray> g_sessionTickets;
+
+void stopNetworkThread() {
+  if (!g_networkThread)
+    return;
+  // Queued behind the deleteLater() of every worker, so they still get to
+  // flush their QUIT and close the socket.
+  QMetaObject::invokeMethod(
+      g_networkAnchor, [] { QThread::currentThread()->quit(); },
+      Qt::QueuedConnection);
+  g_networkThread->wait();
+  delete g_networkAnchor;
+  delete g_networkThread;
+  g_networkAnchor = nullptr;
+  g_networkThread = nullptr;
+}
+
+} // namespace
+
+QThread *IrcSocketWorker::networkThread() {
+  if (!g_networkThread) {
+    g_networkThread = new QThread;
+    g_networkThread->setObjectName(QStringLiteral("IrcNetwork"));
+    g_networkAnchor = new QObject;
+    g_networkAnchor->moveToThread(g_networkThread);
+    g_networkThread->start();
+    qAddPostRoutine(stopNetworkThread);
+  }
+  return g_networkThread;
+}
+
+IrcSocketWorker::IrcSocketWorker(QObject *parent)
+    : QObject(parent), m_socket(new QSslSocket(this)) {
+  connect(m_socket, &QSslSocket::readyRead, this,
+          &IrcSocketWorker::onReadyRead);
+  connect(m_socket, &QSslSocket::connected, this, [this]() {
+    if (!m_useSsl)
+      emit socketConnected(m_socket->localAddress());
+  });
+  connect(m_socket, &QSslSocket::encrypted, this, [this]() {
+    rememberSession();
+    emit socketConnected(m_socket->localAddress());
+  });
+  // TLS 1.3 sends its tickets after the handshake
+  connect(m_socket, &QSslSocket::newSessionTicketReceived, this,
+          &IrcSocketWorker::rememberSession);
+  connect(m_socket, &QSslSocket::disconnected, this,
+          &IrcSocketWorker::disconnected);
+  connect(m_socket, qOverload<const QList<QSslError> &>(&QSslSocket::sslErrors),
+          this, &IrcSocketWorker::onSslErrors);
+}
+
+IrcSocketWorker::~IrcSocketWorker() {
+  // A QUIT written just before the owner went away
+  if (m_socket->state() == QAbstractSocket::ConnectedState)
+    m_socket->flush();
+  takeBatches(); // frees whatever the owner never drained
+}
+
+void IrcSocketWorker::setProxy(const QNetworkProxy &proxy) {
+  m_socket->setProxy(proxy);
+}
+
+void IrcSocketWorker::setAllowSelfSignedCerts(bool allow) {
+  m_allowSelfSignedCerts = allow;
+}
+
+void IrcSocketWorker::connectToHost(const QString &host, quint16 port,
+                                    bool useSsl, quint32 generation) {
+  if (m_socket->state() != QAbstractSocket::UnconnectedState)
+    m_socket->abort();
+  m_readBuffer.clear();
+  m_generation = generation;
+  m_useSsl = useSsl;
+  if (useSsl) {
+    m_sessionKey = host + QLatin1Char(':') + QString::number(port);
+    QSslConfiguration conf = m_socket->sslConfiguration();
+    conf.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    conf.setSessionTicket(g_sessionTickets.value(m_sessionKey));
+    m_socket->setSslConfiguration(conf);
+    m_socket->connectToHostEncrypted(host, port);
+  } else {
+    m_socket->connectToHost(host, port);
+  }
+}
+
+void IrcSocketWorker::write(const QByteArray &line) {
+  if (!m_socket->isOpen())
+    return;
+  m_socket->write(line);
+  m_socket->write("\r\n", 2);
+  m_socket->flush();
+}
+
+void IrcSocketWorker::disconnectFromHost(const QByteArray &quitLine) {
+  if (!m_socket->isOpen())
+    return;
+  write(quitLine);
+  m_socket->disconnectFromHost();
+}
+
+QVector<IrcSocketWorker::Batch> IrcSocketWorker::takeBatches() {
+  Node *node = m_inbox.exchange(nullptr, std::memory_order_acquire);
+  QVector<Batch> batches;
+  while (node) {
+    Node *next = node->next;
+    batches.append(std::move(node->batch));
+    delete node;
+    node = next;
+  }
+  std::reverse(batches.begin(), batches.end());
+  return batches;
+}
+
+void IrcSocketWorker::push(Node *node) {
+  Node *head = m_inbox.load(std::memory_order_relaxed);
+  do
+    node->next = head;
+  while (!m_inbox.compare_exchange_weak(head, node, std::memory_order_release,
+                                        std::memory_order_relaxed));
+  // Otherwise a wake-up is already on its way and will take this too
+  if (!head)
+    emit linesReady();
+}
+
+void IrcSocketWorker::onReadyRead() {
+  while (m_readBuffer.readFrom(m_socket) > 0) {
+    // The views die with the next read, so copy the lines into one buffer
+    // of their own before parsing: the messages point into that instead.
+    m_lines.clear();
+    qsizetype total = 0;
+    QByteArrayView line;
+    while (m_readBuffer.nextLine(line)) {
+      if (!line.isEmpty()) {
+        m_lines.append(line);
+        total += line.size();
+      }
+    }
+    if (m_lines.isEmpty())
+      continue;
+
+    auto *node = new Node;
+    Batch &batch = node->batch;
+    batch.generation = m_generation;
+    batch.bytes.reserve(total);
+    for (QByteArrayView l : std::as_const(m_lines))
+      batch.bytes.append(l);
+    batch.messages.reserve(m_lines.size());
+    const char *pos = batch.bytes.constData();
+    for (QByteArrayView l : std::as_const(m_lines)) {
+      IrcMessage msg;
+      if (IrcMessage::parse(QByteArrayView(pos, l.size()), msg)) {
+        if (msg.commandIs("PING"))
+          write("PONG " + msg.argsView.toByteArray());
+        batch.messages.append(msg);
+      }
+      pos += l.size();
+    }
+
+    if (batch.messages.isEmpty())
+      delete node;
+    else
+      push(node);
+  }
+}
+
+void IrcSocketWorker::rememberSession() {
+  const QByteArray ticket = m_socket->sslConfiguration().sessionTicket();
+  if (!ticket.isEmpty())
+    g_sessionTickets.insert(m_sessionKey, ticket);
+}
+
+void IrcSocketWorker::onSslErrors(const QList<QSslError> &errors) {
+  // If the user has explicitly allowed self-signed / untrusted certs (global pref),
+  // ignore all errors reported for this handshake so the connection can proceed.
+  if (m_allowSelfSignedCerts) {
+    for (const QSslError &e : errors) {
+      qDebug() << "[IRC] Ignoring SSL error (user-approved):" << e.errorString();
+    }
+    m_socket->ignoreSslErrors();
+    return;
+  }
+
+  // Secure default: fail on any SSL error.
+  if (!errors.isEmpty()) {
+    emit errorOccurred(tr("SSL error: %1").arg(errors.first().errorString()));
+    m_socket->abort();
+  }
+}
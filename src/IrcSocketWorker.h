@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QVector>
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QNetworkProxy>
+#include <QtNetwork/QSslError>
+#include <atomic>
+#include "IrcMessage.h"
+#include "LineBuffer.h"
+
+class QSslSocket;
+class QThread;
+
+// Socket half of an IrcConnection, living on the shared network thread.
+//
+// It owns the QSslSocket, so reads, TLS and line framing never wait for the
+// GUI, and it answers PING itself: a long layout pass can no longer delay
+// the PONG into a ping timeout.  Every socket read becomes one Batch of
+// parsed lines, pushed onto a lock-free inbox; linesReady() fires only
+// when the inbox was empty, so however many reads pile up while the GUI is
+// busy, it gets one queued call and drains them all at once.
+//
+// TLS sessions are remembered per host and port for the life of the
+// process, so a reconnect resumes the session instead of doing a full
+// handshake.
+//
+// Everything but takeBatches() runs on the network thread; IrcConnection
+// reaches it with queued invocations.
+class IrcSocketWorker : public QObject {
+  Q_OBJECT
+public:
+  // The lines of one read.  The messages are views into bytes, which is
+  // implicitly shared and never modified, so a Batch can be moved or copied
+  // across threads without invalidating them.
+  struct Batch {
+    QByteArray bytes;
+    QVector<IrcMessage> messages;
+    quint32 generation = 0; // of the connectToHost() that read them
+  };
+
+  // Started on first use and stopped when the application object goes
+  // away, after every worker scheduled for deletion is gone.
+  static QThread *networkThread();
+
+  explicit IrcSocketWorker(QObject *parent = nullptr);
+  ~IrcSocketWorker() override;
+
+  void setProxy(const QNetworkProxy &proxy);
+  void setAllowSelfSignedCerts(bool allow);
+  // generation tags every Batch read on this connection, so the owner can
+  // tell lines of an earlier one, still in the inbox, from the new ones.
+  void connectToHost(const QString &host, quint16 port, bool useSsl,
+                     quint32 generation = 0);
+  // One line, without CRLF; sent right away.
+  void write(const QByteArray &line);
+  void disconnectFromHost(const QByteArray &quitLine);
+
+  // Any thread: everything received since the last call, oldest first.
+  QVector<Batch> takeBatches();
+
+signals:
+  void socketConnected(const QHostAddress &localAddress);
+  void disconnected();
+  void errorOccurred(const QString &error);
+  void linesReady();
+
+private:
+  struct Node {
+    Batch batch;
+    Node *next = nullptr;
+  };
+
+  void onReadyRead();
+  void onSslErrors(const QList<QSslError> &errors);
+  void rememberSession();
+  void push(Node *node);
+
+  QSslSocket *m_socket;
+  bool m_useSsl = true;
+  bool m_allowSelfSignedCerts = false;
+  QString m_sessionKey; // "host:port" of the current TLS connection
+  quint32 m_generation = 0;
+  LineBuffer m_readBuffer;
+  QVector<QByteArrayView> m_lines; // scratch, reused across reads
+  // Newest first; the network thread pushes, takeBatches() swaps it out
+  std::atomic<Node *> m_inbox{nullptr};
+};
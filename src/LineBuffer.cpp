@@ -0,0 +1,62 @@
+#include "LineBuffer.h"
+#include <QIODevice>
+#include <cstring>
+
+void LineBuffer::compact() {
+  if (m_readPos == 0)
+    return;
+  m_buffer.remove(0, m_readPos);
+  m_scanPos -= m_readPos;
+  m_readPos = 0;
+}
+
+void LineBuffer::append(QByteArrayView data) {
+  compact();
+  m_buffer.append(data.data(), data.size());
+}
+
+qint64 LineBuffer::readFrom(QIODevice *device) {
+  const qint64 available = device->bytesAvailable();
+  if (available <= 0)
+    return 0;
+  compact();
+  const qsizetype oldSize = m_buffer.size();
+  m_buffer.resize(oldSize + available);
+  const qint64 got = device->read(m_buffer.data() + oldSize, available);
+  m_buffer.resize(oldSize + qMax<qint64>(got, 0));
+  return qMax<qint64>(got, 0);
+}
+
+bool LineBuffer::nextLine(QByteArrayView &line) {
+  const char *base = m_buffer.constData();
+  const qsizetype size = m_buffer.size();
+  if (m_scanPos < m_readPos)
+    m_scanPos = m_readPos;
+  if (m_scanPos >= size)
+    return false;
+
+  // memchr is vectorized by every libc we ship on, so scanning a large
+  // replay is bounded by memory bandwidth rather than a byte loop.
+  const void *nl = std::memchr(base + m_scanPos, '\n', size - m_scanPos);
+  if (!nl) {
+    // Remember how far we looked so a partial line is not rescanned on
+    // every subsequent read.
+    m_scanPos = size;
+    return false;
+  }
+
+  const qsizetype end = static_cast<const char *>(nl) - base;
+  qsizetype len = end - m_readPos;
+  if (len > 0 && base[end - 1] == '\r')
+    --len;
+  line = QByteArrayView(base + m_readPos, len);
+  m_readPos = end + 1;
+  m_scanPos = m_readPos;
+  return true;
+}
+
+void LineBuffer::clear() {
+  m_buffer.clear();
+  m_readPos = 0;
+  m_scanPos = 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+
+class QIODevice;
+
+// Read-cursor framing buffer for line-oriented protocols.
+//
+// Incoming bytes are appended at the tail and complete lines are handed out
+// as views into the buffer, so splitting a read into lines never copies.
+// The consumed prefix is compacted at most once per append (i.e. once per
+// socket read) instead of once per line, which keeps bouncer backlog
+// replays linear in the number of bytes received.
+class LineBuffer {
+public:
+  // Append raw bytes.  Invalidates any view returned by nextLine().
+  void append(QByteArrayView data);
+
+  // Read everything the device has buffered straight into the tail,
+  // avoiding the temporary QByteArray that readAll() would allocate.
+  // Returns the number of bytes read (0 if nothing was available).
+  qint64 readFrom(QIODevice *device);
+
+  // Pop the next complete line, without its trailing "\n" or "\r\n".
+  // The view stays valid until the next append(), readFrom() or clear().
+  bool nextLine(QByteArrayView &line);
+
+  // Bytes received but not yet returned as a complete line.
+  qsizetype pendingBytes() const { return m_buffer.size() - m_readPos; }
+
+  void clear();
+
+private:
+  void compact();
+
+  QByteArray m_buffer;
+  qsizetype m_readPos = 0; // start of the first unconsumed line
+  qsizetype m_scanPos = 0; // bytes before this are known to contain no '\n'
+};
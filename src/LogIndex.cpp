@@ -0,0 +1,187 @@
+#include "LogIndex.h"
+#include <QDateTime>
+#include <QFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace LogIndex {
+
+static const QByteArray kMagic = QByteArrayLiteral("NUCIDX01");
+static constexpr int kRecordSize = 3 * sizeof(qint64);
+
+static Entry decode(const char *p) {
+  Entry e;
+  e.line = qFromLittleEndian<qint64>(p);
+  e.offset = qFromLittleEndian<qint64>(p + 8);
+  e.msecs = qFromLittleEndian<qint64>(p + 16);
+  return e;
+}
+
+// Walk '\n'-terminated lines from offset (which must start a line), calling
+// onLine(lineNumber, lineOffset, lineBytes).  Reads in large blocks and
+// compacts once per block.  Returns the line number after the last complete
+// line.
+template <typename F>
+static qint64 scan(QFile &log, qint64 offset, qint64 line, F onLine) {
+  constexpr qint64 kChunk = 64 * 1024;
+  if (!log.seek(offset))
+    return line;
+  QByteArray buf;
+  qsizetype pos = 0;
+  for (;;) {
+    const QByteArray chunk = log.read(kChunk);
+    if (chunk.isEmpty())
+      break;
+    if (pos > 0) {
+      buf.remove(0, pos);
+      pos = 0;
+    }
+    buf += chunk;
+    for (;;) {
+      const void *nl =
+          std::memchr(buf.constData() + pos, '\n', buf.size() - pos);
+      if (!nl)
+        break;
+      const qsizetype end = static_cast<const char *>(nl) - buf.constData();
+      onLine(line, offset, QByteArrayView(buf.constData() + pos, end - pos));
+      offset += end - pos + 1;
+      ++line;
+      pos = end + 1;
+    }
+  }
+  return line;
+}
+
+QVector<Entry> load(const QString &indexPath) {
+  QVector<Entry> entries;
+  QFile f(indexPath);
+  if (!f.open(QIODevice::ReadOnly))
+    return entries;
+  const QByteArray data = f.readAll();
+  if (!data.startsWith(kMagic))
+    return entries;
+  const qsizetype count = (data.size() - kMagic.size()) / kRecordSize;
+  entries.reserve(count);
+  const char *p = data.constData() + kMagic.size();
+  for (qsizetype i = 0; i < count; ++i, p += kRecordSize)
+    entries.append(decode(p));
+  return entries;
+}
+
+QVector<Entry> build(QFile &log) {
+  QVector<Entry> entries;
+  qint64 prev = 0;
+  scan(log, 0, 0, [&](qint64 line, qint64 offset, QByteArrayView text) {
+    if (line % kStride != 0)
+      return;
+    qint64 ms = parseLineMsecs(text);
+    if (ms < 0)
+      ms = prev;
+    prev = ms;
+    entries.append({line, offset, ms});
+  });
+  return entries;
+}
+
+void append(QFile &index, const Entry &entry) {
+  char rec[kRecordSize];
+  qToLittleEndian<qint64>(entry.line, rec);
+  qToLittleEndian<qint64>(entry.offset, rec + 8);
+  qToLittleEndian<qint64>(entry.msecs, rec + 16);
+  index.write(rec, kRecordSize);
+}
+
+qint64 sync(const QString &logPath, QFile &index) {
+  QFile log(logPath);
+  const bool haveLog = log.open(QIODevice::ReadOnly);
+  const qint64 logSize = haveLog ? log.size() : 0;
+
+  // Validate the header and the last record against the log; anything that
+  // does not line up (truncated index, log replaced behind our back) is
+  // rebuilt from scratch.
+  const qint64 indexSize = index.size();
+  bool valid = indexSize >= kMagic.size() &&
+               (indexSize - kMagic.size()) % kRecordSize == 0;
+  if (valid) {
+    index.seek(0);
+    valid = index.read(kMagic.size()) == kMagic;
+  }
+  Entry last;
+  bool haveLast = false;
+  if (valid && indexSize > kMagic.size()) {
+    index.seek(indexSize - kRecordSize);
+    const QByteArray rec = index.read(kRecordSize);
+    if (rec.size() == kRecordSize) {
+      last = decode(rec.constData());
+      haveLast = true;
+      valid = last.offset <= logSize && last.line % kStride == 0;
+    }
+  }
+  if (!valid) {
+    index.resize(0);
+    index.seek(0);
+    index.write(kMagic);
+    haveLast = false;
+  }
+  index.seek(index.size());
+  if (!haveLog)
+    return 0;
+
+  qint64 prev = haveLast ? last.msecs : 0;
+  return scan(log, haveLast ? last.offset : 0, haveLast ? last.line : 0,
+              [&](qint64 line, qint64 offset, QByteArrayView text) {
+                if (line % kStride != 0 || (haveLast && line == last.line))
+                  return;
+                qint64 ms = parseLineMsecs(text);
+                if (ms < 0)
+                  ms = prev;
+                prev = ms;
+                append(index, {line, offset, ms});
+              });
+}
+
+qint64 countLinesFrom(QFile &log, qint64 offset) {
+  return scan(log, offset, 0, [](qint64, qint64, QByteArrayView) {});
+}
+
+qint64 parseLineMsecs(QByteArrayView line) {
+  // "yyyy-MM-dd HH:mm:ss"
+  if (line.size() < 19 || line[4] != '-' || line[7] != '-' ||
+      line[10] != ' ' || line[13] != ':' || line[16] != ':')
+    return -1;
+  auto num = [&line](int from, int len, bool &ok) {
+    int v = 0;
+    for (int i = from; i < from + len; ++i) {
+      const char c = line[i];
+      if (c < '0' || c > '9') {
+        ok = false;
+        return 0;
+      }
+      v = v * 10 + (c - '0');
+    }
+    return v;
+  };
+  bool ok = true;
+  const QDate date(num(0, 4, ok), num(5, 2, ok), num(8, 2, ok));
+  const QTime time(num(11, 2, ok), num(14, 2, ok), num(17, 2, ok));
+  if (!ok || !date.isValid() || !time.isValid())
+    return -1;
+  return QDateTime(date, time).toMSecsSinceEpoch();
+}
+
+int lastAtOrBeforeLine(const QVector<Entry> &entries, qint64 line) {
+  auto it = std::upper_bound(
+      entries.begin(), entries.end(), line,
+      [](qint64 l, const Entry &e) { return l < e.line; });
+  return it == entries.begin() ? 0 : int(it - entries.begin()) - 1;
+}
+
+int lastBeforeMsecs(const QVector<Entry> &entries, qint64 msecs) {
+  auto it = std::lower_bound(
+      entries.begin(), entries.end(), msecs,
+      [](const Entry &e, qint64 ms) { return e.msecs < ms; });
+  return it == entries.begin() ? 0 : int(it - entries.begin()) - 1;
+}
+
+} // namespace LogIndex
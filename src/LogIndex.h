@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QByteArrayView>
+#include <QString>
+#include <QVector>
+
+class QFile;
+
+// Sidecar index for a channel log ("<chan>.log.idx").
+//
+// Every kStride-th line gets a fixed-size record of (line number, byte
+// offset, timestamp), so finding "line N" or "the first line at time T" is
+// a binary search over the records followed by a scan of at most kStride
+// lines — a couple of seeks regardless of how large the log is.
+//
+// The LogWriter thread owns the index of the live log: it syncs it when it
+// opens the log and appends records as it writes.  It also syncs the
+// backup's, which matters for backups rotated before indexing existed.
+// Readers only read them.
+namespace LogIndex {
+
+struct Entry {
+  qint64 line = 0;   // 0-based line number
+  qint64 offset = 0; // byte offset of the start of that line
+  qint64 msecs = 0;  // timestamp of that line (ms since epoch, local time)
+};
+
+constexpr int kStride = 64;
+
+inline QString pathFor(const QString &logPath) { return logPath + ".idx"; }
+
+// Read every record of an index file.  Returns an empty vector if the file
+// is missing or not an index.
+QVector<Entry> load(const QString &indexPath);
+
+// Build the records for a log in memory without touching any index file
+// (the fallback for a log whose sidecar cannot be written).
+QVector<Entry> build(QFile &log);
+
+// Bring an open (read/write) index up to date with the log at logPath,
+// appending records for lines written since its last record, or rebuilding
+// it if it does not match the log.  Returns the number of lines in the log.
+qint64 sync(const QString &logPath, QFile &index);
+
+// Append one record to an open index.
+void append(QFile &index, const Entry &entry);
+
+// Count '\n'-terminated lines in log from offset to EOF.
+qint64 countLinesFrom(QFile &log, qint64 offset);
+
+// "yyyy-MM-dd HH:mm:ss ..." → ms since epoch, or -1 if malformed.
+qint64 parseLineMsecs(QByteArrayView line);
+
+// Index of the last entry with line <= line (0 if none).
+int lastAtOrBeforeLine(const QVector<Entry> &entries, qint64 line);
+// Index of the last entry with msecs < msecs (0 if none).
+int lastBeforeMsecs(const QVector<Entry> &entries, qint64 msecs);
+
+} // namespace LogIndex
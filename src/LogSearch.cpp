@@ -0,0 +1,62 @@
+#include "LogSearch.h"
+#include "LogSearchIndex.h"
+#include "Logger.h"
+#include <QFutureWatcher>
+#include <QtConcurrent>
+
+LogSearch::LogSearch(Logger *logger, QObject *parent)
+    : QObject(parent), m_logger(logger) {}
+
+LogSearch::~LogSearch() {
+  // Workers use the logger; let them finish before it can go away
+  const auto watchers =
+      findChildren<QFutureWatcher<LogSearchIndex::Result> *>();
+  for (auto *watcher : watchers)
+    watcher->waitForFinished();
+}
+
+int LogSearch::search(const QString &network, const QString &text,
+                      const QVariantMap &options) {
+  const int requestId = m_nextRequestId++;
+  LogSearchIndex::Query q;
+  q.text = text;
+  q.caseSensitive = options.value("caseSensitive").toBool();
+  q.regex = options.value("regex").toBool();
+  q.nick = options.value("nick").toString();
+  q.channel = options.value("channel").toString();
+  q.fromMsecs = options.value("from").toLongLong();
+  q.toMsecs = options.value("to").toLongLong();
+  q.offset = options.value("offset", 0).toInt();
+  q.limit = options.value("limit", 50).toInt();
+
+  Logger *logger = m_logger;
+  const QString netDir = logger->networkDir(network);
+  auto *watcher = new QFutureWatcher<LogSearchIndex::Result>(this);
+  connect(watcher, &QFutureWatcher<LogSearchIndex::Result>::finished, this,
+          [this, watcher, requestId]() {
+            const LogSearchIndex::Result result = watcher->result();
+            watcher->deleteLater();
+            QVariantList hits;
+            hits.reserve(result.hits.size());
+            for (const auto &h : result.hits) {
+              QVariantMap m;
+              m["channel"] = h.channel;
+              m["timestamp"] = h.timestamp;
+              m["type"] = h.type;
+              m["text"] = h.text;
+              m["msecs"] = h.msecs;
+              hits.append(m);
+            }
+            emit resultsReady(requestId, hits, result.more,
+                              result.incomplete);
+          });
+  watcher->setFuture(QtConcurrent::run([logger, network, netDir, q]() {
+    // Lines still queued for the writer thread are searchable too; logs
+    // not caught up with yet are searched as far as they are indexed
+    const bool complete = logger->updateSearchIndex(network);
+    LogSearchIndex::Result result = LogSearchIndex::search(netDir, q);
+    result.incomplete = result.incomplete || !complete;
+    return result;
+  }));
+  return requestId;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QObject>
+#include <QVariantList>
+#include <QVariantMap>
+
+class Logger;
+
+// QML front end for LogSearchIndex, exposed as "logSearch".  Queries run on
+// a worker thread and report back through resultsReady().
+class LogSearch : public QObject {
+  Q_OBJECT
+public:
+  explicit LogSearch(Logger *logger, QObject *parent = nullptr);
+  ~LogSearch();
+
+  // Search one network's logs.  options: caseSensitive, regex (bool),
+  // nick, channel (string), from, to (ms since epoch), offset, limit (int).
+  // Returns the request id passed to resultsReady().
+  Q_INVOKABLE int search(const QString &network, const QString &text,
+                         const QVariantMap &options = QVariantMap());
+
+signals:
+  // hits: [{channel, timestamp, type, text, msecs}], newest first.
+  // incomplete: older logs are still being indexed, so some hits may be
+  // missing.
+  void resultsReady(int requestId, const QVariantList &hits, bool more,
+                    bool incomplete);
+
+private:
+  Logger *m_logger;
+  int m_nextRequestId = 1;
+};
@@ -0,0 +1,1037 @@
+#include "LogSearchIndex.h"
+#include "LogIndex.h"
+#include "LogWriter.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+// ── On-disk layout ──
+//
+// channels.dat  one "<generation>\t<key>" line per channel; the line number
+//               is the channel id.
+// docs.dat      fixed kDocSize records, doc id = record number.
+// seg-L-F-E.tri segment at merge level L holding postings for docs [F, E):
+//               header, varint-delta postings, then a table of
+//               (trigram, postings offset, doc count) sorted by trigram.
+
+static const QByteArray kSegMagic = QByteArrayLiteral("NUCTRI01");
+static constexpr int kSegHeaderSize = 8 + 4 * 4 + 8;
+static constexpr int kSegEntrySize = 12;
+static constexpr int kDocSize = 40;
+static constexpr int kStampLen = 20; // "yyyy-MM-dd HH:mm:ss "
+
+// ── Trigrams ──
+
+static inline uchar foldAscii(uchar c) {
+  return (c >= 'A' && c <= 'Z') ? uchar(c + 32) : c;
+}
+
+// Trigrams of the ASCII-lowered text.  asciiOnly skips trigrams touching
+// UTF-8 bytes, whose case the index does not fold.
+template <typename F>
+static void forEachTrigram(QByteArrayView text, bool asciiOnly, F f) {
+  const uchar *p = reinterpret_cast<const uchar *>(text.data());
+  for (qsizetype i = 0; i + 2 < text.size(); ++i) {
+    const uchar a = p[i], b = p[i + 1], c = p[i + 2];
+    if (asciiOnly && ((a | b | c) & 0x80))
+      continue;
+    f(quint32(foldAscii(a)) << 16 | quint32(foldAscii(b)) << 8 |
+      foldAscii(c));
+  }
+}
+
+static QByteArrayView chopEol(QByteArrayView line) {
+  qsizetype n = line.size();
+  while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r'))
+    --n;
+  return line.first(n);
+}
+
+// The indexed part of a log line: everything after the timestamp.
+static QByteArrayView messagePart(QByteArrayView line) {
+  line = chopEol(line);
+  if (line.size() <= kStampLen)
+    return {};
+  return line.sliced(kStampLen);
+}
+
+// ── Varints ──
+
+static void putVarint(QByteArray &out, quint32 v) {
+  while (v >= 0x80) {
+    out.append(char(v | 0x80));
+    v >>= 7;
+  }
+  out.append(char(v));
+}
+
+static quint32 getVarint(const uchar *&p, const uchar *end) {
+  quint32 v = 0;
+  int shift = 0;
+  while (p < end && shift < 32) {
+    const uchar b = *p++;
+    v |= quint32(b & 0x7f) << shift;
+    if (!(b & 0x80))
+      break;
+    shift += 7;
+  }
+  return v;
+}
+
+// ── Docs ──
+
+struct DocRecord {
+  quint32 channel = 0;
+  quint32 gen = 0;
+  qint64 offset = 0;
+  quint32 length = 0;
+  quint32 lines = 0;
+  qint64 firstMsecs = 0;
+  qint64 lastMsecs = 0;
+};
+
+static void encodeDoc(const DocRecord &d, char *p) {
+  qToLittleEndian<quint32>(d.channel, p);
+  qToLittleEndian<quint32>(d.gen, p + 4);
+  qToLittleEndian<qint64>(d.offset, p + 8);
+  qToLittleEndian<quint32>(d.length, p + 16);
+  qToLittleEndian<quint32>(d.lines, p + 20);
+  qToLittleEndian<qint64>(d.firstMsecs, p + 24);
+  qToLittleEndian<qint64>(d.lastMsecs, p + 32);
+}
+
+static DocRecord decodeDoc(const char *p) {
+  DocRecord d;
+  d.channel = qFromLittleEndian<quint32>(p);
+  d.gen = qFromLittleEndian<quint32>(p + 4);
+  d.offset = qFromLittleEndian<qint64>(p + 8);
+  d.length = qFromLittleEndian<quint32>(p + 16);
+  d.lines = qFromLittleEndian<quint32>(p + 20);
+  d.firstMsecs = qFromLittleEndian<qint64>(p + 24);
+  d.lastMsecs = qFromLittleEndian<qint64>(p + 32);
+  return d;
+}
+
+static QVector<DocRecord> decodeDocs(const QByteArray &data) {
+  QVector<DocRecord> docs;
+  const qsizetype count = data.size() / kDocSize;
+  docs.reserve(count);
+  for (qsizetype i = 0; i < count; ++i)
+    docs.append(decodeDoc(data.constData() + i * kDocSize));
+  return docs;
+}
+
+// ── Channels ──
+
+struct ChannelRow {
+  QString key;
+  quint32 gen = 0;
+};
+
+static QVector<ChannelRow> loadChannels(const QString &dir) {
+  QVector<ChannelRow> rows;
+  QFile f(dir + "/channels.dat");
+  if (!f.open(QIODevice::ReadOnly))
+    return rows;
+  while (!f.atEnd()) {
+    const QByteArray line = f.readLine().trimmed();
+    const qsizetype tab = line.indexOf('\t');
+    if (tab <= 0)
+      continue;
+    rows.append({QString::fromUtf8(line.mid(tab + 1)),
+                 line.left(tab).toUInt()});
+  }
+  return rows;
+}
+
+// ── Segments ──
+
+struct SegmentName {
+  QString file;
+  int level = 0;
+  quint32 first = 0;
+  quint32 end = 0;
+};
+
+static QString segmentFileName(int level, quint32 first, quint32 end) {
+  return QString::asprintf("seg-%d-%08x-%08x.tri", level, first, end);
+}
+
+static QVector<SegmentName> listSegments(const QString &dir) {
+  QVector<SegmentName> segs;
+  const QStringList files =
+      QDir(dir).entryList({QStringLiteral("seg-*.tri")}, QDir::Files);
+  for (const QString &file : files) {
+    const QStringList parts = file.chopped(4).split('-');
+    if (parts.size() != 4)
+      continue;
+    bool ok1 = false, ok2 = false, ok3 = false;
+    SegmentName s;
+    s.file = file;
+    s.level = parts[1].toInt(&ok1);
+    s.first = parts[2].toUInt(&ok2, 16);
+    s.end = parts[3].toUInt(&ok3, 16);
+    if (ok1 && ok2 && ok3 && s.first < s.end)
+      segs.append(s);
+  }
+  std::sort(segs.begin(), segs.end(),
+            [](const SegmentName &a, const SegmentName &b) {
+              return a.first < b.first;
+            });
+  return segs;
+}
+
+// Read-only view of one segment file (memory-mapped when possible).
+class Segment {
+public:
+  bool open(const QString &path) {
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly))
+      return false;
+    m_size = m_file.size();
+    m_data = m_file.map(0, m_size);
+    if (!m_data) {
+      m_buffer = m_file.readAll();
+      m_data = reinterpret_cast<const uchar *>(m_buffer.constData());
+    }
+    if (m_size < kSegHeaderSize ||
+        std::memcmp(m_data, kSegMagic.constData(), kSegMagic.size()) != 0)
+      return false;
+    m_count = qFromLittleEndian<quint32>(m_data + 20);
+    m_table = qFromLittleEndian<qint64>(m_data + 24);
+    return m_table >= kSegHeaderSize &&
+           m_table + qint64(m_count) * kSegEntrySize <= m_size;
+  }
+
+  int count() const { return int(m_count); }
+  quint32 trigramAt(int i) const { return field(i, 0); }
+  quint32 docCountAt(int i) const { return field(i, 8); }
+
+  int find(quint32 trigram) const {
+    int lo = 0, hi = int(m_count);
+    while (lo < hi) {
+      const int mid = (lo + hi) / 2;
+      if (trigramAt(mid) < trigram)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return (lo < int(m_count) && trigramAt(lo) == trigram) ? lo : -1;
+  }
+
+  void decode(int i, QVector<quint32> &out) const {
+    const uchar *p = m_data + kSegHeaderSize + field(i, 4);
+    const uchar *end = m_data + m_table;
+    quint32 id = 0;
+    const quint32 n = docCountAt(i);
+    if (out.isEmpty())
+      out.reserve(n);
+    for (quint32 k = 0; k < n && p < end; ++k) {
+      id += getVarint(p, end);
+      out.append(id);
+    }
+  }
+
+private:
+  quint32 field(int i, int at) const {
+    return qFromLittleEndian<quint32>(m_data + m_table +
+                                      qint64(i) * kSegEntrySize + at);
+  }
+
+  QFile m_file;
+  QByteArray m_buffer;
+  const uchar *m_data = nullptr;
+  qint64 m_size = 0;
+  qint64 m_table = 0;
+  quint32 m_count = 0;
+};
+
+// Write a segment for docs [first, end).  postingsFor(trigram) must return
+// ascending doc ids.  QSaveFile makes the segment appear atomically.
+template <typename F>
+static bool writeSegment(const QString &dir, int level, quint32 first,
+                         quint32 end, const QVector<quint32> &trigrams,
+                         F postingsFor) {
+  QSaveFile f(dir + "/" + segmentFileName(level, first, end));
+  if (!f.open(QIODevice::WriteOnly))
+    return false;
+  char header[kSegHeaderSize];
+  std::memcpy(header, kSegMagic.constData(), kSegMagic.size());
+  qToLittleEndian<quint32>(quint32(level), header + 8);
+  qToLittleEndian<quint32>(first, header + 12);
+  qToLittleEndian<quint32>(end, header + 16);
+  qToLittleEndian<quint32>(quint32(trigrams.size()), header + 20);
+  qToLittleEndian<qint64>(0, header + 24); // patched below
+  f.write(header, kSegHeaderSize);
+
+  QByteArray table;
+  table.reserve(trigrams.size() * kSegEntrySize);
+  QByteArray postings;
+  qint64 written = 0;
+  for (quint32 t : trigrams) {
+    const QVector<quint32> ids = postingsFor(t);
+    char e[kSegEntrySize];
+    qToLittleEndian<quint32>(t, e);
+    qToLittleEndian<quint32>(quint32(written + postings.size()), e + 4);
+    qToLittleEndian<quint32>(quint32(ids.size()), e + 8);
+    table.append(e, kSegEntrySize);
+    quint32 prev = 0;
+    for (quint32 id : ids) {
+      putVarint(postings, id - prev);
+      prev = id;
+    }
+    if (postings.size() >= 1024 * 1024) {
+      f.write(postings);
+      written += postings.size();
+      postings.clear();
+    }
+  }
+  f.write(postings);
+  written += postings.size();
+  f.write(table);
+  // Table position goes into the header last
+  if (!f.seek(24))
+    return false;
+  char tableAt[8];
+  qToLittleEndian<qint64>(kSegHeaderSize + written, tableAt);
+  f.write(tableAt, 8);
+  return f.commit();
+}
+
+// Drop segments whose docs are all covered by a larger one (left behind
+// when a merge was interrupted).
+static void removeCoveredSegments(const QString &dir) {
+  const auto segs = listSegments(dir);
+  for (const auto &a : segs) {
+    for (const auto &b : segs) {
+      if (b.first <= a.first && a.end <= b.end &&
+          b.end - b.first > a.end - a.first) {
+        QFile::remove(dir + "/" + a.file);
+        break;
+      }
+    }
+  }
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+//  Writer
+// ═══════════════════════════════════════════════════════════════════════
+
+LogSearchIndex::LogSearchIndex(const QString &netDir)
+    : m_netDir(netDir), m_dir(netDir + "/.search") {
+  m_mergePool.setMaxThreadCount(1);
+  QDir().mkpath(m_dir);
+
+  for (const ChannelRow &row : loadChannels(m_dir)) {
+    Channel ch;
+    ch.id = quint32(m_channelKeys.size());
+    ch.gen = row.gen;
+    m_channels.insert(row.key, ch);
+    m_channelKeys.append(row.key);
+  }
+
+  removeCoveredSegments(m_dir);
+  for (const auto &s : listSegments(m_dir))
+    m_sealedDocs = qMax(m_sealedDocs, s.end);
+
+  m_docs = new QFile(m_dir + "/docs.dat");
+  if (!m_docs->open(QIODevice::ReadWrite)) {
+    qWarning() << "[Logger] Cannot open search index in" << m_dir;
+    return;
+  }
+  if (m_docs->size() / kDocSize < m_sealedDocs) {
+    // Segments point at docs that are gone: start over
+    for (const auto &s : listSegments(m_dir))
+      QFile::remove(m_dir + "/" + s.file);
+    m_sealedDocs = 0;
+  }
+  // Unsealed docs from an unclean shutdown have no postings; drop them and
+  // let catchUp() feed their lines again.
+  m_docs->resize(qint64(m_sealedDocs) * kDocSize);
+  m_docCount = m_sealedDocs;
+
+  // Resume each live log where its last doc ends
+  m_docs->seek(0);
+  for (const DocRecord &d : decodeDocs(m_docs->readAll())) {
+    auto it = m_channels.find(m_channelKeys.value(int(d.channel)));
+    if (it != m_channels.end() && d.gen == it->gen)
+      it->fedEnd = qMax(it->fedEnd, d.offset + d.length);
+  }
+  m_docs->seek(m_docs->size());
+}
+
+LogSearchIndex::~LogSearchIndex() {
+  if (m_docs && m_docs->isOpen())
+    seal();
+  m_mergePool.waitForDone();
+  delete m_docs;
+}
+
+LogSearchIndex::Channel &LogSearchIndex::channelFor(const QString &key,
+                                                    bool *created) {
+  auto it = m_channels.find(key);
+  if (created)
+    *created = it == m_channels.end();
+  if (it != m_channels.end())
+    return it.value();
+  Channel ch;
+  ch.id = quint32(m_channelKeys.size());
+  m_channelKeys.append(key);
+  it = m_channels.insert(key, ch);
+  saveChannels();
+  return it.value();
+}
+
+void LogSearchIndex::saveChannels() {
+  QSaveFile f(m_dir + "/channels.dat");
+  if (!f.open(QIODevice::WriteOnly))
+    return;
+  for (const QString &key : std::as_const(m_channelKeys))
+    f.write(QByteArray::number(m_channels.value(key).gen) + '\t' +
+            key.toUtf8() + '\n');
+  f.commit();
+}
+
+void LogSearchIndex::catchUp(const QString &key) {
+  if (!m_docs || !m_docs->isOpen())
+    return;
+  queueCatchUp(key);
+  while (m_channels.value(key).behind)
+    catchUpStep(key, -1);
+}
+
+void LogSearchIndex::queueCatchUp(const QString &key) {
+  if (!m_docs || !m_docs->isOpen())
+    return;
+  const QString path = m_netDir + "/" + key + ".log";
+  bool created = false;
+  Channel &ch = channelFor(key, &created);
+  if (created && QFile::exists(path + ".1")) {
+    // First sight of a channel with a rotated backup: index the backup as
+    // the previous generation, then the live log.
+    ch.gen = 1;
+    ch.onBackup = true;
+    saveChannels();
+  }
+  // Up to date (a new log, or one reopened): lines keep being fed directly
+  if (!ch.onBackup && QFileInfo(path).size() == ch.fedEnd)
+    return;
+  if (!ch.behind) {
+    ch.behind = true;
+    m_behind.append(key);
+  }
+}
+
+void LogSearchIndex::queueCatchUpAll() {
+  const QStringList logs =
+      QDir(m_netDir).entryList({QStringLiteral("*.log")}, QDir::Files);
+  for (const QString &file : logs)
+    queueCatchUp(file.chopped(4));
+}
+
+void LogSearchIndex::work() {
+  if (!m_behind.isEmpty())
+    catchUpStep(m_behind.first(), kCatchUpStepBytes);
+}
+
+void LogSearchIndex::catchUpStep(const QString &key, qint64 budget) {
+  Channel &ch = channelFor(key);
+  const QString path = m_netDir + "/" + key + ".log";
+  if (ch.onBackup) {
+    if (feed(ch, path + ".1", ch.fedEnd, budget))
+      return;
+    finishBlock(ch);
+    ch.onBackup = false;
+    ch.fedEnd = 0;
+    return;
+  }
+  const qint64 size = QFileInfo(path).size();
+  if (size < ch.fedEnd) {
+    // Log replaced or truncated behind our back: start a new generation
+    ch.block = Block();
+    ++ch.gen;
+    ch.fedEnd = 0;
+    saveChannels();
+  }
+  if (size > ch.fedEnd && feed(ch, path, ch.fedEnd, budget))
+    return;
+  ch.behind = false;
+  m_behind.removeOne(key);
+}
+
+// Feeds the complete lines of path from offset from, stopping once about
+// budget bytes are in (< 0: at the end).  True if it stopped early.
+bool LogSearchIndex::feed(Channel &ch, const QString &path, qint64 from,
+                          qint64 budget) {
+  QFile log(path);
+  if (!log.open(QIODevice::ReadOnly) || !log.seek(from))
+    return false;
+  QByteArray buf;
+  qint64 offset = from;
+  qint64 prevMsecs = ch.block.lastMsecs;
+  for (;;) {
+    if (budget >= 0 && offset - from >= budget)
+      return true;
+    const QByteArray chunk = log.read(64 * 1024);
+    if (chunk.isEmpty())
+      break;
+    buf += chunk;
+    qsizetype pos = 0;
+    for (;;) {
+      const void *nl =
+          std::memchr(buf.constData() + pos, '\n', buf.size() - pos);
+      if (!nl)
+        break;
+      const qsizetype end = static_cast<const char *>(nl) - buf.constData() + 1;
+      const QByteArrayView line(buf.constData() + pos, end - pos);
+      qint64 ms = LogIndex::parseLineMsecs(line);
+      if (ms < 0)
+        ms = prevMsecs;
+      prevMsecs = ms;
+      addLine(ch, offset, line, ms);
+      offset += end - pos;
+      pos = end;
+    }
+    buf.remove(0, pos);
+  }
+  return false;
+}
+
+void LogSearchIndex::addLine(const QString &key, qint64 offset,
+                             QByteArrayView line, qint64 msecs) {
+  if (!m_docs || !m_docs->isOpen())
+    return;
+  Channel &ch = channelFor(key);
+  if (ch.behind)
+    return; // catch-up reads it from the log
+  // Same one-second resolution as the timestamps in the log text
+  addLine(ch, offset, line, msecs - msecs % 1000);
+}
+
+void LogSearchIndex::addLine(Channel &ch, qint64 offset, QByteArrayView line,
+                             qint64 msecs) {
+  Block &b = ch.block;
+  if (b.lines == 0) {
+    b.offset = offset;
+    b.firstMsecs = msecs;
+  }
+  b.end = offset + line.size();
+  b.lastMsecs = msecs;
+  ++b.lines;
+  forEachTrigram(messagePart(line), false,
+                 [&b](quint32 t) { b.trigrams.insert(t); });
+  ch.fedEnd = b.end;
+  if (b.lines >= kBlockLines)
+    finishBlock(ch);
+}
+
+void LogSearchIndex::finishBlock(Channel &ch) {
+  Block &b = ch.block;
+  if (b.lines == 0)
+    return;
+  DocRecord d;
+  d.channel = ch.id;
+  d.gen = ch.onBackup ? ch.gen - 1 : ch.gen;
+  d.offset = b.offset;
+  d.length = quint32(b.end - b.offset);
+  d.lines = quint32(b.lines);
+  d.firstMsecs = b.firstMsecs;
+  d.lastMsecs = b.lastMsecs;
+  char rec[kDocSize];
+  encodeDoc(d, rec);
+  m_docs->write(rec, kDocSize);
+
+  const quint32 id = m_docCount++;
+  for (quint32 t : std::as_const(b.trigrams))
+    m_pending[t].append(id);
+  b = Block();
+  if (m_docCount - m_sealedDocs >= quint32(kSegmentDocs))
+    seal();
+}
+
+void LogSearchIndex::rotated(const QString &key) {
+  if (!m_docs || !m_docs->isOpen())
+    return;
+  Channel &ch = channelFor(key);
+  if (!ch.behind || ch.onBackup) {
+    // The partial block now lives in .log.1, or (while catching up on the
+    // old backup) is gone
+    finishBlock(ch);
+    ch.fedEnd = 0;
+  }
+  // Catching up: the rest of the log is read from .log.1
+  ch.onBackup = ch.behind;
+  ++ch.gen;
+  saveChannels();
+}
+
+void LogSearchIndex::flush() {
+  if (m_docs)
+    m_docs->flush();
+}
+
+void LogSearchIndex::seal() {
+  if (m_docCount == m_sealedDocs)
+    return;
+  // Docs must be on disk before a segment refers to them
+  m_docs->flush();
+  QVector<quint32> trigrams = m_pending.keys();
+  std::sort(trigrams.begin(), trigrams.end());
+  if (!writeSegment(m_dir, 0, m_sealedDocs, m_docCount, trigrams,
+                    [this](quint32 t) { return m_pending.value(t); })) {
+    qWarning() << "[Logger] Cannot write search segment in" << m_dir;
+    return; // retried at the next seal
+  }
+  m_pending.clear();
+  m_sealedDocs = m_docCount;
+  // search() copes with segments being replaced under it, and a merge only
+  // takes segments that exist when it starts, so seal() can go on
+  m_mergePool.start([dir = m_dir]() { mergeSegments(dir); });
+}
+
+void LogSearchIndex::mergeSegments(const QString &dir) {
+  for (;;) {
+    const auto segs = listSegments(dir);
+    QMap<int, QVector<SegmentName>> byLevel;
+    for (const auto &s : segs)
+      byLevel[s.level].append(s);
+    auto full = std::find_if(byLevel.begin(), byLevel.end(),
+                             [](const QVector<SegmentName> &l) {
+                               return l.size() >= kMergeFanIn;
+                             });
+    if (full == byLevel.end())
+      return;
+
+    // Same-level segments cover adjacent doc ranges, so merged postings
+    // are just the inputs' postings concatenated in doc order.
+    const QVector<SegmentName> group = full->mid(0, kMergeFanIn);
+    std::vector<Segment> inputs(group.size());
+    QVector<quint32> trigrams;
+    for (int i = 0; i < group.size(); ++i) {
+      if (!inputs[i].open(dir + "/" + group[i].file))
+        return;
+      for (int k = 0; k < inputs[i].count(); ++k)
+        trigrams.append(inputs[i].trigramAt(k));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()),
+                   trigrams.end());
+    const bool ok = writeSegment(
+        dir, full.key() + 1, group.first().first, group.last().end,
+        trigrams, [&inputs](quint32 t) {
+          QVector<quint32> ids;
+          for (const Segment &seg : inputs) {
+            const int e = seg.find(t);
+            if (e >= 0)
+              seg.decode(e, ids);
+          }
+          return ids;
+        });
+    inputs.clear(); // unmap before removing (required on Windows)
+    if (!ok)
+      return;
+    for (const auto &s : group)
+      QFile::remove(dir + "/" + s.file);
+  }
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+//  Search
+// ═══════════════════════════════════════════════════════════════════════
+
+// "<nick> ...", "<@nick> ..." or "* nick ..."
+static bool saidBy(const QString &text, const QString &nick) {
+  auto at = [&](int from, QChar end) {
+    return text.size() > from + nick.size() &&
+           text[from + nick.size()] == end &&
+           QStringView(text).mid(from, nick.size())
+                   .compare(nick, Qt::CaseInsensitive) == 0;
+  };
+  if (text.startsWith('<'))
+    return at(1, '>') || (text.size() > 1 &&
+                          QStringView(u"~&@%+").contains(text[1]) &&
+                          at(2, '>'));
+  if (text.startsWith(QLatin1String("* ")))
+    return at(2, ' ');
+  return false;
+}
+
+namespace {
+struct Matcher {
+  const LogSearchIndex::Query &q;
+  QRegularExpression re;
+
+  explicit Matcher(const LogSearchIndex::Query &query) : q(query) {
+    if (q.regex)
+      re = QRegularExpression(
+          q.text, q.caseSensitive ? QRegularExpression::NoPatternOption
+                                  : QRegularExpression::CaseInsensitiveOption);
+  }
+
+  bool match(QByteArrayView raw, LogSearchIndex::Hit &hit) const {
+    raw = chopEol(raw);
+    if (raw.size() <= kStampLen)
+      return false;
+    const qint64 ms = LogIndex::parseLineMsecs(raw);
+    if (q.fromMsecs > 0 && ms < q.fromMsecs)
+      return false;
+    if (q.toMsecs > 0 && (ms < 0 || ms >= q.toMsecs))
+      return false;
+    const QString line = QString::fromUtf8(raw.data(), raw.size());
+    QString type;
+    QString text;
+    const int close =
+        line.size() > kStampLen && line.at(kStampLen) == '['
+            ? line.indexOf(']', kStampLen)
+            : -1;
+    if (close > 0) {
+      type = line.mid(kStampLen + 1, close - kStampLen - 1);
+      text = line.mid(close + 2);
+    } else {
+      text = line.mid(kStampLen);
+    }
+    if (!q.nick.isEmpty() && !saidBy(text, q.nick))
+      return false;
+    if (!q.text.isEmpty()) {
+      const bool found =
+          q.regex ? re.match(text).hasMatch()
+                  : text.contains(q.text, q.caseSensitive ? Qt::CaseSensitive
+                                                          : Qt::CaseInsensitive);
+      if (!found)
+        return false;
+    }
+    hit.timestamp = line.left(19);
+    hit.type = type;
+    hit.text = text;
+    hit.msecs = ms;
+    return true;
+  }
+};
+} // namespace
+
+// Doc ids in a segment containing every trigram of terms.
+static void intersectIn(const Segment &seg, const QVector<quint32> &terms,
+                        QVector<quint32> &out) {
+  QVector<QPair<quint32, int>> lists; // (doc count, entry)
+  for (quint32 t : terms) {
+    const int e = seg.find(t);
+    if (e < 0)
+      return;
+    lists.append({seg.docCountAt(e), e});
+  }
+  std::sort(lists.begin(), lists.end());
+  QVector<quint32> acc;
+  seg.decode(lists[0].second, acc);
+  QVector<quint32> next, tmp;
+  for (int i = 1; i < lists.size() && !acc.isEmpty(); ++i) {
+    next.clear();
+    tmp.clear();
+    seg.decode(lists[i].second, next);
+    std::set_intersection(acc.cbegin(), acc.cend(), next.cbegin(),
+                          next.cend(), std::back_inserter(tmp));
+    acc.swap(tmp);
+  }
+  out += acc;
+}
+
+LogSearchIndex::Result LogSearchIndex::search(const QString &netDir,
+                                              const Query &q) {
+  Result result;
+  const QString dir = netDir + "/.search";
+  const QVector<ChannelRow> channels = loadChannels(dir);
+  QVector<DocRecord> docs;
+  {
+    QFile f(dir + "/docs.dat");
+    if (f.open(QIODevice::ReadOnly))
+      docs = decodeDocs(f.readAll());
+  }
+
+  int onlyChannel = -1;
+  if (!q.channel.isEmpty()) {
+    const QString key = LogWriter::sanitizeFileName(q.channel.toLower());
+    for (int i = 0; i < channels.size() && onlyChannel < 0; ++i) {
+      if (channels[i].key == key)
+        onlyChannel = i;
+    }
+    if (onlyChannel < 0)
+      return result;
+  }
+
+  // ── Trigram prefilter ──
+  QStringList literals;
+  if (q.regex)
+    literals = requiredLiterals(q.text);
+  else if (!q.text.isEmpty())
+    literals << q.text;
+  QVector<quint32> terms;
+  const bool asciiOnly = !q.caseSensitive || q.regex;
+  for (const QString &lit : std::as_const(literals))
+    forEachTrigram(lit.toUtf8(), asciiOnly,
+                   [&terms](quint32 t) { terms.append(t); });
+  std::sort(terms.begin(), terms.end());
+  terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+
+  QVector<quint32> candidates;
+  quint32 sealed = 0;
+  // A concurrent merge may delete a segment between listing and opening
+  // it; the merged replacement is already in place by then, so list again.
+  for (int attempt = 0; attempt < 3; ++attempt) {
+    candidates.clear();
+    sealed = 0;
+    bool complete = true;
+    const auto segs = listSegments(dir);
+    for (const auto &s : segs) {
+      sealed = qMax(sealed, s.end);
+      if (terms.isEmpty())
+        continue;
+      Segment seg;
+      if (!seg.open(dir + "/" + s.file)) {
+        complete = false;
+        break;
+      }
+      intersectIn(seg, terms, candidates);
+    }
+    if (complete)
+      break;
+  }
+  sealed = qMin(sealed, quint32(docs.size()));
+  if (terms.isEmpty()) {
+    for (quint32 id = 0; id < sealed; ++id)
+      candidates.append(id);
+  }
+  // Docs not sealed into a segment yet are always scanned
+  for (quint32 id = sealed; id < quint32(docs.size()); ++id)
+    candidates.append(id);
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                   candidates.end());
+
+  // ── Verify, newest first ──
+  const Matcher matcher(q);
+  QHash<QString, QFile *> files;
+  auto fileFor = [&](const QString &path) -> QFile * {
+    auto it = files.find(path);
+    if (it == files.end()) {
+      auto *f = new QFile(path);
+      if (!f->open(QIODevice::ReadOnly)) {
+        delete f;
+        f = nullptr;
+      }
+      it = files.insert(path, f);
+    }
+    return it.value();
+  };
+  int skipped = 0;
+  // Scan [offset, end) of a log newest line first; true once the page is
+  // full and one more hit proved there is a next page.
+  // With midLine, offset may fall inside a line, which is skipped.
+  auto scan = [&](const QString &path, const QString &channel, qint64 offset,
+                  qint64 end, bool midLine = false) {
+    QFile *f = fileFor(path);
+    if (!f || !f->seek(offset))
+      return false;
+    ++result.blocksRead;
+    const QByteArray data = f->read(end - offset);
+    const qsizetype first = midLine ? data.indexOf('\n') + 1 : 0;
+    qsizetype stop = data.size();
+    while (stop > first) {
+      const qsizetype start =
+          stop >= first + 2 ? data.lastIndexOf('\n', stop - 2) + 1 : first;
+      const QByteArrayView line(data.constData() + start, stop - start);
+      stop = start;
+      Hit hit;
+      if (!matcher.match(line, hit))
+        continue;
+      if (skipped < q.offset) {
+        ++skipped;
+        continue;
+      }
+      if (result.hits.size() == q.limit) {
+        result.more = true;
+        return true;
+      }
+      hit.channel = channel;
+      result.hits.append(hit);
+    }
+    return false;
+  };
+
+  auto logPath = [&](quint32 channel, quint32 gen) {
+    const QString path = netDir + "/" + channels[channel].key + ".log";
+    if (gen == channels[channel].gen)
+      return path;
+    if (gen + 1 == channels[channel].gen)
+      return path + ".1";
+    return QString(); // rotated away
+  };
+
+  // Tails: the partial block past each live log's last doc
+  QVector<qint64> tailStart(channels.size(), 0);
+  for (const DocRecord &d : std::as_const(docs)) {
+    if (d.channel < quint32(channels.size()) &&
+        d.gen == channels[d.channel].gen)
+      tailStart[d.channel] =
+          qMax(tailStart[d.channel], d.offset + qint64(d.length));
+  }
+  bool full = false;
+  for (int c = 0; c < channels.size() && !full; ++c) {
+    if (onlyChannel >= 0 && c != onlyChannel)
+      continue;
+    const QString path = logPath(c, channels[c].gen);
+    const qint64 size = QFileInfo(path).size();
+    // Far more than a block: catch-up has not got this far yet
+    if (size - tailStart[c] > kCatchUpStepBytes) {
+      result.incomplete = true;
+      full = scan(path, channels[c].key, size - kCatchUpStepBytes, size, true);
+    } else if (size > tailStart[c]) {
+      full = scan(path, channels[c].key, tailStart[c], size);
+    }
+  }
+
+  for (auto it = candidates.crbegin(); it != candidates.crend() && !full;
+       ++it) {
+    const DocRecord &d = docs[*it];
+    if (d.channel >= quint32(channels.size()) ||
+        (onlyChannel >= 0 && d.channel != quint32(onlyChannel)))
+      continue;
+    if ((q.fromMsecs > 0 && d.lastMsecs < q.fromMsecs) ||
+        (q.toMsecs > 0 && d.firstMsecs >= q.toMsecs))
+      continue;
+    const QString path = logPath(d.channel, d.gen);
+    if (path.isEmpty())
+      continue;
+    full = scan(path, channels[d.channel].key, d.offset, d.offset + d.length);
+  }
+
+  qDeleteAll(files);
+  return result;
+}
+
+QStringList LogSearchIndex::requiredLiterals(const QString &pattern) {
+  QStringList out;
+  // With an alternation any branch may match on its own
+  if (pattern.contains('|'))
+    return out;
+  QString run;
+  auto endRun = [&] {
+    if (run.size() >= 3)
+      out << run;
+    run.clear();
+  };
+  auto skipBraces = [&](int &i) {
+    if (i + 1 < pattern.size() && pattern[i + 1] == '{') {
+      const int close = pattern.indexOf('}', i + 1);
+      i = close < 0 ? pattern.size() : close;
+    }
+  };
+  auto isHex = [](QChar h) {
+    const QChar l = h.toLower();
+    return h.isDigit() || (l >= 'a' && l <= 'f');
+  };
+  const int n = pattern.size();
+  for (int i = 0; i < n; ++i) {
+    const QChar c = pattern[i];
+    switch (c.unicode()) {
+    case '*':
+    case '?':
+    case '{':
+      // May repeat zero times: the previous character is optional
+      if (!run.isEmpty())
+        run.chop(1);
+      endRun();
+      if (c == '{') {
+        const int close = pattern.indexOf('}', i);
+        i = close < 0 ? n : close;
+      }
+      break;
+    case '+':
+      endRun();
+      break;
+    case '.':
+    case '^':
+    case '$':
+      endRun();
+      break;
+    case '(': {
+      // Group contents may be optional or repeated; skip them
+      endRun();
+      int depth = 1;
+      while (++i < n && depth > 0) {
+        if (pattern[i] == '\\')
+          ++i;
+        else if (pattern[i] == '(')
+          ++depth;
+        else if (pattern[i] == ')')
+          --depth;
+      }
+      --i;
+      break;
+    }
+    case '[': {
+      endRun();
+      ++i;
+      if (i < n && pattern[i] == '^')
+        ++i;
+      if (i < n && pattern[i] == ']')
+        ++i;
+      while (i < n && pattern[i] != ']') {
+        if (pattern[i] == '\\')
+          ++i;
+        ++i;
+      }
+      break;
+    }
+    case '\\': {
+      if (++i >= n)
+        break;
+      const QChar e = pattern[i];
+      if (!e.isLetterOrNumber()) {
+        run += e; // escaped punctuation is a literal
+        break;
+      }
+      endRun();
+      switch (e.unicode()) {
+      case 'x':
+        if (i + 1 < n && pattern[i + 1] == '{')
+          skipBraces(i);
+        else
+          for (int k = 0; k < 2 && i + 1 < n && isHex(pattern[i + 1]); ++k)
+            ++i;
+        break;
+      case 'p':
+      case 'P':
+      case 'N':
+      case 'g':
+      case 'k':
+      case 'o':
+        if (i + 1 < n && pattern[i + 1] == '{')
+          skipBraces(i);
+        else if (i + 1 < n)
+          ++i;
+        break;
+      case 'c':
+        if (i + 1 < n)
+          ++i;
+        break;
+      default:
+        while (e.isDigit() && i + 1 < n && pattern[i + 1].isDigit())
+          ++i; // backreference
+        break;
+      }
+      break;
+    }
+    default:
+      run += c;
+      break;
+    }
+  }
+  endRun();
+  return out;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <QByteArrayView>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+class QFile;
+
+// Persistent trigram index over one network's channel logs, kept in
+// "<logDir>/<network>/.search/".
+//
+// Logs are cut into blocks of kBlockLines lines ("docs").  docs.dat lists
+// every doc (channel, rotation generation, byte range, time range), and
+// immutable segment files map each trigram of the lower-cased line text to
+// the ids of the docs containing it.  A query intersects the posting lists
+// of its trigrams and reads only the candidate blocks to confirm matches,
+// so it touches a handful of blocks instead of the whole history.
+//
+// The LogWriter thread owns the writing side: lines are fed as they are
+// written, finished docs are appended to docs.dat, and every kSegmentDocs
+// docs are sealed into a segment.  Segments are merged kMergeFanIn at a
+// time, so their number grows logarithmically with the history; merges run
+// on a thread of their own, since one can cover most of it.  Segments are
+// written under a temporary name and renamed into place, which lets
+// search() run on any thread without locking: docs that are not sealed yet
+// and the partial block at the end of each log are simply scanned.
+//
+// Reading logs the index has not seen (catch-up) can take a while, so the
+// writer queues it and does it in work() steps when it has nothing to
+// write; lines written meanwhile are read back from the log with the rest.
+// search() meanwhile reads only the newest kCatchUpStepBytes past a log's
+// last doc and says the result is incomplete.
+class LogSearchIndex {
+public:
+  static constexpr int kBlockLines = 64;
+  static constexpr int kSegmentDocs = 256;
+  static constexpr int kMergeFanIn = 8;
+  static constexpr qint64 kCatchUpStepBytes = 1024 * 1024;
+
+  struct Query {
+    QString text; // substring, or a pattern when regex is set
+    bool regex = false;
+    bool caseSensitive = false;
+    QString nick;         // only lines said or acted by this nick
+    QString channel;      // only this channel (any when empty)
+    qint64 fromMsecs = 0; // inclusive; 0 = unbounded
+    qint64 toMsecs = 0;   // exclusive; 0 = unbounded
+    int offset = 0;       // hits to skip (paging)
+    int limit = 50;
+  };
+  struct Hit {
+    QString channel; // log file name without ".log"
+    QString timestamp;
+    QString type;
+    QString text;
+    qint64 msecs = 0;
+  };
+  struct Result {
+    QVector<Hit> hits; // newest block first, newest line first within it
+    bool more = false; // there is at least one more page
+    // Some log is still being caught up: hits from it may be missing
+    bool incomplete = false;
+    int blocksRead = 0;
+  };
+
+  // netDir is "<logDir>/<network>" as LogWriter lays it out.
+  explicit LogSearchIndex(const QString &netDir);
+  ~LogSearchIndex(); // seals pending docs
+
+  // ── Writer thread ──
+  // Channel keys are log file names without ".log" (see LogWriter).
+  // Index whatever the channel's log holds beyond what is indexed already:
+  // logs from before indexing existed, or lines written while the index
+  // was closed.  Cheap when there is nothing to do.
+  void catchUp(const QString &key);
+  // The same, done by work() a step at a time.  Until the channel has
+  // caught up, addLine() leaves its lines to be read from the log.
+  void queueCatchUp(const QString &key);
+  // Queue catch-up for every log in the network directory.
+  void queueCatchUpAll();
+  bool hasWork() const { return !m_behind.isEmpty(); }
+  // Up to kCatchUpStepBytes of queued catch-up.  Logs being written must
+  // be flushed first.
+  void work();
+  // line is the complete line as written, including its '\n'.
+  void addLine(const QString &key, qint64 offset, QByteArrayView line,
+               qint64 msecs);
+  // The live log has just been moved to ".log.1".
+  void rotated(const QString &key);
+  void flush();
+
+  // ── Any thread ──
+  static Result search(const QString &netDir, const Query &query);
+  // Literal strings every match of a regex must contain; empty when none
+  // can be derived (e.g. alternations), in which case nothing is
+  // prefiltered.
+  static QStringList requiredLiterals(const QString &pattern);
+
+private:
+  struct Block {
+    qint64 offset = 0;
+    qint64 end = 0;
+    int lines = 0;
+    qint64 firstMsecs = 0;
+    qint64 lastMsecs = 0;
+    QSet<quint32> trigrams;
+  };
+  struct Channel {
+    quint32 id = 0;
+    quint32 gen = 0;     // bumped on every rotation
+    qint64 fedEnd = 0;   // end of the last line fed from the log being fed
+    Block block;         // lines not yet part of a doc
+    bool behind = false; // queued for catch-up
+    bool onBackup = false; // catch-up is in ".log.1", generation gen - 1
+  };
+
+  Channel &channelFor(const QString &key, bool *created = nullptr);
+  // One step of catch-up for key, of about budget bytes (< 0: to the end)
+  void catchUpStep(const QString &key, qint64 budget);
+  bool feed(Channel &ch, const QString &path, qint64 from, qint64 budget);
+  void addLine(Channel &ch, qint64 offset, QByteArrayView line, qint64 msecs);
+  void finishBlock(Channel &ch);
+  void seal();
+  static void mergeSegments(const QString &dir);
+  void saveChannels();
+
+  QString m_netDir;
+  QString m_dir;
+  QHash<QString, Channel> m_channels;
+  QStringList m_channelKeys; // by id
+  QFile *m_docs = nullptr;
+  quint32 m_docCount = 0;
+  quint32 m_sealedDocs = 0;
+  QHash<quint32, QVector<quint32>> m_pending; // trigram -> unsealed doc ids
+  QStringList m_behind;    // channels queued for catch-up, oldest first
+  QThreadPool m_mergePool; // one thread: merges run one at a time
+};
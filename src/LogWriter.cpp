@@ -0,0 +1,337 @@
+#include "LogWriter.h"
+#include "LogIndex.h"
+#include "LogSearchIndex.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+// Records pile up for at most kFlushIntervalMs; a burst this large wakes the
+// writer early so the pending vector stays small.
+static constexpr int kWakeBatch = 256;
+
+LogWriter::LogWriter(const QString &logDir, QObject *parent)
+    : QThread(parent), m_logDir(logDir) {
+  setObjectName(QStringLiteral("LogWriter"));
+}
+
+LogWriter::~LogWriter() { shutdown(); }
+
+// Replace characters that are invalid in filenames (Windows is the strictest:
+// \ / : * ? " < > |) so channels like #foo|bar still get a log file.
+QString LogWriter::sanitizeFileName(QString name) {
+  static const QString invalid = QStringLiteral("/\\:*?\"<>|");
+  for (const QChar &c : invalid)
+    name.replace(c, QLatin1Char('_'));
+  return name;
+}
+
+QString LogWriter::networkDirFor(const QString &logDir,
+                                 const QString &network) {
+  return logDir + "/" + sanitizeFileName(network.toLower());
+}
+
+QString LogWriter::filePathFor(const QString &logDir, const QString &network,
+                               const QString &channel) {
+  return networkDirFor(logDir, network) + "/" +
+         sanitizeFileName(channel.toLower()) + ".log";
+}
+
+// ── GUI-thread side ──
+
+void LogWriter::enqueue(Record record) {
+  QMutexLocker lock(&m_mutex);
+  m_pending.append(std::move(record));
+  ++m_enqueued;
+  if (m_pending.size() == kWakeBatch)
+    m_wake.wakeOne();
+}
+
+void LogWriter::enqueue(QVector<Record> records) {
+  if (records.isEmpty())
+    return;
+  QMutexLocker lock(&m_mutex);
+  const qsizetype before = m_pending.size();
+  if (m_pending.isEmpty())
+    m_pending.swap(records);
+  else
+    m_pending.append(std::move(records));
+  m_enqueued += m_pending.size() - before;
+  if (before < kWakeBatch && m_pending.size() >= kWakeBatch)
+    m_wake.wakeOne();
+}
+
+void LogWriter::flush() {
+  QMutexLocker lock(&m_mutex);
+  if (!isRunning())
+    return;
+  const quint64 target = m_enqueued;
+  if (m_written >= target)
+    return;
+  m_flushRequested = true;
+  m_wake.wakeOne();
+  while (m_written < target)
+    m_flushed.wait(&m_mutex);
+}
+
+void LogWriter::ensureIndexed(const QString &network,
+                              const QString &channel) {
+  Record rec;
+  rec.network = network;
+  rec.channel = channel;
+  rec.indexOnly = true;
+  enqueue(std::move(rec));
+  flush();
+}
+
+bool LogWriter::ensureSearchIndexed(const QString &network) {
+  Record rec;
+  rec.network = network;
+  rec.indexOnly = true; // no channel: the whole network
+  enqueue(std::move(rec));
+  flush();
+  QMutexLocker lock(&m_mutex);
+  return !m_searchBehind.contains(network.toLower());
+}
+
+void LogWriter::shutdown() {
+  {
+    QMutexLocker lock(&m_mutex);
+    m_stop = true;
+    m_wake.wakeOne();
+  }
+  wait();
+}
+
+// ── Writer thread ──
+
+void LogWriter::run() {
+  QVector<Record> batch;
+  QElapsedTimer sinceFlush;
+  sinceFlush.start();
+  bool indexing = false;
+
+  for (;;) {
+    bool flushNow = false;
+    bool stop = false;
+    quint64 target = 0;
+    {
+      QMutexLocker lock(&m_mutex);
+      // Search-index catch-up fills idle time: only sleep without any
+      if (!indexing && m_pending.size() < kWakeBatch && !m_flushRequested &&
+          !m_stop)
+        m_wake.wait(&m_mutex, kFlushIntervalMs);
+      batch.swap(m_pending);
+      flushNow = m_flushRequested;
+      m_flushRequested = false;
+      stop = m_stop;
+      target = m_enqueued;
+    }
+
+    for (const Record &rec : std::as_const(batch))
+      writeRecord(rec);
+    batch.clear();
+
+    if (flushNow || stop || sinceFlush.elapsed() >= kFlushIntervalMs) {
+      flushAll();
+      sinceFlush.restart();
+      const QSet<QString> behind = searchBehind();
+      QMutexLocker lock(&m_mutex);
+      m_written = target;
+      m_searchBehind = behind;
+      m_flushed.wakeAll();
+    }
+    // One step at a time between batches, so neither a flush nor a line
+    // waits for more than that
+    indexing = !stop && indexStep();
+    if (stop)
+      break;
+  }
+  closeAll();
+}
+
+bool LogWriter::indexStep() {
+  for (LogSearchIndex *search : std::as_const(m_search)) {
+    if (!search->hasWork())
+      continue;
+    flushAll(); // catch-up reads the logs from disk
+    search->work();
+    return true;
+  }
+  return false;
+}
+
+QSet<QString> LogWriter::searchBehind() const {
+  QSet<QString> behind;
+  for (auto it = m_search.cbegin(); it != m_search.cend(); ++it) {
+    if (it.value()->hasWork())
+      behind.insert(it.key());
+  }
+  return behind;
+}
+
+const QByteArray &LogWriter::stampFor(qint64 msecs) {
+  // Lines arrive in bursts within the same second; format once per second.
+  const qint64 secs = msecs / 1000;
+  if (secs != m_stampSecs) {
+    m_stamp = QDateTime::fromMSecsSinceEpoch(msecs)
+                  .toString("yyyy-MM-dd HH:mm:ss")
+                  .toUtf8();
+    m_stampSecs = secs;
+  }
+  return m_stamp;
+}
+
+LogSearchIndex *LogWriter::searchIndexFor(const QString &network) {
+  const QString key = network.toLower();
+  auto it = m_search.find(key);
+  if (it == m_search.end()) {
+    const QString dir = networkDirFor(m_logDir, network);
+    QDir().mkpath(dir);
+    it = m_search.insert(key, new LogSearchIndex(dir));
+  }
+  return it.value();
+}
+
+void LogWriter::writeRecord(const Record &rec) {
+  if (rec.indexOnly && rec.channel.isEmpty()) {
+    searchIndexFor(rec.network)->queueCatchUpAll();
+    return;
+  }
+  OpenLog *log = openLog(rec.network, rec.channel);
+  if (!log || rec.indexOnly)
+    return;
+
+  // ── Size-based rotation: keep one .log.1 backup ──
+  if (log->size > kMaxLogSize)
+    rotate(*log);
+  if (!log->file->isOpen())
+    return;
+
+  QByteArray line = stampFor(rec.msecs);
+  line += " [";
+  line += rec.type.toUtf8();
+  line += "] ";
+  line += rec.message.toUtf8();
+  line += '\n';
+  // Index timestamps have the same one-second resolution as the log text
+  if (log->lines % LogIndex::kStride == 0 && log->index->isOpen())
+    LogIndex::append(*log->index,
+                     {log->lines, log->size, rec.msecs - rec.msecs % 1000});
+  const qint64 n = log->file->write(line);
+  ++log->lines;
+  if (n > 0) {
+    log->search->addLine(log->key, log->size, line, rec.msecs);
+    log->size += n;
+  }
+  log->dirty = true;
+  log->lastUse = ++m_useCounter;
+}
+
+LogWriter::OpenLog *LogWriter::openLog(const QString &network,
+                                       const QString &channel) {
+  const QString key = network.toLower() + '\n' + channel.toLower();
+  auto it = m_open.find(key);
+  if (it != m_open.end())
+    return &it.value();
+
+  // Evict the least recently written file once the cache is full.
+  if (m_open.size() >= kMaxOpenFiles) {
+    auto victim = m_open.begin();
+    for (auto i = m_open.begin(); i != m_open.end(); ++i) {
+      if (i->lastUse < victim->lastUse)
+        victim = i;
+    }
+    closeLog(*victim);
+    m_open.erase(victim);
+  }
+
+  // Ensure log directory exists: ~/.config/NUchat/logs/<network>/
+  const QString path = filePathFor(m_logDir, network, channel);
+  const QString dir = QFileInfo(path).absolutePath();
+  if (!m_knownDirs.contains(dir)) {
+    QDir().mkpath(dir);
+    m_knownDirs.insert(dir);
+  }
+
+  // Binary mode: index offsets must match the bytes on disk exactly.
+  auto *file = new QFile(path);
+  if (!file->open(QIODevice::Append)) {
+    qWarning() << "[Logger] Cannot open" << path << ":" << file->errorString();
+    delete file;
+    return nullptr;
+  }
+  OpenLog log;
+  log.file = file;
+  log.size = file->size();
+  log.index = new QFile(LogIndex::pathFor(path));
+  if (log.index->open(QIODevice::ReadWrite)) {
+    log.lines = LogIndex::sync(path, *log.index);
+  } else {
+    qWarning() << "[Logger] Cannot open index for" << path;
+  }
+  // A backup rotated before indexing existed gets its sidecar once, here,
+  // instead of an in-memory index built by every scrollback page read
+  const QString backup = path + ".1";
+  if (QFile::exists(backup)) {
+    QFile backupIndex(LogIndex::pathFor(backup));
+    if (backupIndex.open(QIODevice::ReadWrite))
+      LogIndex::sync(backup, backupIndex);
+  }
+  log.key = sanitizeFileName(channel.toLower());
+  log.search = searchIndexFor(network);
+  log.search->queueCatchUp(log.key);
+  return &m_open.insert(key, log).value();
+}
+
+void LogWriter::rotate(OpenLog &log) {
+  const QString path = log.file->fileName();
+  log.file->close();
+  log.index->close();
+  // The index travels with its log so the backup stays seekable
+  const QString backup = path + ".1";
+  QFile::remove(backup);
+  QFile::remove(LogIndex::pathFor(backup));
+  QFile::rename(path, backup);
+  QFile::rename(LogIndex::pathFor(path), LogIndex::pathFor(backup));
+  if (!log.file->open(QIODevice::Append))
+    qWarning() << "[Logger] Cannot reopen" << path << "after rotation";
+  if (log.index->open(QIODevice::ReadWrite | QIODevice::Truncate))
+    LogIndex::sync(path, *log.index);
+  log.search->rotated(log.key);
+  log.size = 0;
+  log.lines = 0;
+  log.dirty = false;
+}
+
+void LogWriter::closeLog(OpenLog &log) {
+  // QFile flushes and closes on destruction
+  delete log.file;
+  delete log.index;
+  log.file = nullptr;
+  log.index = nullptr;
+}
+
+void LogWriter::flushAll() {
+  for (auto &log : m_open) {
+    if (log.dirty) {
+      log.file->flush();
+      if (log.index->isOpen())
+        log.index->flush();
+      log.dirty = false;
+    }
+  }
+  for (LogSearchIndex *search : std::as_const(m_search))
+    search->flush();
+}
+
+void LogWriter::closeAll() {
+  for (auto &log : m_open)
+    closeLog(log);
+  m_open.clear();
+  qDeleteAll(m_search); // seals pending docs
+  m_search.clear();
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+class QFile;
+class LogSearchIndex;
+
+// Background writer behind Logger.
+//
+// The GUI thread only appends a record to a pending vector under a short
+// lock; the writer thread swaps the whole vector out and formats and writes
+// the batch without holding the lock.  Open files are kept in a small LRU
+// so a busy channel costs one buffered write per line instead of an
+// mkpath/stat/open/close cycle, and rotation is decided from a size counter
+// kept alongside each handle.  The writer also feeds each network's
+// LogSearchIndex as it writes, and catches the index up on older logs in
+// the time left between batches.
+class LogWriter : public QThread {
+  Q_OBJECT
+public:
+  struct Record {
+    QString network;
+    QString channel;
+    QString type;
+    QString message;
+    qint64 msecs = 0; // capture time, so queueing delay never skews logs
+    bool indexOnly = false; // open (and index) the log without writing
+  };
+
+  static constexpr int kMaxOpenFiles = 32;
+  static constexpr int kFlushIntervalMs = 1000;
+  static constexpr qint64 kMaxLogSize = 10 * 1024 * 1024; // 10 MB
+
+  explicit LogWriter(const QString &logDir, QObject *parent = nullptr);
+  ~LogWriter() override;
+
+  void enqueue(Record record);
+  // Several records under one lock, e.g. everything a burst of lines logged
+  void enqueue(QVector<Record> records);
+  // Block until everything enqueued so far is on disk.
+  void flush();
+  // Make sure the log's sidecar index is current (opens the log on the
+  // writer thread, which syncs the index), then flush.  Search-index
+  // catch-up is not waited for.
+  void ensureIndexed(const QString &network, const QString &channel);
+  // Flush, so every line logged to the network so far is searchable, and
+  // queue catch-up of its logs on disk.  Whether the search index has
+  // caught up with all of them; if not, the writer thread carries on in
+  // the background.  Safe to call from any thread.
+  bool ensureSearchIndexed(const QString &network);
+  // Flush, close every file and join the thread.
+  void shutdown();
+
+  static QString sanitizeFileName(QString name);
+  static QString filePathFor(const QString &logDir, const QString &network,
+                             const QString &channel);
+  static QString networkDirFor(const QString &logDir, const QString &network);
+
+protected:
+  void run() override;
+
+private:
+  struct OpenLog {
+    QFile *file = nullptr;
+    QFile *index = nullptr; // LogIndex sidecar
+    LogSearchIndex *search = nullptr; // owned by m_search
+    QString key;                      // channel key within the network
+    qint64 size = 0;
+    qint64 lines = 0;
+    quint64 lastUse = 0;
+    bool dirty = false;
+  };
+
+  void writeRecord(const Record &rec);
+  OpenLog *openLog(const QString &network, const QString &channel);
+  void rotate(OpenLog &log);
+  static void closeLog(OpenLog &log);
+  void flushAll();
+  void closeAll();
+  // One step of search-index catch-up; false when there is none left
+  bool indexStep();
+  QSet<QString> searchBehind() const;
+  const QByteArray &stampFor(qint64 msecs);
+  LogSearchIndex *searchIndexFor(const QString &network);
+
+  const QString m_logDir;
+
+  // ── Shared with the GUI thread (guarded by m_mutex) ──
+  QMutex m_mutex;
+  QWaitCondition m_wake;
+  QWaitCondition m_flushed;
+  QVector<Record> m_pending;
+  quint64 m_enqueued = 0; // records handed to enqueue()
+  quint64 m_written = 0;  // records written and flushed
+  QSet<QString> m_searchBehind; // networks with catch-up left, as of m_written
+  bool m_flushRequested = false;
+  bool m_stop = false;
+
+  // ── Writer-thread only ──
+  QHash<QString, OpenLog> m_open; // "network\nchannel" (lower-cased)
+  QSet<QString> m_knownDirs;
+  QHash<QString, LogSearchIndex *> m_search; // by lower-cased network
+  quint64 m_useCounter = 0;
+  qint64 m_stampSecs = -1;
+  QByteArray m_stamp;
+};
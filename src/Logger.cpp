@@ -1,130 +1,238 @@
 #include "Logger.h"
+#include "LogIndex.h"
+#include "LogWriter.h"
 #include <QFileInfo>
-
-Logger::Logger(QObject *parent) : QObject(parent) {}
-
-QString Logger::logDir() const {
-  return QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation) +
-         QStringLiteral("/logs");
+#include <utility>
+
+Logger::Logger(QObject *parent)
+    : QObject(parent),
+      m_logDir(QStandardPaths::writableLocation(
+                   QStandardPaths::AppConfigLocation) +
+               QStringLiteral("/logs")) {
+  m_writer = new LogWriter(m_logDir, this);
+  m_writer->start(QThread::LowPriority);
 }
 
-// Replace characters that are invalid in filenames (Windows is the strictest:
-// \ / : * ? " < > |) so channels like #foo|bar still get a log file.
-static QString sanitizeFileName(QString name) {
-  static const QString invalid = QStringLiteral("/\\:*?\"<>|");
-  for (const QChar &c : invalid)
-    name.replace(c, QLatin1Char('_'));
-  return name;
+Logger::~Logger() {
+  // Flush on shutdown: everything queued reaches disk before we go away
+  queueHeld();
+  m_writer->shutdown();
 }
 
 QString Logger::logFilePath(const QString &network,
                             const QString &channel) const {
-  return logDir() + "/" + sanitizeFileName(network.toLower()) + "/" +
-         sanitizeFileName(channel.toLower()) + ".log";
+  return LogWriter::filePathFor(m_logDir, network, channel);
 }
 
 void Logger::log(const QString &network, const QString &channel,
                  const QString &type, const QString &message) {
-  // Ensure log directory exists: ~/.config/NUchat/logs/<network>/
-  QString dir = logDir() + "/" + sanitizeFileName(network.toLower());
-  QDir().mkpath(dir);
-
-  QString filePath = logFilePath(network, channel);
-
-  // ── Size-based rotation: keep one .log.1 backup ──
-  static constexpr qint64 kMaxLogSize = 10 * 1024 * 1024; // 10 MB
-  if (QFileInfo(filePath).size() > kMaxLogSize) {
-    QString backup = filePath + ".1";
-    QFile::remove(backup);
-    QFile::rename(filePath, backup);
+  LogWriter::Record rec;
+  rec.network = network;
+  rec.channel = channel;
+  rec.type = type;
+  rec.message = message;
+  rec.msecs = QDateTime::currentMSecsSinceEpoch();
+  if (m_holdDepth > 0)
+    m_held.append(std::move(rec));
+  else
+    m_writer->enqueue(std::move(rec));
+}
+
+void Logger::holdLines() { ++m_holdDepth; }
+
+void Logger::releaseLines() {
+  if (m_holdDepth == 0 || --m_holdDepth > 0)
+    return;
+  queueHeld();
+}
+
+void Logger::queueHeld() const {
+  if (!m_held.isEmpty())
+    m_writer->enqueue(std::exchange(m_held, {}));
+}
+
+void Logger::flush() {
+  queueHeld();
+  m_writer->flush();
+}
+
+bool Logger::updateSearchIndex(const QString &network) {
+  return m_writer->ensureSearchIndexed(network);
+}
+
+QString Logger::networkDir(const QString &network) const {
+  return LogWriter::networkDirFor(m_logDir, network);
+}
+
+// Parse one stored line.  Returns false for malformed lines and for noisy
+// system messages that should not be replayed as scrollback.
+static bool parseLogLine(const QString &line, Logger::LogEntry &entry) {
+  if (line.length() < 20)
+    return false; // skip malformed lines
+
+  entry.timestamp = line.left(19); // "yyyy-MM-dd HH:mm:ss"
+
+  // Parse type: new format has " [type] ", old format has no brackets
+  int bracketOpen = line.indexOf('[', 20);
+  int bracketClose = (bracketOpen >= 0) ? line.indexOf(']', bracketOpen) : -1;
+  if (bracketOpen == 20 && bracketClose > bracketOpen) {
+    // New format: "yyyy-MM-dd HH:mm:ss [chat] <nick> message"
+    entry.type = line.mid(bracketOpen + 1, bracketClose - bracketOpen - 1);
+    entry.text = line.mid(bracketClose + 2); // skip "] "
+  } else {
+    // Old format: "yyyy-MM-dd HH:mm:ss <nick> message" — guess type
+    QString rest = line.mid(20);
+    if (rest.startsWith('<') || rest.startsWith('-'))
+      entry.type = QStringLiteral("chat");
+    else if (rest.startsWith('*'))
+      entry.type = QStringLiteral("action");
+    else
+      entry.type = QStringLiteral("system");
+    entry.text = rest;
+  }
+  // Filter out noisy system messages from scrollback
+  if (entry.type == "system") {
+    const QString &t = entry.text;
+    if (t.startsWith("Now talking in ") || t.startsWith("Topic for ") ||
+        t.startsWith("*** Topic for ") || t.contains("Scrollback from ") ||
+        t.contains("End of scrollback") || t.startsWith("Connecting to "))
+      return false;
+  }
+  return true;
+}
+
+static QByteArrayView chopEol(const QByteArray &raw) {
+  qsizetype n = raw.size();
+  while (n > 0 && (raw[n - 1] == '\n' || raw[n - 1] == '\r'))
+    --n;
+  return QByteArrayView(raw.constData(), n);
+}
+
+// Index records and total line count for an open log.  The writer keeps
+// the sidecars of the live log and its backup current (see
+// LogWriter::openLog()); an in-memory index is only the fallback for one
+// that could not be written.
+static bool loadIndex(QFile &file, QVector<LogIndex::Entry> &entries,
+                      qint64 &lines) {
+  entries = LogIndex::load(LogIndex::pathFor(file.fileName()));
+  if (entries.isEmpty() || entries.last().offset > file.size())
+    entries = LogIndex::build(file);
+  if (entries.isEmpty()) {
+    lines = 0;
+    return false;
   }
+  lines = entries.last().line +
+          LogIndex::countLinesFrom(file, entries.last().offset);
+  return true;
+}
 
-  QFile file(filePath);
-  if (file.open(QIODevice::Append | QIODevice::Text)) {
-    QTextStream stream(&file);
-    QString ts = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss");
-    stream << ts << " [" << type << "] " << message << "\n";
+// Lines [start, end) of an indexed log: one seek to the nearest record at
+// or before start, then a short forward read.
+static QVector<Logger::LogEntry>
+readLines(QFile &file, const QVector<LogIndex::Entry> &entries, qint64 start,
+          qint64 end) {
+  QVector<Logger::LogEntry> result;
+  const LogIndex::Entry &from =
+      entries[LogIndex::lastAtOrBeforeLine(entries, start)];
+  if (!file.seek(from.offset))
+    return result;
+  result.reserve(end - start);
+  for (qint64 line = from.line; line < end && !file.atEnd(); ++line) {
+    const QByteArray raw = file.readLine();
+    if (line < start)
+      continue;
+    Logger::LogEntry entry;
+    if (parseLogLine(QString::fromUtf8(chopEol(raw)), entry))
+      result.append(entry);
   }
+  return result;
+}
+
+QString Logger::logFilePath(const QString &network, const QString &channel,
+                            int file) const {
+  const QString path = logFilePath(network, channel);
+  return file == 0 ? path : path + "." + QString::number(file);
 }
 
 QVector<Logger::LogEntry> Logger::loadScrollback(const QString &network,
                                                  const QString &channel,
                                                  int maxLines) const {
-  QVector<LogEntry> result;
-  QString filePath = logFilePath(network, channel);
-  QFile file(filePath);
-  if (!file.open(QIODevice::ReadOnly))
-    return result;
-
-  qint64 fileSize = file.size();
-  if (fileSize == 0) {
-    file.close();
-    return result;
-  }
+  return loadScrollbackPage(network, channel, ScrollbackCursor(), maxLines)
+      .entries;
+}
 
-  // ── Seek from EOF: read backwards in chunks to find enough lines ──
-  // We read 8 KB chunks from the end, accumulating raw bytes until we
-  // have at least maxLines+1 newlines (to guarantee maxLines full lines).
-  constexpr int kChunkSize = 8192;
-  QByteArray tail;
-  qint64 readPos = fileSize;
-  int newlineCount = 0;
-  int targetNewlines = maxLines + 1; // +1 because the last line may not end with \n
-
-  while (readPos > 0 && newlineCount < targetNewlines) {
-    qint64 chunkStart = qMax(qint64(0), readPos - kChunkSize);
-    qint64 toRead = readPos - chunkStart;
-    file.seek(chunkStart);
-    QByteArray chunk = file.read(toRead);
-    tail.prepend(chunk);
-    readPos = chunkStart;
-    // Count newlines in this chunk
-    for (char c : chunk) {
-      if (c == '\n') ++newlineCount;
+Logger::ScrollbackPage Logger::loadScrollbackPage(const QString &network,
+                                                  const QString &channel,
+                                                  ScrollbackCursor before,
+                                                  int maxLines) const {
+  ScrollbackPage page;
+  // Lines still queued for the writer thread belong in the scrollback too,
+  // and the writer keeps the live log's index current.
+  queueHeld();
+  if (QFile::exists(logFilePath(network, channel)))
+    m_writer->ensureIndexed(network, channel);
+
+  ScrollbackCursor cur = before;
+  qint64 remaining = maxLines;
+  while (remaining > 0 && cur.file <= 1) {
+    QFile file(logFilePath(network, channel, cur.file));
+    QVector<LogIndex::Entry> entries;
+    qint64 lines = 0;
+    if (!file.open(QIODevice::ReadOnly) || !loadIndex(file, entries, lines)) {
+      cur = {cur.file + 1, -1};
+      continue;
     }
+    const qint64 end = cur.line < 0 ? lines : qMin(cur.line, lines);
+    const qint64 start = qMax<qint64>(0, end - remaining);
+    // Prepend: each pass reads an older stretch than the last
+    page.entries = readLines(file, entries, start, end) + page.entries;
+    remaining -= end - start;
+    cur = start > 0 ? ScrollbackCursor{cur.file, start}
+                    : ScrollbackCursor{cur.file + 1, -1};
   }
-  file.close();
-
-  // Split the tail into lines and take the last maxLines
-  QString text = QString::fromUtf8(tail);
-  QStringList allLines = text.split('\n', Qt::SkipEmptyParts);
-
-  int start = qMax(0, allLines.size() - maxLines);
-  for (int i = start; i < allLines.size(); ++i) {
-    const QString &line = allLines[i];
-    if (line.length() < 20)
-      continue; // skip malformed lines
-
-    LogEntry entry;
-    entry.timestamp = line.left(19); // "yyyy-MM-dd HH:mm:ss"
-
-    // Parse type: new format has " [type] ", old format has no brackets
-    int bracketOpen = line.indexOf('[', 20);
-    int bracketClose = (bracketOpen >= 0) ? line.indexOf(']', bracketOpen) : -1;
-    if (bracketOpen == 20 && bracketClose > bracketOpen) {
-      // New format: "yyyy-MM-dd HH:mm:ss [chat] <nick> message"
-      entry.type = line.mid(bracketOpen + 1, bracketClose - bracketOpen - 1);
-      entry.text = line.mid(bracketClose + 2); // skip "] "
-    } else {
-      // Old format: "yyyy-MM-dd HH:mm:ss <nick> message" — guess type
-      QString rest = line.mid(20);
-      if (rest.startsWith('<') || rest.startsWith('-'))
-        entry.type = QStringLiteral("chat");
-      else if (rest.startsWith('*'))
-        entry.type = QStringLiteral("action");
-      else
-        entry.type = QStringLiteral("system");
-      entry.text = rest;
+  page.next = cur;
+  page.atStart =
+      cur.file > 1 ||
+      (cur.file == 1 && !QFile::exists(logFilePath(network, channel, 1)));
+  return page;
+}
+
+Logger::ScrollbackPage Logger::loadScrollbackBefore(const QString &network,
+                                                    const QString &channel,
+                                                    qint64 msecs,
+                                                    int maxLines) const {
+  queueHeld();
+  if (QFile::exists(logFilePath(network, channel)))
+    m_writer->ensureIndexed(network, channel);
+
+  // Find the first line at or after msecs: binary search the index, then
+  // scan forward at most one stride.
+  ScrollbackCursor cursor;
+  for (int f = 0; f <= 1; ++f) {
+    QFile file(logFilePath(network, channel, f));
+    QVector<LogIndex::Entry> entries;
+    qint64 lines = 0;
+    if (!file.open(QIODevice::ReadOnly) || !loadIndex(file, entries, lines))
+      continue;
+    // Older than this whole file: look in the rotated backup instead
+    if (f == 0 && entries.first().msecs >= msecs &&
+        QFile::exists(logFilePath(network, channel, 1))) {
+      cursor = {1, -1};
+      continue;
     }
-    // Filter out noisy system messages from scrollback
-    if (entry.type == "system") {
-      const QString &t = entry.text;
-      if (t.startsWith("Now talking in ") || t.startsWith("Topic for ") ||
-          t.startsWith("*** Topic for ") || t.contains("Scrollback from ") ||
-          t.contains("End of scrollback") || t.startsWith("Connecting to "))
-        continue;
+    const LogIndex::Entry &from =
+        entries[LogIndex::lastBeforeMsecs(entries, msecs)];
+    qint64 line = from.line;
+    if (file.seek(from.offset)) {
+      while (!file.atEnd()) {
+        const qint64 ms = LogIndex::parseLineMsecs(chopEol(file.readLine()));
+        if (ms >= msecs)
+          break;
+        ++line;
+      }
     }
-    result.append(entry);
+    cursor = {f, line};
+    break;
   }
-  return result;
+  return loadScrollbackPage(network, channel, cursor, maxLines);
 }
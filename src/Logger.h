@@ -7,15 +7,30 @@
 #include <QDateTime>
 #include <QStandardPaths>
 #include <QVector>
+#include "LogWriter.h"
 
+// Per-channel text logs.  log() only queues the line; a LogWriter thread
+// formats and writes it, so logging never blocks the GUI thread on disk.
 class Logger : public QObject
 {
     Q_OBJECT
 public:
     explicit Logger(QObject *parent = nullptr);
+    ~Logger();
     void log(const QString &network, const QString &channel,
              const QString &type, const QString &message);
-    QString logDir() const;
+    // Block until every queued line has been written out.
+    void flush();
+    // Between holdLines() and releaseLines() (nestable), log() collects
+    // lines and the last release hands them to the writer in one go.
+    void holdLines();
+    void releaseLines();
+    // Make every line logged to the network so far searchable and queue
+    // catch-up of older logs (see LogSearchIndex).  Blocks for a flush;
+    // false while catch-up is still going.  Safe from a worker thread.
+    bool updateSearchIndex(const QString &network);
+    QString networkDir(const QString &network) const;
+    QString logDir() const { return m_logDir; }
 
     struct LogEntry {
         QString timestamp;
@@ -25,6 +40,35 @@ public:
     QVector<LogEntry> loadScrollback(const QString &network, const QString &channel,
                                       int maxLines = 200) const;
 
+    // ── Paged scrollback ──
+    // Seeks through the LogIndex sidecar, so each page costs a couple of
+    // seeks plus the lines returned, however long the log is.  Paging
+    // continues from <chan>.log into the rotated <chan>.log.1.
+    struct ScrollbackCursor {
+        int file = 0;     // 0 = <chan>.log, 1 = <chan>.log.1
+        qint64 line = -1; // load lines before this one; -1 = end of file
+    };
+    struct ScrollbackPage {
+        QVector<LogEntry> entries; // oldest first
+        ScrollbackCursor next;     // pass back in to get the page before
+        bool atStart = false;      // nothing older is logged
+    };
+    ScrollbackPage loadScrollbackPage(const QString &network, const QString &channel,
+                                      ScrollbackCursor before, int maxLines = 200) const;
+    // Up to maxLines lines logged before msecs ("jump to date").
+    ScrollbackPage loadScrollbackBefore(const QString &network, const QString &channel,
+                                        qint64 msecs, int maxLines = 200) const;
+
 private:
     QString logFilePath(const QString &network, const QString &channel) const;
+    QString logFilePath(const QString &network, const QString &channel,
+                        int file) const;
+    // Scrollback reads (GUI thread) queue held lines first, so they are
+    // never missing from what is read back
+    void queueHeld() const;
+
+    QString m_logDir;
+    LogWriter *m_writer = nullptr;
+    mutable QVector<LogWriter::Record> m_held;
+    int m_holdDepth = 0;
 };
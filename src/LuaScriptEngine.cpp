@@ -440,7 +440,7 @@ void LuaScriptEngine::onFileChanged(const QString &path)
 void LuaScriptEngine::command(const QString &cmd)
 {
     if (m_mgr)
-        m_mgr->sendMessage("", "/" + cmd);
+        m_mgr->sendBulkMessage(m_mgr->activeConnection(), "", "/" + cmd); // behind what the user types
 }
 
 void LuaScriptEngine::prnt(const QString &text)
@@ -1,10 +1,24 @@
 #include "MessageModel.h"
 #include "ImageDownloader.h"
+#include "IrcFormatter.h"
 #include <QRegularExpression>
 #include <QSettings>
+#include <QTextDocument>
 #include <QUrl>
 
-MessageModel::MessageModel(QObject *parent) : QAbstractListModel(parent) {
+namespace {
+static bool isCollapsibleEvent(const MessageModel::Message &msg);
+}
+
+// Enough for several screens of the row view and ChatDocument's trimmed
+// document; anything older is re-rendered if scrolled back to.
+static constexpr int kHtmlCacheLines = 4096;
+
+// Bumped whenever rendering inputs shared by all lines change
+static quint32 s_formatGeneration = 0;
+
+MessageModel::MessageModel(QObject *parent)
+    : QAbstractListModel(parent), m_htmlCache(kHtmlCacheLines) {
   connect(ImageDownloader::instance(), &ImageDownloader::imageReady, this,
           &MessageModel::onImageReady);
 }
@@ -27,7 +41,11 @@ QVariant MessageModel::data(const QModelIndex &index, int role) const {
   case TimestampRole:
     return msg.timestamp.toString(Qt::ISODate);
   case FormattedTextRole:
-    return msg.formattedText;
+    return formatted(msg);
+  case RowHtmlRole:
+    return rowHtml(index.row());
+  case CollapsedRole:
+    return isCollapsedRow(index.row());
   default:
     return {};
   }
@@ -39,12 +57,13 @@ QHash<int, QByteArray> MessageModel::roleNames() const {
   roles[TextRole] = "text";
   roles[TimestampRole] = "timestamp";
   roles[FormattedTextRole] = "formattedText";
+  roles[RowHtmlRole] = "rowHtml";
+  roles[CollapsedRole] = "collapsed";
   return roles;
 }
 
 void MessageModel::addMessage(const QString &type, const QString &text,
                               const QString &timestamp) {
-  beginInsertRows(QModelIndex(), m_messages.count(), m_messages.count());
   Message msg;
   msg.id = m_nextMessageId++;
   msg.type = type;
@@ -59,12 +78,58 @@ void MessageModel::addMessage(const QString &type, const QString &text,
     msg.timestamp = QDateTime::currentDateTime();
   }
 
-  msg.formattedText = formatLine(msg); // pre-render HTML once
-  m_messages.append(msg);
+  msg.highlight = m_highlightEnabled;
+  msg.collapsible = isCollapsibleEvent(msg);
+  // A batch load inside a hold goes straight in: reloaded() must find it
+  if (m_holdDepth > 0 && !m_batchMode) {
+    m_held.append(msg);
+    return;
+  }
+  appendRows({msg});
+}
+
+void MessageModel::holdAppends() { ++m_holdDepth; }
+
+void MessageModel::releaseAppends() {
+  if (m_holdDepth == 0 || --m_holdDepth > 0)
+    return;
+  appendHeld();
+}
+
+void MessageModel::appendHeld() {
+  if (m_held.isEmpty())
+    return;
+  QList<Message> rows;
+  rows.swap(m_held);
+  appendRows(rows);
+}
+
+void MessageModel::appendRows(const QList<Message> &rows) {
+  const int from = m_messages.size();
+  beginInsertRows(QModelIndex(), from, from + rows.size() - 1);
+  m_messages.append(rows);
+  m_lastRun = EventRun(); // the run at the end may have grown
   endInsertRows();
-  if (!m_batchMode)
-    emit messageAdded(msg.formattedText); // reuse cached text, no double format
+  // One repaint per event group the new rows joined
+  for (int row = from; row < m_messages.size(); ++row) {
+    int first, last;
+    if (m_messages.at(row).collapsible && eventGroupAt(row, &first, &last)) {
+      if (rows.size() == 1)
+        emitGroupChanged(row);
+      else
+        emit dataChanged(index(first), index(last),
+                         {RowHtmlRole, CollapsedRole});
+      row = last;
+    }
+  }
+  for (const Message &msg : rows) {
+    if (!m_batchMode)
+      emit messageAdded(formatted(msg)); // cached for the view's own lookup
+    fetchImages(msg);
+  }
+}
 
+void MessageModel::fetchImages(const Message &msg) {
   // Auto-download images for chat/action messages if enabled in preferences.
   // Static QSettings: Qt shares one cache per file within a process, so
   // writes from the QML Settings wrapper are visible here without re-reading
@@ -72,11 +137,17 @@ void MessageModel::addMessage(const QString &type, const QString &text,
   static QSettings prefs;
   bool showInlineImages =
       prefs.value(QStringLiteral("ui/showInlineImages"), true).toBool();
-  if (showInlineImages &&
-      (type == QLatin1String("chat") || type == QLatin1String("action"))) {
+  // Extension-less links cost a request each, aborted after the headers
+  // or first bytes unless they turn out to be images; not for scrollback
+  // loaded in a batch, which would send one per link on every switch
+  bool sniffLinks =
+      !m_batchMode &&
+      prefs.value(QStringLiteral("ui/sniffExtensionlessLinks"), true).toBool();
+  if (showInlineImages && (msg.type == QLatin1String("chat") ||
+                           msg.type == QLatin1String("action"))) {
     static const QRegularExpression urlRe(QStringLiteral(
         "(https?://[^\\s\\x02\\x03\\x04\\x0F\\x16\\x1D\\x1E\\x1F]+)"));
-    auto it = urlRe.globalMatch(text);
+    auto it = urlRe.globalMatch(msg.text);
     while (it.hasNext()) {
       QString url = it.next().captured(1);
       // Strip trailing punctuation
@@ -84,489 +155,33 @@ void MessageModel::addMessage(const QString &type, const QString &text,
              url.endsWith(':') || url.endsWith(')') || url.endsWith('\'') ||
              url.endsWith('"'))
         url.chop(1);
-      if (ImageDownloader::isImageUrl(url)) {
+      if (ImageDownloader::isImageUrl(url) ||
+          (sniffLinks && ImageDownloader::mightBeImageUrl(url))) {
         m_pendingImages.insert(url);
-        ImageDownloader::instance()->download(url);
+        ImageDownloader::instance()->fetchInline(url, this);
       }
     }
   }
 }
 
 void MessageModel::clear() {
+  m_held.clear();
   beginResetModel();
   m_messages.clear();
+  m_lastRun = EventRun();
   endResetModel();
+  m_htmlCache.clear();
   m_expandedGroups.clear();
   // Drop pending image downloads — otherwise an image requested in the
   // previous channel would embed into whichever channel is shown when the
   // download finishes.
   m_pendingImages.clear();
+  ImageDownloader::instance()->cancelFetches(this);
   emit cleared();
 }
 
-// Standard mIRC color palette (indices 0-15)
-static const char *mircColors[] = {
-    "#ffffff", "#000000",
-    "#00007f", "#009300", // 0-3: white, black, navy, green
-    "#ff0000", "#7f0000",
-    "#9c009c", "#fc7f00", // 4-7: red, brown, purple, orange
-    "#ffff00", "#00fc00",
-    "#009393", "#00ffff", // 8-11: yellow, lime, teal, cyan
-    "#0000fc", "#ff00ff",
-    "#7f7f7f", "#d2d2d2" // 12-15: blue, pink, grey, light grey
-};
-
-// Extended mIRC colors 16-98 (approximated)
-static QString mircColor(int idx) {
-  if (idx >= 0 && idx <= 15)
-    return QString::fromLatin1(mircColors[idx]);
-  // Extended colors 16-98: generate from standard 6x6x6 cube + greys
-  if (idx >= 16 && idx <= 87) {
-    int n = idx - 16;
-    int r = (n / 36) * 51;
-    int g = ((n / 6) % 6) * 51;
-    int b = (n % 6) * 51;
-    return QStringLiteral("#%1%2%3")
-        .arg(r, 2, 16, QLatin1Char('0'))
-        .arg(g, 2, 16, QLatin1Char('0'))
-        .arg(b, 2, 16, QLatin1Char('0'));
-  }
-  if (idx >= 88 && idx <= 98) {
-    int grey = (idx - 88) * 23 + 10;
-    return QStringLiteral("#%1%1%1").arg(grey, 2, 16, QLatin1Char('0'));
-  }
-  return QString();
-}
-
-// Strip literal HTML tags from incoming IRC text, but only real HTML tags.
-// IRC messages use <nick> patterns which must not be removed.
-// A "real" HTML tag has attributes (contains a space/slash) or matches a
-// known HTML element name.
-static const QSet<QString> s_htmlTagNames = {
-    "a",          "b",        "i",     "u",      "s",      "em",      "strong",
-    "span",       "div",      "p",     "br",     "hr",     "img",     "font",
-    "small",      "big",      "sub",   "sup",    "ul",     "ol",      "li",
-    "table",      "tr",       "td",    "th",     "thead",  "tbody",   "h1",
-    "h2",         "h3",       "h4",    "h5",     "h6",     "pre",     "code",
-    "blockquote", "script",   "style", "html",   "head",   "body",    "meta",
-    "link",       "title",    "input", "button", "form",   "label",   "select",
-    "option",     "textarea", "nav",   "header", "footer", "section", "article",
-    "aside",      "main"};
-
-static bool isHtmlTag(const QString &tagContent) {
-  if (tagContent.isEmpty())
-    return false;
-  // Closing tag: </tagname>
-  QString inner = tagContent;
-  if (inner.startsWith('/'))
-    inner = inner.mid(1);
-  // Get the tag name (up to first space or end)
-  int spacePos = inner.indexOf(' ');
-  QString tagName = (spacePos >= 0) ? inner.left(spacePos) : inner;
-  tagName = tagName.toLower();
-  // Only treat it as HTML if the tag name is a known element — with or
-  // without attributes.  Requiring the name match prevents eating user text
-  // like "<3 you>" or pasted generics like "<QMap K, V>".
-  return s_htmlTagNames.contains(tagName);
-}
-
-static QString stripHtmlTags(const QString &text) {
-  if (!text.contains(QLatin1Char('<')))
-    return text;
-
-  QString result;
-  result.reserve(text.size());
-  int i = 0;
-  int len = text.size();
-  while (i < len) {
-    if (text[i] == '<') {
-      // Find the closing >
-      int end = text.indexOf('>', i + 1);
-      if (end < 0) {
-        // No closing >, keep everything as-is
-        result += text.mid(i);
-        break;
-      }
-      QString tagContent = text.mid(i + 1, end - i - 1).trimmed();
-      if (isHtmlTag(tagContent)) {
-        // Skip this tag entirely
-        i = end + 1;
-      } else {
-        // Not an HTML tag (e.g. IRC nick like <blondie>) — keep it
-        result += text[i];
-        i++;
-      }
-    } else {
-      result += text[i];
-      i++;
-    }
-  }
-  return result;
-}
-
-// Wrap emoji grapheme clusters with an explicit emoji-capable fallback stack.
-// This keeps the main chat font intact (including monospace) while ensuring
-// emoji symbols render with available color/emoji fonts.
-static bool isEmojiBaseCodepoint(char32_t cp) {
-  if (cp >= 0x1F300 && cp <= 0x1FAFF)
-    return true;
-  if (cp >= 0x1F1E6 && cp <= 0x1F1FF)
-    return true; // regional indicators (flags)
-  if (cp >= 0x2600 && cp <= 0x27BF)
-    return true;
-  if (cp >= 0x2300 && cp <= 0x23FF)
-    return true;
-  if (cp == 0x00A9 || cp == 0x00AE || cp == 0x203C || cp == 0x2049 ||
-      cp == 0x2122 || cp == 0x2139 || cp == 0x3030 || cp == 0x303D ||
-      cp == 0x3297 || cp == 0x3299)
-    return true;
-  return false;
-}
-
-static bool isEmojiJoinerOrModifier(char32_t cp) {
-  return cp == 0x200D || cp == 0xFE0E || cp == 0xFE0F || cp == 0x20E3 ||
-         (cp >= 0x1F3FB && cp <= 0x1F3FF);
-}
-
-static QString wrapEmojiWithFontFallback(const QString &html) {
-  static const QString kEmojiSpanPrefix = QStringLiteral(
-      "<span style=\"font-family:'Noto Color Emoji','Segoe UI Emoji','Apple "
-      "Color Emoji','Noto Emoji';\">");
-  static const QString kEmojiSpanSuffix = QStringLiteral("</span>");
-
-  QString out;
-  out.reserve(html.size() + 64);
-
-  auto appendCodepoint = [&out](char32_t cp) {
-    if (cp <= 0xFFFF) {
-      out += QChar(static_cast<ushort>(cp));
-    } else {
-      cp -= 0x10000;
-      const ushort hi = static_cast<ushort>(0xD800 + ((cp >> 10) & 0x3FF));
-      const ushort lo = static_cast<ushort>(0xDC00 + (cp & 0x3FF));
-      out += QChar(hi);
-      out += QChar(lo);
-    }
-  };
-
-  int i = 0;
-  while (i < html.size()) {
-    const QChar ch = html.at(i);
-
-    // Preserve HTML tags/entities verbatim.
-    if (ch == QLatin1Char('<')) {
-      const int end = html.indexOf(QLatin1Char('>'), i + 1);
-      if (end < 0) {
-        out += html.mid(i);
-        break;
-      }
-      out += html.mid(i, end - i + 1);
-      i = end + 1;
-      continue;
-    }
-    if (ch == QLatin1Char('&')) {
-      const int end = html.indexOf(QLatin1Char(';'), i + 1);
-      if (end > i) {
-        out += html.mid(i, end - i + 1);
-        i = end + 1;
-        continue;
-      }
-    }
-
-    char32_t cp = ch.unicode();
-    int cpLen = 1;
-    if (ch.isHighSurrogate() && i + 1 < html.size() &&
-        html.at(i + 1).isLowSurrogate()) {
-      cp = QChar::surrogateToUcs4(ch, html.at(i + 1));
-      cpLen = 2;
-    }
-
-    if (!isEmojiBaseCodepoint(cp)) {
-      out += html.mid(i, cpLen);
-      i += cpLen;
-      continue;
-    }
-
-    out += kEmojiSpanPrefix;
-    appendCodepoint(cp);
-    i += cpLen;
-
-    // Include ZWJ/VS/modifier-linked continuation codepoints in one span.
-    while (i < html.size()) {
-      const QChar n = html.at(i);
-      if (n == QLatin1Char('<') || n == QLatin1Char('&'))
-        break;
-
-      char32_t ncp = n.unicode();
-      int nLen = 1;
-      if (n.isHighSurrogate() && i + 1 < html.size() &&
-          html.at(i + 1).isLowSurrogate()) {
-        ncp = QChar::surrogateToUcs4(n, html.at(i + 1));
-        nLen = 2;
-      }
-
-      if (!isEmojiJoinerOrModifier(ncp) && !isEmojiBaseCodepoint(ncp))
-        break;
-
-      appendCodepoint(ncp);
-      i += nLen;
-    }
-
-    out += kEmojiSpanSuffix;
-  }
-
-  return out;
-}
-
-QString MessageModel::ircToHtml(const QString &text) {
-  // Strip any literal HTML tags first (relay bots sometimes embed HTML)
-  const QString stripped = stripHtmlTags(text);
-
-  // HTML-escape first
-  QString escaped;
-  escaped.reserve(stripped.size() * 1.2);
-  for (const QChar &ch : stripped) {
-    if (ch == '<')
-      escaped += "&lt;";
-    else if (ch == '>')
-      escaped += "&gt;";
-    else if (ch == '&')
-      escaped += "&amp;";
-    else if (ch == '"')
-      escaped += "&quot;";
-    else
-      escaped += ch;
-  }
-
-  // Parse IRC formatting codes and convert to HTML
-  QString result;
-  result.reserve(escaped.size() * 1.5);
-
-  bool bold = false, italic = false, underline = false, strikethrough = false;
-  QString fgColor, bgColor;
-  int openFonts = 0;
-
-  auto closeAllFonts = [&]() {
-    for (int s = 0; s < openFonts; s++)
-      result += "</font>";
-    openFonts = 0;
-  };
-
-  auto openColorFont = [&]() {
-    if (fgColor.isEmpty() && bgColor.isEmpty())
-      return;
-    if (!fgColor.isEmpty()) {
-      result += "<font color=\"" + fgColor + "\">";
-      openFonts++;
-    }
-  };
-
-  int i = 0;
-  int len = escaped.length();
-  while (i < len) {
-    QChar ch = escaped[i];
-    ushort code = ch.unicode();
-
-    if (code == 0x02) { // Bold
-      if (bold)
-        result += "</b>";
-      else
-        result += "<b>";
-      bold = !bold;
-      i++;
-    } else if (code == 0x1D) { // Italic
-      if (italic)
-        result += "</i>";
-      else
-        result += "<i>";
-      italic = !italic;
-      i++;
-    } else if (code == 0x1F) { // Underline
-      if (underline)
-        result += "</u>";
-      else
-        result += "<u>";
-      underline = !underline;
-      i++;
-    } else if (code == 0x1E) { // Strikethrough
-      if (strikethrough)
-        result += "</s>";
-      else
-        result += "<s>";
-      strikethrough = !strikethrough;
-      i++;
-    } else if (code == 0x16) { // Reverse — swap fg/bg
-      closeAllFonts();
-      std::swap(fgColor, bgColor);
-      if (fgColor.isEmpty() && !bgColor.isEmpty())
-        fgColor = "#000000";
-      openColorFont();
-      i++;
-    } else if (code == 0x0F) { // Reset
-      closeAllFonts();
-      if (bold) {
-        result += "</b>";
-        bold = false;
-      }
-      if (italic) {
-        result += "</i>";
-        italic = false;
-      }
-      if (underline) {
-        result += "</u>";
-        underline = false;
-      }
-      if (strikethrough) {
-        result += "</s>";
-        strikethrough = false;
-      }
-      fgColor.clear();
-      bgColor.clear();
-      i++;
-    } else if (code == 0x03) { // Color: \x03FG[,BG]
-      i++;                     // skip \x03
-      closeAllFonts();
-
-      // Parse foreground color number (1-2 digits)
-      int fg = -1, bg = -1;
-      if (i < len && escaped[i].isDigit()) {
-        fg = escaped[i].digitValue();
-        i++;
-        if (i < len && escaped[i].isDigit()) {
-          fg = fg * 10 + escaped[i].digitValue();
-          i++;
-        }
-        // Parse optional background
-        if (i < len && escaped[i] == ',') {
-          i++; // skip comma
-          if (i < len && escaped[i].isDigit()) {
-            bg = escaped[i].digitValue();
-            i++;
-            if (i < len && escaped[i].isDigit()) {
-              bg = bg * 10 + escaped[i].digitValue();
-              i++;
-            }
-          }
-        }
-      }
-
-      if (fg >= 0) {
-        fgColor = mircColor(fg);
-        if (bg >= 0)
-          bgColor = mircColor(bg);
-      } else {
-        // Bare \x03 resets color
-        fgColor.clear();
-        bgColor.clear();
-      }
-      openColorFont();
-    } else if (code == 0x04) { // Hex color: \x04RRGGBB[,RRGGBB]
-      i++;                     // skip \x04
-      closeAllFonts();
-      // Parse 6-char hex fg
-      if (i + 5 < len) {
-        bool ok;
-        QString hexFg = escaped.mid(i, 6);
-        hexFg.toInt(&ok, 16);
-        if (ok) {
-          fgColor = "#" + hexFg;
-          i += 6;
-          if (i < len && escaped[i] == ',') {
-            i++;
-            if (i + 5 < len) {
-              QString hexBg = escaped.mid(i, 6);
-              hexBg.toInt(&ok, 16);
-              if (ok) {
-                bgColor = "#" + hexBg;
-                i += 6;
-              }
-            }
-          }
-        }
-      }
-      openColorFont();
-    } else if (code == 0x11) { // Monospace
-      // Not widely used; skip the control char
-      i++;
-    } else {
-      result += ch;
-      i++;
-    }
-  }
-
-  // Close remaining tags
-  closeAllFonts();
-  if (bold)
-    result += "</b>";
-  if (italic)
-    result += "</i>";
-  if (underline)
-    result += "</u>";
-  if (strikethrough)
-    result += "</s>";
-
-  return wrapEmojiWithFontFallback(result);
-}
-
-// ── URL linkification ──
-// Runs as a post-pass on the HTML output from ircToHtml().
-// Detects http/https URLs in text content and wraps them in <a> tags.
-QString MessageModel::linkifyUrls(const QString &html) {
-  // Match URLs that are NOT already inside an HTML tag (our tags only use
-  // style attributes with color/background values, never http URLs).
-  static const QRegularExpression re(QStringLiteral("(https?://[^\\s<\"]+)"));
-
-  QString result;
-  result.reserve(html.size() + 256);
-  int lastPos = 0;
-
-  auto it = re.globalMatch(html);
-  while (it.hasNext()) {
-    auto m = it.next();
-    QString url = m.captured(1);
-
-    // Strip trailing HTML entities that were part of surrounding text
-    while (url.endsWith(QLatin1String("&amp;")) ||
-           url.endsWith(QLatin1String("&lt;")) ||
-           url.endsWith(QLatin1String("&gt;"))) {
-      if (url.endsWith(QLatin1String("&amp;")))
-        url.chop(5);
-      else
-        url.chop(4);
-    }
-    // Strip trailing punctuation
-    while (url.endsWith('.') || url.endsWith(',') || url.endsWith(';') ||
-           url.endsWith(':') || url.endsWith(')') || url.endsWith('\''))
-      url.chop(1);
-
-    result += html.mid(lastPos, m.capturedStart(1) - lastPos);
-
-    // Restore HTML entities for the href attribute
-    QString href = url;
-    href.replace(QLatin1String("&amp;"), QLatin1String("&"));
-    href.replace(QLatin1String("&lt;"), QLatin1String("<"));
-    href.replace(QLatin1String("&gt;"), QLatin1String(">"));
-    href.replace(QLatin1String("&quot;"), QLatin1String("\""));
-
-    // Build the link
-    result += QStringLiteral("<a href=\"") + href.toHtmlEscaped() +
-              QStringLiteral(
-                  "\" style=\"color:#4fc3f7; text-decoration:underline;\">") +
-              url + QStringLiteral("</a>");
-
-    // For video URLs, add a label
-    if (ImageDownloader::isVideoUrl(href)) {
-      result += QStringLiteral(" <font color=\"#4fc3f7\">&#9654; Video</font>");
-    }
-
-    lastPos = m.capturedStart(1) + url.length();
-  }
-  result += html.mid(lastPos);
-  return result;
-}
-
 // ── Image download callback ──
-void MessageModel::onImageReady(const QString &url, const QString &localPath,
+void MessageModel::onImageReady(const QString &url, const QString &source,
                                 int width, int height) {
   if (!m_pendingImages.contains(url))
     return;
@@ -577,7 +192,7 @@ void MessageModel::onImageReady(const QString &url, const QString &localPath,
 
   // Build an embed message with clickable image
   QString html = QStringLiteral("<a href=\"") + url.toHtmlEscaped() +
-                 QStringLiteral("\"><img src=\"file://") + localPath +
+                 QStringLiteral("\"><img src=\"") + source +
                  QStringLiteral("\" width=\"%1\" height=\"%2\"></a>")
                      .arg(displayW)
                      .arg(displayH);
@@ -589,68 +204,27 @@ void MessageModel::onImageReady(const QString &url, const QString &localPath,
   msg.text = html;
   msg.timestamp = QDateTime::currentDateTime();
   m_messages.append(msg);
+  m_lastRun = EventRun();
   endInsertRows();
   emit messageAdded(html);
 }
 
-// ── Nick colorization ──
-// 16 distinct nick colors – dark palette (bright on dark bg)
-static const char *nickPaletteDark[] = {
-    "#c678dd", // purple
-    "#e06c75", // red
-    "#98c379", // green
-    "#e5c07b", // yellow
-    "#61afef", // blue
-    "#56b6c2", // cyan
-    "#be5046", // dark red
-    "#d19a66", // orange
-    "#ff79c6", // pink
-    "#50fa7b", // bright green
-    "#8be9fd", // bright cyan
-    "#bd93f9", // lavender
-    "#ffb86c", // light orange
-    "#ff5555", // bright red
-    "#69ff94", // mint
-    "#f1fa8c", // light yellow
-};
-// 16 distinct nick colors – light palette (dark/saturated on light bg)
-static const char *nickPaletteLight[] = {
-    "#7b2fa0", // purple
-    "#b5182e", // red
-    "#3a7d1a", // green
-    "#9e7c16", // dark yellow
-    "#1a5fb4", // blue
-    "#1a8a7d", // teal
-    "#8b2d1a", // dark red
-    "#a85600", // orange
-    "#c4246e", // pink
-    "#1d8348", // forest green
-    "#0e6f87", // dark cyan
-    "#6a3daa", // dark lavender
-    "#b46a00", // dark orange
-    "#cc2222", // bright red
-    "#127a3a", // dark mint
-    "#887a09", // olive
-};
-static const int nickColorCount = 16;
 static bool s_darkMode = true;
 
-void MessageModel::setDarkMode(bool dark) { s_darkMode = dark; }
+void MessageModel::setDarkMode(bool dark) {
+  if (s_darkMode == dark)
+    return;
+  s_darkMode = dark;
+  ++s_formatGeneration;
+  if (!m_messages.isEmpty())
+    emit dataChanged(index(0), index(m_messages.size() - 1),
+                     {FormattedTextRole, RowHtmlRole});
+}
 
 void MessageModel::setNickname(const QString &nick) { m_nickname = nick; }
 
 bool MessageModel::containsNickWord(const QString &text, const QString &nick) {
-  if (nick.isEmpty())
-    return false;
-  // Characters that can appear in an IRC nick (RFC 2812 + common extensions);
-  // a mention is the nick NOT surrounded by these on either side.
-  static const QString nickChars =
-      QStringLiteral("A-Za-z0-9_\\-\\[\\]\\\\`^{}|");
-  const QRegularExpression re(
-      QStringLiteral("(?<![%1])%2(?![%1])")
-          .arg(nickChars, QRegularExpression::escape(nick)),
-      QRegularExpression::CaseInsensitiveOption);
-  return re.match(text).hasMatch();
+  return IrcFormatter::containsNickWord(text, nick);
 }
 
 void MessageModel::setHighlightEnabled(bool enabled) {
@@ -658,86 +232,14 @@ void MessageModel::setHighlightEnabled(bool enabled) {
 }
 
 void MessageModel::setTimestampFormat(const QString &fmt) {
-  m_timestampFormat = fmt.isEmpty() ? QStringLiteral("hh:mm:ss") : fmt;
-}
-
-QString MessageModel::nickColor(const QString &nick) {
-  // DJB2 hash for consistent color assignment
-  uint hash = 5381;
-  for (const QChar &c : nick)
-    hash = ((hash << 5) + hash) + c.toLower().unicode();
-  const char **palette = s_darkMode ? nickPaletteDark : nickPaletteLight;
-  return QString::fromLatin1(palette[hash % nickColorCount]);
-}
-
-// Finds <nick> and <@nick> patterns in HTML-escaped text and wraps them
-// in colored, clickable <a> tags with nick:// scheme.
-// Also handles action lines: "* nick ..." at the start.
-QString MessageModel::colorizeNicks(const QString &html) {
-  // Match: &lt;[prefix]nick&gt; — the < > are HTML-escaped by ircToHtml
-  // The nick part must NOT contain < or > (which would indicate we're
-  // spanning across HTML tags from mIRC color wrapping)
-  // Channel mode prefixes: ~ (owner), & (admin/protected), @ (op), % (halfop), + (voice)
-  // Use alternation to match &amp; as a complete entity, not individual chars
-  static const QRegularExpression nickRe(
-      QStringLiteral("&lt;((?:~|&amp;|@|%|\\+)*)([^&<>]+?)&gt;"));
-
-  QString result;
-  result.reserve(html.size() + 256);
-  int lastPos = 0;
-
-  auto it = nickRe.globalMatch(html);
-  while (it.hasNext()) {
-    auto m = it.next();
-
-    // Extra safety: if the matched region contains any HTML tags, skip it
-    QString matched = m.captured(0);
-    if (matched.contains(QLatin1Char('<')) ||
-        matched.contains(QLatin1Char('>'))) {
-      result += html.mid(lastPos, m.capturedEnd() - lastPos);
-      lastPos = m.capturedEnd();
-      continue;
-    }
-
-    result += html.mid(lastPos, m.capturedStart() - lastPos);
-
-    QString prefix = m.captured(1);
-    QString bareNick = m.captured(2);
-    // Unescape &amp; back to & in prefix (e.g. &amp; for & prefix)
-    prefix.replace(QLatin1String("&amp;"), QLatin1String("&"));
-    QString color = nickColor(bareNick);
-
-    // Re-escape the prefix for HTML output
-    QString escapedPrefix = prefix;
-    escapedPrefix.replace(QLatin1String("&"), QLatin1String("&amp;"));
-    
-    result += QStringLiteral("&lt;") + escapedPrefix +
-              QStringLiteral("<a href=\"nick://") + bareNick.toHtmlEscaped() +
-              QStringLiteral("\" style=\"color:") + color +
-              QStringLiteral("; text-decoration:none; font-weight:bold;\">") +
-              bareNick.toHtmlEscaped() + QStringLiteral("</a>") +
-              QStringLiteral("&gt;");
-
-    lastPos = m.capturedEnd();
-  }
-  result += html.mid(lastPos);
-
-  // Also colorize action nicks: "* nick " at line start
-  // Pattern: after "* " at start, the next word is the nick
-  static const QRegularExpression actionRe(QStringLiteral("^(\\* )([^\\s<]+)"));
-  auto am = actionRe.match(result);
-  if (am.hasMatch()) {
-    QString actionNick = am.captured(2);
-    QString color = nickColor(actionNick);
-    QString replacement =
-        am.captured(1) + QStringLiteral("<a href=\"nick://") +
-        actionNick.toHtmlEscaped() + QStringLiteral("\" style=\"color:") +
-        color + QStringLiteral("; text-decoration:none; font-weight:bold;\">") +
-        actionNick.toHtmlEscaped() + QStringLiteral("</a>");
-    result = replacement + result.mid(am.capturedEnd());
-  }
-
-  return result;
+  const QString format = fmt.isEmpty() ? QStringLiteral("hh:mm:ss") : fmt;
+  if (m_timestampFormat == format)
+    return;
+  m_timestampFormat = format;
+  ++s_formatGeneration;
+  if (!m_messages.isEmpty())
+    emit dataChanged(index(0), index(m_messages.size() - 1),
+                     {FormattedTextRole, RowHtmlRole});
 }
 
 QString MessageModel::formatLineFromQml(const QString &text,
@@ -749,60 +251,76 @@ QString MessageModel::formatLineFromQml(const QString &text,
   msg.timestamp = QDateTime::fromString(timestamp, Qt::ISODate);
   if (!msg.timestamp.isValid())
     msg.timestamp = QDateTime::currentDateTime();
+  msg.highlight = m_highlightEnabled;
   return formatLine(msg);
 }
 
+QString MessageModel::formatted(const Message &msg) const {
+  const CachedHtml *cached = m_htmlCache.object(msg.id);
+  if (cached && cached->generation == s_formatGeneration)
+    return cached->html;
+  QString html = formatLine(msg);
+  m_htmlCache.insert(msg.id, new CachedHtml{html, s_formatGeneration, {}, false});
+  return html;
+}
+
+// What a RichText TextEdit shows for html, as selection and search see it
+static QString htmlToPlainText(const QString &html) {
+  QTextDocument doc;
+  doc.setHtml(html);
+  return doc.toPlainText();
+}
+
+QString MessageModel::formattedPlain(const Message &msg) const {
+  formatted(msg); // brings the cache entry up to date
+  CachedHtml *cached = m_htmlCache.object(msg.id);
+  if (!cached)
+    return htmlToPlainText(formatLine(msg));
+  if (!cached->hasPlain) {
+    cached->plain = htmlToPlainText(cached->html);
+    cached->hasPlain = true;
+  }
+  return cached->plain;
+}
+
 QString MessageModel::formatLine(const Message &msg) const {
   // Embed messages are pre-formatted HTML — pass through
   if (msg.type == QLatin1String("embed"))
     return msg.text;
 
-  QString ts = QStringLiteral("<font color=\"#888888\">[") +
-               msg.timestamp.toString(m_timestampFormat) +
-               QStringLiteral("]</font> ");
-  QString prefix;
+  const QString ts = QStringLiteral("<font color=\"#888888\">[") +
+                     msg.timestamp.toString(m_timestampFormat) +
+                     QStringLiteral("]</font> ");
+  QLatin1String prefix;
   if (msg.type == QLatin1String("system"))
-    prefix = QStringLiteral("<font color=\"#888888\">*** </font>");
+    prefix = QLatin1String("<font color=\"#888888\">*** </font>");
   else if (msg.type == QLatin1String("action"))
-    prefix = QStringLiteral("<font color=\"#ce9178\">* </font>");
+    prefix = QLatin1String("<font color=\"#ce9178\">* </font>");
   else if (msg.type == QLatin1String("error"))
-    prefix = QStringLiteral("<font color=\"#f44747\">! </font>");
-
-  QString htmlBody = linkifyUrls(colorizeNicks(ircToHtml(msg.text)));
-
-  // Highlight other people's chat messages that mention our nick
-  bool isHighlight = false;
-  if (m_highlightEnabled && !m_nickname.isEmpty() &&
-      msg.type == QLatin1String("chat")) {
-    // Extract sender nick from "<[+@~&%]nick> ..." format
-    int lt = msg.text.indexOf(QLatin1Char('<'));
-    int gt = msg.text.indexOf(QLatin1Char('>'));
-    if (lt >= 0 && gt > lt) {
-      QString senderRaw = msg.text.mid(lt + 1, gt - lt - 1);
-      // Strip mode prefixes (+, @, ~, &, %)
-      while (!senderRaw.isEmpty() &&
-             (senderRaw[0] == '+' || senderRaw[0] == '@' ||
-              senderRaw[0] == '~' || senderRaw[0] == '&' ||
-              senderRaw[0] == '%'))
-        senderRaw = senderRaw.mid(1);
-
-      // Only highlight if the sender is NOT us
-      if (senderRaw.compare(m_nickname, Qt::CaseInsensitive) != 0) {
-        // Check the body after the <nick> prefix for our nick (whole word)
-        QString msgBody = msg.text.mid(gt + 1);
-        isHighlight = containsNickWord(msgBody, m_nickname);
-      }
-    }
-  }
-
-  if (isHighlight) {
-    return QStringLiteral("<span style=\"background-color:#3a2a00;\">") + ts +
-           prefix + htmlBody +
-           QStringLiteral("</span>") +
-           QStringLiteral("<span style=\"background-color:transparent;\">&#8203;</span>");
+    prefix = QLatin1String("<font color=\"#f44747\">! </font>");
+
+  // Highlight other people's chat messages that mention our nick; the
+  // formatter finds the mention during the same scan.
+  IrcFormatter::Options opt;
+  opt.darkPalette = s_darkMode;
+  if (msg.highlight && msg.type == QLatin1String("chat"))
+    opt.mentionNick = m_nickname;
+
+  static const QLatin1String highlightOpen(
+      "<span style=\"background-color:#3a2a00;\">");
+  static const QLatin1String highlightClose(
+      "</span><span style=\"background-color:transparent;\">&#8203;</span>");
+
+  QString body;
+  body.reserve(highlightOpen.size() + ts.size() + prefix.size() +
+               msg.text.size() * 2 + highlightClose.size());
+  body += ts;
+  body += prefix;
+  if (IrcFormatter::appendHtml(msg.text, body, opt)) {
+    body.insert(0, highlightOpen);
+    body += highlightClose;
   }
-
-  return ts + prefix + htmlBody;
+  return body;
 }
 
 // ─── Event-collapse helpers ──────────────────────────────────────────────────
@@ -827,6 +345,13 @@ static bool isCollapsibleEvent(const MessageModel::Message &msg) {
   return classifyEvent(msg.text, nick) != EventKind::Unknown;
 }
 
+static constexpr int kCollapseThreshold = 3;
+
+static bool collapseEventsEnabled() {
+  static QSettings prefs; // shared per-process QSettings cache
+  return prefs.value(QStringLiteral("ui/collapseEvents"), true).toBool();
+}
+
 static QString makeEventGroupHtml(const QList<MessageModel::Message> &msgs,
                                    int from, int count, int groupId, bool expanded) {
   QStringList joins, parts, quits, kicks, nicks;
@@ -883,22 +408,139 @@ void MessageModel::toggleEventGroup(int groupId) {
   } else {
     m_expandedGroups.insert(groupId);
   }
+  // Recent groups are the ones being clicked
+  for (int row = m_messages.size() - 1; row >= 0; --row) {
+    if (m_messages.at(row).id == groupId) {
+      int first, last;
+      if (eventGroupAt(row, &first, &last))
+        emit dataChanged(index(first), index(last),
+                         {RowHtmlRole, CollapsedRole});
+      break;
+    }
+  }
+}
+
+bool MessageModel::eventGroupAt(int row, int *first, int *last) const {
+  if (!m_messages.at(row).collapsible || !collapseEventsEnabled())
+    return false;
+  // Rows are asked for in order (a view painting, a search, a selection),
+  // so the run found last time usually holds this one too
+  EventRun &run = m_lastRun;
+  if (run.firstId < 0 || row < run.first || row > run.last ||
+      run.last >= m_messages.size() ||
+      m_messages.at(run.first).id != run.firstId) {
+    int i = row;
+    int j = row;
+    while (i > 0 && m_messages.at(i - 1).collapsible)
+      --i;
+    while (j + 1 < m_messages.size() && m_messages.at(j + 1).collapsible)
+      ++j;
+    run = {m_messages.at(i).id, i, j};
+  }
+  if (run.last - run.first + 1 < kCollapseThreshold)
+    return false;
+  *first = run.first;
+  *last = run.last;
+  return true;
+}
+
+// The group's summary rides on its first row; when expanded every member
+// shows its own indented line, when collapsed the other rows are hidden.
+QString MessageModel::rowHtml(int row) const {
+  const Message &msg = m_messages.at(row);
+  int first, last;
+  if (!eventGroupAt(row, &first, &last))
+    return formatted(msg);
+  const int gid = m_messages.at(first).id;
+  const bool expanded = m_expandedGroups.contains(gid);
+  const QString line =
+      expanded ? QStringLiteral("&nbsp;&nbsp;&nbsp;&nbsp;") + formatted(msg)
+               : QString();
+  if (row != first)
+    return line;
+  const QString summary =
+      makeEventGroupHtml(m_messages, first, last - first + 1, gid, expanded);
+  return expanded ? summary + QStringLiteral("<br>") + line : summary;
+}
+
+bool MessageModel::isCollapsedRow(int row) const {
+  int first, last;
+  return eventGroupAt(row, &first, &last) && row != first &&
+         !m_expandedGroups.contains(m_messages.at(first).id);
+}
+
+// A system event landed next to others.  The run's first row carries the
+// summary; when the run has just reached the threshold all of it changes.
+void MessageModel::emitGroupChanged(int row) {
+  int first, last;
+  if (!eventGroupAt(row, &first, &last))
+    return;
+  const int to = last - first + 1 == kCollapseThreshold ? last : first;
+  emit dataChanged(index(first), index(to), {RowHtmlRole, CollapsedRole});
+}
+
+QString MessageModel::plainText(int row) const {
+  if (row < 0 || row >= m_messages.size())
+    return QString();
+  const Message &msg = m_messages.at(row);
+  int first, last;
+  if (!eventGroupAt(row, &first, &last))
+    return formattedPlain(msg);
+  // rowHtml()'s layout: the indent is four no-break spaces, which plain
+  // text turns into spaces, and only the summary needs parsing
+  const bool expanded = m_expandedGroups.contains(m_messages.at(first).id);
+  const QString line =
+      expanded ? QStringLiteral("    ") + formattedPlain(msg) : QString();
+  if (row != first)
+    return line;
+  const QString summary = htmlToPlainText(makeEventGroupHtml(
+      m_messages, first, last - first + 1, m_messages.at(first).id, expanded));
+  return expanded ? summary + QLatin1Char('\n') + line : summary;
+}
+
+QString MessageModel::selectedText(int fromRow, int fromPos, int toRow,
+                                   int toPos) const {
+  fromRow = qMax(fromRow, 0);
+  toRow = qMin(toRow, int(m_messages.size()) - 1);
+  QStringList lines;
+  for (int row = fromRow; row <= toRow; ++row) {
+    if (isCollapsedRow(row))
+      continue;
+    const QString text = plainText(row);
+    const int from = row == fromRow ? qBound(0, fromPos, int(text.size())) : 0;
+    const int to = row == toRow ? qBound(from, toPos, int(text.size()))
+                                : int(text.size());
+    lines.append(text.mid(from, to - from));
+  }
+  return lines.join(QLatin1Char('\n'));
+}
+
+int MessageModel::findRow(const QString &text, bool caseSensitive,
+                          int before) const {
+  if (text.isEmpty())
+    return -1;
+  const Qt::CaseSensitivity cs =
+      caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+  const int count = m_messages.size();
+  int row = before < 0 || before > count ? count : before;
+  while (--row >= 0) {
+    if (!isCollapsedRow(row) && plainText(row).contains(text, cs))
+      return row;
+  }
+  return -1;
 }
 
 QString MessageModel::allFormattedText() const {
-  static const int kCollapseThreshold = 3;
-  static QSettings prefs;  // shared per-process QSettings cache
-  const bool collapseEvents =
-      prefs.value(QStringLiteral("ui/collapseEvents"), true).toBool();
+  const bool collapseEvents = collapseEventsEnabled();
 
   QStringList result;
   result.reserve(m_messages.size());
 
   int i = 0;
   while (i < m_messages.size()) {
-    if (collapseEvents && isCollapsibleEvent(m_messages.at(i))) {
+    if (collapseEvents && m_messages.at(i).collapsible) {
       int j = i + 1;
-      while (j < m_messages.size() && isCollapsibleEvent(m_messages.at(j)))
+      while (j < m_messages.size() && m_messages.at(j).collapsible)
         ++j;
       const int count = j - i;
       if (count >= kCollapseThreshold) {
@@ -911,16 +553,16 @@ QString MessageModel::allFormattedText() const {
         if (expanded) {
           for (int k = i; k < j; ++k) {
             // Indent the individual lines
-            result.append(QStringLiteral("&nbsp;&nbsp;&nbsp;&nbsp;") + m_messages.at(k).formattedText);
+            result.append(QStringLiteral("&nbsp;&nbsp;&nbsp;&nbsp;") + formatted(m_messages.at(k)));
           }
         }
       } else {
         for (int k = i; k < j; ++k)
-          result.append(m_messages.at(k).formattedText);
+          result.append(formatted(m_messages.at(k)));
       }
       i = j;
     } else {
-      result.append(m_messages.at(i).formattedText);
+      result.append(formatted(m_messages.at(i)));
       ++i;
     }
   }
@@ -928,6 +570,7 @@ QString MessageModel::allFormattedText() const {
 }
 
 void MessageModel::beginBatch() {
+  appendHeld(); // rows held from before the load go in first
   m_batchMode = true;
 }
 
@@ -935,3 +578,45 @@ void MessageModel::endBatch() {
   m_batchMode = false;
   emit reloaded();
 }
+
+void MessageModel::prependMessages(const QList<Entry> &entries) {
+  if (entries.isEmpty())
+    return;
+  // Held rows are newer than anything here; put them in first so the
+  // seam logic below sees the rows that are really there
+  appendHeld();
+  QList<Message> older;
+  older.reserve(entries.size());
+  for (const Entry &e : entries) {
+    Message msg;
+    msg.id = m_nextMessageId++;
+    msg.type = e.type;
+    msg.text = e.text;
+    msg.timestamp = QDateTime::fromString(e.timestamp, Qt::ISODate);
+    if (!msg.timestamp.isValid())
+      msg.timestamp = QDateTime::currentDateTime();
+    // highlight stays off: log scrollback never highlights
+    msg.collapsible = isCollapsibleEvent(msg);
+    older.append(msg);
+  }
+
+  // Keep a leading "Scrollback from" header on top
+  int row = 0;
+  if (!m_messages.isEmpty() &&
+      m_messages.first().type == QLatin1String("system") &&
+      m_messages.first().text.contains(QLatin1String("Scrollback from ")))
+    row = 1;
+  beginInsertRows(QModelIndex(), row, row + older.size() - 1);
+  for (int i = 0; i < older.size(); ++i)
+    m_messages.insert(row + i, older[i]);
+  m_lastRun = EventRun();
+  endInsertRows();
+  // Events at the seam may now form one group with the rows below
+  const int seam = row + older.size();
+  if (seam < m_messages.size() && m_messages.at(seam).collapsible) {
+    int first, last;
+    if (eventGroupAt(seam, &first, &last))
+      emit dataChanged(index(first), index(last), {RowHtmlRole, CollapsedRole});
+  }
+  emit olderMessagesPrepended(entries.size());
+}
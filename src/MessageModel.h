@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QAbstractListModel>
+#include <QCache>
 #include <QDateTime>
 #include <QMap>
 #include <QSet>
@@ -14,16 +15,19 @@ public:
     TypeRole = Qt::UserRole + 1,
     TextRole,
     TimestampRole,
-    FormattedTextRole
+    FormattedTextRole,
+    RowHtmlRole,  // formattedText as shown in the chat view (event groups)
+    CollapsedRole // hidden inside a collapsed event group
   };
   Q_ENUM(Roles)
 
   struct Message {
     QString text;          // raw IRC text
-    QString formattedText; // pre-rendered HTML for display
     QString type;          // "system", "chat", "action", "error", "embed"
     QDateTime timestamp;
     int id = 0;            // session-unique, monotonic — stable event-group key
+    bool collapsible = false; // join/part/quit/... that event groups fold
+    bool highlight = false;   // nick mentions are highlighted (not for logs)
   };
 
   explicit MessageModel(QObject *parent = nullptr);
@@ -45,14 +49,37 @@ public:
   Q_INVOKABLE void setHighlightEnabled(bool enabled);
   Q_INVOKABLE void setTimestampFormat(const QString &fmt);
   Q_INVOKABLE void toggleEventGroup(int groupId);
+  // ── Row-based chat view ──
+  // The same lines allFormattedText() produces, one row at a time.  Plain
+  // text positions match those of a RichText TextEdit showing rowHtml.
+  Q_INVOKABLE QString plainText(int row) const;
+  Q_INVOKABLE QString selectedText(int fromRow, int fromPos, int toRow,
+                                   int toPos) const;
+  // Last visible row before `before` (-1 = from the end) whose text
+  // contains `text`; -1 when there is none.
+  Q_INVOKABLE int findRow(const QString &text, bool caseSensitive,
+                          int before = -1) const;
   // Batch-load mode: suppresses per-message signals during a channel switch.
   // Call beginBatch() before inserting, endBatch() when done; QML receives a
   // single reloaded() signal instead of N messageAdded() signals.
   void beginBatch();
   void endBatch();
-  static QString ircToHtml(const QString &text);
-  // Wrap http/https URLs in HTML output with clickable <a> tags
-  static QString linkifyUrls(const QString &html);
+  // Append hold: between holdAppends() and releaseAppends() (nestable),
+  // addMessage() only queues the row; the last release inserts everything
+  // queued with a single rowsInserted.  Used while a burst of server lines
+  // is handled.  clear() drops rows still held.  A batch load is not held:
+  // beginBatch() inserts what is held and the batch rows go in directly.
+  void holdAppends();
+  void releaseAppends();
+  // Insert older scrollback above the current rows, below a leading
+  // "Scrollback from" header (no highlighting, no image fetches); QML gets a
+  // single olderMessagesPrepended() signal.
+  struct Entry {
+    QString type;
+    QString text;
+    QString timestamp;
+  };
+  void prependMessages(const QList<Entry> &entries);
   // Whole-word nick match honoring IRC nick characters — avoids false
   // highlights like nick "ed" matching "edited".
   static bool containsNickWord(const QString &text, const QString &nick);
@@ -61,16 +88,29 @@ signals:
   void messageAdded(const QString &formattedLine);
   void cleared();
   void reloaded(); // emitted by endBatch() after a channel-switch load
+  void olderMessagesPrepended(int count);
 
 private slots:
-  void onImageReady(const QString &url, const QString &localPath, int width,
+  void onImageReady(const QString &url, const QString &source, int width,
                     int height);
 
 private:
   QString formatLine(const Message &msg) const;
-  static QString colorizeNicks(const QString &html);
-  static QString nickColor(const QString &nick);
+  // HTML for msg, rendered on first use and kept in m_htmlCache
+  QString formatted(const Message &msg) const;
+  // Its plain text, parsed from that HTML once and cached alongside it
+  QString formattedPlain(const Message &msg) const;
+  // Bounds of the event group holding row; false when it is not grouped.
+  bool eventGroupAt(int row, int *first, int *last) const;
+  QString rowHtml(int row) const;
+  bool isCollapsedRow(int row) const;
+  void emitGroupChanged(int row);
+  void appendRows(const QList<Message> &rows);
+  void appendHeld();
+  void fetchImages(const Message &msg);
   QList<Message> m_messages;
+  QList<Message> m_held; // appended while m_holdDepth > 0
+  int m_holdDepth = 0;
   int m_nextMessageId = 1;
   QSet<QString> m_pendingImages;
   QString m_nickname;
@@ -78,4 +118,24 @@ private:
   bool m_batchMode = false;
   QString m_timestampFormat = QStringLiteral("hh:mm:ss");
   QSet<int> m_expandedGroups;
+  // The run of collapsible rows eventGroupAt() found last, identified by
+  // its first row's id; reset whenever rows are added.
+  struct EventRun {
+    int firstId = -1;
+    int first = 0;
+    int last = 0;
+  };
+  mutable EventRun m_lastRun;
+
+  // Rendered HTML by message id.  Lines are only formatted when a view asks
+  // for them, so a channel switch does not format thousands of lines that
+  // are never scrolled to.  Entries from an older format generation (theme
+  // or timestamp format changed since) are re-rendered on access.
+  struct CachedHtml {
+    QString html;
+    quint32 generation = 0;
+    QString plain; // for plainText(), filled on first use
+    bool hasPlain = false;
+  };
+  mutable QCache<int, CachedHtml> m_htmlCache;
 };
@@ -0,0 +1,138 @@
+#include "NetsplitTracker.h"
+
+#include <algorithm>
+
+namespace {
+
+// A server name as it shows in split QUITs: dotted labels of letters,
+// digits and '-', the first possibly masked as '*', ending in an
+// alphabetic TLD.
+bool isHostName(QStringView host) {
+  if (host.isEmpty() || host.front() == u'.' || host.back() == u'.')
+    return false;
+  const qsizetype lastDot = host.lastIndexOf(u'.');
+  if (lastDot < 0 || host.size() - lastDot - 1 < 2)
+    return false;
+  QChar prev;
+  for (qsizetype i = 0; i < host.size(); ++i) {
+    const QChar c = host.at(i);
+    if (c == u'.') {
+      if (prev == u'.')
+        return false;
+    } else if (i > lastDot) {
+      if (!c.isLetter())
+        return false;
+    } else if (!c.isLetterOrNumber() && c != u'-' && c != u'_' &&
+               !(c == u'*' && i == 0)) {
+      return false;
+    }
+    prev = c;
+  }
+  return true;
+}
+
+// Removes a nick from the channel's pending events of one kind; whether it
+// was there
+bool takePending(QVector<NetsplitTracker::Event> &pending, int channel,
+                 bool rejoin, const QString &folded) {
+  for (int i = 0; i < pending.size(); ++i) {
+    NetsplitTracker::Event &e = pending[i];
+    if (e.channel != channel || e.rejoin != rejoin)
+      continue;
+    const qsizetype at = e.folded.indexOf(folded);
+    if (at < 0)
+      continue;
+    e.nicks.removeAt(at);
+    e.folded.removeAt(at);
+    if (e.nicks.isEmpty())
+      pending.removeAt(i);
+    return true;
+  }
+  return false;
+}
+
+} // namespace
+
+bool NetsplitTracker::isSplitReason(QStringView reason) {
+  const qsizetype space = reason.indexOf(u' ');
+  if (space <= 0 || reason.indexOf(u' ', space + 1) >= 0)
+    return false;
+  const QStringView a = reason.first(space);
+  const QStringView b = reason.sliced(space + 1);
+  return isHostName(a) && isHostName(b) &&
+         a.compare(b, Qt::CaseInsensitive) != 0;
+}
+
+int NetsplitTracker::pendingEvent(int channel, const QString &servers,
+                                  bool rejoin) {
+  for (int i = 0; i < m_pending.size(); ++i) {
+    const Event &e = m_pending.at(i);
+    if (e.channel == channel && e.rejoin == rejoin && e.servers == servers)
+      return i;
+  }
+  m_pending.append({channel, servers, rejoin, {}, {}});
+  return int(m_pending.size()) - 1;
+}
+
+bool NetsplitTracker::quit(int channel, const QString &servers,
+                           const QString &nick, const QString &folded,
+                           qint64 now) {
+  m_split.insert({channel, folded}, {servers, now});
+  // Flapping: back and gone again before anyone saw the rejoin
+  if (takePending(m_pending, channel, true, folded))
+    return true;
+  Event &e = m_pending[pendingEvent(channel, servers, false)];
+  e.nicks.append(nick);
+  e.folded.append(folded);
+  return false;
+}
+
+bool NetsplitTracker::join(int channel, const QString &nick,
+                           const QString &folded, qint64 now) {
+  const auto it = m_split.find({channel, folded});
+  if (it == m_split.end() || now - it->when > kRememberMs)
+    return false;
+  const QString servers = it->servers;
+  m_split.erase(it);
+  // Back before the split was even reported: still on the list
+  if (takePending(m_pending, channel, false, folded))
+    return true;
+  Event &e = m_pending[pendingEvent(channel, servers, true)];
+  e.nicks.append(nick);
+  e.folded.append(folded);
+  return true;
+}
+
+bool NetsplitTracker::rejoining(int channel, const QString &folded) const {
+  for (const Event &e : m_pending) {
+    if (e.rejoin && e.channel == channel && e.folded.contains(folded))
+      return true;
+  }
+  return false;
+}
+
+void NetsplitTracker::forget(int channel) {
+  m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(),
+                                 [channel](const Event &e) {
+                                   return e.channel == channel;
+                                 }),
+                  m_pending.end());
+  for (auto it = m_split.begin(); it != m_split.end();) {
+    if (it.key().first == channel)
+      it = m_split.erase(it);
+    else
+      ++it;
+  }
+}
+
+QVector<NetsplitTracker::Event> NetsplitTracker::take(qint64 now) {
+  QVector<Event> events;
+  events.swap(m_pending);
+  for (auto it = m_split.begin(); it != m_split.end();) {
+    if (now - it->when > kRememberMs)
+      it = m_split.erase(it);
+    else
+      ++it;
+  }
+  return events;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Collects the QUIT storm of a netsplit, and the JOINs of the same nicks
+// when the servers relink, into one event per channel.
+//
+// The caller decides which QUITs are splits (isSplitReason), feeds them and
+// the JOINs in, and drains the events on a timer; nothing here touches the
+// nick lists.  Split nicks stay listed until their quit event is drained;
+// rejoining nicks are listed as soon as they JOIN, so modes, nick changes
+// and parts in the meantime find them, and only the summary line waits.
+// Nicks are given both as shown and folded under the server's case
+// mapping.
+class NetsplitTracker {
+public:
+  // A split nick that rejoins within this long counts as a netjoin
+  static constexpr qint64 kRememberMs = 15 * 60 * 1000;
+
+  // "hub.example.net leaf.example.net": two different host names, which
+  // servers use for split QUITs and clients cannot forge with a plain QUIT
+  // (the server prefixes those with "Quit: ").
+  static bool isSplitReason(QStringView reason);
+
+  struct Event {
+    int channel;
+    QString servers; // the quit reason: "hub.example.net leaf.example.net"
+    bool rejoin;     // false: the nicks split off, true: they came back
+    QStringList nicks;
+    QStringList folded;
+  };
+
+  // Whether the QUIT cancels a rejoin still pending; the caller listed the
+  // nick at the JOIN and drops it again right away.
+  bool quit(int channel, const QString &servers, const QString &nick,
+            const QString &folded, qint64 now);
+  // Whether the JOIN is a split nick coming back; if so it is part of an
+  // event (or cancels a QUIT still pending) and needs no handling of its
+  // own.
+  bool join(int channel, const QString &nick, const QString &folded,
+            qint64 now);
+  // Whether a rejoin of the nick is waiting to be reported
+  bool rejoining(int channel, const QString &folded) const;
+  // Drops everything about a channel that was left
+  void forget(int channel);
+
+  bool hasPending() const { return !m_pending.isEmpty(); }
+  // Pending events in the order they started; forgets splits older than
+  // kRememberMs as of `now`.
+  QVector<Event> take(qint64 now);
+
+private:
+  using Member = QPair<int, QString>; // channel, folded nick
+  struct Split {
+    QString servers;
+    qint64 when;
+  };
+  int pendingEvent(int channel, const QString &servers, bool rejoin);
+
+  QVector<Event> m_pending;
+  QHash<Member, Split> m_split;
+};
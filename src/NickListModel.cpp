@@ -0,0 +1,343 @@
+#include "NickListModel.h"
+
+#include <QSet>
+#include <algorithm>
+
+namespace {
+
+constexpr int kNoPrefix = 5;
+// Batches at least this large reset the model
+constexpr int kResetBatch = 32;
+
+// Whether m sorts before the key (rank, folded)
+bool before(int mRank, QStringView mFolded, int rank, QStringView folded) {
+  return mRank != rank ? mRank < rank : mFolded < folded;
+}
+
+} // namespace
+
+NickListModel::NickListModel(QObject *parent) : QAbstractListModel(parent) {}
+
+int NickListModel::prefixRank(QChar symbol) {
+  switch (symbol.unicode()) {
+  case u'~':
+    return 0; // owner
+  case u'&':
+    return 1; // admin / protected
+  case u'@':
+    return 2; // op
+  case u'%':
+    return 3; // halfop
+  case u'+':
+    return 4; // voice
+  default:
+    return kNoPrefix;
+  }
+}
+
+bool NickListModel::lessThan(const Member &a, const Member &b) {
+  return before(a.rank, a.folded, b.rank, b.folded);
+}
+
+NickListModel::Member NickListModel::makeMember(const QString &name) const {
+  Member m;
+  qsizetype i = 0;
+  while (i < name.size() && prefixRank(name.at(i)) < kNoPrefix) {
+    if (!m.prefixes.contains(name.at(i)))
+      m.prefixes += name.at(i);
+    ++i;
+  }
+  std::sort(m.prefixes.begin(), m.prefixes.end(),
+            [](QChar a, QChar b) { return prefixRank(a) < prefixRank(b); });
+  m.nick = name.mid(i);
+  m.folded = ChannelRegistry::fold(m.nick, m_mapping);
+  m.rank = m.prefixes.isEmpty() ? kNoPrefix : prefixRank(m.prefixes.front());
+  return m;
+}
+
+int NickListModel::rowOf(const QString &folded) const {
+  const int rank = m_rankOf.value(folded, -1);
+  if (rank < 0)
+    return -1;
+  const auto it = std::lower_bound(
+      m_rows.cbegin(), m_rows.cend(), folded,
+      [rank](const Member &m, const QString &key) {
+        return before(m.rank, m.folded, rank, key);
+      });
+  return it != m_rows.cend() && it->folded == folded
+             ? int(it - m_rows.cbegin())
+             : -1;
+}
+
+// ── Model ──
+
+int NickListModel::rowCount(const QModelIndex &parent) const {
+  if (parent.isValid())
+    return 0;
+  return count();
+}
+
+QVariant NickListModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid() || index.row() < 0 || index.row() >= count())
+    return {};
+  const Member &m = m_rows.at(index.row());
+  switch (role) {
+  case Qt::DisplayRole:
+    return m.prefixes.left(1) + m.nick;
+  case NickRole:
+    return m.nick;
+  case PrefixRole:
+    return m.prefixes.left(1);
+  default:
+    return {};
+  }
+}
+
+QHash<int, QByteArray> NickListModel::roleNames() const {
+  QHash<int, QByteArray> roles;
+  roles[Qt::DisplayRole] = "display";
+  roles[NickRole] = "nick";
+  roles[PrefixRole] = "prefix";
+  return roles;
+}
+
+// ── Membership ──
+
+void NickListModel::setCaseMapping(ChannelRegistry::CaseMapping mapping) {
+  if (m_mapping == mapping)
+    return;
+  m_mapping = mapping;
+  if (m_rows.isEmpty())
+    return;
+  beginResetModel();
+  QVector<Member> rows;
+  rows.reserve(m_rows.size());
+  m_rankOf.clear();
+  for (Member &m : m_rows) {
+    m.folded = ChannelRegistry::fold(m.nick, mapping);
+    // Nicks that now fold together are one member; the first one stays
+    if (m_rankOf.contains(m.folded))
+      continue;
+    m_rankOf.insert(m.folded, m.rank);
+    rows.append(std::move(m));
+  }
+  std::sort(rows.begin(), rows.end(), lessThan);
+  const bool shrank = rows.size() != m_rows.size();
+  m_rows = std::move(rows);
+  endResetModel();
+  if (shrank)
+    emit countChanged();
+}
+
+void NickListModel::reset(const QStringList &names) {
+  beginResetModel();
+  m_rows.clear();
+  m_rankOf.clear();
+  m_rows.reserve(names.size());
+  m_rankOf.reserve(names.size());
+  for (const QString &name : names) {
+    Member m = makeMember(name);
+    if (m.nick.isEmpty() || m_rankOf.contains(m.folded))
+      continue;
+    m_rankOf.insert(m.folded, m.rank);
+    m_rows.append(std::move(m));
+  }
+  std::sort(m_rows.begin(), m_rows.end(), lessThan);
+  endResetModel();
+  emit countChanged();
+}
+
+void NickListModel::clear() {
+  if (m_rows.isEmpty())
+    return;
+  beginResetModel();
+  m_rows.clear();
+  m_rankOf.clear();
+  endResetModel();
+  emit countChanged();
+}
+
+bool NickListModel::add(const QString &name) {
+  Member m = makeMember(name);
+  if (m.nick.isEmpty() || m_rankOf.contains(m.folded))
+    return false;
+  const int row = int(std::lower_bound(m_rows.cbegin(), m_rows.cend(), m,
+                                       lessThan) -
+                      m_rows.cbegin());
+  beginInsertRows(QModelIndex(), row, row);
+  m_rankOf.insert(m.folded, m.rank);
+  m_rows.insert(row, std::move(m));
+  endInsertRows();
+  emit countChanged();
+  return true;
+}
+
+bool NickListModel::remove(QStringView nick) {
+  const QString folded = ChannelRegistry::fold(nick, m_mapping);
+  const int row = rowOf(folded);
+  if (row < 0)
+    return false;
+  beginRemoveRows(QModelIndex(), row, row);
+  m_rows.remove(row);
+  m_rankOf.remove(folded);
+  endRemoveRows();
+  emit countChanged();
+  return true;
+}
+
+bool NickListModel::rename(QStringView oldNick, const QString &newNick) {
+  const QString folded = ChannelRegistry::fold(oldNick, m_mapping);
+  const int row = rowOf(folded);
+  if (row < 0)
+    return false;
+  Member m = m_rows.at(row);
+  m.nick = newNick;
+  m.folded = ChannelRegistry::fold(newNick, m_mapping);
+  if (m.folded != folded) {
+    // The server would not let two members hold one nick; if our list
+    // says otherwise, the stale entry goes.
+    if (m_rankOf.contains(m.folded))
+      return remove(oldNick);
+    m_rankOf.remove(folded);
+    m_rankOf.insert(m.folded, m.rank);
+  }
+  reposition(row, std::move(m));
+  return true;
+}
+
+bool NickListModel::setPrefix(QStringView nick, QChar prefix, bool set) {
+  const int rank = prefixRank(prefix);
+  if (rank == kNoPrefix)
+    return false;
+  const int row = rowOf(ChannelRegistry::fold(nick, m_mapping));
+  if (row < 0)
+    return false;
+  Member m = m_rows.at(row);
+  if (m.prefixes.contains(prefix) == set)
+    return false;
+  if (set) {
+    qsizetype at = 0;
+    while (at < m.prefixes.size() && prefixRank(m.prefixes.at(at)) < rank)
+      ++at;
+    m.prefixes.insert(at, prefix);
+  } else {
+    m.prefixes.remove(prefix);
+  }
+  m.rank = m.prefixes.isEmpty() ? kNoPrefix : prefixRank(m.prefixes.front());
+  m_rankOf.insert(m.folded, m.rank);
+  reposition(row, std::move(m));
+  return true;
+}
+
+int NickListModel::addAll(const QStringList &names) {
+  if (names.size() < kResetBatch) {
+    int added = 0;
+    for (const QString &name : names)
+      added += add(name);
+    return added;
+  }
+  QVector<Member> fresh;
+  QSet<QString> seen;
+  for (const QString &name : names) {
+    Member m = makeMember(name);
+    if (m.nick.isEmpty() || m_rankOf.contains(m.folded) ||
+        seen.contains(m.folded))
+      continue;
+    seen.insert(m.folded);
+    fresh.append(std::move(m));
+  }
+  if (fresh.isEmpty())
+    return 0;
+  std::sort(fresh.begin(), fresh.end(), lessThan);
+  beginResetModel();
+  const qsizetype middle = m_rows.size();
+  for (Member &m : fresh) {
+    m_rankOf.insert(m.folded, m.rank);
+    m_rows.append(std::move(m));
+  }
+  std::inplace_merge(m_rows.begin(), m_rows.begin() + middle, m_rows.end(),
+                     lessThan);
+  endResetModel();
+  emit countChanged();
+  return int(fresh.size());
+}
+
+int NickListModel::removeAll(const QStringList &nicks) {
+  if (nicks.size() < kResetBatch) {
+    int removed = 0;
+    for (const QString &nick : nicks)
+      removed += remove(nick);
+    return removed;
+  }
+  QSet<QString> gone;
+  for (const QString &nick : nicks) {
+    QString folded = ChannelRegistry::fold(nick, m_mapping);
+    if (m_rankOf.contains(folded))
+      gone.insert(std::move(folded));
+  }
+  if (gone.isEmpty())
+    return 0;
+  beginResetModel();
+  m_rows.erase(std::remove_if(m_rows.begin(), m_rows.end(),
+                              [&gone](const Member &m) {
+                                return gone.contains(m.folded);
+                              }),
+               m_rows.end());
+  for (const QString &folded : gone)
+    m_rankOf.remove(folded);
+  endResetModel();
+  emit countChanged();
+  return int(gone.size());
+}
+
+void NickListModel::reposition(int row, Member updated) {
+  // Where it goes with the old entry still in place, which is exactly the
+  // destination beginMoveRows() wants
+  const int pos = int(std::lower_bound(m_rows.cbegin(), m_rows.cend(),
+                                       updated, lessThan) -
+                      m_rows.cbegin());
+  int dest = row;
+  if (pos != row && pos != row + 1) {
+    beginMoveRows(QModelIndex(), row, row, QModelIndex(), pos);
+    dest = pos > row ? pos - 1 : pos;
+    m_rows.move(row, dest);
+    m_rows[dest] = std::move(updated);
+    endMoveRows();
+  } else {
+    m_rows[dest] = std::move(updated);
+  }
+  const QModelIndex changed = index(dest);
+  emit dataChanged(changed, changed);
+}
+
+// ── Lookup ──
+
+bool NickListModel::contains(QStringView nick) const {
+  return m_rankOf.contains(ChannelRegistry::fold(nick, m_mapping));
+}
+
+QString NickListModel::prefix(QStringView nick) const {
+  const int row = rowOf(ChannelRegistry::fold(nick, m_mapping));
+  return row < 0 ? QString() : m_rows.at(row).prefixes.left(1);
+}
+
+QStringList NickListModel::names() const {
+  QStringList out;
+  out.reserve(m_rows.size());
+  for (const Member &m : m_rows)
+    out.append(m.prefixes.left(1) + m.nick);
+  return out;
+}
+
+QString NickListModel::nickAt(int row) const {
+  return row >= 0 && row < count() ? m_rows.at(row).nick : QString();
+}
+
+QStringList NickListModel::completions(const QString &partial) const {
+  QStringList out;
+  for (const Member &m : m_rows) {
+    if (m.nick.startsWith(partial, Qt::CaseInsensitive))
+      out.append(m.nick);
+  }
+  return out;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "ChannelRegistry.h"
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+// The members of one channel, in nick-list order: by highest channel
+// prefix (~ & @ % +, then none) and within a rank by the nick folded under
+// the server's CASEMAPPING.
+//
+// Rows are kept sorted as members come and go, so a JOIN, PART, NICK or
+// MODE costs one hash lookup plus a binary search and signals only the
+// rows it touches; only a fresh NAMES list resets the model.
+class NickListModel : public QAbstractListModel {
+  Q_OBJECT
+  Q_PROPERTY(int count READ count NOTIFY countChanged)
+public:
+  enum Roles {
+    NickRole = Qt::UserRole + 1, // nick without prefix
+    PrefixRole                   // highest prefix symbol, or ""
+  };
+  Q_ENUM(Roles)
+
+  explicit NickListModel(QObject *parent = nullptr);
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex &index,
+                int role = Qt::DisplayRole) const override;
+  QHash<int, QByteArray> roleNames() const override;
+
+  void setCaseMapping(ChannelRegistry::CaseMapping mapping);
+
+  // Replaces every member; names may carry prefixes ("@+nick").
+  void reset(const QStringList &names);
+  void clear();
+  // Each returns whether the list changed.
+  bool add(const QString &name);
+  bool remove(QStringView nick);
+  bool rename(QStringView oldNick, const QString &newNick);
+  bool setPrefix(QStringView nick, QChar prefix, bool set);
+  // Many members at once (netsplits): past a few dozen, one model reset
+  // instead of a signal per row.  Each returns how many members changed.
+  int addAll(const QStringList &names);
+  int removeAll(const QStringList &nicks);
+
+  int count() const { return int(m_rows.size()); }
+  bool contains(QStringView nick) const;
+  // Highest prefix symbol of a member, empty if none or not a member
+  QString prefix(QStringView nick) const;
+  // Prefixed names in list order
+  QStringList names() const;
+  Q_INVOKABLE QString nickAt(int row) const;
+  // Members whose nick starts with `partial` (case-insensitively), in
+  // list order
+  Q_INVOKABLE QStringList completions(const QString &partial) const;
+
+  static int prefixRank(QChar symbol);
+
+signals:
+  void countChanged();
+
+private:
+  struct Member {
+    QString nick;
+    QString folded;
+    QString prefixes; // every prefix held, highest first
+    int rank;         // rank of prefixes.front(), 5 without one
+  };
+  static bool lessThan(const Member &a, const Member &b);
+  Member makeMember(const QString &name) const;
+  int rowOf(const QString &folded) const;
+  // Puts rows[row] where `updated` sorts, with one move or change signal
+  void reposition(int row, Member updated);
+
+  ChannelRegistry::CaseMapping m_mapping = ChannelRegistry::CaseMapping::Rfc1459;
+  QVector<Member> m_rows;
+  QHash<QString, int> m_rankOf; // folded nick → rank, enough to find its row
+};
@@ -0,0 +1,357 @@
+// ── Numeric dispatch table ──
+// Called once from the IRCConnectionManager constructor, before any plugin
+// or script can add its own handlers.  The table is indexed directly by the
+// numeric, so dispatch is a single array lookup no matter how many numerics
+// we handle.  Handlers registered for the same numeric run in order.
+#include "IRCConnectionManager.h"
+#include "IrcConnection.h"
+#include "MessageModel.h"
+#include <QDateTime>
+
+int IRCConnectionManager::registerNumericHandler(int code,
+                                                 NumericHandler handler) {
+  if (code < 0 || code >= kNumericTableSize || !handler)
+    return -1;
+  const int id = m_nextNumericHandlerId++;
+  m_numericTable[code].append({id, std::move(handler)});
+  return id;
+}
+
+void IRCConnectionManager::unregisterNumericHandler(int id) {
+  // Only plugins and scripts unregister, and rarely — a full sweep is fine.
+  for (auto &handlers : m_numericTable) {
+    handlers.removeIf(
+        [id](const NumericEntry &e) { return e.id == id; });
+  }
+}
+
+void IRCConnectionManager::dispatchNumeric(IrcConnection *conn, int code,
+                                           const QStringList &params,
+                                           const QString &trailing) {
+  if (code < 0 || code >= kNumericTableSize)
+    return;
+  // Copy: a handler may register or unregister handlers for this numeric.
+  const QVector<NumericEntry> handlers = m_numericTable[code];
+  if (handlers.isEmpty())
+    return;
+  const QString srv = serverNameFor(conn);
+  for (const auto &e : handlers)
+    e.handler(conn, srv, code, params, trailing);
+}
+
+void IRCConnectionManager::initNumericTable() {
+  auto on = [this](std::initializer_list<int> codes,
+                   const NumericHandler &handler) {
+    for (int code : codes)
+      registerNumericHandler(code, handler);
+  };
+  auto whoisKey = [](const QString &srv, const QString &nick) {
+    return srv + "\n" + nick.toLower();
+  };
+  // Plain server-tab text; also shown if the server tab is active.
+  auto serverText = [this](const QString &srv, const QString &text) {
+    appendToChannel(srv, srv, "system", text);
+    if (m_activeServer == srv &&
+        (m_activeChannel.isEmpty() || m_activeChannel == srv)) {
+      if (m_msgModel)
+        m_msgModel->addMessage("system", text);
+    }
+  };
+
+  // ═══════════════════════════════════════════════════
+  //  WHOIS replies (311–319, 330, 338, 378, 671)
+  // ═══════════════════════════════════════════════════
+  // Accumulate all WHOIS lines into a buffer, then display as a structured
+  // block when RPL_ENDOFWHOIS (318) arrives.
+
+  // RPL_WHOISUSER: <nick> <user> <host> * :<realname>
+  on({311}, [this, whoisKey](IrcConnection *, const QString &srv, int,
+                             const QStringList &params,
+                             const QString &trailing) {
+    QString nick = params.value(0);
+    QString user = params.value(1);
+    QString host = params.value(2);
+    QString key = whoisKey(srv, nick);
+    m_whoisBuffer[key].clear(); // start fresh
+    m_whoisBuffer[key] << nick + " (" + user + "@" + host + ")";
+    m_whoisBuffer[key] << "  Real name: " + trailing;
+  });
+
+  // RPL_WHOISSERVER: <nick> <server> :<server info>
+  on({312}, [this, whoisKey](IrcConnection *, const QString &srv, int,
+                             const QStringList &params,
+                             const QString &trailing) {
+    QString server = params.value(1);
+    m_whoisBuffer[whoisKey(srv, params.value(0))]
+        << "  Server: " + server + " (" + trailing + ")";
+  });
+
+  // RPL_WHOISOPERATOR (313), RPL_WHOISHOST (378), RPL_WHOISSECURE (671)
+  on({313, 378, 671}, [this, whoisKey](IrcConnection *, const QString &srv,
+                                       int, const QStringList &params,
+                                       const QString &trailing) {
+    m_whoisBuffer[whoisKey(srv, params.value(0))] << "  " + trailing;
+  });
+
+  // RPL_WHOISIDLE: <nick> <seconds> <signon> :seconds idle
+  on({317}, [this, whoisKey](IrcConnection *, const QString &srv, int,
+                             const QStringList &params, const QString &) {
+    QString nick = params.value(0);
+    int idleSecs = params.value(1).toInt();
+    int d = idleSecs / 86400, h = (idleSecs % 86400) / 3600,
+        m = (idleSecs % 3600) / 60, s = idleSecs % 60;
+    QString idle;
+    if (d > 0)
+      idle += QString::number(d) + "d ";
+    if (h > 0)
+      idle += QString::number(h) + "h ";
+    if (m > 0)
+      idle += QString::number(m) + "m ";
+    idle += QString::number(s) + "s";
+    QString signonTime;
+    if (params.size() > 2) {
+      qint64 ts = params.value(2).toLongLong();
+      signonTime =
+          QDateTime::fromSecsSinceEpoch(ts).toString("yyyy-MM-dd hh:mm:ss");
+    }
+    QString line = "  Idle: " + idle;
+    if (!signonTime.isEmpty())
+      line += " | Signed on: " + signonTime;
+    m_whoisBuffer[whoisKey(srv, nick)] << line;
+  });
+
+  // RPL_ENDOFWHOIS — flush the accumulated WHOIS block
+  on({318}, [this, whoisKey](IrcConnection *, const QString &srv, int,
+                             const QStringList &params, const QString &) {
+    QString nick = params.value(0);
+    QString key = whoisKey(srv, nick);
+    QString ch = m_activeChannel.isEmpty() ? srv : m_activeChannel;
+
+    if (m_whoisBuffer.contains(key) && !m_whoisBuffer[key].isEmpty()) {
+      // Display as a structured block with separator
+      QString sep = "━━━━━━━━ WHOIS " + nick + " ━━━━━━━━";
+      if (m_msgModel) m_msgModel->addMessage("system", sep);
+      appendToChannel(srv, ch, "system", sep);
+
+      for (const QString &line : m_whoisBuffer[key]) {
+        if (m_msgModel) m_msgModel->addMessage("system", line);
+        appendToChannel(srv, ch, "system", line);
+      }
+
+      QString endSep = "━━━━━━━━ End of WHOIS ━━━━━━━━";
+      if (m_msgModel) m_msgModel->addMessage("system", endSep);
+      appendToChannel(srv, ch, "system", endSep);
+      m_whoisBuffer.remove(key);
+    } else {
+      // No data accumulated (shouldn't happen normally)
+      QString text = "[WHOIS] No information for " + nick;
+      if (m_msgModel) m_msgModel->addMessage("system", text);
+      appendToChannel(srv, ch, "system", text);
+    }
+  });
+
+  // RPL_WHOISCHANNELS: <nick> :<channels>
+  on({319}, [this, whoisKey](IrcConnection *, const QString &srv, int,
+                             const QStringList &params,
+                             const QString &trailing) {
+    m_whoisBuffer[whoisKey(srv, params.value(0))]
+        << "  Channels: " + trailing;
+  });
+
+  // RPL_WHOISACCOUNT: <nick> <account> :is logged in as
+  on({330}, [this, whoisKey](IrcConnection *, const QString &srv, int,
+                             const QStringList &params, const QString &) {
+    m_whoisBuffer[whoisKey(srv, params.value(0))]
+        << "  Account: " + params.value(1);
+  });
+
+  // RPL_WHOISACTUALLY: <nick> <ip> :actually using host
+  on({338}, [this, whoisKey](IrcConnection *, const QString &srv, int,
+                             const QStringList &params, const QString &) {
+    m_whoisBuffer[whoisKey(srv, params.value(0))]
+        << "  Actual host: " + params.value(1);
+  });
+
+  // RPL_WHOWASUSER
+  on({314}, [this](IrcConnection *, const QString &srv, int,
+                   const QStringList &params, const QString &trailing) {
+    QString nick = params.value(1);
+    QString user = params.value(2);
+    QString host = params.value(3);
+    QString text = "[WHOWAS] " + nick + " was " + user + "@" + host +
+                   " : " + trailing;
+    if (m_msgModel)
+      m_msgModel->addMessage("system", text);
+    appendToChannel(srv, m_activeChannel.isEmpty() ? srv : m_activeChannel,
+                    "system", text);
+  });
+
+  // ═══════════════════════════════════════════════════
+  //  Channel state
+  // ═══════════════════════════════════════════════════
+
+  // RPL_ISUPPORT: <token>... :are supported by this server
+  // CASEMAPPING decides which channel names are the same channel.
+  on({5}, [this](IrcConnection *, const QString &srv, int,
+                 const QStringList &params, const QString &) {
+    for (const QString &token : params) {
+      if (token.startsWith(QLatin1String("CASEMAPPING="))) {
+        const auto mapping = ChannelRegistry::caseMappingFromName(
+            QStringView(token).sliced(12));
+        m_channels.setCaseMapping(srv, mapping);
+        for (auto it = m_users.cbegin(); it != m_users.cend(); ++it) {
+          if (m_channels.isOnServer(it.key(), srv))
+            it.value()->setCaseMapping(mapping);
+        }
+      }
+    }
+  });
+
+  // RPL_CHANNELMODEIS: <channel> <modes> [<mode params>]
+  on({324}, [this](IrcConnection *, const QString &srv, int,
+                   const QStringList &params, const QString &) {
+    QString channel = params.value(1);
+    QString modes = params.value(2);
+    QStringList modeParams = params.mid(3);
+    QString text = "Channel modes for " + channel + ": " + modes;
+    if (!modeParams.isEmpty())
+      text += " " + modeParams.join(" ");
+    // Store the mode string for display in the topic bar
+    const int key = channelId(srv, channel);
+    m_modes[key] = modes;
+    if (m_activeServer == srv && m_activeChannel == channel)
+      emit channelModesChanged(modes);
+    appendToChannel(srv, channel, "system", text);
+    if (m_msgModel && m_activeServer == srv && m_activeChannel == channel)
+      m_msgModel->addMessage("system", text);
+  });
+
+  // RPL_CREATIONTIME: <channel> <timestamp>
+  on({329}, [this](IrcConnection *, const QString &srv, int,
+                   const QStringList &params, const QString &) {
+    QString channel = params.value(1);
+    qint64 ts = params.value(2).toLongLong();
+    QString timeStr =
+        QDateTime::fromSecsSinceEpoch(ts).toString("ddd MMM d hh:mm:ss yyyy");
+    QString text = "Channel " + channel + " created on " + timeStr;
+    appendToChannel(srv, channel, "system", text);
+    if (m_msgModel && m_activeServer == srv && m_activeChannel == channel)
+      m_msgModel->addMessage("system", text);
+  });
+
+  // RPL_BANLIST (367): <channel> <mask> <setter> <timestamp>
+  // (our nick was already stripped by IrcConnection)
+  on({367}, [this](IrcConnection *, const QString &, int,
+                   const QStringList &params, const QString &) {
+    QString channel = params.value(0);
+    QString mask = params.value(1);
+    QString setter = params.value(2);
+    // The timestamp is a Unix epoch; convert to readable
+    QString timeStr;
+    if (params.size() > 3) {
+      qint64 ts = params.value(3).toLongLong();
+      timeStr = QDateTime::fromSecsSinceEpoch(ts).toString("yyyy-MM-dd hh:mm");
+    }
+    emit banListEntry(channel, mask, setter, timeStr);
+  });
+
+  // RPL_ENDOFBANLIST (368)
+  on({368}, [this](IrcConnection *, const QString &, int,
+                   const QStringList &params, const QString &) {
+    emit banListEnd(params.value(0));
+  });
+
+  // ═══════════════════════════════════════════════════
+  //  Away state: RPL_UNAWAY (305) / RPL_NOWAWAY (306)
+  // ═══════════════════════════════════════════════════
+
+  on({305}, [this](IrcConnection *, const QString &srv, int,
+                   const QStringList &, const QString &trailing) {
+    // You are no longer marked as being away
+    m_isAway = false;
+    emit awayStateChanged(false);
+    QString text = trailing.isEmpty()
+                       ? "You are no longer marked as being away"
+                       : trailing;
+    appendToChannel(srv, m_activeChannel.isEmpty() ? srv : m_activeChannel,
+                    "system", text);
+    if (m_msgModel)
+      m_msgModel->addMessage("system", text);
+    // Show away log summary if there were messages
+    if (!m_awayLog.isEmpty()) {
+      if (m_msgModel)
+        m_msgModel->addMessage(
+            "system", "You have " + QString::number(m_awayLog.size()) +
+                          " message(s) in your away log. Use View > Away "
+                          "Log to see them.");
+    }
+  });
+
+  on({306}, [this](IrcConnection *, const QString &srv, int,
+                   const QStringList &, const QString &trailing) {
+    // You have been marked as being away
+    m_isAway = true;
+    m_awayLog.clear();
+    emit awayStateChanged(true);
+    QString text =
+        trailing.isEmpty() ? "You have been marked as being away" : trailing;
+    appendToChannel(srv, m_activeChannel.isEmpty() ? srv : m_activeChannel,
+                    "system", text);
+    if (m_msgModel)
+      m_msgModel->addMessage("system", text);
+  });
+
+  // ── MONITOR notify list: RPL_MONONLINE (730) / RPL_MONOFFLINE (731) ──
+  on({730, 731}, [this](IrcConnection *, const QString &srv, int code,
+                        const QStringList &, const QString &trailing) {
+    // trailing: comma-separated nick[!user@host] list
+    const QStringList targets = trailing.split(',', Qt::SkipEmptyParts);
+    for (const QString &t : targets) {
+      QString nick = t.section('!', 0, 0).trimmed();
+      if (nick.isEmpty()) continue;
+      bool online = (code == 730);
+      QString text = nick + (online
+          ? QStringLiteral(" is online (notify)")
+          : QStringLiteral(" is offline (notify)"));
+      appendToChannel(srv, srv, "system", text);
+      if (m_msgModel && m_activeServer == srv)
+        m_msgModel->addMessage("system", text);
+      if (online)
+        emit notifyUser(QStringLiteral("Notify"), text, false, false);
+    }
+  });
+
+  // ═══════════════════════════════════════════════════
+  //  Server text: welcome burst, LUSERS, MOTD
+  // ═══════════════════════════════════════════════════
+
+  on({2, 3, 4, 5, 251, 252, 253, 254, 255, 265, 266, 372, 373, 374, 375, 376},
+     [serverText](IrcConnection *, const QString &srv, int,
+                  const QStringList &, const QString &trailing) {
+       serverText(srv, trailing);
+     });
+
+  // ═══════════════════════════════════════════════════
+  //  Error numerics (400–599)
+  // ═══════════════════════════════════════════════════
+  // Route to the relevant channel if mentioned in params, else server tab.
+  const NumericHandler errorHandler =
+      [this](IrcConnection *, const QString &srv, int code,
+             const QStringList &params, const QString &trailing) {
+        QString text = "[" + QString::number(code) + "] " + trailing;
+        // Some error numerics mention a channel in params (e.g. 404 #channel
+        // :Cannot send)
+        QString dest = srv;
+        for (int pi = 1; pi < params.size(); pi++) {
+          if (params[pi].startsWith('#') || params[pi].startsWith('&')) {
+            dest = params[pi];
+            break;
+          }
+        }
+        appendToChannel(srv, dest, "error", text);
+        if (m_msgModel && m_activeServer == srv && m_activeChannel == dest)
+          m_msgModel->addMessage("error", text);
+      };
+  for (int code = 400; code < 600; ++code)
+    registerNumericHandler(code, errorHandler);
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <QObject>
+#include <QList>
+#include <QStringList>
 
 class IrcConnection;
 
@@ -11,6 +13,10 @@ public:
     virtual void initialize(QObject *parent) = 0;
     // called when a message arrives on a channel; return true if handled
     virtual bool handleCommand(const QString &command, const QStringList &args, IrcConnection *connection) { Q_UNUSED(command); Q_UNUSED(args); Q_UNUSED(connection); return false; }
+    // numerics this plugin wants; handleNumeric() is called for each of them
+    // from the manager's numeric dispatch table, after the built-in handlers
+    virtual QList<int> numerics() const { return {}; }
+    virtual void handleNumeric(int code, const QStringList &params, const QString &trailing, IrcConnection *connection) { Q_UNUSED(code); Q_UNUSED(params); Q_UNUSED(trailing); Q_UNUSED(connection); }
 };
 
 #define PluginInterface_iid "com.nuchat.PluginInterface"
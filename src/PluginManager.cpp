@@ -1,4 +1,5 @@
 #include "PluginManager.h"
+#include "IRCConnectionManager.h"
 #include "PluginInterface.h"
 
 #include <QDir>
@@ -8,7 +9,13 @@
 
 PluginManager::PluginManager(QObject *parent) : QObject(parent) {}
 
-PluginManager::~PluginManager() { qDeleteAll(plugins); }
+PluginManager::~PluginManager() {
+  if (m_mgr) {
+    for (int id : std::as_const(m_numericHandlerIds))
+      m_mgr->unregisterNumericHandler(id);
+  }
+  qDeleteAll(plugins);
+}
 
 static const QStringList kPluginExtensions =
 #if defined(Q_OS_WIN)
@@ -51,6 +58,17 @@ void PluginManager::loadPlugins(const QString &directory) {
 
     pi->initialize(this);
     plugins.append(pi);
+    if (m_mgr) {
+      for (int code : pi->numerics()) {
+        int id = m_mgr->registerNumericHandler(
+            code, [pi](IrcConnection *conn, const QString &, int c,
+                       const QStringList &params, const QString &trailing) {
+              pi->handleNumeric(c, params, trailing, conn);
+            });
+        if (id >= 0)
+          m_numericHandlerIds.append(id);
+      }
+    }
     qDebug() << "[Plugins] Loaded" << file;
   }
 }
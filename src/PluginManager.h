@@ -5,6 +5,7 @@
 
 class PluginInterface;
 class IrcConnection;
+class IRCConnectionManager;
 
 class PluginManager : public QObject
 {
@@ -13,6 +14,9 @@ public:
     explicit PluginManager(QObject *parent = nullptr);
     ~PluginManager();
 
+    // Plugins loaded after this get their numerics() hooked into the
+    // manager's numeric dispatch table.
+    void setConnectionManager(IRCConnectionManager *mgr) { m_mgr = mgr; }
     void loadPlugins(const QString &directory);
 
 public slots:
@@ -20,4 +24,6 @@ public slots:
 
 private:
     QVector<PluginInterface*> plugins;
+    IRCConnectionManager *m_mgr = nullptr;
+    QVector<int> m_numericHandlerIds;
 };
@@ -742,8 +742,9 @@ void PythonScriptEngine::command(const QString &cmd)
     if (!trimmed.startsWith('/'))
         trimmed = "/" + trimmed;
 
-    // Route through the manager's sendMessage which handles /commands
-    m_mgr->sendMessage("", trimmed);
+    // Route through the manager's sendMessage which handles /commands;
+    // script output queues behind anything the user types
+    m_mgr->sendBulkMessage(m_mgr->activeConnection(), "", trimmed);
 }
 
 void PythonScriptEngine::prnt(const QString &text)
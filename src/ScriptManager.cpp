@@ -1,4 +1,5 @@
 #include "ScriptManager.h"
+#include "IRCConnectionManager.h"
 #include "IrcConnection.h"
 #include <QDebug>
 #include <QDir>
@@ -14,13 +15,67 @@ ScriptManager::ScriptManager(QObject *parent) : QObject(parent) {
   QJSValue global = m_engine.globalObject();
   // In Qt6, print/console is generally accessible or evaluating isn't needed
   // here. Qt automatically injects console.log
+  global.setProperty("nuchat", m_engine.newQObject(this));
 #endif
 }
 
 ScriptManager::~ScriptManager() {
-  // nothing special; avoid tearing down Qt objects at exit
+  // Handlers in the manager's numeric table capture this object
+  const auto files = m_numericHandlers.keys();
+  for (const QString &file : files)
+    unregisterNumerics(file);
 }
 
+IRCConnectionManager *ScriptManager::manager() const {
+  return qobject_cast<IRCConnectionManager *>(parent());
+}
+
+void ScriptManager::unregisterNumerics(const QString &file) {
+  const QVector<int> ids = m_numericHandlers.take(file);
+  if (auto *mgr = manager()) {
+    for (int id : ids)
+      mgr->unregisterNumericHandler(id);
+  }
+}
+
+void ScriptManager::evaluateFile(const QString &path, const QString &name) {
+#if HAVE_QJSE
+  QFile f(path);
+  if (!f.open(QIODevice::ReadOnly))
+    return;
+  // Re-evaluating a script re-registers its handlers; drop the old ones
+  unregisterNumerics(path);
+  m_currentFile = path;
+  m_engine.evaluate(f.readAll(), name);
+  m_currentFile.clear();
+#else
+  Q_UNUSED(path)
+  Q_UNUSED(name)
+#endif
+}
+
+#if HAVE_QJSE
+int ScriptManager::registerNumeric(int code, const QJSValue &callback) {
+  auto *mgr = manager();
+  if (!mgr || !callback.isCallable())
+    return -1;
+  int id = mgr->registerNumericHandler(
+      code, [this, callback](IrcConnection *conn, const QString &, int c,
+                             const QStringList &params,
+                             const QString &trailing) {
+        QJSValueList args;
+        args << m_engine.newQObject(conn);
+        args << c;
+        args << m_engine.toScriptValue(params);
+        args << trailing;
+        callback.call(args);
+      });
+  if (id >= 0)
+    m_numericHandlers[m_currentFile].append(id);
+  return id;
+}
+#endif
+
 void ScriptManager::loadScripts(const QString &directory) {
 #if HAVE_QJSE
   m_directory = directory;
@@ -30,13 +85,8 @@ void ScriptManager::loadScripts(const QString &directory) {
   connect(watcher, &QFileSystemWatcher::fileChanged, this,
           &ScriptManager::onFileChanged);
 
-  for (const QString &file : dir.entryList({"*.js"}, QDir::Files)) {
-    QFile f(dir.filePath(file));
-    if (f.open(QIODevice::ReadOnly)) {
-      QString code = f.readAll();
-      m_engine.evaluate(code, file);
-    }
-  }
+  for (const QString &file : dir.entryList({"*.js"}, QDir::Files))
+    evaluateFile(dir.filePath(file), file);
 #endif
 }
 
@@ -61,11 +111,7 @@ void ScriptManager::handleMessage(IrcConnection *conn, const QString &sender,
 void ScriptManager::onFileChanged(const QString &path) {
 #if HAVE_QJSE
   // reload changed file
-  QFile f(path);
-  if (f.open(QIODevice::ReadOnly)) {
-    QString code = f.readAll();
-    m_engine.evaluate(code, path);
-  }
+  evaluateFile(path, path);
 #else
   Q_UNUSED(path)
 #endif
@@ -2,6 +2,8 @@
 
 #include <QObject>
 #include <QFileSystemWatcher>
+#include <QHash>
+#include <QVector>
 
 #if __has_include(<QJSEngine>)
 #include <QJSEngine>
@@ -11,6 +13,7 @@
 #endif
 
 class IrcConnection;
+class IRCConnectionManager;
 
 class ScriptManager : public QObject
 {
@@ -22,12 +25,26 @@ public:
 
     void handleMessage(IrcConnection *conn, const QString &sender, const QString &message);
 
+#if HAVE_QJSE
+    // Exposed to scripts as nuchat.registerNumeric(code, function(conn,
+    // code, params, trailing) {...}).  Handlers go into the connection
+    // manager's numeric dispatch table and are dropped when their script is
+    // reloaded.
+    Q_INVOKABLE int registerNumeric(int code, const QJSValue &callback);
+#endif
+
 private slots:
     void onFileChanged(const QString &path);
 
 private:
+    void evaluateFile(const QString &path, const QString &name);
+    void unregisterNumerics(const QString &file);
+    IRCConnectionManager *manager() const;
+
 #if HAVE_QJSE
     QJSEngine m_engine;
 #endif
     QString m_directory;
+    QString m_currentFile;                         // script being evaluated
+    QHash<QString, QVector<int>> m_numericHandlers; // file -> handler ids
 };
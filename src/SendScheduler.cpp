@@ -0,0 +1,126 @@
+#include "SendScheduler.h"
+
+SendScheduler::Profile SendScheduler::profileNamed(const QString &name) {
+  if (name.compare(QLatin1String("strict"), Qt::CaseInsensitive) == 0)
+    return {QStringLiteral("strict"), 10000, 2000, 120};
+  if (name.compare(QLatin1String("relaxed"), Qt::CaseInsensitive) == 0)
+    return {QStringLiteral("relaxed"), 4000, 250, 2048};
+  // A short line costs about 1.1 s against the 8 s window: a burst of
+  // about 7, then a line a second, while long lines pay for their length
+  return {QStringLiteral("default"), 8000, 1000, 512};
+}
+
+QStringList SendScheduler::profileNames() {
+  return {QStringLiteral("default"), QStringLiteral("strict"),
+          QStringLiteral("relaxed")};
+}
+
+SendScheduler::SendScheduler(const Profile &profile) : m_profile(profile) {}
+
+qint64 SendScheduler::cost(qsizetype bytes) const {
+  bytes += 2; // CRLF
+  qint64 ms = m_profile.lineCostMs;
+  if (m_profile.bytesPerSecond > 0)
+    ms += bytes * 1000 / m_profile.bytesPerSecond;
+  return ms;
+}
+
+QByteArray SendScheduler::targetOf(const QByteArray &line) {
+  qsizetype pos = 0;
+  if (line.startsWith('@')) {
+    pos = line.indexOf(' ');
+    if (pos < 0)
+      return {};
+    ++pos;
+  }
+  qsizetype end = line.indexOf(' ', pos);
+  if (end < 0)
+    return {};
+  const QByteArrayView command(line.constData() + pos, end - pos);
+  if (command.compare("PRIVMSG", Qt::CaseInsensitive) != 0 &&
+      command.compare("NOTICE", Qt::CaseInsensitive) != 0 &&
+      command.compare("TAGMSG", Qt::CaseInsensitive) != 0)
+    return {};
+  pos = end + 1;
+  end = line.indexOf(' ', pos);
+  if (end < 0)
+    end = line.size();
+  return line.mid(pos, end - pos).toLower();
+}
+
+void SendScheduler::enqueue(Lane lane, const QByteArray &line) {
+  Queue &queue = m_lanes[int(lane)];
+  const QByteArray target = targetOf(line);
+  QQueue<QByteArray> &pending = queue.byTarget[target];
+  if (pending.isEmpty())
+    queue.turns.enqueue(target);
+  pending.enqueue(line);
+  ++queue.lines;
+  m_queuedBytes += line.size();
+  m_peakDepth = qMax(m_peakDepth, depth());
+}
+
+const QByteArray &SendScheduler::head(const Queue &queue) const {
+  return queue.byTarget.constFind(queue.turns.head())->head();
+}
+
+QByteArray SendScheduler::take(Queue &queue) {
+  const QByteArray target = queue.turns.dequeue();
+  auto it = queue.byTarget.find(target);
+  QByteArray line = it->dequeue();
+  if (it->isEmpty())
+    queue.byTarget.erase(it);
+  else
+    queue.turns.enqueue(target); // back of the line for this target
+  --queue.lines;
+  return line;
+}
+
+bool SendScheduler::next(qint64 now, QByteArray &line) {
+  for (int lane = 0; lane < kLanes; ++lane) {
+    Queue &queue = m_lanes[lane];
+    if (queue.lines == 0)
+      continue;
+    const qint64 c = cost(head(queue).size());
+    // An idle clock always lets one line through, even one that costs
+    // more than the whole window.  Lower lanes wait behind a blocked one.
+    if (lane != int(Lane::Control) && m_clock > now &&
+        m_clock + c - now > m_profile.windowMs)
+      return false;
+    line = take(queue);
+    m_clock = qMax(m_clock, now) + c;
+    m_queuedBytes -= line.size();
+    ++m_sent[lane];
+    return true;
+  }
+  return false;
+}
+
+qint64 SendScheduler::delayUntilNext(qint64 now) const {
+  for (int lane = 0; lane < kLanes; ++lane) {
+    const Queue &queue = m_lanes[lane];
+    if (queue.lines == 0)
+      continue;
+    if (lane == int(Lane::Control) || m_clock <= now)
+      return 0;
+    const qint64 c = cost(head(queue).size());
+    const qint64 fits = m_clock + c - m_profile.windowMs - now;
+    return qMax<qint64>(0, qMin(fits, m_clock - now));
+  }
+  return -1;
+}
+
+void SendScheduler::clear() {
+  for (Queue &queue : m_lanes)
+    queue = Queue();
+  m_clock = 0;
+  m_queuedBytes = 0;
+  m_peakDepth = 0;
+}
+
+int SendScheduler::depth() const {
+  int lines = 0;
+  for (const Queue &queue : m_lanes)
+    lines += queue.lines;
+  return lines;
+}
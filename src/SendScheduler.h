@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QQueue>
+#include <QString>
+#include <QStringList>
+#include <array>
+
+// Outgoing flood control for one connection.
+//
+// Servers throttle clients with a penalty clock (ircd's "since" time):
+// every line pushes the client's clock ahead by a fixed cost plus a cost
+// per byte, and the server stops reading once the clock runs more than a
+// window ahead of real time.  The scheduler keeps the same clock and only
+// releases a line while doing so stays inside the window, so a long paste
+// costs what the server will charge for it and never earns an Excess
+// Flood.
+//
+// Lines wait in one of three lanes, always drained in priority order:
+// Control (registration, CAP/SASL, lag PINGs, QUIT) goes out at once and is
+// only charged, Interactive (what the user typed, automatic WHO/MODE
+// queries) next, Bulk (pastes, script output) last.  Within a lane, the
+// queues of different targets take turns, so a paste to one channel
+// doesn't hold up lines to another.
+//
+// Time is passed in (milliseconds on any monotonic clock), so the class
+// does no I/O and no timing of its own.
+class SendScheduler {
+public:
+  enum class Lane { Control, Interactive, Bulk };
+  static constexpr int kLanes = 3;
+
+  struct Profile {
+    QString name;
+    qint64 windowMs;    // how far ahead of real time the clock may run
+    int lineCostMs;     // charged for every line
+    int bytesPerSecond; // plus one second per this many bytes; 0 = none
+  };
+  // "default", "strict" (classic ircd: 2 s + 1 s per 120 bytes) and
+  // "relaxed" (bouncers, networks with raised limits).  Unknown names give
+  // the default profile.
+  static Profile profileNamed(const QString &name);
+  static QStringList profileNames();
+
+  explicit SendScheduler(const Profile &profile = profileNamed(QString()));
+
+  const Profile &profile() const { return m_profile; }
+  void setProfile(const Profile &profile) { m_profile = profile; }
+
+  // line is one IRC line without CRLF
+  void enqueue(Lane lane, const QByteArray &line);
+  // Pops the next line that may be sent at `now`; false if none may.
+  bool next(qint64 now, QByteArray &line);
+  // Milliseconds from `now` until next() can release a line; 0 if it can
+  // now, -1 if nothing is queued.
+  qint64 delayUntilNext(qint64 now) const;
+  // Drops everything queued and forgets the clock (new connection).
+  void clear();
+
+  // ── Metrics ──
+  int depth(Lane lane) const { return m_lanes[int(lane)].lines; }
+  int depth() const;
+  qint64 queuedBytes() const { return m_queuedBytes; }
+  int peakDepth() const { return m_peakDepth; } // since the last clear()
+  quint64 sentLines(Lane lane) const { return m_sent[int(lane)]; }
+  // How far the penalty clock runs ahead of `now`
+  qint64 backlogMs(qint64 now) const { return qMax<qint64>(0, m_clock - now); }
+
+  qint64 cost(qsizetype bytes) const;
+  // Fairness key: the target of PRIVMSG/NOTICE/TAGMSG, folded to ASCII
+  // lower case; empty for everything else.
+  static QByteArray targetOf(const QByteArray &line);
+
+private:
+  struct Queue {
+    QHash<QByteArray, QQueue<QByteArray>> byTarget;
+    QQueue<QByteArray> turns; // targets with lines waiting, next one first
+    int lines = 0;
+  };
+  const QByteArray &head(const Queue &queue) const;
+  QByteArray take(Queue &queue);
+
+  Profile m_profile;
+  std::array<Queue, kLanes> m_lanes;
+  std::array<quint64, kLanes> m_sent{};
+  qint64 m_clock = 0;
+  qint64 m_queuedBytes = 0;
+  int m_peakDepth = 0;
+};
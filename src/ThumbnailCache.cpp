@@ -0,0 +1,88 @@
+#include "ThumbnailCache.h"
+#include <QImageReader>
+#include <QMutexLocker>
+
+ThumbnailCache::ThumbnailCache(qint64 budgetBytes) : m_cache(budgetBytes) {}
+
+ThumbnailCache *ThumbnailCache::instance() {
+  static ThumbnailCache cache;
+  return &cache;
+}
+
+void ThumbnailCache::insert(const QString &key, const QImage &image) {
+  if (image.isNull())
+    return;
+  QMutexLocker lock(&m_mutex);
+  m_cache.insert(key, new QImage(image), image.sizeInBytes());
+}
+
+QImage ThumbnailCache::find(const QString &key) const {
+  QMutexLocker lock(&m_mutex);
+  const QImage *image = m_cache.object(key);
+  return image ? *image : QImage();
+}
+
+QImage ThumbnailCache::load(const QString &path) {
+  QImage image = find(path);
+  if (!image.isNull())
+    return image;
+  // Decoded outside the lock; two threads missing on the same path both
+  // decode it, and the second insert replaces the first.
+  image.load(path);
+  insert(path, image);
+  return image;
+}
+
+void ThumbnailCache::clear() {
+  QMutexLocker lock(&m_mutex);
+  m_cache.clear();
+}
+
+void ThumbnailCache::setBudget(qint64 bytes) {
+  QMutexLocker lock(&m_mutex);
+  m_cache.setMaxCost(bytes);
+}
+
+qint64 ThumbnailCache::budget() const {
+  QMutexLocker lock(&m_mutex);
+  return m_cache.maxCost();
+}
+
+qint64 ThumbnailCache::bytes() const {
+  QMutexLocker lock(&m_mutex);
+  return m_cache.totalCost();
+}
+
+int ThumbnailCache::count() const {
+  QMutexLocker lock(&m_mutex);
+  return int(m_cache.count());
+}
+
+QImage ThumbnailCache::decodeScaled(const QString &path, int maxWidth,
+                                    QSize *originalSize) {
+  QImageReader reader(path);
+  reader.setAutoTransform(true);
+  const QSize stored = reader.size();
+  QSize upright = stored;
+  if (reader.transformation() & QImageIOHandler::TransformationRotate90)
+    upright.transpose();
+
+  // Let the reader scale while decoding when it knows the size (JPEG then
+  // decodes at a fraction of the resolution); the scaled size is in the
+  // file's own orientation, before the EXIF rotation.
+  if (upright.isValid() && upright.width() > maxWidth) {
+    const double f = double(maxWidth) / upright.width();
+    reader.setScaledSize(QSize(qMax(1, qRound(stored.width() * f)),
+                               qMax(1, qRound(stored.height() * f))));
+  }
+  QImage image = reader.read();
+  if (image.isNull())
+    return image;
+  if (!upright.isValid())
+    upright = image.size();
+  if (image.width() > maxWidth)
+    image = image.scaledToWidth(maxWidth, Qt::SmoothTransformation);
+  if (originalSize)
+    *originalSize = upright;
+  return image;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+
+// Decoded inline-image thumbnails, shared by ImageDownloader's decode pool
+// and the image provider that hands them to the chat view.
+//
+// An LRU bounded by bytes of pixel data rather than by entry count, so a
+// channel full of screenshots costs the budget and no more: a lookup makes
+// the image the most recent one, and an insert past the budget drops the
+// least recent.  Safe to use from any thread.
+class ThumbnailCache {
+public:
+  static constexpr qint64 kDefaultBudget = 64 * 1024 * 1024;
+
+  explicit ThumbnailCache(qint64 budgetBytes = kDefaultBudget);
+  static ThumbnailCache *instance();
+
+  // Keys are the thumbnails' file paths.  An image larger than the whole
+  // budget is not kept.
+  void insert(const QString &key, const QImage &image);
+  QImage find(const QString &key) const; // null if not in memory
+  // find(), or else the file at path decoded and inserted
+  QImage load(const QString &path);
+  void clear();
+
+  void setBudget(qint64 bytes);
+  qint64 budget() const;
+  qint64 bytes() const;
+  int count() const;
+
+  // The image at path, scaled down (never up) to at most maxWidth and
+  // turned upright per its EXIF orientation.  originalSize gets the size
+  // before scaling.  Null if the file can't be decoded.
+  static QImage decodeScaled(const QString &path, int maxWidth,
+                             QSize *originalSize = nullptr);
+
+private:
+  mutable QMutex m_mutex;
+  mutable QCache<QString, QImage> m_cache; // cost = bytes
+};
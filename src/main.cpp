@@ -12,12 +12,15 @@
 #include <windows.h>
 #endif
 
+#include "ChatDocument.h"
 #include "DccManager.h"
 #include "IRCConnectionManager.h"
 #include "ImageDownloader.h"
 #include "IrcConnection.h"
+#include "LogSearch.h"
 #include "Logger.h"
 #include "MessageModel.h"
+#include "NickListModel.h"
 #include "NotificationManager.h"
 #include "PluginManager.h"
 #include "ScriptManager.h"
@@ -62,14 +65,20 @@ int main(int argc, char *argv[]) {
   qmlRegisterType<ThemeManager>("NUchat", 1, 0, "ThemeManager");
   qmlRegisterType<ServerChannelModel>("NUchat", 1, 0, "ServerChannelModel");
   qmlRegisterType<MessageModel>("NUchat", 1, 0, "MessageModel");
+  qmlRegisterUncreatableType<NickListModel>(
+      "NUchat", 1, 0, "NickListModel", "Use ircManager.nickList");
+  qmlRegisterType<ChatDocument>("NUchat", 1, 0, "ChatDocument");
 #ifdef HAVE_HUNSPELL
   qmlRegisterType<SpellHighlighter>("NUchat", 1, 0, "SpellHighlighter");
   qmlRegisterType<SpellChecker>("NUchat", 1, 0, "SpellChecker");
 #endif
 #endif
 
-  IRCConnectionManager manager;
+  // The logger outlives the manager: disconnects during the manager's
+  // teardown still write to it.
   Logger logger;
+  LogSearch logSearch(&logger);
+  IRCConnectionManager manager;
   ThemeManager themeManager;
   ServerChannelModel treeModel;
   MessageModel msgModel;
@@ -162,6 +171,7 @@ int main(int argc, char *argv[]) {
   engine.rootContext()->setContextProperty("themeManager", &themeManager);
   engine.rootContext()->setContextProperty("treeModel", &treeModel);
   engine.rootContext()->setContextProperty("msgModel", &msgModel);
+  engine.rootContext()->setContextProperty("logSearch", &logSearch);
   engine.rootContext()->setContextProperty("scriptMgr", scriptMgr);
   engine.rootContext()->setContextProperty("pluginMgr", &pluginMgr);
 #ifdef HAVE_PYTHON
@@ -174,6 +184,10 @@ int main(int argc, char *argv[]) {
   engine.rootContext()->setContextProperty("notifyMgr", &notifyMgr);
   engine.rootContext()->setContextProperty("imgDownloader",
                                            ImageDownloader::instance());
+  // Inline image embeds: decoded thumbnails, never the originals
+  engine.addImageProvider(
+      QStringLiteral("thumbnails"),
+      new ThumbnailProvider(ImageDownloader::instance()->cacheDir()));
   // DCC file transfer manager
   DccManager dccManager;
   QString dccDownDir = appSettings.value("dcc/downloadDir", QDir::homePath() + "/Downloads").toString();
@@ -188,6 +202,7 @@ int main(int argc, char *argv[]) {
 #endif
 
   // load plugins from build/plugins (or install directory)
+  pluginMgr.setConnectionManager(&manager);
   pluginMgr.loadPlugins(QCoreApplication::applicationDirPath() + "/../plugins");
 
   // when a new connection is added, hook it to plugin and script managers
@@ -0,0 +1,51 @@
+#include <QtTest>
+#include "ChangeAggregator.h"
+
+class TestChangeAggregator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testCoalescesPerFrame()
+    {
+        ChangeAggregator agg;
+        int flushes = 0;
+        QHash<int, ChangeAggregator::Changes> last;
+        connect(&agg, &ChangeAggregator::flushed, this,
+                [&](const QHash<int, ChangeAggregator::Changes> &c) { ++flushes; last = c; });
+
+        for (int i = 0; i < 1000; ++i)
+            agg.mark(i % 3, ChangeAggregator::Activity);
+        agg.mark(1, ChangeAggregator::Users);
+        agg.mark(-1, ChangeAggregator::Users); // unknown channel: ignored
+        QVERIFY(agg.isPending());
+        QCOMPARE(flushes, 0);
+
+        QTRY_COMPARE_WITH_TIMEOUT(flushes, 1, 1000);
+        QVERIFY(!agg.isPending());
+        QCOMPARE(last.size(), 3);
+        QVERIFY(last.value(0) == ChangeAggregator::Changes(ChangeAggregator::Activity));
+        QVERIFY(last.value(1) == (ChangeAggregator::Activity | ChangeAggregator::Users));
+
+        // Nothing more to deliver
+        QTest::qWait(3 * ChangeAggregator::kFrameMs);
+        QCOMPARE(flushes, 1);
+    }
+
+    void testFlushNow()
+    {
+        ChangeAggregator agg;
+        int flushes = 0;
+        connect(&agg, &ChangeAggregator::flushed, this, [&flushes] { ++flushes; });
+        agg.flush();
+        QCOMPARE(flushes, 0);
+        agg.mark(7, ChangeAggregator::Users);
+        agg.flush();
+        QCOMPARE(flushes, 1);
+        QTest::qWait(3 * ChangeAggregator::kFrameMs);
+        QCOMPARE(flushes, 1);
+    }
+};
+
+QTEST_MAIN(TestChangeAggregator)
+#include "test_changeaggregator.moc"
@@ -0,0 +1,139 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include "ChannelHistory.h"
+
+// ChannelHistory keeps the newest `capacity` lines of a channel in a ring,
+// with the text packed into blocks that are released as lines age out.
+class TestChannelHistory : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testAppendAndEvict()
+    {
+        ChannelHistory h(3);
+        QVERIFY(h.isEmpty());
+        h.append(ChannelHistory::Type::Chat, u"<a> one", 1000);
+        h.append(ChannelHistory::Type::Action, u"* a waves", 2000);
+        h.append(ChannelHistory::Type::System, u"a has joined", 3000);
+        QCOMPARE(h.size(), 3);
+        QCOMPARE(h.textAt(0).toString(), QString("<a> one"));
+
+        h.append(ChannelHistory::Type::Error, u"oops", 4000);
+        QCOMPARE(h.size(), 3);
+        QCOMPARE(h.textAt(0).toString(), QString("* a waves"));
+        QVERIFY(h.typeAt(0) == ChannelHistory::Type::Action);
+        QCOMPARE(h.timestampAt(0), qint64(2000));
+        const ChannelHistory::Line last = h.at(2);
+        QVERIFY(last.type == ChannelHistory::Type::Error);
+        QCOMPARE(last.text, QString("oops"));
+        QCOMPARE(last.timestamp, qint64(4000));
+
+        h.clear();
+        QVERIFY(h.isEmpty());
+        h.append(ChannelHistory::Type::Chat, u"again", 5000);
+        QCOMPARE(h.textAt(0).toString(), QString("again"));
+    }
+
+    void testInsertOlder()
+    {
+        using Type = ChannelHistory::Type;
+        ChannelHistory h(6);
+        h.insertOlder(0, {{Type::System, "── Scrollback from #c ──", 0},
+                          {Type::Chat, "<x> old", 10},
+                          {Type::System, "── End of scrollback ──", 0}});
+        h.append(Type::Chat, u"<y> new", 20);
+        QCOMPARE(h.size(), 4);
+
+        // Below the header; only two fit, the oldest of the three is dropped
+        QCOMPARE(h.insertOlder(1, {{Type::Chat, "<x> first", 1},
+                                   {Type::Chat, "<x> second", 2},
+                                   {Type::Chat, "<x> third", 3}}), 2);
+        const QStringList expected = {"── Scrollback from #c ──", "<x> second",
+                                      "<x> third", "<x> old",
+                                      "── End of scrollback ──", "<y> new"};
+        QCOMPARE(h.size(), expected.size());
+        for (int i = 0; i < h.size(); ++i)
+            QCOMPARE(h.textAt(i).toString(), expected.at(i));
+        QCOMPARE(h.insertOlder(1, {{Type::Chat, "<x> zeroth", 0}}), 0);
+
+        // Full: appending keeps evicting from the front in order
+        h.append(Type::Chat, u"<y> newer", 30);
+        QCOMPARE(h.textAt(0).toString(), QString("<x> second"));
+        QCOMPARE(h.textAt(5).toString(), QString("<y> newer"));
+    }
+
+    void testTextBlocksAreReleased()
+    {
+        ChannelHistory h(100);
+        const QString line = QString("<nick> ") + QString(120, QChar('x'));
+        for (int i = 0; i < 100; ++i)
+            h.append(ChannelHistory::Type::Chat, line, i);
+        const qsizetype full = h.textCapacity();
+        for (int i = 0; i < 10000; ++i)
+            h.append(ChannelHistory::Type::Chat, line, i);
+        // Live text plus at most a block of slack at either end
+        QVERIFY(h.textCapacity() <= full + 2 * 8192);
+        QCOMPARE(h.size(), 100);
+
+        // A line longer than a block gets one of its own
+        const QString huge(20000, QChar('y'));
+        h.append(ChannelHistory::Type::System, huge, 0);
+        QCOMPARE(h.textAt(99).toString(), huge);
+        QCOMPARE(h.textAt(98).toString(), line);
+    }
+
+    void testTypesAndTimestamps()
+    {
+        using Type = ChannelHistory::Type;
+        for (const char *name : {"chat", "action", "system", "error", "embed"})
+            QCOMPARE(ChannelHistory::typeName(ChannelHistory::typeFromName(QString(name))),
+                     QString(name));
+        QVERIFY(ChannelHistory::typeFromName(u"notice") == Type::Chat);
+
+        const QDateTime t(QDate(2024, 3, 1), QTime(12, 34, 56));
+        QCOMPARE(ChannelHistory::parseTimestamp(u"2024-03-01 12:34:56"), t.toMSecsSinceEpoch());
+        QCOMPARE(ChannelHistory::parseTimestamp(u"2024-03-01T12:34:56"), t.toMSecsSinceEpoch());
+        QCOMPARE(ChannelHistory::parseTimestamp(u"2024-13-01 12:34:56"), qint64(0));
+        QCOMPARE(ChannelHistory::parseTimestamp(u""), qint64(0));
+        QCOMPARE(ChannelHistory::formatTimestamp(t.toMSecsSinceEpoch()),
+                 QString("2024-03-01T12:34:56"));
+        QVERIFY(ChannelHistory::formatTimestamp(0).isEmpty());
+    }
+
+    void benchAppend()
+    {
+        const int lines = qEnvironmentVariableIsSet("NUCHAT_BENCH_HISTORY_LINES")
+            ? qEnvironmentVariableIntValue("NUCHAT_BENCH_HISTORY_LINES") : 200000;
+        const int cap = 5000;
+        const QString text = "<someone> a fairly ordinary line of channel chatter";
+
+        // The old layout: three QStrings per line, front trimmed by remove()
+        struct Stored { QString type, text, timestamp; };
+        QElapsedTimer timer;
+        timer.start();
+        QVector<Stored> vec;
+        for (int i = 0; i < lines; ++i) {
+            vec.append({"chat", text, QDateTime::currentDateTime().toString(Qt::ISODate)});
+            if (vec.size() > cap)
+                vec.remove(0, vec.size() - cap);
+        }
+        const qint64 vecMs = timer.elapsed();
+
+        timer.restart();
+        ChannelHistory h(cap);
+        for (int i = 0; i < lines; ++i)
+            h.append(ChannelHistory::Type::Chat, text, QDateTime::currentMSecsSinceEpoch());
+        const qint64 ringMs = timer.elapsed();
+        QCOMPARE(h.size(), cap);
+        QCOMPARE(int(vec.size()), cap);
+
+        qInfo().noquote() << QString("%1 lines into a %2-line history: vector %3 ms, "
+                                     "ring %4 ms, %5 KiB of text blocks")
+                                 .arg(lines).arg(cap).arg(vecMs).arg(ringMs)
+                                 .arg(h.textCapacity() * 2 / 1024);
+    }
+};
+
+QTEST_MAIN(TestChannelHistory)
+#include "test_channelhistory.moc"
@@ -0,0 +1,63 @@
+#include <QtTest>
+#include "ChannelRegistry.h"
+
+// ChannelRegistry hands out one id per channel as the server defines
+// "same channel": its CASEMAPPING for channel names, case-insensitive
+// server names.
+class TestChannelRegistry : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testIntern()
+    {
+        ChannelRegistry reg;
+        QCOMPARE(reg.find("irc.example.org", "#chat"), -1);
+
+        const int chat = reg.intern("irc.example.org", "#Chat");
+        QCOMPARE(reg.intern("irc.example.org", "#chat"), chat);
+        QCOMPARE(reg.intern("IRC.Example.org", "#CHAT"), chat);
+        QCOMPARE(reg.find("irc.example.org", "#cHaT"), chat);
+        QCOMPARE(reg.channelName(chat), QString("#Chat"));
+        QCOMPARE(reg.serverName(chat), QString("irc.example.org"));
+        QVERIFY(reg.isOnServer(chat, "IRC.EXAMPLE.ORG"));
+
+        const int other = reg.intern("irc.other.net", "#chat");
+        QVERIFY(other != chat);
+        QVERIFY(!reg.isOnServer(other, "irc.example.org"));
+        QVERIFY(reg.intern("irc.example.org", "#dev") != chat);
+    }
+
+    void testCaseMapping()
+    {
+        using CaseMapping = ChannelRegistry::CaseMapping;
+        QVERIFY(ChannelRegistry::caseMappingFromName(u"ascii") == CaseMapping::Ascii);
+        QVERIFY(ChannelRegistry::caseMappingFromName(u"strict-rfc1459")
+                == CaseMapping::StrictRfc1459);
+        QVERIFY(ChannelRegistry::caseMappingFromName(u"rfc7613") == CaseMapping::Rfc1459);
+
+        ChannelRegistry reg;
+        // rfc1459 until the server says otherwise: [ ] \ ~ are { } | ^
+        const int a = reg.intern("srv", "#[a]~");
+        QCOMPARE(reg.find("srv", "#{A}^"), a);
+
+        reg.setCaseMapping("srv", CaseMapping::Ascii);
+        QVERIFY(reg.caseMapping("srv") == CaseMapping::Ascii);
+        QCOMPARE(reg.find("srv", "#[A]~"), a);
+        QCOMPARE(reg.find("srv", "#{a}^"), -1);
+        const int b = reg.intern("srv", "#{a}^");
+        QVERIFY(b != a);
+
+        reg.setCaseMapping("srv", CaseMapping::StrictRfc1459);
+        QCOMPARE(reg.find("srv", "#{a}~"), a);
+        QCOMPARE(reg.find("srv", "#{a}^"), b);
+
+        // Back to rfc1459 both fold to "#{a}^": the older id wins
+        reg.setCaseMapping("srv", CaseMapping::Rfc1459);
+        QCOMPARE(reg.find("srv", "#{a}^"), a);
+        QCOMPARE(reg.find("srv", "#[A]~"), a);
+    }
+};
+
+QTEST_MAIN(TestChannelRegistry)
+#include "test_channelregistry.moc"
@@ -0,0 +1,129 @@
+#include <QtTest>
+#include <QTextBlock>
+#include <QTextDocument>
+#include "ChatDocument.h"
+#include "MessageModel.h"
+
+// ChatDocument keeps one text block per visible MessageModel row; these
+// tests check the block list after appends, trimming, event-group changes
+// and prepends against what the model says should be shown.
+class TestChatDocument : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QString blockText(const QTextDocument &doc, int block)
+    {
+        return doc.findBlockByNumber(block).text();
+    }
+
+private slots:
+    void testAppend()
+    {
+        MessageModel model;
+        QTextDocument doc;
+        ChatDocument chat;
+        chat.setDocument(&doc);
+        chat.setModel(&model);
+        QCOMPARE(doc.blockCount(), 1);
+        QVERIFY(doc.isEmpty());
+
+        for (int i = 0; i < 5; ++i)
+            model.addMessage("chat", QString("<bob> line %1").arg(i));
+        QCOMPARE(doc.blockCount(), 5);
+        QVERIFY(blockText(doc, 0).contains("line 0"));
+        QVERIFY(blockText(doc, 4).contains("line 4"));
+        QVERIFY(!doc.isUndoRedoEnabled());
+    }
+
+    void testTrimToMaxLines()
+    {
+        MessageModel model;
+        QTextDocument doc;
+        ChatDocument chat;
+        chat.setMaxLines(10);
+        chat.setDocument(&doc);
+        chat.setModel(&model);
+
+        for (int i = 0; i < 30; ++i)
+            model.addMessage("chat", QString("<bob> line %1").arg(i));
+        QVERIFY(doc.blockCount() >= 10);
+        QVERIFY(doc.blockCount() <= 11);
+        QVERIFY(blockText(doc, doc.blockCount() - 1).contains("line 29"));
+        QVERIFY(blockText(doc, 0).contains(
+            QString("line %1").arg(chat.firstRow())));
+
+        // A larger cap re-lays out the newest rows only
+        chat.setMaxLines(20);
+        QCOMPARE(doc.blockCount(), 20);
+        QCOMPARE(chat.firstRow(), 10);
+        QVERIFY(blockText(doc, 0).contains("line 10"));
+    }
+
+    void testEventGroupInPlace()
+    {
+        MessageModel model;
+        QTextDocument doc;
+        ChatDocument chat;
+        chat.setDocument(&doc);
+        chat.setModel(&model);
+
+        model.addMessage("chat", "<bob> before");
+        model.addMessage("system", "alice has joined #c");
+        model.addMessage("system", "carol has joined #c");
+        QCOMPARE(doc.blockCount(), 3); // below the threshold: plain lines
+
+        model.addMessage("system", "dave has joined #c");
+        QCOMPARE(doc.blockCount(), 2);
+        QVERIFY(blockText(doc, 0).contains("before"));
+        QVERIFY(blockText(doc, 1).contains("3 events"));
+
+        // Growing the group only rewrites its summary
+        model.addMessage("system", "erin has quit (bye)");
+        QCOMPARE(doc.blockCount(), 2);
+        QVERIFY(blockText(doc, 1).contains("4 events"));
+
+        const int gid = model.index(1).data(MessageModel::RowHtmlRole)
+                            .toString().section("eventgroup://", 1).section('"', 0, 0)
+                            .toInt();
+        model.toggleEventGroup(gid);
+        QCOMPARE(doc.blockCount(), 5);
+        QVERIFY(blockText(doc, 1).contains("alice has joined"));
+        QVERIFY(blockText(doc, 4).contains("erin has quit"));
+
+        model.toggleEventGroup(gid);
+        QCOMPARE(doc.blockCount(), 2);
+
+        model.addMessage("chat", "<bob> after");
+        QCOMPARE(doc.blockCount(), 3);
+        QVERIFY(blockText(doc, 2).contains("after"));
+    }
+
+    void testPrependAndClear()
+    {
+        MessageModel model;
+        QTextDocument doc;
+        ChatDocument chat;
+        chat.setDocument(&doc);
+        chat.setModel(&model);
+
+        model.addMessage("system", "Scrollback from 2024-01-01");
+        model.addMessage("chat", "<bob> newest");
+        model.prependMessages({{"chat", "<bob> older 1", QString()},
+                               {"chat", "<bob> older 2", QString()}});
+        QCOMPARE(doc.blockCount(), 4);
+        QVERIFY(blockText(doc, 0).contains("Scrollback from"));
+        QVERIFY(blockText(doc, 1).contains("older 1"));
+        QVERIFY(blockText(doc, 2).contains("older 2"));
+        QVERIFY(blockText(doc, 3).contains("newest"));
+
+        model.clear();
+        QVERIFY(doc.isEmpty());
+        model.addMessage("chat", "<bob> fresh");
+        QCOMPARE(doc.blockCount(), 1);
+        QVERIFY(blockText(doc, 0).contains("fresh"));
+    }
+};
+
+QTEST_MAIN(TestChatDocument)
+#include "test_chatdocument.moc"
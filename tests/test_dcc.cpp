@@ -0,0 +1,213 @@
+#include <QtTest>
+#include <QCryptographicHash>
+#include <QRandomGenerator>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QtEndian>
+#include "DccEngine.h"
+
+class TestDcc : public QObject
+{
+    Q_OBJECT
+
+private:
+    static bool writeRandomFile(const QString &path, qint64 size)
+    {
+        QFile f(path);
+        if (!f.open(QIODevice::WriteOnly))
+            return false;
+        QByteArray block(1024 * 1024, '\0');
+        for (qint64 left = size; left > 0; left -= block.size()) {
+            QRandomGenerator::global()->fillRange(reinterpret_cast<quint32 *>(block.data()),
+                                                  block.size() / 4);
+            const qint64 n = qMin<qint64>(left, block.size());
+            if (f.write(block.constData(), n) != n)
+                return false;
+        }
+        return true;
+    }
+
+    static QByteArray sha1(const QString &path)
+    {
+        QFile f(path);
+        if (!f.open(QIODevice::ReadOnly))
+            return {};
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(&f);
+        return hash.result();
+    }
+
+    // A sender on the DCC thread, listening on a free port
+    static DccEngine *startSender(const QString &path, quint16 *port, bool turbo = false)
+    {
+        auto *sender = new DccEngine;
+        sender->moveToThread(DccEngine::transferThread());
+        QString error;
+        QMetaObject::invokeMethod(
+            sender, [&]() { *port = sender->listen(path, 0, turbo, &error); },
+            Qt::BlockingQueuedConnection);
+        return sender;
+    }
+
+    // Sends from to to over loopback; the time taken, -1 on failure
+    static qint64 transfer(const QString &from, const QString &to, qint64 size,
+                           bool turbo, bool *zeroCopy = nullptr)
+    {
+        quint16 port = 0;
+        DccEngine *sender = startSender(from, &port, turbo);
+        int sent = -1;
+        QObject context;
+        connect(sender, &DccEngine::finished, &context,
+                [&sent](bool ok) { sent = ok ? 1 : 0; });
+
+        DccEngine receiver;
+        int received = -1;
+        connect(&receiver, &DccEngine::finished, &context,
+                [&received](bool ok, const QString &error) {
+                    received = ok ? 1 : 0;
+                    if (!ok)
+                        qWarning() << "receive failed:" << error;
+                });
+
+        QElapsedTimer t;
+        t.start();
+        if (port != 0)
+            receiver.receive(to, QHostAddress(QHostAddress::LocalHost), port, size, turbo);
+        QDeadlineTimer deadline(120000);
+        while (port != 0 && (sent < 0 || received < 0) && !deadline.hasExpired())
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 50);
+        const qint64 ms = t.elapsed();
+
+        if (zeroCopy)
+            *zeroCopy = sender->zeroCopy();
+        sender->deleteLater();
+        return sent == 1 && received == 1 ? ms : -1;
+    }
+
+private slots:
+    void testBufferSize()
+    {
+        QCOMPARE(DccEngine::bufferSizeFor(0), DccEngine::kMinBuffer);
+        QCOMPARE(DccEngine::bufferSizeFor(qQNaN()), DccEngine::kMinBuffer);
+        QCOMPARE(DccEngine::bufferSizeFor(100.0 * 1024), DccEngine::kMinBuffer);
+        // 50 ms worth in between
+        QCOMPARE(DccEngine::bufferSizeFor(20.0 * 1024 * 1024), qint64(1024 * 1024));
+        QCOMPARE(DccEngine::bufferSizeFor(10e9), DccEngine::kMaxBuffer);
+        QCOMPARE(DccEngine::bufferSizeFor(qInf()), DccEngine::kMaxBuffer);
+    }
+
+    void testLoopback()
+    {
+        const qint64 mb = qEnvironmentVariableIntValue("NUCHAT_BENCH_DCC_MB") > 0
+                              ? qEnvironmentVariableIntValue("NUCHAT_BENCH_DCC_MB")
+                              : 64;
+        const qint64 size = mb * 1024 * 1024 + 12345; // not a multiple of any block
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString from = dir.filePath("from.bin");
+        const QString to = dir.filePath("to.bin");
+        QVERIFY(writeRandomFile(from, size));
+
+        bool zeroCopy = false;
+        const qint64 ms = transfer(from, to, size, false, &zeroCopy);
+        QVERIFY(ms >= 0);
+        QCOMPARE(QFileInfo(to).size(), size);
+        QCOMPARE(sha1(to), sha1(from));
+        qInfo("DCC loopback: %lld MB in %lld ms, %.0f MB/s (%s)", mb, ms,
+              mb * 1000.0 / qMax<qint64>(ms, 1), zeroCopy ? "sendfile" : "buffered");
+    }
+
+    void testTurbo()
+    {
+        const qint64 size = 8 * 1024 * 1024;
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString from = dir.filePath("from.bin");
+        const QString to = dir.filePath("to.bin");
+        QVERIFY(writeRandomFile(from, size));
+
+        // No ACKs at all: the sender is done when the receiver hangs up
+        QVERIFY(transfer(from, to, size, true) >= 0);
+        QCOMPARE(sha1(to), sha1(from));
+    }
+
+    void testLockstepSender()
+    {
+        // An old-style sender that waits for each block to be ACKed before
+        // sending the next: every block's ACK must go out as soon as it is in.
+        const int blocks = 500;
+        const qint64 blockSize = 4096;
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        QTcpServer server;
+        QVERIFY(server.listen(QHostAddress::LocalHost));
+        QTcpSocket *peer = nullptr;
+        qint64 sent = 0;
+        quint32 lastAck = 0;
+        auto sendBlock = [&]() {
+            peer->write(QByteArray(blockSize, char('a' + sent / blockSize)));
+            sent += blockSize;
+        };
+        connect(&server, &QTcpServer::newConnection, this, [&]() {
+            peer = server.nextPendingConnection();
+            connect(peer, &QTcpSocket::readyRead, this, [&]() {
+                while (peer->bytesAvailable() >= 4) {
+                    char ack[4];
+                    peer->read(ack, 4);
+                    lastAck = qFromBigEndian<quint32>(ack);
+                }
+                if (qint64(lastAck) == sent && sent < blocks * blockSize)
+                    sendBlock();
+            });
+            sendBlock();
+        });
+
+        DccEngine receiver;
+        QSignalSpy done(&receiver, &DccEngine::finished);
+        QElapsedTimer t;
+        t.start();
+        receiver.receive(dir.filePath("to.bin"), QHostAddress(QHostAddress::LocalHost),
+                         server.serverPort(), blocks * blockSize, false);
+        QVERIFY(done.wait(10000));
+        QVERIFY(done.first().at(0).toBool());
+        QCOMPARE(receiver.transferred(), blocks * blockSize);
+        // A loopback round trip per block: far below a millisecond each
+        QVERIFY2(t.elapsed() < blocks * 2,
+                 qPrintable(QString("%1 ms for %2 blocks").arg(t.elapsed()).arg(blocks)));
+        QTRY_COMPARE(lastAck, quint32(blocks * blockSize));
+    }
+
+    void testSenderNeedsFinalAck()
+    {
+        // The receiver takes every byte but hangs up without ACKing: the
+        // sender can't know it arrived, so it must not report success.
+        const qint64 size = 64 * 1024;
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString from = dir.filePath("from.bin");
+        QVERIFY(writeRandomFile(from, size));
+
+        quint16 port = 0;
+        DccEngine *sender = startSender(from, &port);
+        QVERIFY(port != 0);
+        int sent = -1;
+        connect(sender, &DccEngine::finished, this, [&sent](bool ok) { sent = ok ? 1 : 0; });
+
+        QTcpSocket peer;
+        qint64 got = 0;
+        connect(&peer, &QTcpSocket::readyRead, this, [&]() {
+            got += peer.readAll().size();
+            if (got >= size)
+                peer.disconnectFromHost();
+        });
+        peer.connectToHost(QHostAddress::LocalHost, port);
+        QTRY_VERIFY_WITH_TIMEOUT(sent >= 0, 10000);
+        QCOMPARE(got, size);
+        QCOMPARE(sent, 0);
+        sender->deleteLater();
+    }
+};
+
+QTEST_MAIN(TestDcc)
+#include "test_dcc.moc"
@@ -0,0 +1,100 @@
+#include <QtTest>
+#include "FetchScheduler.h"
+
+using Priority = FetchScheduler::Priority;
+
+class TestFetchScheduler : public QObject
+{
+    Q_OBJECT
+
+private:
+    static FetchScheduler::Job job(const QString &url, const QString &host,
+                                   quintptr group = 1,
+                                   Priority priority = Priority::Inline)
+    {
+        return {url, host, group, priority};
+    }
+
+    // URLs next() lets start right now
+    static QStringList startAll(FetchScheduler &s)
+    {
+        QStringList started;
+        FetchScheduler::Job j;
+        while (s.next(j))
+            started.append(j.url);
+        return started;
+    }
+
+private slots:
+    void testLimits()
+    {
+        FetchScheduler s(3, 2);
+        for (int i = 0; i < 50; ++i)
+            s.enqueue(job(QString("https://i.example/%1.png").arg(i), "i.example"));
+        s.enqueue(job("https://other.example/a.png", "other.example"));
+
+        // Two for the busy host, the third slot for the other one
+        QCOMPARE(startAll(s), QStringList({"https://i.example/0.png",
+                                           "https://i.example/1.png",
+                                           "https://other.example/a.png"}));
+        QCOMPARE(s.running("i.example"), 2);
+        QCOMPARE(s.queued(), 48);
+
+        s.finished("https://other.example/a.png");
+        // The free slot can't go to a host already at its limit
+        QVERIFY(startAll(s).isEmpty());
+        s.finished("https://i.example/0.png");
+        QCOMPARE(startAll(s), QStringList({"https://i.example/2.png"}));
+        QCOMPARE(s.running(), 2);
+    }
+
+    void testDeduplicates()
+    {
+        FetchScheduler s;
+        QVERIFY(s.enqueue(job("https://a/1.png", "a")));
+        QVERIFY(!s.enqueue(job("https://a/1.png", "a")));
+        QCOMPARE(s.queued(), 1);
+        QCOMPARE(startAll(s).size(), 1);
+        QVERIFY(s.isRunning("https://a/1.png"));
+        QVERIFY(!s.enqueue(job("https://a/1.png", "a")));
+        s.finished("https://a/1.png");
+        QVERIFY(s.enqueue(job("https://a/1.png", "a")));
+    }
+
+    void testExplicitFirst()
+    {
+        FetchScheduler s(1, 1);
+        s.enqueue(job("https://a/1.png", "a"));
+        s.enqueue(job("https://a/2.png", "a"));
+        s.enqueue(job("https://b/save.png", "b", 0, Priority::Explicit));
+        QCOMPARE(startAll(s), QStringList({"https://b/save.png"}));
+        s.finished("https://b/save.png");
+
+        // A queued embed the user then asks for is promoted
+        s.enqueue(job("https://a/2.png", "a", 0, Priority::Explicit));
+        QCOMPARE(startAll(s), QStringList({"https://a/2.png"}));
+        s.finished("https://a/2.png");
+        QCOMPARE(startAll(s), QStringList({"https://a/1.png"}));
+    }
+
+    void testCancelGroup()
+    {
+        FetchScheduler s(2, 2);
+        s.enqueue(job("https://a/1.png", "a", 1));
+        s.enqueue(job("https://a/2.png", "a", 2));
+        s.enqueue(job("https://a/3.png", "a", 1));
+        s.enqueue(job("https://a/4.png", "a", 2));
+        QCOMPARE(startAll(s), QStringList({"https://a/1.png", "https://a/2.png"}));
+
+        // The view of group 1 switched channel
+        QStringList dropped;
+        QCOMPARE(s.cancelGroup(1, &dropped), QStringList({"https://a/1.png"}));
+        QCOMPARE(dropped, QStringList({"https://a/3.png"}));
+        QCOMPARE(s.queued(), 1);
+        s.finished("https://a/1.png"); // aborted by the caller
+        QCOMPARE(startAll(s), QStringList({"https://a/4.png"}));
+    }
+};
+
+QTEST_MAIN(TestFetchScheduler)
+#include "test_fetchscheduler.moc"
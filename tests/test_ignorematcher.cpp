@@ -0,0 +1,125 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include "IgnoreMatcher.h"
+
+// The old IRCConnectionManager::isIgnored: a regex compiled per mask per
+// call, run for the prefix and again for the nick.
+static bool legacyIsIgnored(const QStringList &masks, const QString &nickOrMask)
+{
+    for (const QString &pattern : masks) {
+        QString regex = QRegularExpression::escape(pattern);
+        regex.replace("\\*", ".*").replace("\\?", ".");
+        QRegularExpression re("^" + regex + "$", QRegularExpression::CaseInsensitiveOption);
+        if (re.match(nickOrMask).hasMatch())
+            return true;
+        if (nickOrMask.contains('!')) {
+            const QString patternNick = pattern.section('!', 0, 0);
+            if (!patternNick.contains('*') && !patternNick.contains('?')
+                && nickOrMask.section('!', 0, 0).compare(patternNick, Qt::CaseInsensitive) == 0)
+                return true;
+        }
+    }
+    return false;
+}
+
+class TestIgnoreMatcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testExactNicks()
+    {
+        IgnoreMatcher m;
+        QVERIFY(m.isEmpty());
+        QVERIFY(!m.matches(u"bob!u@h"));
+
+        m.setMasks({"bob!*@*", "Carol", "[dan]!*"});
+        QVERIFY(!m.isEmpty());
+        QVERIFY(m.matches(u"bob!user@host.example"));
+        QVERIFY(m.matches(u"BOB!x@y"));
+        QVERIFY(m.matches(u"carol!c@example.org"));
+        QVERIFY(m.matches(u"carol")); // bare nick prefix
+        QVERIFY(!m.matches(u"bobby!user@host"));
+        // RFC 1459 case mapping: {dan} is [dan]
+        QVERIFY(m.matches(u"{DAN}!d@h"));
+        QVERIFY(!m.matches(u"dan!d@h"));
+    }
+
+    void testWildcards()
+    {
+        IgnoreMatcher m;
+        m.setMasks({"*!*@*.spam.example", "spam*", "?x!ident@*", "bob!*@evil.example"});
+        QVERIFY(m.matches(u"anyone!any@host.spam.example"));
+        QVERIFY(!m.matches(u"anyone!any@spam.example"));
+        QVERIFY(m.matches(u"spammer42!u@h"));
+        QVERIFY(m.matches(u"SPAM!u@h"));
+        QVERIFY(m.matches(u"ax!ident@whatever"));
+        QVERIFY(!m.matches(u"abx!ident@whatever"));
+        QVERIFY(!m.matches(u"ax!other@whatever"));
+        // A host-specific mask no longer ignores the nick everywhere
+        QVERIFY(m.matches(u"bob!b@evil.example"));
+        QVERIFY(!m.matches(u"bob!b@good.example"));
+
+        m.setMasks({});
+        QVERIFY(m.isEmpty());
+        QVERIFY(!m.matches(u"spammer42!u@h"));
+    }
+
+    void testMatchesLegacyOnFullMasks()
+    {
+        const QStringList masks = {"troll!*@*", "*!*@10.0.*", "*bot*!*@*",
+                                   "eve!~eve@*.example.net", "x?y!*@*"};
+        IgnoreMatcher m;
+        m.setMasks(masks);
+        const QStringList prefixes = {
+            "troll!t@h", "Troll!t@h", "alice!a@10.0.0.1", "alice!a@10.1.0.1",
+            "somebot1!b@h", "eve!~eve@a.example.net", "x1y!u@h", "xy!u@h",
+            "bob!b@h"};
+        for (const QString &prefix : prefixes)
+            QCOMPARE(m.matches(prefix), legacyIsIgnored(masks, prefix));
+    }
+
+    void benchFlood()
+    {
+        const int masks = qEnvironmentVariableIsSet("NUCHAT_BENCH_IGNORE_MASKS")
+            ? qEnvironmentVariableIntValue("NUCHAT_BENCH_IGNORE_MASKS") : 300;
+        const int messages = 20000;
+        QStringList list;
+        for (int i = 0; i < masks; ++i)
+            list << (i % 3 ? QString("spammer%1!*@*").arg(i)
+                           : QString("*!*@%1.botnet.example").arg(i));
+        QStringList prefixes;
+        for (int i = 0; i < messages; ++i)
+            prefixes << QString("user%1!ident%1@host%2.isp.example").arg(i % 500).arg(i % 97);
+
+        QElapsedTimer timer;
+        timer.start();
+        int legacyHits = 0;
+        for (int i = 0; i < messages / 20; ++i) {
+            const QString &prefix = prefixes.at(i);
+            legacyHits += legacyIsIgnored(list, prefix)
+                || legacyIsIgnored(list, prefix.section('!', 0, 0));
+        }
+        const double legacyUs = timer.nsecsElapsed() / 1000.0 * 20;
+
+        IgnoreMatcher m;
+        timer.restart();
+        m.setMasks(list);
+        int hits = 0;
+        for (const QString &prefix : prefixes)
+            hits += m.matches(prefix);
+        const double compiledUs = timer.nsecsElapsed() / 1000.0;
+        QCOMPARE(hits, 0);
+        QCOMPARE(legacyHits, 0);
+
+        qInfo().noquote() << QString("%1 masks, %2 messages: per-call regex ~%3 ms, "
+                                     "compiled %4 ms")
+                                 .arg(masks).arg(messages)
+                                 .arg(legacyUs / 1000.0, 0, 'f', 1)
+                                 .arg(compiledUs / 1000.0, 0, 'f', 1);
+    }
+};
+
+QTEST_MAIN(TestIgnoreMatcher)
+#include "test_ignorematcher.moc"
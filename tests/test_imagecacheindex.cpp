@@ -0,0 +1,121 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include "ImageCacheIndex.h"
+
+class TestImageCacheIndex : public QObject
+{
+    Q_OBJECT
+
+private:
+    static ImageCacheIndex::Entry entry(const QString &name, qint64 bytes,
+                                        qint64 lastAccess)
+    {
+        ImageCacheIndex::Entry e;
+        e.name = name;
+        e.mime = "image/png";
+        e.bytes = bytes;
+        e.width = 640;
+        e.height = 480;
+        e.lastAccess = lastAccess;
+        return e;
+    }
+
+private slots:
+    void testSurvivesRestart()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.filePath("index");
+
+        ImageCacheIndex index;
+        QVERIFY(!index.load(path));
+        QVERIFY(index.wantsCompaction()); // no file yet: write a fresh one
+        QVERIFY(ImageCacheIndex::replaceFile(path, index.snapshot()));
+        index.insert(entry("0123456789abcdef.png", 1000, 10));
+        index.insert(entry("fedcba9876543210.jpg", 2000, 20));
+        index.touch("0123456789abcdef.png", 30);
+        index.remove("fedcba9876543210.jpg");
+        index.insert(entry("00000000000000aa.gif", 500, 40));
+        QVERIFY(!index.wantsCompaction());
+        QVERIFY(ImageCacheIndex::appendToFile(path, index.takeJournal()));
+        QVERIFY(index.takeJournal().isEmpty());
+
+        ImageCacheIndex reloaded;
+        QVERIFY(reloaded.load(path));
+        QCOMPARE(reloaded.count(), 2);
+        QCOMPARE(reloaded.totalBytes(), qint64(1500));
+        QVERIFY(!reloaded.contains("fedcba9876543210.jpg"));
+        const auto e = reloaded.entry("0123456789abcdef.png");
+        QCOMPARE(e.lastAccess, qint64(30));
+        QCOMPARE(e.mime, QByteArray("image/png"));
+        QCOMPARE(e.width, 640);
+        QCOMPARE(e.height, 480);
+    }
+
+    void testEvictsLeastRecentlyUsed()
+    {
+        ImageCacheIndex index;
+        index.setBudget(3000);
+        index.insert(entry("a.png", 1000, 1));
+        index.insert(entry("b.png", 1000, 2));
+        index.insert(entry("c.png", 1000, 3));
+        QVERIFY(index.evict().isEmpty());
+
+        index.touch("a.png", 4);
+        index.insert(entry("d.png", 1500, 5));
+        const auto evicted = index.evict();
+        QCOMPARE(evicted.size(), 2);
+        QCOMPARE(evicted.at(0).name, QString("b.png"));
+        QCOMPARE(evicted.at(1).name, QString("c.png"));
+        QVERIFY(index.contains("a.png"));
+        QVERIFY(index.contains("d.png"));
+        QCOMPARE(index.totalBytes(), qint64(2500));
+    }
+
+    void testCompaction()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.filePath("index");
+        ImageCacheIndex index;
+        index.load(path);
+        QVERIFY(ImageCacheIndex::replaceFile(path, index.snapshot()));
+        index.insert(entry("a.png", 10, 1));
+        for (int i = 2; !index.wantsCompaction(); ++i)
+            index.touch("a.png", i);
+        QVERIFY(ImageCacheIndex::replaceFile(path, index.snapshot()));
+        QVERIFY(!index.wantsCompaction());
+        QCOMPARE(QFileInfo(path).size(), qint64(8 + 96));
+
+        ImageCacheIndex reloaded;
+        QVERIFY(reloaded.load(path));
+        QCOMPARE(reloaded.count(), 1);
+        QVERIFY(reloaded.entry("a.png").lastAccess > 1000);
+    }
+
+    void testTornRecord()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.filePath("index");
+        ImageCacheIndex index;
+        index.insert(entry("a.png", 10, 1));
+        index.insert(entry("b.png", 10, 2));
+        QByteArray file = index.snapshot();
+        file.chop(40); // crash in the middle of the last record
+        QVERIFY(ImageCacheIndex::replaceFile(path, file));
+
+        ImageCacheIndex reloaded;
+        QVERIFY(reloaded.load(path));
+        QCOMPARE(reloaded.count(), 1);
+        // Appending after a torn record would misalign the file
+        QVERIFY(reloaded.wantsCompaction());
+
+        QVERIFY(ImageCacheIndex::replaceFile(path, "not an index"));
+        QVERIFY(!reloaded.load(path));
+        QCOMPARE(reloaded.count(), 0);
+    }
+};
+
+QTEST_MAIN(TestImageCacheIndex)
+#include "test_imagecacheindex.moc"
@@ -0,0 +1,131 @@
+#include <QtTest>
+#include <QtEndian>
+#include "ImageSniffer.h"
+
+using ImageSniffer::Verdict;
+
+class TestImageSniffer : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QByteArray be32(quint32 v)
+    {
+        QByteArray b(4, '\0');
+        qToBigEndian(v, b.data());
+        return b;
+    }
+    static QByteArray le16(quint16 v)
+    {
+        QByteArray b(2, '\0');
+        qToLittleEndian(v, b.data());
+        return b;
+    }
+    static QByteArray le32(quint32 v)
+    {
+        QByteArray b(4, '\0');
+        qToLittleEndian(v, b.data());
+        return b;
+    }
+
+    static QByteArray png(quint32 w, quint32 h)
+    {
+        return QByteArray("\x89PNG\r\n\x1A\n") + be32(13) + "IHDR" + be32(w) + be32(h)
+               + QByteArray("\x08\x06\x00\x00\x00", 5);
+    }
+
+    // SOI, an APP1 segment of appLength bytes, then a baseline frame header
+    static QByteArray jpeg(quint16 w, quint16 h, int appLength)
+    {
+        QByteArray d("\xFF\xD8");
+        d += "\xFF\xE1";
+        d += char(appLength >> 8);
+        d += char(appLength & 0xFF);
+        d += QByteArray(appLength - 2, 'x');
+        d += QByteArray("\xFF\xC0\x00\x11\x08", 5);
+        d += char(h >> 8);
+        d += char(h & 0xFF);
+        d += char(w >> 8);
+        d += char(w & 0xFF);
+        d += QByteArray(12, '\0');
+        return d;
+    }
+
+private slots:
+    void testPng()
+    {
+        const auto r = ImageSniffer::sniff(png(640, 480));
+        QCOMPARE(r.verdict, Verdict::Image);
+        QCOMPARE(r.mime, QByteArray("image/png"));
+        QCOMPARE(r.size, QSize(640, 480));
+
+        // The signature without the header: wait for the size
+        QCOMPARE(ImageSniffer::sniff(png(1, 1).left(12)).verdict, Verdict::NeedMore);
+    }
+
+    void testJpegAfterMetadata()
+    {
+        const QByteArray d = jpeg(4000, 3000, 20000);
+        auto r = ImageSniffer::sniff(d);
+        QCOMPARE(r.verdict, Verdict::Image);
+        QCOMPARE(r.mime, QByteArray("image/jpeg"));
+        QCOMPARE(r.size, QSize(4000, 3000));
+
+        // Known to be a JPEG from the first bytes, sized once SOF arrives
+        r = ImageSniffer::sniff(d.left(1000));
+        QCOMPARE(r.verdict, Verdict::Image);
+        QVERIFY(!r.size.isValid());
+    }
+
+    void testGifBmpWebp()
+    {
+        auto r = ImageSniffer::sniff(QByteArray("GIF89a") + le16(320) + le16(200));
+        QCOMPARE(r.verdict, Verdict::Image);
+        QCOMPARE(r.mime, QByteArray("image/gif"));
+        QCOMPARE(r.size, QSize(320, 200));
+
+        // Bottom-up BMPs have a negative height
+        r = ImageSniffer::sniff(QByteArray("BM") + QByteArray(12, '\0') + le32(40)
+                                + le32(800) + le32(quint32(-600)) + QByteArray(8, '\0'));
+        QCOMPARE(r.mime, QByteArray("image/bmp"));
+        QCOMPARE(r.size, QSize(800, 600));
+
+        QByteArray vp8l = QByteArray("RIFF") + le32(100) + "WEBPVP8L" + le32(50) + "\x2F";
+        vp8l += le32((1024 - 1) | (768 - 1) << 14);
+        vp8l += QByteArray(8, '\0');
+        r = ImageSniffer::sniff(vp8l);
+        QCOMPARE(r.mime, QByteArray("image/webp"));
+        QCOMPARE(r.size, QSize(1024, 768));
+
+        QByteArray vp8x = QByteArray("RIFF") + le32(100) + "WEBPVP8X" + le32(10)
+                          + QByteArray(4, '\0');
+        vp8x += QByteArray("\x0F\x27\x00", 3);  // 10000 - 1
+        vp8x += QByteArray("\x1F\x4E\x00", 3);  // 20000 - 1
+        r = ImageSniffer::sniff(vp8x);
+        QCOMPARE(r.size, QSize(10000, 20000));
+    }
+
+    void testText()
+    {
+        auto r = ImageSniffer::sniff("<?xml version=\"1.0\"?>\n<svg xmlns=\"http://www.w3.org/2000/svg\">");
+        QCOMPARE(r.verdict, Verdict::Image);
+        QCOMPARE(r.mime, QByteArray("image/svg+xml"));
+
+        QCOMPARE(ImageSniffer::sniff("<!DOCTYPE html>\n<html><head><title>x</title>", true).verdict,
+                 Verdict::NotImage);
+        QCOMPARE(ImageSniffer::sniff("{\"error\": \"not found\", \"code\": 404}").verdict,
+                 Verdict::NotImage);
+    }
+
+    void testShortInput()
+    {
+        QCOMPARE(ImageSniffer::sniff("").verdict, Verdict::NeedMore);
+        QCOMPARE(ImageSniffer::sniff("GIF8").verdict, Verdict::NeedMore);
+        // ... unless that is all there is
+        QCOMPARE(ImageSniffer::sniff("GIF8", true).verdict, Verdict::NotImage);
+        QCOMPARE(ImageSniffer::sniff("", true).verdict, Verdict::NotImage);
+    }
+};
+
+QTEST_MAIN(TestImageSniffer)
+#include "test_imagesniffer.moc"
@@ -0,0 +1,460 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include "ImageDownloader.h"
+#include "IrcFormatter.h"
+
+// The previous multi-pass pipeline (strip tags → escape → control codes →
+// emoji spans → nick regex → URL regex), kept as the reference the single
+// pass must agree with on ordinary chat lines and as the benchmark baseline.
+namespace legacy {
+
+static const QSet<QString> htmlTagNames = {
+    "a", "b", "i", "u", "s", "em", "strong", "span", "div", "p", "br", "hr",
+    "img", "font", "small", "big", "sub", "sup", "ul", "ol", "li", "table",
+    "tr", "td", "th", "thead", "tbody", "h1", "h2", "h3", "h4", "h5", "h6",
+    "pre", "code", "blockquote", "script", "style", "html", "head", "body",
+    "meta", "link", "title", "input", "button", "form", "label", "select",
+    "option", "textarea", "nav", "header", "footer", "section", "article",
+    "aside", "main"};
+
+static QString stripHtmlTags(const QString &text)
+{
+    QString result;
+    for (int i = 0; i < text.size();) {
+        const int end = text[i] == '<' ? text.indexOf('>', i + 1) : -1;
+        if (end >= 0) {
+            QString inner = text.mid(i + 1, end - i - 1).trimmed();
+            if (inner.startsWith('/'))
+                inner = inner.mid(1);
+            if (htmlTagNames.contains(inner.section(' ', 0, 0).toLower())) {
+                i = end + 1;
+                continue;
+            }
+        }
+        result += text[i++];
+    }
+    return result;
+}
+
+static bool isEmojiBase(char32_t cp)
+{
+    return (cp >= 0x1F300 && cp <= 0x1FAFF) || (cp >= 0x1F1E6 && cp <= 0x1F1FF)
+        || (cp >= 0x2600 && cp <= 0x27BF) || (cp >= 0x2300 && cp <= 0x23FF)
+        || cp == 0x00A9 || cp == 0x00AE || cp == 0x203C || cp == 0x2049
+        || cp == 0x2122 || cp == 0x2139 || cp == 0x3030 || cp == 0x303D
+        || cp == 0x3297 || cp == 0x3299;
+}
+
+static bool isEmojiJoiner(char32_t cp)
+{
+    return cp == 0x200D || cp == 0xFE0E || cp == 0xFE0F || cp == 0x20E3
+        || (cp >= 0x1F3FB && cp <= 0x1F3FF);
+}
+
+static QString wrapEmoji(const QString &html)
+{
+    QString out;
+    int i = 0;
+    auto cpAt = [&](int k, int *n) -> char32_t {
+        if (html[k].isHighSurrogate() && k + 1 < html.size() && html[k + 1].isLowSurrogate()) {
+            *n = 2;
+            return QChar::surrogateToUcs4(html[k], html[k + 1]);
+        }
+        *n = 1;
+        return html[k].unicode();
+    };
+    while (i < html.size()) {
+        if (html[i] == '<' || html[i] == '&') {
+            const int end = html.indexOf(html[i] == '<' ? '>' : ';', i + 1);
+            if (end > i) {
+                out += html.mid(i, end - i + 1);
+                i = end + 1;
+                continue;
+            }
+            if (html[i] == '<') {
+                out += html.mid(i);
+                break;
+            }
+        }
+        int n;
+        const char32_t cp = cpAt(i, &n);
+        if (!isEmojiBase(cp)) {
+            out += html.mid(i, n);
+            i += n;
+            continue;
+        }
+        out += "<span style=\"font-family:'Noto Color Emoji','Segoe UI Emoji','Apple "
+               "Color Emoji','Noto Emoji';\">";
+        out += html.mid(i, n);
+        i += n;
+        while (i < html.size() && html[i] != '<' && html[i] != '&') {
+            const char32_t next = cpAt(i, &n);
+            if (!isEmojiJoiner(next) && !isEmojiBase(next))
+                break;
+            out += html.mid(i, n);
+            i += n;
+        }
+        out += "</span>";
+    }
+    return out;
+}
+
+static QString ircToHtml(const QString &text)
+{
+    const QString escaped = stripHtmlTags(text).toHtmlEscaped();
+    QString result;
+    bool b = false, it = false, u = false, s = false;
+    QString fgColor, bgColor;
+    int openFonts = 0;
+    auto closeFonts = [&] { for (; openFonts; --openFonts) result += "</font>"; };
+    auto openFont = [&] {
+        if (!fgColor.isEmpty()) {
+            result += "<font color=\"" + fgColor + "\">";
+            ++openFonts;
+        }
+    };
+    auto toggle = [&](bool &on, const char *tag) {
+        result += QString(on ? "</%1>" : "<%1>").arg(tag);
+        on = !on;
+    };
+    const int len = escaped.size();
+    for (int i = 0; i < len;) {
+        const ushort code = escaped[i].unicode();
+        if (code == 0x02) { toggle(b, "b"); ++i; }
+        else if (code == 0x1D) { toggle(it, "i"); ++i; }
+        else if (code == 0x1F) { toggle(u, "u"); ++i; }
+        else if (code == 0x1E) { toggle(s, "s"); ++i; }
+        else if (code == 0x16) {
+            closeFonts();
+            std::swap(fgColor, bgColor);
+            if (fgColor.isEmpty() && !bgColor.isEmpty())
+                fgColor = "#000000";
+            openFont();
+            ++i;
+        } else if (code == 0x0F) {
+            closeFonts();
+            if (b) toggle(b, "b");
+            if (it) toggle(it, "i");
+            if (u) toggle(u, "u");
+            if (s) toggle(s, "s");
+            fgColor.clear();
+            bgColor.clear();
+            ++i;
+        } else if (code == 0x03) {
+            ++i;
+            closeFonts();
+            int fg = -1, bg = -1;
+            if (i < len && escaped[i].isDigit()) {
+                fg = escaped[i++].digitValue();
+                if (i < len && escaped[i].isDigit())
+                    fg = fg * 10 + escaped[i++].digitValue();
+                if (i < len && escaped[i] == ',') {
+                    ++i;
+                    if (i < len && escaped[i].isDigit()) {
+                        bg = escaped[i++].digitValue();
+                        if (i < len && escaped[i].isDigit())
+                            bg = bg * 10 + escaped[i++].digitValue();
+                    }
+                }
+            }
+            if (fg >= 0) {
+                fgColor = IrcFormatter::mircColor(fg);
+                if (bg >= 0)
+                    bgColor = IrcFormatter::mircColor(bg);
+            } else {
+                fgColor.clear();
+                bgColor.clear();
+            }
+            openFont();
+        } else if (code == 0x04) {
+            ++i;
+            closeFonts();
+            bool ok = false;
+            if (i + 5 < len) {
+                escaped.mid(i, 6).toInt(&ok, 16);
+                if (ok) {
+                    fgColor = "#" + escaped.mid(i, 6);
+                    i += 6;
+                    if (i < len && escaped[i] == ',') {
+                        ++i;
+                        if (i + 5 < len) {
+                            escaped.mid(i, 6).toInt(&ok, 16);
+                            if (ok) {
+                                bgColor = "#" + escaped.mid(i, 6);
+                                i += 6;
+                            }
+                        }
+                    }
+                }
+            }
+            openFont();
+        } else if (code == 0x11) {
+            ++i;
+        } else {
+            result += escaped[i++];
+        }
+    }
+    closeFonts();
+    if (b) result += "</b>";
+    if (it) result += "</i>";
+    if (u) result += "</u>";
+    if (s) result += "</s>";
+    return wrapEmoji(result);
+}
+
+static QString nickLink(const QString &nick)
+{
+    return "<a href=\"nick://" + nick.toHtmlEscaped() + "\" style=\"color:"
+        + IrcFormatter::nickColor(nick, true)
+        + "; text-decoration:none; font-weight:bold;\">" + nick.toHtmlEscaped() + "</a>";
+}
+
+static QString colorizeNicks(const QString &html)
+{
+    static const QRegularExpression nickRe("&lt;((?:~|&amp;|@|%|\\+)*)([^&<>]+?)&gt;");
+    QString result;
+    int last = 0;
+    auto it = nickRe.globalMatch(html);
+    while (it.hasNext()) {
+        const auto m = it.next();
+        result += html.mid(last, m.capturedStart() - last);
+        result += "&lt;" + m.captured(1) + nickLink(m.captured(2)) + "&gt;";
+        last = m.capturedEnd();
+    }
+    result += html.mid(last);
+    static const QRegularExpression actionRe("^(\\* )([^\\s<]+)");
+    const auto am = actionRe.match(result);
+    if (am.hasMatch())
+        result = am.captured(1) + nickLink(am.captured(2)) + result.mid(am.capturedEnd());
+    return result;
+}
+
+static QString linkifyUrls(const QString &html)
+{
+    static const QRegularExpression re("(https?://[^\\s<\"]+)");
+    QString result;
+    int last = 0;
+    auto it = re.globalMatch(html);
+    while (it.hasNext()) {
+        const auto m = it.next();
+        QString url = m.captured(1);
+        while (url.endsWith("&amp;") || url.endsWith("&lt;") || url.endsWith("&gt;"))
+            url.chop(url.endsWith("&amp;") ? 5 : 4);
+        while (url.endsWith('.') || url.endsWith(',') || url.endsWith(';')
+               || url.endsWith(':') || url.endsWith(')') || url.endsWith('\''))
+            url.chop(1);
+        result += html.mid(last, m.capturedStart(1) - last);
+        QString href = url;
+        href.replace("&amp;", "&").replace("&lt;", "<").replace("&gt;", ">").replace("&quot;", "\"");
+        result += "<a href=\"" + href.toHtmlEscaped()
+            + "\" style=\"color:#4fc3f7; text-decoration:underline;\">" + url + "</a>";
+        if (ImageDownloader::isVideoUrl(href))
+            result += " <font color=\"#4fc3f7\">&#9654; Video</font>";
+        last = m.capturedStart(1) + url.size();
+    }
+    result += html.mid(last);
+    return result;
+}
+
+static bool containsNickWord(const QString &text, const QString &nick)
+{
+    const QRegularExpression re(
+        QString("(?<![%1])%2(?![%1])")
+            .arg("A-Za-z0-9_\\-\\[\\]\\\\`^{}|", QRegularExpression::escape(nick)),
+        QRegularExpression::CaseInsensitiveOption);
+    return re.match(text).hasMatch();
+}
+
+static bool mentions(const QString &text, const QString &nick)
+{
+    const int lt = text.indexOf('<');
+    const int gt = text.indexOf('>');
+    if (lt < 0 || gt <= lt)
+        return false;
+    QString sender = text.mid(lt + 1, gt - lt - 1);
+    while (!sender.isEmpty() && QString("+@~&%").contains(sender[0]))
+        sender = sender.mid(1);
+    return sender.compare(nick, Qt::CaseInsensitive) != 0
+        && containsNickWord(text.mid(gt + 1), nick);
+}
+
+static QString format(const QString &text)
+{
+    return linkifyUrls(colorizeNicks(ircToHtml(text)));
+}
+
+} // namespace legacy
+
+// IrcFormatter must produce what the old pipeline produced for real chat,
+// in one pass and with one output allocation per line.
+class TestIrcFormatter : public QObject
+{
+    Q_OBJECT
+
+private:
+    // Lines shaped like busy-channel traffic: mode prefixes, colors and
+    // styles, URLs with query strings, emoji, actions, "<3" and comparisons.
+    static QStringList corpus(int lines)
+    {
+        static const char *const nicks[] = {"alice", "Bob", "[carol]", "dave|away",
+                                            "eve_", "Frank-", "gr`eg", "ed"};
+        static const char *const prefixes[] = {"", "@", "+", "~", "%", "&", "@+"};
+        static const QStringList bodies = {
+            "hey ed, did you see the build?",
+            "\x02important:\x02 release is \x03" "04,01blocked\x03 on CI",
+            "check https://example.org/path?q=1&lang=en).",
+            "\x1Ditalic\x1D and \x1Funderlined\x1F and \x1Estruck\x1E text",
+            "reverse \x16video\x16 and \x0F reset",
+            "\x04" "FF8800orange\x04 then \x03" "12,15blue on grey",
+            "I <3 this channel \xF0\x9F\x98\x80\xF0\x9F\x91\x8D\xF0\x9F\x8F\xBD",
+            "if a > b && c < d then \"quote\" it",
+            "video: https://www.youtube.com/watch?v=dQw4w9WgXcQ",
+            "edited the README, see https://github.com/lord3nd3r/NUchat/pull/12",
+            "ED: ping",
+            "template <QMap K, V> is fine",
+            "\x03" "09green\x03\x02" "bold-no-close",
+            "plain words only, nothing special here at all",
+        };
+        QStringList out;
+        out.reserve(lines);
+        for (int i = 0; i < lines; ++i) {
+            const QString nick = nicks[i % 8];
+            const QString body = bodies.at((i * 7) % bodies.size());
+            if (i % 11 == 0)
+                out << QString("* %1 %2").arg(nick, body);
+            else
+                out << QString("<%1%2> %3").arg(QString(prefixes[i % 7]), nick, body);
+        }
+        return out;
+    }
+
+    static QString html(const QString &text, const IrcFormatter::Options &opt = {})
+    {
+        return IrcFormatter::toHtml(text, opt);
+    }
+
+    static QString nickLink(const QString &nick)
+    {
+        return QString("<a href=\"nick://%1\" style=\"color:%2; text-decoration:none; "
+                       "font-weight:bold;\">%1</a>")
+            .arg(nick, IrcFormatter::nickColor(nick, true));
+    }
+
+private slots:
+    void testControlCodes()
+    {
+        QCOMPARE(html("\x02" "b\x02 \x1Di\x1D \x03" "04,02red\x03 "
+                                      "\x04" "FF8800x\x0F"),
+                 QString("<b>b</b> <i>i</i> <font color=\"#ff0000\">red</font> "
+                         "<font color=\"#FF8800\">x</font>"));
+        // Unclosed styles are closed at the end of the line
+        QCOMPARE(html("\x02\x1Fx"), QString("<b><u>x</b></u>"));
+        // Reverse swaps the colors; with no background, black on the old
+        // foreground
+        QCOMPARE(html("\x03" "1,4a\x16" "b"),
+                 QString("<font color=\"#000000\">a</font><font color=\"#ff0000\">b</font>"));
+        QCOMPARE(html("\x03" "4x\x16" "y"),
+                 QString("<font color=\"#ff0000\">x</font><font color=\"#000000\">y</font>"));
+        QCOMPARE(html("a & b < c > \"d\""),
+                 QString("a &amp; b &lt; c &gt; &quot;d&quot;"));
+    }
+
+    void testUrls()
+    {
+        QCOMPARE(html("see https://example.org/a?x=1&y=2)."),
+                 QString("see <a href=\"https://example.org/a?x=1&amp;y=2\" "
+                         "style=\"color:#4fc3f7; text-decoration:underline;\">"
+                         "https://example.org/a?x=1&amp;y=2</a>)."));
+        QVERIFY(html("https://youtu.be/abc").endsWith("&#9654; Video</font>"));
+        // Scheme alone is not a link
+        QCOMPARE(html("http:// x"), QString("http:// x"));
+        QCOMPARE(html("hhttps"), QString("hhttps"));
+    }
+
+    void testNicks()
+    {
+        QCOMPARE(html("<@bob> hi <3 you"),
+                 "&lt;@" + nickLink("bob") + "&gt; hi &lt;3 you");
+        QCOMPARE(html("* bob waves"), "* " + nickLink("bob") + " waves");
+        QCOMPARE(html("<&carol> x"),
+                 "&lt;&amp;" + nickLink("carol") + "&gt; x");
+        // Relay HTML is dropped, generics and hearts are not
+        QCOMPARE(html("<b>bold</b>"), QString("bold"));
+        IrcFormatter::Options noLinks;
+        noLinks.nickLinks = false;
+        QCOMPARE(html("<QMap K, V>", noLinks), QString("&lt;QMap K, V&gt;"));
+        QCOMPARE(html("<bob> hi", noLinks), QString("&lt;bob&gt; hi"));
+    }
+
+    void testMentions()
+    {
+        IrcFormatter::Options opt;
+        opt.mentionNick = "ed";
+        QString out;
+        QVERIFY(IrcFormatter::appendHtml(QString("<bob> ed: hi"), out, opt));
+        QVERIFY(IrcFormatter::appendHtml(QString("<bob> hi ED"), out, opt));
+        QVERIFY(!IrcFormatter::appendHtml(QString("<bob> I edited it"), out, opt));
+        QVERIFY(!IrcFormatter::appendHtml(QString("<bob> [ed]"), out, opt));
+        QVERIFY(!IrcFormatter::appendHtml(QString("<@Ed> talking to myself, ed"), out, opt));
+        // The sender's own nick is not a mention
+        QVERIFY(!IrcFormatter::appendHtml(QString("<ed> hi"), out, opt));
+        QVERIFY(!IrcFormatter::appendHtml(QString("no sender ed"), out, opt));
+        opt.mentionNick.clear();
+        QVERIFY(!IrcFormatter::appendHtml(QString("<bob> ed"), out, opt));
+    }
+
+    void testMatchesLegacyPipeline()
+    {
+        const QStringList lines = corpus(500);
+        for (const QString &line : lines) {
+            IrcFormatter::Options opt;
+            opt.mentionNick = "ed";
+            QString html;
+            const bool mentioned = IrcFormatter::appendHtml(line, html, opt);
+            QCOMPARE(html, legacy::format(line));
+            QCOMPARE(mentioned, legacy::mentions(line, "ed"));
+        }
+        for (const QString &line : lines) {
+            for (const QString nick : {"ed", "[carol]", "dave|away", "bob", "x"})
+                QCOMPARE(IrcFormatter::containsNickWord(line, nick),
+                         legacy::containsNickWord(line, nick));
+        }
+    }
+
+    void benchFormat()
+    {
+        const int lines = qEnvironmentVariableIsSet("NUCHAT_BENCH_FORMAT_LINES")
+            ? qEnvironmentVariableIntValue("NUCHAT_BENCH_FORMAT_LINES") : 20000;
+        const QStringList input = corpus(lines);
+        IrcFormatter::Options opt;
+        opt.mentionNick = "ed";
+
+        QElapsedTimer timer;
+        timer.start();
+        qsizetype sink = 0;
+        for (const QString &line : input) {
+            const QString html = legacy::format(line);
+            sink += html.size() + legacy::mentions(line, "ed");
+        }
+        const qint64 legacyUs = timer.nsecsElapsed() / 1000;
+
+        timer.restart();
+        for (const QString &line : input) {
+            QString html;
+            html.reserve(line.size() * 2);
+            sink -= IrcFormatter::appendHtml(line, html, opt);
+            sink -= html.size();
+        }
+        const qint64 singleUs = timer.nsecsElapsed() / 1000;
+        QCOMPARE(sink, qsizetype(0));
+
+        qInfo().noquote() << QString("%1 lines: multi-pass %2 ms, single pass %3 ms (%4x)")
+                                 .arg(lines).arg(legacyUs / 1000.0, 0, 'f', 1)
+                                 .arg(singleUs / 1000.0, 0, 'f', 1)
+                                 .arg(double(legacyUs) / qMax<qint64>(1, singleUs), 0, 'f', 1);
+    }
+};
+
+QTEST_MAIN(TestIrcFormatter)
+#include "test_ircformatter.moc"
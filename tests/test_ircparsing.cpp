@@ -2,7 +2,10 @@
 // We use a thin test-helper subclass to expose the private processLine()
 // method so we can feed raw server lines without a real TCP socket.
 #include <QtTest>
+#include <QElapsedTimer>
+#include "IRCConnectionManager.h"
 #include "IrcConnection.h"
+#include "IrcMessage.h"
 
 // Friend trick: expose processLine() for testing
 class IrcConnectionTestable : public IrcConnection
@@ -12,6 +15,63 @@ public:
     void feedLine(const QString &line) { processLine(line); }
 };
 
+// The QString-based split IrcConnection::processLine used before IrcMessage,
+// kept here as the baseline for benchParseThroughput.
+struct LegacyParsed {
+    QMap<QString, QString> tags;
+    QString prefix;
+    QString command;
+    QStringList params;
+};
+
+static LegacyParsed legacyParse(const QString &line)
+{
+    LegacyParsed p;
+    QString rest = line;
+    if (rest.startsWith('@')) {
+        int sp = rest.indexOf(' ');
+        if (sp > 0) {
+            const auto parts = rest.mid(1, sp - 1).split(';', Qt::SkipEmptyParts);
+            for (const QString &part : parts) {
+                int eq = part.indexOf('=');
+                if (eq >= 0) {
+                    QString val = part.mid(eq + 1);
+                    val.replace("\\:", ";");
+                    val.replace("\\s", " ");
+                    val.replace("\\r", "\r");
+                    val.replace("\\n", "\n");
+                    val.replace("\\\\", "\\");
+                    p.tags[part.left(eq)] = val;
+                } else {
+                    p.tags[part] = QString();
+                }
+            }
+            rest = rest.mid(sp + 1).trimmed();
+        }
+    }
+    if (rest.startsWith(':')) {
+        int sp = rest.indexOf(' ');
+        if (sp < 0)
+            return p;
+        p.prefix = rest.mid(1, sp - 1);
+        rest = rest.mid(sp + 1);
+    }
+    QString trailing;
+    int colonIdx = rest.indexOf(" :");
+    if (colonIdx >= 0) {
+        trailing = rest.mid(colonIdx + 2);
+        rest = rest.left(colonIdx);
+    }
+    QStringList tokens = rest.split(' ', Qt::SkipEmptyParts);
+    if (tokens.isEmpty())
+        return p;
+    p.command = tokens.takeFirst().toUpper();
+    p.params = tokens;
+    if (!trailing.isNull())
+        p.params.append(trailing);
+    return p;
+}
+
 class TestIrcParsing : public QObject
 {
     Q_OBJECT
@@ -171,6 +231,177 @@ private slots:
         // ERROR line has no prefix
         conn.feedLine("ERROR :Closing link");
     }
+
+    // ── IrcMessage ──
+
+    void testIrcMessageFields()
+    {
+        const QByteArray line = ":nick!user@host PRIVMSG #channel :hello world";
+        IrcMessage msg;
+        QVERIFY(IrcMessage::parse(line, msg));
+        QCOMPARE(msg.source(), QString("nick!user@host"));
+        QCOMPARE(msg.nick(), QString("nick"));
+        QVERIFY(msg.commandIs("PRIVMSG"));
+        QCOMPARE(msg.numeric(), -1);
+        QCOMPARE(msg.paramCount, 2);
+        QVERIFY(msg.hasTrailing);
+        QCOMPARE(msg.param(0), QString("#channel"));
+        QCOMPARE(msg.param(1), QString("hello world"));
+        QVERIFY(msg.param(2).isNull());
+    }
+
+    void testIrcMessageNumericAndSpaces()
+    {
+        const QByteArray line = ":srv  005   me CHANTYPES=# PREFIX=(ov)@+ :are supported";
+        IrcMessage msg;
+        QVERIFY(IrcMessage::parse(line, msg));
+        QCOMPARE(msg.numeric(), 5);
+        QCOMPARE(msg.paramList(),
+                 (QStringList{"me", "CHANTYPES=#", "PREFIX=(ov)@+", "are supported"}));
+        QVERIFY(msg.paramEquals(0, "me"));
+    }
+
+    void testIrcMessageLowercaseCommand()
+    {
+        IrcMessage msg;
+        QVERIFY(IrcMessage::parse("privmsg #c :x", msg));
+        QVERIFY(msg.commandIs("PRIVMSG"));
+        QCOMPARE(msg.command(), QString("PRIVMSG"));
+        QVERIFY(!msg.hasSource());
+    }
+
+    void testIrcMessageMaxParams()
+    {
+        const QByteArray line = "CMD 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16";
+        IrcMessage msg;
+        QVERIFY(IrcMessage::parse(line, msg));
+        QCOMPARE(msg.paramCount, IrcMessage::kMaxParams);
+        QCOMPARE(msg.param(14), QString("15 16"));
+    }
+
+    void testIrcMessageRejectsEmpty()
+    {
+        IrcMessage msg;
+        QVERIFY(!IrcMessage::parse("", msg));
+        QVERIFY(!IrcMessage::parse(":prefixonly", msg));
+        QVERIFY(!IrcMessage::parse("@a=b", msg));
+    }
+
+    void testIrcMessageTags()
+    {
+        const QByteArray line =
+            "@time=2024-01-01T00:00:00.000Z;+draft/reply=abc;flag;msg=a\\sb\\:c\\\\ "
+            ":n!u@h PRIVMSG #c :hi";
+        IrcMessage msg;
+        QVERIFY(IrcMessage::parse(line, msg));
+        QCOMPARE(msg.tag("time"), QString("2024-01-01T00:00:00.000Z"));
+        QCOMPARE(msg.tag("msg"), QString("a b;c\\"));
+        bool present = false;
+        msg.tagValueRaw("flag", &present);
+        QVERIFY(present);
+        msg.tagValueRaw("missing", &present);
+        QVERIFY(!present);
+        const auto tags = msg.tags();
+        QCOMPARE(tags.size(), 4);
+        QCOMPARE(tags.value("+draft/reply"), QString("abc"));
+        QVERIFY(tags.contains("flag"));
+        QCOMPARE(msg.param(1), QString("hi"));
+    }
+
+    void testTaggedMessageSignal()
+    {
+        IrcConnectionTestable conn;
+        QSignalSpy tagSpy(&conn, &IrcConnection::taggedMessageReceived);
+        QSignalSpy msgSpy(&conn, &IrcConnection::privmsgReceived);
+        conn.feedLine("@time=2024-01-01T00:00:00Z :a!b@c PRIVMSG #x :tagged");
+        QCOMPARE(tagSpy.count(), 1);
+        const auto tags = tagSpy.first()[0].value<QMap<QString, QString>>();
+        QCOMPARE(tags.value("time"), QString("2024-01-01T00:00:00Z"));
+        QCOMPARE(msgSpy.count(), 1);
+        QCOMPARE(msgSpy.first()[2].toString(), QString("tagged"));
+    }
+
+    // Lines/sec of the old QString split vs. IrcMessage on a typical mix of
+    // tagged chat, numerics and membership changes.
+    // Autojoin packs channels into as few JOIN lines as the limit allows
+    void testPackJoins()
+    {
+        QStringList channels;
+        for (int i = 0; i < 60; ++i)
+            channels << QString("#channel-number-%1").arg(i, 2, 10, QChar('0'));
+        const QStringList lines = IrcConnection::packJoins(channels);
+        QVERIFY(lines.size() > 1);
+        QVERIFY(lines.size() <= 3);
+        QStringList joined;
+        for (const QString &line : lines) {
+            QVERIFY(line.startsWith("JOIN #"));
+            QVERIFY(line.toUtf8().size() <= 510);
+            joined += line.mid(5).split(',');
+        }
+        QCOMPARE(joined, channels);
+
+        QCOMPARE(IrcConnection::packJoins({"#a", "#b", "#c"}, 12),
+                 QStringList({"JOIN #a,#b", "JOIN #c"}));
+        // A name too long for any line still goes out, on its own
+        QCOMPARE(IrcConnection::packJoins({"#a", "#toolong"}, 10),
+                 QStringList({"JOIN #a", "JOIN #toolong"}));
+        QVERIFY(IrcConnection::packJoins({}).isEmpty());
+    }
+
+    void testReconnectBackoff()
+    {
+        // Doubles from the base up to the cap, jitter takes up to half off
+        QCOMPARE(IRCConnectionManager::reconnectDelayMs(1, 1000, 60000, 0.0), 500);
+        QCOMPARE(IRCConnectionManager::reconnectDelayMs(1, 1000, 60000, 0.999), 999);
+        QCOMPARE(IRCConnectionManager::reconnectDelayMs(3, 1000, 60000, 0.0), 2000);
+        QCOMPARE(IRCConnectionManager::reconnectDelayMs(10, 1000, 60000, 0.0), 30000);
+        QCOMPARE(IRCConnectionManager::reconnectDelayMs(1000, 1000, 60000, 0.5), 45000);
+        // A cap below the base still waits the base
+        QCOMPARE(IRCConnectionManager::reconnectDelayMs(5, 1000, 0, 0.0), 500);
+    }
+
+    void benchParseThroughput()
+    {
+        const QList<QByteArray> sample = {
+            "@time=2024-03-01T12:00:00.000Z;msgid=abc123 :alice!a@host.example.org PRIVMSG #channel :hello there, how is everyone doing today?",
+            ":bob!b@198.51.100.7 PRIVMSG #channel :\x01" "ACTION waves\x01",
+            ":irc.example.net 353 me = #channel :@alice +bob carol dave erin frank",
+            ":carol!c@host JOIN #channel",
+            ":dave!d@host QUIT :Ping timeout: 240 seconds",
+            ":irc.example.net 005 me CHANTYPES=# PREFIX=(ov)@+ NETWORK=Example :are supported by this server",
+            "@time=2024-03-01T12:00:01.000Z :erin!e@host NOTICE #channel :reminder: meeting at noon",
+            ":frank!f@host MODE #channel +o alice",
+        };
+        constexpr int kRounds = 50000;
+        const qint64 total = qint64(kRounds) * sample.size();
+
+        QList<QString> decoded;
+        for (const QByteArray &l : sample)
+            decoded << QString::fromUtf8(l);
+
+        QElapsedTimer t;
+        t.start();
+        qint64 sink = 0;
+        for (int r = 0; r < kRounds; ++r)
+            for (const QString &l : decoded)
+                sink += legacyParse(l).params.size();
+        const qint64 legacyMs = qMax<qint64>(t.elapsed(), 1);
+
+        t.restart();
+        IrcMessage msg;
+        for (int r = 0; r < kRounds; ++r)
+            for (const QByteArray &l : sample)
+                if (IrcMessage::parse(l, msg))
+                    sink -= msg.paramCount;
+        const qint64 newMs = qMax<qint64>(t.elapsed(), 1);
+
+        qInfo("legacy QString parse: %lld lines in %lld ms (%.0f lines/sec)",
+              qlonglong(total), qlonglong(legacyMs), total * 1000.0 / legacyMs);
+        qInfo("IrcMessage::parse:    %lld lines in %lld ms (%.0f lines/sec)",
+              qlonglong(total), qlonglong(newMs), total * 1000.0 / newMs);
+        // Both parsers must agree on the parameter count for every line.
+        QCOMPARE(sink, qint64(0));
+    }
 };
 
 QTEST_MAIN(TestIrcParsing)
@@ -0,0 +1,170 @@
+// Drives IrcConnection against a loopback server to check that the socket
+// side (IrcSocketWorker) runs on its own thread, and what goes over the wire
+// during registration.
+#include <QtTest>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include "IrcConnection.h"
+#include "IrcSocketWorker.h"
+
+class TestIrcSocketWorker : public QObject
+{
+    Q_OBJECT
+
+private:
+    // Reads from peer, without running this thread's event loop, until
+    // `needle` shows up or the time runs out.
+    static QByteArray readUntil(QTcpSocket *peer, const QByteArray &needle)
+    {
+        QByteArray got;
+        QElapsedTimer timer;
+        timer.start();
+        while (!got.contains(needle) && timer.elapsed() < 5000) {
+            if (peer->waitForReadyRead(100))
+                got += peer->readAll();
+        }
+        return got;
+    }
+
+    static bool flush(QTcpSocket *peer)
+    {
+        while (peer->bytesToWrite() > 0) {
+            if (!peer->waitForBytesWritten(5000))
+                return false;
+        }
+        return true;
+    }
+
+private slots:
+    void testPingAnsweredWhileGuiBusy()
+    {
+        QTcpServer server;
+        QVERIFY(server.listen(QHostAddress::LocalHost));
+        IrcConnection conn;
+        QSignalSpy connected(&conn, &IrcConnection::socketConnected);
+        conn.connectToServer("127.0.0.1", server.serverPort(), false);
+
+        // From here on this thread only blocks: nothing queued to it runs
+        QVERIFY(server.waitForNewConnection(5000));
+        QTcpSocket *peer = server.nextPendingConnection();
+        QVERIFY(peer);
+        peer->write("PING :busy.example.net\r\n");
+        QVERIFY(flush(peer));
+        const QByteArray got = readUntil(peer, "\r\n");
+        QCOMPARE(got, QByteArray("PONG :busy.example.net\r\n"));
+        QCOMPARE(connected.size(), 0);
+
+        // Once the event loop runs the connection catches up and registers
+        QTRY_COMPARE(connected.size(), 1);
+        QCOMPARE(conn.localAddress(), QHostAddress(QHostAddress::LocalHost));
+        QVERIFY(readUntil(peer, "USER ").contains("NICK "));
+    }
+
+    void testPipelinedRegistration()
+    {
+        QTcpServer server;
+        QVERIFY(server.listen(QHostAddress::LocalHost));
+        IrcConnection conn;
+        QSignalSpy registered(&conn, &IrcConnection::registered);
+        conn.connectToServer("127.0.0.1", server.serverPort(), false);
+        QVERIFY(server.waitForNewConnection(5000));
+        QTcpSocket *peer = server.nextPendingConnection();
+        QVERIFY(peer);
+
+        // CAP LS, NICK and USER all go out before the server says anything
+        QByteArray got;
+        QTRY_VERIFY((got += peer->readAll()).contains("USER "));
+        QVERIFY(got.startsWith("CAP LS 302\r\n"));
+        QVERIFY(got.contains("NICK "));
+
+        // Without SASL the REQ and END come together, without waiting for ACK
+        peer->write(":irc.test CAP * LS :multi-prefix server-time\r\n");
+        QVERIFY(flush(peer));
+        got.clear();
+        QTRY_VERIFY((got += peer->readAll()).contains("CAP END\r\n"));
+        QCOMPARE(got, QByteArray("CAP REQ :server-time multi-prefix\r\nCAP END\r\n"));
+
+        // A late ACK doesn't end negotiation a second time
+        peer->write(":irc.test CAP * ACK :server-time multi-prefix\r\n"
+                    ":irc.test 001 NUchat_user :Welcome\r\n");
+        QVERIFY(flush(peer));
+        QTRY_COMPARE(registered.size(), 1);
+        QTest::qWait(50);
+        QVERIFY(!peer->readAll().contains("CAP END"));
+    }
+
+    void testBatchedLinesKeepOrder()
+    {
+        QTcpServer server;
+        QVERIFY(server.listen(QHostAddress::LocalHost));
+        IrcConnection conn;
+        QStringList texts;
+        connect(&conn, &IrcConnection::privmsgReceived, this,
+                [&texts](const QString &, const QString &, const QString &text) {
+                    texts.append(text);
+                });
+        QSignalSpy started(&conn, &IrcConnection::batchStarted);
+        QSignalSpy finished(&conn, &IrcConnection::batchFinished);
+        conn.connectToServer("127.0.0.1", server.serverPort(), false);
+        QVERIFY(server.waitForNewConnection(5000));
+        QTcpSocket *peer = server.nextPendingConnection();
+        QVERIFY(peer);
+
+        // Many reads pile up while this thread is blocked
+        constexpr int kLines = 2000;
+        for (int i = 0; i < kLines; ++i) {
+            peer->write(":a!b@c PRIVMSG #x :" + QByteArray::number(i) + "\r\n");
+            if (i % 100 == 0)
+                QVERIFY(flush(peer));
+        }
+        QVERIFY(flush(peer));
+        QTest::qSleep(200);
+        QVERIFY(texts.isEmpty());
+
+        QTRY_COMPARE(texts.size(), kLines);
+        for (int i = 0; i < kLines; ++i)
+            QCOMPARE(texts.at(i), QString::number(i));
+        // Far fewer hand-overs than lines, each one bracketed
+        QVERIFY(started.count() >= 1);
+        QVERIFY(started.count() < kLines / 10);
+        QCOMPARE(finished.count(), started.count());
+    }
+
+    void testStaleLinesDropped()
+    {
+        QTcpServer oldServer;
+        QTcpServer newServer;
+        QVERIFY(oldServer.listen(QHostAddress::LocalHost));
+        QVERIFY(newServer.listen(QHostAddress::LocalHost));
+        IrcConnection conn;
+        QStringList texts;
+        connect(&conn, &IrcConnection::privmsgReceived, this,
+                [&texts](const QString &, const QString &, const QString &text) {
+                    texts.append(text);
+                });
+        QSignalSpy registered(&conn, &IrcConnection::registered);
+        conn.connectToServer("127.0.0.1", oldServer.serverPort(), false);
+        QVERIFY(oldServer.waitForNewConnection(5000));
+        QTcpSocket *oldPeer = oldServer.nextPendingConnection();
+        QVERIFY(oldPeer);
+
+        // Read by the worker, but not yet drained when the reconnect comes
+        oldPeer->write(":a!b@c PRIVMSG #x :old\r\n:irc.test 001 NUchat_user :Welcome\r\n");
+        QVERIFY(flush(oldPeer));
+        QTest::qSleep(200);
+        conn.connectToServer("127.0.0.1", newServer.serverPort(), false);
+
+        QVERIFY(newServer.waitForNewConnection(5000));
+        QTcpSocket *newPeer = newServer.nextPendingConnection();
+        QVERIFY(newPeer);
+        newPeer->write(":a!b@c PRIVMSG #x :new\r\n");
+        QVERIFY(flush(newPeer));
+        QTRY_COMPARE(texts, QStringList({"new"}));
+        // Nor did the old session's welcome register the new one
+        QCOMPARE(registered.size(), 0);
+        QVERIFY(!conn.isConnected());
+    }
+};
+
+QTEST_MAIN(TestIrcSocketWorker)
+#include "test_ircsocketworker.moc"
@@ -0,0 +1,200 @@
+// Tests for LineBuffer, the framing layer behind IrcConnection::onReadyRead.
+// The throughput test replays a bouncer backlog through both the buffer and
+// the old "m_readBuffer = m_readBuffer.mid(idx + 1)" splitter.  Point
+// NUCHAT_ZNC_PLAYBACK at a recorded ZNC playback to measure real traffic;
+// otherwise a synthetic 50 MB backlog is generated.
+#include <QtTest>
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QFile>
+#include "LineBuffer.h"
+
+static QList<QByteArray> drain(LineBuffer &buf)
+{
+    QList<QByteArray> out;
+    QByteArrayView line;
+    while (buf.nextLine(line))
+        out << line.toByteArray();
+    return out;
+}
+
+static QByteArray syntheticPlayback(qsizetype targetBytes)
+{
+    QByteArray out;
+    out.reserve(targetBytes + 512);
+    int n = 0;
+    while (out.size() < targetBytes) {
+        out += "@time=2024-03-01T12:";
+        out += QByteArray::number(10 + n % 50);
+        out += ":00.000Z;batch=znc :nick";
+        out += QByteArray::number(n % 97);
+        out += "!user@host.example.org PRIVMSG #channel";
+        out += QByteArray::number(n % 40);
+        out += " :backlog line ";
+        out += QByteArray::number(n);
+        out += " lorem ipsum dolor sit amet, consectetur adipiscing\r\n";
+        ++n;
+    }
+    return out;
+}
+
+// Splits the way IrcConnection did before LineBuffer existed.
+static qsizetype legacySplit(const QByteArray &data, qsizetype chunk)
+{
+    QByteArray readBuffer;
+    qsizetype lines = 0;
+    for (qsizetype pos = 0; pos < data.size(); pos += chunk) {
+        readBuffer += data.mid(pos, chunk);
+        while (true) {
+            int idx = readBuffer.indexOf('\n');
+            if (idx < 0)
+                break;
+            QByteArray rawLine = readBuffer.left(idx);
+            readBuffer = readBuffer.mid(idx + 1);
+            if (rawLine.endsWith('\r'))
+                rawLine.chop(1);
+            if (!rawLine.isEmpty())
+                ++lines;
+        }
+    }
+    return lines;
+}
+
+class TestLineBuffer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testSingleLine()
+    {
+        LineBuffer buf;
+        buf.append("PING :server\r\n");
+        const auto lines = drain(buf);
+        QCOMPARE(lines.size(), 1);
+        QCOMPARE(lines[0], QByteArray("PING :server"));
+        QCOMPARE(buf.pendingBytes(), qsizetype(0));
+    }
+
+    void testBareLf()
+    {
+        LineBuffer buf;
+        buf.append("one\ntwo\r\nthree\n");
+        QCOMPARE(drain(buf),
+                 (QList<QByteArray>{"one", "two", "three"}));
+    }
+
+    void testPartialLineAcrossAppends()
+    {
+        LineBuffer buf;
+        buf.append(":a!b@c PRIVMSG #x :hel");
+        QVERIFY(drain(buf).isEmpty());
+        QCOMPARE(buf.pendingBytes(), qsizetype(22));
+        buf.append("lo\r");
+        QVERIFY(drain(buf).isEmpty());
+        buf.append("\nNEXT");
+        QCOMPARE(drain(buf), QList<QByteArray>{":a!b@c PRIVMSG #x :hello"});
+        QCOMPARE(buf.pendingBytes(), qsizetype(4));
+        buf.append("\n");
+        QCOMPARE(drain(buf), QList<QByteArray>{"NEXT"});
+    }
+
+    void testEmptyLines()
+    {
+        LineBuffer buf;
+        buf.append("\r\n\nx\n");
+        QCOMPARE(drain(buf), (QList<QByteArray>{"", "", "x"}));
+    }
+
+    void testClear()
+    {
+        LineBuffer buf;
+        buf.append("partial");
+        buf.clear();
+        QCOMPARE(buf.pendingBytes(), qsizetype(0));
+        buf.append("line\n");
+        QCOMPARE(drain(buf), QList<QByteArray>{"line"});
+    }
+
+    void testReadFromDevice()
+    {
+        QByteArray data("first\r\nsecond\r\nthi");
+        QBuffer dev(&data);
+        QVERIFY(dev.open(QIODevice::ReadOnly));
+        LineBuffer buf;
+        QCOMPARE(buf.readFrom(&dev), qint64(data.size()));
+        QCOMPARE(drain(buf), (QList<QByteArray>{"first", "second"}));
+        QCOMPARE(buf.readFrom(&dev), qint64(0));
+        QCOMPARE(buf.pendingBytes(), qsizetype(3));
+    }
+
+    // Every chunk size must produce exactly the lines the old splitter did.
+    void testMatchesLegacySplitter()
+    {
+        const QByteArray data = syntheticPlayback(64 * 1024);
+        const qsizetype expected = legacySplit(data, data.size());
+        for (qsizetype chunk : {1, 7, 100, 4096, 65536}) {
+            LineBuffer buf;
+            qsizetype lines = 0;
+            for (qsizetype pos = 0; pos < data.size(); pos += chunk) {
+                buf.append(QByteArrayView(data).sliced(pos, qMin(chunk, data.size() - pos)));
+                QByteArrayView line;
+                while (buf.nextLine(line)) {
+                    QVERIFY(!line.endsWith('\r'));
+                    QVERIFY(!line.toByteArray().contains('\n'));
+                    if (!line.isEmpty())
+                        ++lines;
+                }
+            }
+            QCOMPARE(lines, expected);
+        }
+    }
+
+    void benchZncPlayback()
+    {
+        QByteArray data;
+        const QString path = qEnvironmentVariable("NUCHAT_ZNC_PLAYBACK");
+        if (!path.isEmpty()) {
+            QFile f(path);
+            QVERIFY2(f.open(QIODevice::ReadOnly), qPrintable(path));
+            data = f.readAll();
+        } else {
+            data = syntheticPlayback(50 * 1024 * 1024);
+        }
+        // Socket reads rarely exceed 64 KB, so feed the backlog in chunks of
+        // that size just as QSslSocket would deliver it.
+        constexpr qsizetype kChunk = 64 * 1024;
+        const double mb = data.size() / (1024.0 * 1024.0);
+
+        QElapsedTimer t;
+        t.start();
+        LineBuffer buf;
+        qsizetype lines = 0;
+        for (qsizetype pos = 0; pos < data.size(); pos += kChunk) {
+            buf.append(QByteArrayView(data).sliced(pos, qMin(kChunk, data.size() - pos)));
+            QByteArrayView line;
+            while (buf.nextLine(line))
+                if (!line.isEmpty())
+                    ++lines;
+        }
+        const qint64 newMs = qMax<qint64>(t.elapsed(), 1);
+        qInfo("LineBuffer: %.1f MB, %lld lines in %lld ms (%.1f MB/s)", mb,
+              qlonglong(lines), qlonglong(newMs), mb * 1000.0 / newMs);
+
+        // The old splitter copies the remaining buffer once per line; run it
+        // on a 4 MB slice so the test does not take minutes.
+        const QByteArray slice = data.left(4 * 1024 * 1024);
+        const double sliceMb = slice.size() / (1024.0 * 1024.0);
+        t.restart();
+        const qsizetype legacyLines = legacySplit(slice, kChunk);
+        const qint64 oldMs = qMax<qint64>(t.elapsed(), 1);
+        qInfo("legacy mid() splitter: %.1f MB, %lld lines in %lld ms (%.1f MB/s)",
+              sliceMb, qlonglong(legacyLines), qlonglong(oldMs),
+              sliceMb * 1000.0 / oldMs);
+
+        QVERIFY(lines > 0);
+        QCOMPARE(buf.pendingBytes(), qsizetype(0));
+    }
+};
+
+QTEST_MAIN(TestLineBuffer)
+#include "test_linebuffer.moc"
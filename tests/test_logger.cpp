@@ -0,0 +1,220 @@
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include "Logger.h"
+#include "LogIndex.h"
+#include "LogWriter.h"
+
+// Logger writes on a background thread; these tests check that queued
+// lines always become visible through flush(), loadScrollback() and
+// destruction, including when more channels are active than file handles
+// are cached.
+class TestLogger : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QByteArray readLog(const Logger &logger, const QString &net,
+                              const QString &chan)
+    {
+        QFile f(LogWriter::filePathFor(logger.logDir(), net, chan));
+        if (!f.open(QIODevice::ReadOnly))
+            return {};
+        return f.readAll();
+    }
+
+    // A log left over from an earlier run (no index), one line a minute.
+    static QString writeOldLog(const Logger &logger, const QString &net,
+                               const QString &chan, int lines)
+    {
+        const QString path = LogWriter::filePathFor(logger.logDir(), net, chan);
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        QFile f(path);
+        if (!f.open(QIODevice::WriteOnly))
+            return {};
+        const QDateTime base(QDate(2024, 1, 1), QTime(0, 0));
+        for (int i = 0; i < lines; ++i)
+            f.write(base.addSecs(60 * i).toString("yyyy-MM-dd HH:mm:ss").toUtf8() +
+                    " [chat] <old> line " + QByteArray::number(i) + "\n");
+        return path;
+    }
+
+private slots:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+    }
+
+    void init()
+    {
+        Logger logger;
+        QDir(logger.logDir()).removeRecursively();
+    }
+
+    void cleanupTestCase()
+    {
+        Logger logger;
+        QDir(logger.logDir()).removeRecursively();
+    }
+
+    void testLineFormat()
+    {
+        Logger logger;
+        logger.log("Libera", "#Qt", "chat", "<alice> hello");
+        logger.flush();
+        const QByteArray data = readLog(logger, "libera", "#qt");
+        QVERIFY(data.endsWith(" [chat] <alice> hello\n"));
+        QCOMPARE(data.indexOf(" [chat]"), 19); // "yyyy-MM-dd HH:mm:ss"
+    }
+
+    void testScrollbackSeesQueuedLines()
+    {
+        Logger logger;
+        for (int i = 0; i < 50; ++i)
+            logger.log("net", "#chan", "chat", "<bob> line " + QString::number(i));
+        const auto entries = logger.loadScrollback("net", "#chan", 10);
+        QCOMPARE(entries.size(), 10);
+        QCOMPARE(entries.last().text, QString("<bob> line 49"));
+        QCOMPARE(entries.last().type, QString("chat"));
+    }
+
+    void testHeldLines()
+    {
+        Logger logger;
+        logger.log("net", "#held", "system", "joined");
+        logger.flush();
+        logger.holdLines();
+        for (int i = 0; i < 20; ++i)
+            logger.log("net", "#held", "chat", "<bob> line " + QString::number(i));
+        // Held lines are still visible to scrollback
+        const auto entries = logger.loadScrollback("net", "#held", 5);
+        QCOMPARE(entries.size(), 5);
+        QCOMPARE(entries.last().text, QString("<bob> line 19"));
+
+        logger.log("net", "#held", "chat", "<bob> after");
+        logger.releaseLines();
+        logger.flush();
+        QVERIFY(readLog(logger, "net", "#held").endsWith(" [chat] <bob> after\n"));
+    }
+
+    void testFlushOnDestruction()
+    {
+        QString dir;
+        {
+            Logger logger;
+            dir = logger.logDir();
+            logger.log("net", "#gone", "system", "last words");
+        }
+        QFile f(LogWriter::filePathFor(dir, "net", "#gone"));
+        QVERIFY(f.open(QIODevice::ReadOnly));
+        QVERIFY(f.readAll().contains("[system] last words"));
+    }
+
+    // More channels than cached handles: evicted files must still get
+    // every line, in order.
+    void testHandleEviction()
+    {
+        Logger logger;
+        const int channels = LogWriter::kMaxOpenFiles * 2;
+        for (int round = 0; round < 3; ++round)
+            for (int c = 0; c < channels; ++c)
+                logger.log("net", "#c" + QString::number(c), "chat",
+                           "round " + QString::number(round));
+        logger.flush();
+        for (int c = 0; c < channels; ++c) {
+            const QByteArray data = readLog(logger, "net", "#c" + QString::number(c));
+            QCOMPARE(data.count('\n'), 3);
+            QVERIFY(data.indexOf("round 0") < data.indexOf("round 2"));
+        }
+    }
+
+    // Pages walk backwards through the log across several index strides.
+    void testScrollbackPaging()
+    {
+        Logger logger;
+        const int total = LogIndex::kStride * 4 + 10;
+        for (int i = 0; i < total; ++i)
+            logger.log("net", "#page", "chat", "<p> line " + QString::number(i));
+
+        Logger::ScrollbackCursor cursor;
+        QStringList seen;
+        bool atStart = false;
+        for (int pages = 0; !atStart && pages < 10; ++pages) {
+            const auto page = logger.loadScrollbackPage("net", "#page", cursor, 100);
+            QStringList texts;
+            for (const auto &e : page.entries)
+                texts.append(e.text);
+            seen = texts + seen;
+            cursor = page.next;
+            atStart = page.atStart;
+        }
+        QVERIFY(atStart);
+        QCOMPARE(seen.size(), total);
+        for (int i = 0; i < total; ++i)
+            QCOMPARE(seen[i], "<p> line " + QString::number(i));
+    }
+
+    // A log written before indexing existed gets an index on first read.
+    void testIndexBuiltForExistingLog()
+    {
+        Logger logger;
+        const QString path = writeOldLog(logger, "net", "#old", 500);
+        QVERIFY(!QFile::exists(LogIndex::pathFor(path)));
+
+        const auto entries = logger.loadScrollback("net", "#old", 5);
+        QCOMPARE(entries.size(), 5);
+        QCOMPARE(entries.first().text, QString("<old> line 495"));
+        QVERIFY(QFile::exists(LogIndex::pathFor(path)));
+
+        // New lines extend the index rather than rebuilding it
+        logger.log("net", "#old", "chat", "<new> hi");
+        const auto page = logger.loadScrollbackPage("net", "#old", {0, 3}, 3);
+        QCOMPARE(page.entries.size(), 3);
+        QCOMPARE(page.entries.last().text, QString("<old> line 2"));
+        QCOMPARE(logger.loadScrollback("net", "#old", 1).last().text,
+                 QString("<new> hi"));
+    }
+
+    // So does a rotated backup from before then, once, on the writer thread
+    void testIndexBuiltForOldBackup()
+    {
+        Logger logger;
+        const QString path = writeOldLog(logger, "net", "#bak", 300);
+        QVERIFY(QFile::rename(path, path + ".1"));
+        logger.log("net", "#bak", "chat", "<new> hi");
+        logger.flush();
+        QVERIFY(QFile::exists(LogIndex::pathFor(path + ".1")));
+
+        const auto page = logger.loadScrollbackPage("net", "#bak", {1, -1}, 5);
+        QCOMPARE(page.entries.size(), 5);
+        QCOMPARE(page.entries.first().text, QString("<old> line 295"));
+        QCOMPARE(LogIndex::load(LogIndex::pathFor(path + ".1")).size(),
+                 300 / LogIndex::kStride + 1);
+    }
+
+    void testScrollbackBeforeTime()
+    {
+        Logger logger;
+        writeOldLog(logger, "net", "#time", 500);
+        const QDateTime line300 =
+            QDateTime(QDate(2024, 1, 1), QTime(0, 0)).addSecs(60 * 300);
+        const auto page = logger.loadScrollbackBefore(
+            "net", "#time", line300.toMSecsSinceEpoch(), 10);
+        QCOMPARE(page.entries.size(), 10);
+        QCOMPARE(page.entries.first().text, QString("<old> line 290"));
+        QCOMPARE(page.entries.last().text, QString("<old> line 299"));
+        QVERIFY(!page.atStart);
+    }
+
+    void testSanitizedFileName()
+    {
+        QCOMPARE(LogWriter::sanitizeFileName("#foo|bar"), QString("#foo_bar"));
+        QVERIFY(LogWriter::filePathFor("/logs", "Net", "#A:B")
+                    .endsWith("/net/#a_b.log"));
+    }
+};
+
+QTEST_MAIN(TestLogger)
+#include "test_logger.moc"
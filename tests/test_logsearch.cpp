@@ -0,0 +1,380 @@
+#include <QtTest>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <algorithm>
+#include "LogSearchIndex.h"
+#include "LogWriter.h"
+
+// LogSearchIndex is fed by the LogWriter thread as lines are written and
+// searched from any thread; these tests go through LogWriter wherever the
+// writer side matters.
+class TestLogSearch : public QObject
+{
+    Q_OBJECT
+
+private:
+    using Index = LogSearchIndex;
+
+    static const qint64 kBase; // 2024-01-01 00:00 local, ms
+
+    static LogWriter::Record rec(const QString &chan, const QString &text,
+                                 qint64 msecs)
+    {
+        LogWriter::Record r;
+        r.network = "net";
+        r.channel = chan;
+        r.type = "chat";
+        r.message = text;
+        r.msecs = msecs;
+        return r;
+    }
+
+    static Index::Query query(const QString &text, int limit = 1000)
+    {
+        Index::Query q;
+        q.text = text;
+        q.limit = limit;
+        return q;
+    }
+
+    static QStringList texts(const Index::Result &r)
+    {
+        QStringList out;
+        for (const auto &h : r.hits)
+            out << h.text;
+        return out;
+    }
+
+    static void writeFile(const QString &path, const QString &word, int lines)
+    {
+        QFile f(path);
+        QVERIFY(f.open(QIODevice::Append));
+        const QDateTime base = QDateTime::fromMSecsSinceEpoch(kBase);
+        for (int i = 0; i < lines; ++i)
+            f.write(base.addSecs(i).toString("yyyy-MM-dd HH:mm:ss").toUtf8() +
+                    " [chat] <old> " + word.toUtf8() + " " +
+                    QByteArray::number(i) + ";\n");
+    }
+
+private slots:
+    void testRequiredLiterals()
+    {
+        QCOMPARE(Index::requiredLiterals("foo.*bar"), QStringList({"foo", "bar"}));
+        QCOMPARE(Index::requiredLiterals("ab?cdef"), QStringList({"cdef"}));
+        QCOMPARE(Index::requiredLiterals("(optional)?tail"), QStringList({"tail"}));
+        QCOMPARE(Index::requiredLiterals("\\bhello\\b"), QStringList({"hello"}));
+        QCOMPARE(Index::requiredLiterals("x\\.y\\.z"), QStringList({"x.y.z"}));
+        QCOMPARE(Index::requiredLiterals("[abc]def+gh"), QStringList({"def"}));
+        QCOMPARE(Index::requiredLiterals("\\x41bcd"), QStringList({"bcd"}));
+        QVERIFY(Index::requiredLiterals("foo|bar").isEmpty());
+        QVERIFY(Index::requiredLiterals("a.b.c").isEmpty());
+    }
+
+    // Enough lines to seal and merge segments; hits must come from the
+    // index (a few blocks read), not a scan.
+    void testSubstringAcrossSegments()
+    {
+        QTemporaryDir tmp;
+        const QString netDir = LogWriter::networkDirFor(tmp.path(), "net");
+        const int docs = Index::kSegmentDocs * Index::kMergeFanIn + 3;
+        const int lines = docs * Index::kBlockLines + 10;
+        {
+            LogWriter writer(tmp.path());
+            writer.start();
+            for (int i = 0; i < lines; ++i)
+                writer.enqueue(rec("#big", "<u" + QString::number(i % 7) +
+                                   "> msg #" + QString::number(i) + ";" +
+                                   (i == 4242 ? " needle" : ""),
+                                   kBase + i * 1000));
+            writer.flush();
+
+            // Searchable while the writer is still running
+            const auto r = Index::search(netDir, query("needle"));
+            QCOMPARE(texts(r), QStringList({"<u6> msg #4242; needle"}));
+            QCOMPARE(r.hits.first().channel, QString("#big"));
+            QCOMPARE(r.hits.first().type, QString("chat"));
+            // tail + 3 unsealed docs + the hit
+            QVERIFY2(r.blocksRead <= 5, qPrintable(QString::number(r.blocksRead)));
+        }
+        QVERIFY(!QDir(netDir + "/.search")
+                     .entryList({QStringLiteral("seg-1-*.tri")}).isEmpty());
+        // The last lines never filled a block; they are found in the tail
+        const QString last = "#" + QString::number(lines - 1) + ";";
+        QCOMPARE(Index::search(netDir, query(last)).hits.size(), 1);
+        QCOMPARE(Index::search(netDir, query("#1;")).hits.size(), 1);
+        QCOMPARE(Index::search(netDir, query("no such text")).hits.size(), 0);
+    }
+
+    void testCaseAndRegex()
+    {
+        QTemporaryDir tmp;
+        const QString netDir = LogWriter::networkDirFor(tmp.path(), "net");
+        {
+            LogWriter writer(tmp.path());
+            writer.start();
+            const QStringList said = {"<alice> Hello World", "<bob> hello there",
+                                      "<carol> HELLO!!!", "<dave> nothing",
+                                      QString::fromUtf8("<erin> Héllo wörld")};
+            for (const QString &s : said)
+                writer.enqueue(rec("#c", s, kBase));
+            // Push the interesting lines out of the tail into indexed docs
+            for (int i = 0; i < Index::kBlockLines * 3; ++i)
+                writer.enqueue(rec("#c", "<filler> zzz", kBase + 1000));
+        }
+        QCOMPARE(Index::search(netDir, query("hello")).hits.size(), 3);
+
+        auto q = query("hello");
+        q.caseSensitive = true;
+        QCOMPARE(texts(Index::search(netDir, q)), QStringList({"<bob> hello there"}));
+
+        // Unicode case folding on the verify side
+        QCOMPARE(Index::search(netDir, query(QString::fromUtf8("HÉLLO"))).hits.size(), 1);
+
+        q = query("H[eE]llo W");
+        q.regex = true;
+        QCOMPARE(texts(Index::search(netDir, q)), QStringList({"<alice> Hello World"}));
+        q = query("^<(bob|dave)>");
+        q.regex = true;
+        QCOMPARE(Index::search(netDir, q).hits.size(), 2);
+    }
+
+    void testFilters()
+    {
+        QTemporaryDir tmp;
+        const QString netDir = LogWriter::networkDirFor(tmp.path(), "net");
+        const QStringList nicks = {"alice", "@bob", "carol"};
+        {
+            LogWriter writer(tmp.path());
+            writer.start();
+            for (const QString chan : {"#a", "#b"})
+                for (int i = 0; i < 300; ++i)
+                    writer.enqueue(rec(chan, "<" + nicks[i % 3] + "> line " +
+                                       QString::number(i), kBase + i * 60000));
+        }
+        auto q = query("line");
+        q.nick = "alice";
+        q.channel = "#a";
+        QCOMPARE(Index::search(netDir, q).hits.size(), 100);
+
+        q = query(QString());
+        q.nick = "BOB"; // mode prefixes and case are ignored
+        QCOMPARE(Index::search(netDir, q).hits.size(), 200);
+
+        q = query("line");
+        q.channel = "#B";
+        const auto inB = Index::search(netDir, q);
+        QCOMPARE(inB.hits.size(), 300);
+        QVERIFY(std::all_of(inB.hits.cbegin(), inB.hits.cend(),
+                            [](const Index::Hit &h) { return h.channel == "#b"; }));
+
+        q = query("line");
+        q.fromMsecs = kBase + 10 * 60000;
+        q.toMsecs = kBase + 20 * 60000;
+        const auto ranged = Index::search(netDir, q);
+        QCOMPARE(ranged.hits.size(), 20);
+        for (const auto &h : ranged.hits)
+            QVERIFY(h.msecs >= q.fromMsecs && h.msecs < q.toMsecs);
+    }
+
+    void testPaging()
+    {
+        QTemporaryDir tmp;
+        const QString netDir = LogWriter::networkDirFor(tmp.path(), "net");
+        {
+            LogWriter writer(tmp.path());
+            writer.start();
+            for (int i = 0; i < 150; ++i)
+                writer.enqueue(rec("#p", "<p> page line " + QString::number(i),
+                                   kBase + i * 1000));
+        }
+        QStringList all;
+        bool more = true;
+        for (int page = 0; more; ++page) {
+            auto q = query("page line", 50);
+            q.offset = page * 50;
+            const auto r = Index::search(netDir, q);
+            QCOMPARE(r.hits.size(), 50);
+            all += texts(r);
+            more = r.more;
+            QCOMPARE(more, page < 2);
+        }
+        QCOMPARE(all.size(), 150);
+        QCOMPARE(all.first(), QString("<p> page line 149")); // newest first
+        QCOMPARE(all.last(), QString("<p> page line 0"));
+        QCOMPARE(all.removeDuplicates(), 0);
+    }
+
+    // Logs from before the index existed, and lines added while the client
+    // was closed, are indexed on catch-up without duplicating anything.
+    void testCatchUpExistingLogs()
+    {
+        QTemporaryDir tmp;
+        const QString netDir = LogWriter::networkDirFor(tmp.path(), "net");
+        QDir().mkpath(netDir);
+        writeFile(netDir + "/#old.log", "before", 500);
+        {
+            LogWriter writer(tmp.path());
+            writer.start();
+            QTRY_VERIFY(writer.ensureSearchIndexed("net"));
+            QCOMPARE(Index::search(netDir, query("before 123;")).hits.size(), 1);
+        }
+        writeFile(netDir + "/#old.log", "after", 100);
+        {
+            LogWriter writer(tmp.path());
+            writer.start();
+            QTRY_VERIFY(writer.ensureSearchIndexed("net"));
+            QCOMPARE(Index::search(netDir, query("after 42;")).hits.size(), 1);
+            QCOMPARE(Index::search(netDir, query("before 123;")).hits.size(), 1);
+            QCOMPARE(Index::search(netDir, query("before")).hits.size(), 500);
+        }
+    }
+
+    void testRotatedBackupSearchable()
+    {
+        QTemporaryDir tmp;
+        const QString netDir = tmp.path() + "/net";
+        const QString log = netDir + "/#r.log";
+        QDir().mkpath(netDir);
+        Index index(netDir);
+
+        writeFile(log, "old", 100);
+        index.catchUp("#r");
+        QVERIFY(QFile::rename(log, log + ".1"));
+        index.rotated("#r");
+        writeFile(log, "new", 100);
+        index.catchUp("#r");
+        index.flush();
+        QCOMPARE(Index::search(netDir, query("old 42;")).hits.size(), 1);
+        QCOMPARE(Index::search(netDir, query("new 42;")).hits.size(), 1);
+
+        // A second rotation drops the oldest generation for good
+        QVERIFY(QFile::remove(log + ".1"));
+        QVERIFY(QFile::rename(log, log + ".1"));
+        index.rotated("#r");
+        writeFile(log, "newer", 10);
+        index.catchUp("#r");
+        index.flush();
+        QCOMPARE(Index::search(netDir, query("old 42;")).hits.size(), 0);
+        QCOMPARE(Index::search(netDir, query("new 42;")).hits.size(), 1);
+        QCOMPARE(Index::search(netDir, query("newer 7;")).hits.size(), 1);
+    }
+
+    // Catch-up done in work() steps, with the log growing and rotating
+    // while it is under way: every line is indexed exactly once.
+    void testStepwiseCatchUp()
+    {
+        QTemporaryDir tmp;
+        const QString netDir = tmp.path() + "/net";
+        const QString log = netDir + "/#s.log";
+        QDir().mkpath(netDir);
+        writeFile(log, "early", 80000); // well over two steps
+        Index index(netDir);
+
+        index.queueCatchUp("#s");
+        QVERIFY(index.hasWork());
+        index.work();
+        QVERIFY(index.hasWork());
+        index.flush();
+        // Half way: what is indexed, and the newest lines, are searched
+        auto r = Index::search(netDir, query("early 123;"));
+        QCOMPARE(r.hits.size(), 1);
+        QVERIFY(r.incomplete);
+        QCOMPARE(Index::search(netDir, query("early 79999;")).hits.size(), 1);
+        writeFile(log, "middle", 100);
+        QVERIFY(QFile::rename(log, log + ".1"));
+        index.rotated("#s");
+        writeFile(log, "late", 100);
+        index.queueCatchUp("#s");
+        while (index.hasWork())
+            index.work();
+        index.flush();
+
+        QCOMPARE(Index::search(netDir, query("early 123;")).hits.size(), 1);
+        r = Index::search(netDir, query("early 79999;"));
+        QCOMPARE(r.hits.size(), 1);
+        QVERIFY(!r.incomplete);
+        QCOMPARE(Index::search(netDir, query("middle")).hits.size(), 100);
+        QCOMPARE(Index::search(netDir, query("late")).hits.size(), 100);
+    }
+
+    // Indexing throughput and query latency over a synthetic corpus.
+    // NUCHAT_BENCH_CORPUS_MB sets its size (default 16; 1024 for the 1 GB
+    // run).
+    void benchCorpus()
+    {
+        const qint64 targetMb = qEnvironmentVariableIsSet("NUCHAT_BENCH_CORPUS_MB")
+            ? qEnvironmentVariableIntValue("NUCHAT_BENCH_CORPUS_MB") : 16;
+        QTemporaryDir tmp;
+        const QString netDir = LogWriter::networkDirFor(tmp.path(), "net");
+        // Channels stay below the rotation size so the whole corpus is kept
+        const int channels = int(qMax<qint64>(16, targetMb / 8));
+        static const char *words[] = {
+            "the", "deploy", "build", "failed", "merge", "review", "lunch",
+            "server", "restart", "ping", "kernel", "patch", "release",
+            "coffee", "weekend", "bug", "fixed", "test", "green", "cache"};
+        QRandomGenerator rng(4711);
+
+        QElapsedTimer timer;
+        timer.start();
+        qint64 bytes = 0;
+        qint64 line = 0;
+        {
+            LogWriter writer(tmp.path());
+            writer.start();
+            // Runs of lines per channel keep the open-file cache warm
+            while (bytes < targetMb * 1024 * 1024) {
+                const QString chan = "#chan" + QString::number(rng.bounded(channels));
+                for (int i = 0; i < 500; ++i, ++line) {
+                    QString text = "<nick" + QString::number(rng.bounded(40)) + ">";
+                    for (int w = 0; w < 10; ++w)
+                        text += QLatin1Char(' ') + QLatin1String(words[rng.bounded(20)]);
+                    if (line == 1000)
+                        text += " xyzzy4711";
+                    bytes += text.size() + 28;
+                    writer.enqueue(rec(chan, text, kBase + line * 100));
+                }
+            }
+        }
+        const double writeSecs = timer.elapsed() / 1000.0;
+
+        auto time = [&](const char *label, const Index::Query &q) {
+            QVector<qint64> runs;
+            Index::Result r;
+            for (int i = 0; i < 5; ++i) {
+                QElapsedTimer t;
+                t.start();
+                r = Index::search(netDir, q);
+                runs.append(t.nsecsElapsed() / 1000);
+            }
+            std::sort(runs.begin(), runs.end());
+            qInfo().noquote() << QString("  %1: %2 hits, %3 blocks, median %4 ms")
+                                     .arg(QString::fromLatin1(label)).arg(r.hits.size()).arg(r.blocksRead)
+                                     .arg(runs[2] / 1000.0, 0, 'f', 2);
+            return r;
+        };
+
+        qInfo().noquote() << QString("Corpus: %1 MB, %2 lines, %3 channels; "
+                                     "written + indexed at %4 MB/s")
+                                 .arg(bytes / (1024 * 1024)).arg(line).arg(channels)
+                                 .arg(bytes / (1024.0 * 1024.0) / writeSecs, 0, 'f', 1);
+        const auto rare = time("rare token", query("xyzzy4711", 50));
+        QCOMPARE(rare.hits.size(), 1);
+        time("common words", query("deploy failed", 50));
+        auto q = query("^<nick1[0-9]> .*restart kernel", 50);
+        q.regex = true;
+        time("regex", q);
+        q = query("coffee", 50);
+        q.nick = "nick7";
+        q.channel = "#chan3";
+        time("nick + channel", q);
+    }
+};
+
+const qint64 TestLogSearch::kBase =
+    QDateTime(QDate(2024, 1, 1), QTime(0, 0)).toMSecsSinceEpoch();
+
+QTEST_MAIN(TestLogSearch)
+#include "test_logsearch.moc"
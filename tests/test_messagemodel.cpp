@@ -0,0 +1,193 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QTextDocument>
+#include "MessageModel.h"
+
+// MessageModel renders HTML lazily: nothing is formatted while lines are
+// added, the first read of formattedText renders and caches the line, and
+// a theme or timestamp-format change re-renders on the next read.
+class TestMessageModel : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QString html(const MessageModel &model, int row)
+    {
+        return model.index(row).data(MessageModel::FormattedTextRole).toString();
+    }
+
+private slots:
+    void testFormatsOnDemand()
+    {
+        MessageModel model;
+        const QString ts = "2024-01-01T12:34:56";
+        model.beginBatch();
+        model.addMessage("chat", "<bob> \x02hello\x02 https://example.org", ts);
+        model.addMessage("action", "bob waves", ts);
+        model.endBatch();
+
+        QCOMPARE(html(model, 0),
+                 model.formatLineFromQml("<bob> \x02hello\x02 https://example.org", "chat", ts));
+        QCOMPARE(html(model, 1), model.formatLineFromQml("bob waves", "action", ts));
+        QVERIFY(html(model, 0).contains("<b>"));
+        QVERIFY(html(model, 0).contains("href=\"https://example.org\""));
+        // Cached: a second read is the same text
+        QCOMPARE(html(model, 0), html(model, 0));
+    }
+
+    void testFormatGenerationInvalidates()
+    {
+        MessageModel model;
+        model.addMessage("chat", "<bob> hi", "2024-01-01T12:34:56");
+        QVERIFY(html(model, 0).contains("[12:34:56]"));
+
+        QSignalSpy changed(&model, &MessageModel::dataChanged);
+        model.setTimestampFormat("hh:mm");
+        QCOMPARE(changed.count(), 1);
+        QVERIFY(html(model, 0).contains("[12:34]"));
+        QVERIFY(!html(model, 0).contains("[12:34:56]"));
+
+        // Setting the same format again changes nothing
+        model.setTimestampFormat("hh:mm");
+        QCOMPARE(changed.count(), 1);
+        model.setTimestampFormat(QString());
+    }
+
+    void testHighlightFrozenAtInsert()
+    {
+        MessageModel model;
+        model.setNickname("me");
+        model.setHighlightEnabled(false); // log scrollback
+        model.addMessage("chat", "<bob> hi me");
+        model.setHighlightEnabled(true);
+        model.addMessage("chat", "<bob> hey me");
+        model.addMessage("chat", "<me> talking to myself, me");
+
+        // Rendered only now, after the switch: each line keeps its own state
+        QVERIFY(!html(model, 0).contains("#3a2a00"));
+        QVERIFY(html(model, 1).contains("#3a2a00"));
+        QVERIFY(!html(model, 2).contains("#3a2a00"));
+    }
+
+    void testHeldAppendsInsertOnce()
+    {
+        MessageModel model;
+        model.addMessage("system", "before");
+        QSignalSpy inserted(&model, &QAbstractItemModel::rowsInserted);
+        model.holdAppends();
+        model.holdAppends();
+        for (int i = 0; i < 5; ++i)
+            model.addMessage("chat", "<bob> line " + QString::number(i));
+        model.releaseAppends();
+        // Still held by the outer hold
+        QCOMPARE(model.rowCount(), 1);
+        QCOMPARE(inserted.count(), 0);
+        model.releaseAppends();
+        QCOMPARE(model.rowCount(), 6);
+        QCOMPARE(inserted.count(), 1);
+        QCOMPARE(inserted.at(0).at(1).toInt(), 1);
+        QCOMPARE(inserted.at(0).at(2).toInt(), 5);
+        QCOMPARE(model.index(5).data(MessageModel::TextRole).toString(),
+                 QString("<bob> line 4"));
+
+        // A clear while held drops the held rows with the rest
+        model.holdAppends();
+        model.addMessage("chat", "<bob> gone");
+        model.clear();
+        model.releaseAppends();
+        QCOMPARE(model.rowCount(), 0);
+    }
+
+    void testPlainTextMatchesRowHtml()
+    {
+        // The cached plain text must stay what the view's RichText shows
+        MessageModel model;
+        model.setNickname("me");
+        model.setHighlightEnabled(true);
+        const QString ts = "2024-01-01T12:34:56";
+        model.addMessage("chat", "<bob> \x02hi\x02 me & <you>", ts);
+        for (int i = 0; i < 4; ++i)
+            model.addMessage("system", QString("nick%1 has joined #chan").arg(i), ts);
+        model.addMessage("action", "bob waves", ts);
+
+        auto check = [&model]() {
+            for (int row = 0; row < model.rowCount(); ++row) {
+                QTextDocument doc;
+                doc.setHtml(model.index(row).data(MessageModel::RowHtmlRole).toString());
+                QCOMPARE(model.plainText(row), doc.toPlainText());
+            }
+        };
+        check();
+        model.toggleEventGroup(2); // ids count from 1: the group's first row
+        QVERIFY(!model.index(2).data(MessageModel::CollapsedRole).toBool());
+        check();
+        model.setTimestampFormat("hh:mm");
+        check();
+        QVERIFY(model.plainText(0).startsWith("[12:34] <bob> hi me & <you>"));
+        model.setTimestampFormat(QString());
+    }
+
+    void testBatchInsideHold()
+    {
+        // A channel switch while a burst of lines is being handled
+        MessageModel model;
+        model.holdAppends();
+        model.addMessage("chat", "<bob> held");
+        int rowsAtReload = -1;
+        connect(&model, &MessageModel::reloaded, this,
+                [&]() { rowsAtReload = model.rowCount(); });
+        model.beginBatch();
+        for (int i = 0; i < 3; ++i)
+            model.addMessage("chat", "<bob> scrollback " + QString::number(i));
+        model.endBatch();
+        QCOMPARE(rowsAtReload, 4);
+        QCOMPARE(model.index(3).data(MessageModel::TextRole).toString(),
+                 QString("<bob> scrollback 2"));
+
+        // The hold itself is still on after the batch
+        model.addMessage("chat", "<bob> later");
+        QCOMPARE(model.rowCount(), 4);
+        model.releaseAppends();
+        QCOMPARE(model.rowCount(), 5);
+    }
+
+    void benchChannelSwitch()
+    {
+        const int lines = qEnvironmentVariableIsSet("NUCHAT_BENCH_SWITCH_LINES")
+            ? qEnvironmentVariableIntValue("NUCHAT_BENCH_SWITCH_LINES") : 5000;
+        MessageModel model;
+        model.setNickname("me");
+        model.setHighlightEnabled(true);
+
+        QElapsedTimer timer;
+        timer.start();
+        model.beginBatch();
+        for (int i = 0; i < lines; ++i)
+            model.addMessage("chat", QString("<nick%1> \x03%2line %3 https://example.org/%3 me")
+                                         .arg(i % 40).arg(i % 16).arg(i));
+        model.endBatch();
+        const qint64 loadUs = timer.nsecsElapsed() / 1000;
+
+        // What a view shows after the switch: one screen at the bottom
+        timer.restart();
+        for (int row = qMax(0, lines - 50); row < lines; ++row)
+            QVERIFY(!html(model, row).isEmpty());
+        const qint64 screenUs = timer.nsecsElapsed() / 1000;
+
+        timer.restart();
+        for (int row = 0; row < lines; ++row)
+            model.formatLineFromQml(model.index(row).data(MessageModel::TextRole).toString(),
+                                    "chat", QString());
+        const qint64 eagerUs = timer.nsecsElapsed() / 1000;
+
+        qInfo().noquote() << QString("%1 lines: load %2 ms + first screen %3 ms; "
+                                     "formatting every line would add %4 ms")
+                                 .arg(lines).arg(loadUs / 1000.0, 0, 'f', 1)
+                                 .arg(screenUs / 1000.0, 0, 'f', 1)
+                                 .arg(eagerUs / 1000.0, 0, 'f', 1);
+    }
+};
+
+QTEST_MAIN(TestMessageModel)
+#include "test_messagemodel.moc"
@@ -0,0 +1,91 @@
+#include <QtTest>
+#include "NetsplitTracker.h"
+
+class TestNetsplitTracker : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testSplitReason()
+    {
+        QVERIFY(NetsplitTracker::isSplitReason(u"hub.example.net leaf.example.net"));
+        QVERIFY(NetsplitTracker::isSplitReason(u"*.freenode.net *.split"));
+        QVERIFY(NetsplitTracker::isSplitReason(u"irc-1.eu.example.org irc2.us.example.org"));
+
+        QVERIFY(!NetsplitTracker::isSplitReason(u""));
+        QVERIFY(!NetsplitTracker::isSplitReason(u"Quit: leaving"));
+        QVERIFY(!NetsplitTracker::isSplitReason(u"Ping timeout: 240 seconds"));
+        QVERIFY(!NetsplitTracker::isSplitReason(u"hub.example.net hub.example.net"));
+        QVERIFY(!NetsplitTracker::isSplitReason(u"hub.example.net  leaf.example.net"));
+        QVERIFY(!NetsplitTracker::isSplitReason(u"hub.example.net leaf.example.net x"));
+        QVERIFY(!NetsplitTracker::isSplitReason(u"Quit: a.b c.d"));
+        QVERIFY(!NetsplitTracker::isSplitReason(u"see http://a.example.com"));
+        QVERIFY(!NetsplitTracker::isSplitReason(u"1.2.3.4 5.6.7.8"));
+        QVERIFY(!NetsplitTracker::isSplitReason(u"hub..example.net leaf.example.net"));
+        QVERIFY(!NetsplitTracker::isSplitReason(u"hub.example.net. leaf.example.net"));
+    }
+
+    void testSplitAndRejoin()
+    {
+        const QString servers = "hub.example.net leaf.example.net";
+        NetsplitTracker t;
+        QVERIFY(!t.hasPending());
+        t.quit(1, servers, "Alice", "alice", 1000);
+        t.quit(2, servers, "Alice", "alice", 1000);
+        t.quit(1, servers, "Bob", "bob", 1001);
+        QVERIFY(t.hasPending());
+        // Not split: an ordinary join
+        QVERIFY(!t.join(1, "carol", "carol", 1002));
+
+        auto events = t.take(1500);
+        QVERIFY(!t.hasPending());
+        QCOMPARE(events.size(), 2);
+        QCOMPARE(events.at(0).channel, 1);
+        QVERIFY(!events.at(0).rejoin);
+        QCOMPARE(events.at(0).servers, servers);
+        QCOMPARE(events.at(0).nicks, QStringList({"Alice", "Bob"}));
+        QCOMPARE(events.at(1).channel, 2);
+        QCOMPARE(events.at(1).nicks, QStringList({"Alice"}));
+
+        QVERIFY(t.join(1, "Alice", "alice", 60000));
+        QVERIFY(t.rejoining(1, "alice"));
+        QVERIFY(t.join(2, "Alice", "alice", 60000));
+        // Each split nick comes back once
+        QVERIFY(!t.join(1, "Alice", "alice", 60001));
+        events = t.take(60500);
+        QCOMPARE(events.size(), 2);
+        QVERIFY(events.at(0).rejoin);
+        QCOMPARE(events.at(0).servers, servers);
+        QCOMPARE(events.at(0).nicks, QStringList({"Alice"}));
+
+        // Bob stays split too long to count as a netjoin
+        QVERIFY(!t.join(1, "Bob", "bob", 1001 + NetsplitTracker::kRememberMs + 1));
+    }
+
+    void testQuickReturns()
+    {
+        const QString servers = "a.example.net b.example.net";
+        NetsplitTracker t;
+        // Back before the split was reported: nothing to report
+        QVERIFY(!t.quit(1, servers, "Alice", "alice", 0));
+        QVERIFY(t.join(1, "Alice", "alice", 10));
+        QVERIFY(!t.hasPending());
+
+        // Gone again before the rejoin was reported
+        t.quit(1, servers, "Bob", "bob", 0);
+        t.take(100);
+        QVERIFY(t.join(1, "Bob", "bob", 200));
+        QVERIFY(t.quit(1, servers, "Bob", "bob", 300));
+        QVERIFY(!t.hasPending());
+        QVERIFY(t.join(1, "Bob", "bob", 400));
+        QCOMPARE(t.take(500).size(), 1);
+
+        t.quit(3, servers, "Carol", "carol", 0);
+        t.forget(3);
+        QVERIFY(!t.hasPending());
+        QVERIFY(!t.join(3, "Carol", "carol", 10));
+    }
+};
+
+QTEST_MAIN(TestNetsplitTracker)
+#include "test_netsplittracker.moc"
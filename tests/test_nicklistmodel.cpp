@@ -0,0 +1,168 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include "NickListModel.h"
+
+static QStringList rows(const NickListModel &m)
+{
+    QStringList out;
+    for (int i = 0; i < m.rowCount(); ++i)
+        out << m.data(m.index(i), Qt::DisplayRole).toString();
+    return out;
+}
+
+class TestNickListModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testOrder()
+    {
+        NickListModel m;
+        m.reset({"zed", "+bob", "@carol", "Alice", "~owner", "%half", "@+both", "@carol"});
+        QCOMPARE(rows(m), QStringList({"~owner", "@both", "@carol", "%half", "+bob",
+                                       "Alice", "zed"}));
+        QCOMPARE(m.count(), 7);
+        QCOMPARE(m.names(), rows(m));
+        QVERIFY(m.contains(u"ALICE"));
+        QCOMPARE(m.prefix(u"Both"), QString("@"));
+        QCOMPARE(m.prefix(u"zed"), QString());
+        QCOMPARE(m.nickAt(1), QString("both"));
+        QCOMPARE(m.data(m.index(1), NickListModel::PrefixRole).toString(), QString("@"));
+    }
+
+    void testRowSignals()
+    {
+        NickListModel m;
+        m.reset({"@op", "alice", "carol"});
+        QSignalSpy inserted(&m, &QAbstractItemModel::rowsInserted);
+        QSignalSpy removed(&m, &QAbstractItemModel::rowsRemoved);
+        QSignalSpy moved(&m, &QAbstractItemModel::rowsMoved);
+        QSignalSpy reset(&m, &QAbstractItemModel::modelReset);
+
+        QVERIFY(m.add("bob"));
+        QVERIFY(!m.add("BOB"));
+        QCOMPARE(inserted.size(), 1);
+        QCOMPARE(inserted.at(0).at(1).toInt(), 2);
+        QCOMPARE(rows(m), QStringList({"@op", "alice", "bob", "carol"}));
+
+        QVERIFY(m.remove(u"Alice"));
+        QVERIFY(!m.remove(u"nobody"));
+        QCOMPARE(removed.size(), 1);
+        QCOMPARE(removed.at(0).at(1).toInt(), 1);
+
+        // Voicing carol moves her above the regulars
+        QVERIFY(m.setPrefix(u"carol", QChar('+'), true));
+        QVERIFY(!m.setPrefix(u"carol", QChar('+'), true));
+        QCOMPARE(rows(m), QStringList({"@op", "+carol", "bob"}));
+        QCOMPARE(moved.size(), 1);
+
+        // Ops keep their voice when deopped
+        QVERIFY(m.setPrefix(u"carol", QChar('@'), true));
+        QVERIFY(m.setPrefix(u"carol", QChar('@'), false));
+        QCOMPARE(rows(m), QStringList({"@op", "+carol", "bob"}));
+        QCOMPARE(moved.size(), 3);
+
+        // A rename that keeps its place only changes the row
+        QVERIFY(m.rename(u"bob", "bobby"));
+        QVERIFY(m.rename(u"op", "zop"));
+        QVERIFY(m.rename(u"bobby", "aaron"));
+        QVERIFY(!m.rename(u"nobody", "x"));
+        QCOMPARE(rows(m), QStringList({"@zop", "+carol", "aaron"}));
+        QCOMPARE(moved.size(), 3);
+        QCOMPARE(reset.size(), 0);
+        QCOMPARE(inserted.size(), 1);
+        QCOMPARE(removed.size(), 1);
+
+        QVERIFY(m.rename(u"aaron", "Carol2"));
+        QVERIFY(m.setPrefix(u"carol2", QChar('~'), true));
+        QCOMPARE(rows(m), QStringList({"~Carol2", "@zop", "+carol"}));
+        QCOMPARE(moved.size(), 4);
+    }
+
+    void testCaseMapping()
+    {
+        NickListModel m;
+        m.reset({"[dan]", "Dan"});
+        QVERIFY(m.contains(u"{DAN}"));
+        QVERIFY(m.remove(u"{dan}"));
+        QCOMPARE(rows(m), QStringList({"Dan"}));
+
+        m.reset({"[dan]", "{dan}", "x"});
+        QCOMPARE(m.count(), 2);
+        m.setCaseMapping(ChannelRegistry::CaseMapping::Ascii);
+        QVERIFY(!m.contains(u"{dan}"));
+        QVERIFY(m.add("{dan}"));
+        QCOMPARE(m.count(), 3);
+        m.setCaseMapping(ChannelRegistry::CaseMapping::Rfc1459);
+        // Folded "{dan}" sorts after the letters
+        QCOMPARE(rows(m), QStringList({"x", "[dan]"}));
+    }
+
+    void testBatches()
+    {
+        NickListModel m;
+        m.reset({"@op", "keep"});
+        QSignalSpy inserted(&m, &QAbstractItemModel::rowsInserted);
+        QSignalSpy reset(&m, &QAbstractItemModel::modelReset);
+
+        // Small batches still signal per row
+        QCOMPARE(m.addAll({"b", "a", "keep"}), 2);
+        QCOMPARE(inserted.size(), 2);
+        QCOMPARE(reset.size(), 0);
+        QCOMPARE(m.removeAll({"a", "B", "nobody"}), 2);
+        QCOMPARE(reset.size(), 0);
+
+        QStringList many;
+        for (int i = 0; i < 100; ++i)
+            many << QString("n%1").arg(i, 3, 10, QChar('0'));
+        QCOMPARE(m.addAll(many + QStringList({"n000", "+v"})), 101);
+        QCOMPARE(reset.size(), 1);
+        QCOMPARE(m.count(), 103);
+        QCOMPARE(m.nickAt(0), QString("op"));
+        QCOMPARE(m.nickAt(1), QString("v"));
+        QCOMPARE(m.nickAt(2), QString("keep"));
+        QCOMPARE(m.nickAt(3), QString("n000"));
+        QCOMPARE(m.nickAt(102), QString("n099"));
+
+        QCOMPARE(m.removeAll(many), 100);
+        QCOMPARE(reset.size(), 2);
+        QCOMPARE(rows(m), QStringList({"@op", "+v", "keep"}));
+        QVERIFY(!m.contains(u"n050"));
+    }
+
+    void testCompletions()
+    {
+        NickListModel m;
+        m.reset({"@Alfred", "alice", "+albert", "bob"});
+        QCOMPARE(m.completions("AL"), QStringList({"Alfred", "albert", "alice"}));
+        QCOMPARE(m.completions("z"), QStringList());
+    }
+
+    void benchNetsplit()
+    {
+        const int users = qEnvironmentVariableIsSet("NUCHAT_BENCH_NICKLIST_USERS")
+            ? qEnvironmentVariableIntValue("NUCHAT_BENCH_NICKLIST_USERS") : 5000;
+        QStringList names;
+        for (int i = 0; i < users; ++i)
+            names << (i % 50 == 0 ? "@" : i % 10 == 0 ? "+" : "") + QString("user%1").arg(i);
+
+        NickListModel m;
+        m.reset(names);
+        QElapsedTimer timer;
+        timer.start();
+        // Half the channel splits off and comes back
+        for (int i = 0; i < users; i += 2)
+            QVERIFY(m.remove(QString("user%1").arg(i)));
+        for (int i = 0; i < users; i += 2)
+            QVERIFY(m.add(QString("user%1").arg(i)));
+        const qint64 ms = timer.elapsed();
+        QCOMPARE(m.count(), users);
+
+        qInfo().noquote() << QString("%1-user channel: %2 quits and rejoins in %3 ms")
+                                 .arg(users).arg(users / 2).arg(ms);
+    }
+};
+
+QTEST_MAIN(TestNickListModel)
+#include "test_nicklistmodel.moc"
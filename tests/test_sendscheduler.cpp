@@ -0,0 +1,144 @@
+#include <QtTest>
+#include "SendScheduler.h"
+
+using Lane = SendScheduler::Lane;
+
+class TestSendScheduler : public QObject
+{
+    Q_OBJECT
+
+private:
+    // Everything next() lets through at `now`
+    static QList<QByteArray> drain(SendScheduler &s, qint64 now)
+    {
+        QList<QByteArray> out;
+        QByteArray line;
+        while (s.next(now, line))
+            out.append(line);
+        return out;
+    }
+
+    static SendScheduler::Profile unlimited()
+    {
+        return {"test", 1000000, 1, 0};
+    }
+
+private slots:
+    void testBurstThenThrottle()
+    {
+        SendScheduler s;
+        const QByteArray line = "PRIVMSG #a :hi";
+        for (int i = 0; i < 20; ++i)
+            s.enqueue(Lane::Interactive, line);
+
+        const qint64 cost = s.cost(line.size());
+        const auto burst = drain(s, 0);
+        QVERIFY(burst.size() >= 2);
+        // As many as fit in the window, and not one more
+        QVERIFY(burst.size() * cost <= s.profile().windowMs);
+        QVERIFY((burst.size() + 1) * cost > s.profile().windowMs);
+
+        // Then one line per line cost
+        const qint64 wait = s.delayUntilNext(0);
+        QVERIFY(wait > 0);
+        QVERIFY(drain(s, wait - 1).isEmpty());
+        QCOMPARE(drain(s, wait).size(), 1);
+        QCOMPARE(s.delayUntilNext(wait), cost);
+        QCOMPARE(s.sentLines(Lane::Interactive), quint64(burst.size() + 1));
+    }
+
+    void testLongLinesCostMore()
+    {
+        SendScheduler s(SendScheduler::profileNamed("strict"));
+        QCOMPARE(s.profile().name, QString("strict"));
+        QVERIFY(s.cost(400) > s.cost(10) + 2000);
+
+        const QByteArray paste = "PRIVMSG #a :" + QByteArray(400, 'x');
+        for (int i = 0; i < 10; ++i)
+            s.enqueue(Lane::Bulk, paste);
+        const auto burst = drain(s, 0);
+        QVERIFY(burst.size() * s.cost(paste.size()) <= s.profile().windowMs);
+        QVERIFY(burst.size() < 10);
+    }
+
+    void testPriorityLanes()
+    {
+        SendScheduler s;
+        for (int i = 0; i < 50; ++i)
+            s.enqueue(Lane::Bulk, "PRIVMSG #a :paste " + QByteArray::number(i));
+        drain(s, 0); // window full of paste
+        s.enqueue(Lane::Interactive, "WHO #a");
+        s.enqueue(Lane::Control, "PING :LAG1");
+
+        // Control is never held back, only charged
+        auto out = drain(s, 0);
+        QCOMPARE(out, QList<QByteArray>({"PING :LAG1"}));
+        // Typed input overtakes the rest of the paste
+        const qint64 wait = s.delayUntilNext(0);
+        QVERIFY(wait > 0);
+        QByteArray line;
+        QVERIFY(s.next(wait, line));
+        QCOMPARE(line, QByteArray("WHO #a"));
+        QVERIFY(s.depth(Lane::Bulk) > 0);
+    }
+
+    void testRoundRobinTargets()
+    {
+        SendScheduler s(unlimited());
+        for (int i = 1; i <= 4; ++i)
+            s.enqueue(Lane::Bulk, "PRIVMSG #a :" + QByteArray::number(i));
+        s.enqueue(Lane::Bulk, "PRIVMSG #B :1");
+        s.enqueue(Lane::Bulk, "privmsg #b :2");
+        s.enqueue(Lane::Bulk, "JOIN #c");
+        QCOMPARE(drain(s, 0), QList<QByteArray>({
+            "PRIVMSG #a :1", "PRIVMSG #B :1", "JOIN #c", "PRIVMSG #a :2",
+            "privmsg #b :2", "PRIVMSG #a :3", "PRIVMSG #a :4"}));
+    }
+
+    void testTargetOf()
+    {
+        QCOMPARE(SendScheduler::targetOf("PRIVMSG #Chan :hello"), QByteArray("#chan"));
+        QCOMPARE(SendScheduler::targetOf("@+typing=active TAGMSG Bob"), QByteArray("bob"));
+        QCOMPARE(SendScheduler::targetOf("NOTICE Bob :\x01VERSION x\x01"), QByteArray("bob"));
+        QCOMPARE(SendScheduler::targetOf("JOIN #chan"), QByteArray());
+        QCOMPARE(SendScheduler::targetOf("AWAY"), QByteArray());
+    }
+
+    void testOversizedLine()
+    {
+        SendScheduler s({"tiny", 1000, 2000, 0});
+        s.enqueue(Lane::Interactive, "PRIVMSG #a :1");
+        s.enqueue(Lane::Interactive, "PRIVMSG #a :2");
+        // More than the window: goes whenever the clock is idle
+        QCOMPARE(drain(s, 0).size(), 1);
+        QCOMPARE(s.delayUntilNext(0), qint64(2000));
+        QCOMPARE(drain(s, 2000).size(), 1);
+        QCOMPARE(s.delayUntilNext(2000), qint64(-1));
+    }
+
+    void testMetrics()
+    {
+        SendScheduler s(SendScheduler::profileNamed("no such profile"));
+        QCOMPARE(s.profile().name, QString("default"));
+        s.enqueue(Lane::Interactive, "PRIVMSG #a :12345");
+        s.enqueue(Lane::Bulk, "PRIVMSG #a :123");
+        QCOMPARE(s.depth(), 2);
+        QCOMPARE(s.depth(Lane::Bulk), 1);
+        QCOMPARE(s.queuedBytes(), qint64(32));
+        QCOMPARE(s.peakDepth(), 2);
+        drain(s, 0);
+        QCOMPARE(s.depth(), 0);
+        QCOMPARE(s.queuedBytes(), qint64(0));
+        QCOMPARE(s.peakDepth(), 2);
+        QVERIFY(s.backlogMs(0) > 0);
+
+        s.enqueue(Lane::Bulk, "PRIVMSG #a :x");
+        s.clear();
+        QCOMPARE(s.depth(), 0);
+        QCOMPARE(s.peakDepth(), 0);
+        QCOMPARE(s.backlogMs(0), qint64(0));
+    }
+};
+
+QTEST_MAIN(TestSendScheduler)
+#include "test_sendscheduler.moc"
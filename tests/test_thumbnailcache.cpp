@@ -0,0 +1,127 @@
+#include <QtTest>
+#include <QImage>
+#include <QTemporaryDir>
+#include "ThumbnailCache.h"
+
+class TestThumbnailCache : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QImage solid(int w, int h)
+    {
+        QImage image(w, h, QImage::Format_ARGB32);
+        image.fill(Qt::red);
+        return image;
+    }
+
+private slots:
+    void testBudgetEvictsLeastRecent()
+    {
+        const QImage tile = solid(100, 100); // 40000 bytes
+        ThumbnailCache cache(3 * tile.sizeInBytes());
+        cache.insert("a", tile);
+        cache.insert("b", tile);
+        cache.insert("c", tile);
+        QCOMPARE(cache.count(), 3);
+        QCOMPARE(cache.bytes(), 3 * tile.sizeInBytes());
+
+        // Touching "a" makes "b" the oldest
+        QVERIFY(!cache.find("a").isNull());
+        cache.insert("d", tile);
+        QCOMPARE(cache.count(), 3);
+        QVERIFY(cache.find("b").isNull());
+        QVERIFY(!cache.find("a").isNull());
+        QVERIFY(!cache.find("d").isNull());
+        QVERIFY(cache.bytes() <= cache.budget());
+
+        // Larger than the whole budget: not kept, nothing else lost
+        cache.insert("huge", solid(400, 400));
+        QVERIFY(cache.find("huge").isNull());
+        QCOMPARE(cache.count(), 3);
+
+        cache.setBudget(tile.sizeInBytes());
+        QCOMPARE(cache.count(), 1);
+        cache.clear();
+        QCOMPARE(cache.bytes(), qint64(0));
+    }
+
+    void testLoadReadsOnce()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.filePath("x.thumb");
+        QVERIFY(solid(40, 30).save(path, "PNG"));
+
+        ThumbnailCache cache;
+        QCOMPARE(cache.load(path).size(), QSize(40, 30));
+        QCOMPARE(cache.count(), 1);
+        // Served from memory from now on
+        QVERIFY(QFile::remove(path));
+        QCOMPARE(cache.load(path).size(), QSize(40, 30));
+        QVERIFY(cache.load(dir.filePath("missing.thumb")).isNull());
+        QCOMPARE(cache.count(), 1);
+    }
+
+    void testDecodeScaled()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString big = dir.filePath("big.png");
+        QVERIFY(solid(1600, 900).save(big));
+        QSize original;
+        const QImage thumb = ThumbnailCache::decodeScaled(big, 400, &original);
+        QCOMPARE(thumb.size(), QSize(400, 225));
+        QCOMPARE(original, QSize(1600, 900));
+
+        // Never scaled up
+        const QString small = dir.filePath("small.png");
+        QVERIFY(solid(120, 80).save(small));
+        QCOMPARE(ThumbnailCache::decodeScaled(small, 400).size(), QSize(120, 80));
+
+        QVERIFY(ThumbnailCache::decodeScaled(dir.filePath("none.png"), 400).isNull());
+    }
+
+    void benchScrollScreenshots()
+    {
+        // A channel of screenshots scrolled back and forth: every embed is
+        // re-requested, only the budget's worth stays decoded.
+        const int shots = qEnvironmentVariableIntValue("NUCHAT_BENCH_SHOTS") > 0
+                              ? qEnvironmentVariableIntValue("NUCHAT_BENCH_SHOTS")
+                              : 40;
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QStringList originals;
+        for (int i = 0; i < shots; ++i) {
+            originals << dir.filePath(QString("shot%1.png").arg(i));
+            QVERIFY(solid(1920, 1080).save(originals.last()));
+        }
+
+        QElapsedTimer t;
+        t.start();
+        for (const QString &path : std::as_const(originals))
+            QVERIFY(!QImage(path).isNull());
+        const qint64 fullMs = qMax<qint64>(t.elapsed(), 1);
+
+        const QImage sample = solid(400, 225);
+        ThumbnailCache cache(10 * sample.sizeInBytes());
+        QStringList thumbs;
+        for (const QString &path : std::as_const(originals)) {
+            thumbs << path + ".thumb";
+            QVERIFY(ThumbnailCache::decodeScaled(path, 400).save(thumbs.last(), "PNG"));
+        }
+        t.restart();
+        for (const QString &path : std::as_const(thumbs))
+            QVERIFY(!cache.load(path).isNull());
+        const qint64 thumbMs = qMax<qint64>(t.elapsed(), 1);
+
+        qInfo("full-size decode: %d images in %lld ms, %lld bytes each",
+              shots, qlonglong(fullMs), qlonglong(solid(1920, 1080).sizeInBytes()));
+        qInfo("thumbnail load:   %d images in %lld ms, cache holds %lld bytes",
+              shots, qlonglong(thumbMs), qlonglong(cache.bytes()));
+        QVERIFY(cache.bytes() <= cache.budget());
+    }
+};
+
+QTEST_MAIN(TestThumbnailCache)
+#include "test_thumbnailcache.moc"